@@ -0,0 +1,232 @@
+#ifndef _CHARSCAN_HPP_INCLUDED_
+#define _CHARSCAN_HPP_INCLUDED_
+
+// Block-wise character scanning for the text parsers. The scanners test 16 (SSE2) or 32
+// (AVX2) characters at once and fall back to a character loop for the tail of the range
+// and on targets without SIMD. Ranges don't need to be zero-terminated, no byte at or
+// behind end is read.
+
+#include "BasicTypes.hpp"
+#include "bits.hpp"
+
+#if !defined(CHARSCAN_NO_SIMD)
+#  if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#     define CHARSCAN_SSE2
+#     include <emmintrin.h>
+#  endif
+#  if defined(CHARSCAN_SSE2) && defined(__AVX2__)
+#     define CHARSCAN_AVX2
+#     include <immintrin.h>
+#  endif
+#endif
+
+namespace core
+{
+
+   namespace charscan
+   {
+      // The matchers describe a character class for the scalar, SSE2 and AVX2 paths. Match()
+      // returns true or a byte mask of 0xff for every character which ends the scan.
+
+      // '\r', '\n', '\0' and '\f', see core::IsLineEnd()
+      struct LineEnd
+      {
+         static bool Match(char c)
+         {
+            return (c == '\r' || c == '\n' || c == '\0' || c == '\f');
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_or_si128(
+               _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+               _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()), _mm_cmpeq_epi8(v, _mm_set1_epi8('\f'))));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_or_si256(
+               _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+               _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\f'))));
+         }
+#endif
+      };
+
+      // ' ' and '\t', see core::IsSpace()
+      struct Blank
+      {
+         static bool Match(char c)
+         {
+            return (c == ' ' || c == '\t');
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+         }
+#endif
+      };
+
+      // a single character
+      template <char C>
+      struct Char
+      {
+         static bool Match(char c)
+         {
+            return (c == C);
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_cmpeq_epi8(v, _mm_set1_epi8(C));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(C));
+         }
+#endif
+      };
+
+      // adds a single character to a class
+      template <class TClass, char C>
+      struct Or
+      {
+         static bool Match(char c)
+         {
+            return (c == C || TClass::Match(c));
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C)), TClass::Match(v));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C)), TClass::Match(v));
+         }
+#endif
+      };
+
+      // the union of two classes
+      template <class TClassA, class TClassB>
+      struct Union
+      {
+         static bool Match(char c)
+         {
+            return (TClassA::Match(c) || TClassB::Match(c));
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_or_si128(TClassA::Match(v), TClassB::Match(v));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_or_si256(TClassA::Match(v), TClassB::Match(v));
+         }
+#endif
+      };
+
+      // every character not in the class
+      template <class TClass>
+      struct Not
+      {
+         static bool Match(char c)
+         {
+            return !TClass::Match(c);
+         }
+#ifdef CHARSCAN_SSE2
+         static __m128i Match(__m128i v)
+         {
+            return _mm_xor_si128(TClass::Match(v), _mm_set1_epi8((char)0xff));
+         }
+#endif
+#ifdef CHARSCAN_AVX2
+         static __m256i Match(__m256i v)
+         {
+            return _mm256_xor_si256(TClass::Match(v), _mm256_set1_epi8((char)0xff));
+         }
+#endif
+      };
+
+      // see core::IsSpaceOrNewLine()
+      typedef Union<Blank, LineEnd> SpaceOrNewLine;
+
+      // Returns the first position in [it, end) holding a character of TClass, end if there is none.
+      template <class TClass>
+      inline const char *Find(const char *it, const char *end)
+      {
+#ifdef CHARSCAN_AVX2
+         while (end - it >= 32)
+         {
+            const __m256i block = _mm256_loadu_si256((const __m256i*)it);
+            const uint32 mask = (uint32)_mm256_movemask_epi8(TClass::Match(block));
+            if (mask != 0)
+               return it + core::bits::GetTrailingBit(mask);
+            it += 32;
+         }
+#endif
+#ifdef CHARSCAN_SSE2
+         while (end - it >= 16)
+         {
+            const __m128i block = _mm_loadu_si128((const __m128i*)it);
+            const uint32 mask = (uint32)_mm_movemask_epi8(TClass::Match(block));
+            if (mask != 0)
+               return it + core::bits::GetTrailingBit(mask);
+            it += 16;
+         }
+#endif
+         while (it != end && !TClass::Match(*it))
+            ++it;
+         return it;
+      }
+
+      template <class TClass>
+      inline char *Find(char *it, char *end)
+      {
+         return const_cast<char*>(Find<TClass>((const char*)it, (const char*)end));
+      }
+
+      // first line end
+      inline const char *FindLineEnd(const char *it, const char *end)
+      {
+         return Find<LineEnd>(it, end);
+      }
+
+      // first character which is neither ' ' nor '\t'
+      inline const char *SkipBlanks(const char *it, const char *end)
+      {
+         return Find< Not<Blank> >(it, end);
+      }
+
+      // first blank or line end, the end of a token
+      inline const char *FindSpaceOrNewLine(const char *it, const char *end)
+      {
+         return Find<SpaceOrNewLine>(it, end);
+      }
+
+      // first occurrence of C
+      template <char C>
+      inline const char *FindChar(const char *it, const char *end)
+      {
+         return Find< Char<C> >(it, end);
+      }
+
+   } // namespace charscan
+
+} // namespace core
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef _FASTFLOAT_HPP_INCLUDED_
+#define _FASTFLOAT_HPP_INCLUDED_
+
+// Correctly rounded string to float conversion for the text parsers. The numbers are read
+// in place, ranges don't need to be zero-terminated and no byte at or behind end is read.
+// Most numbers are converted exactly in float arithmetic (Clinger's fast path), the others
+// with a 128 bit multiplication by a power of five (Eisel-Lemire). The rare cases this
+// can't decide, numbers with more than 19 significant digits, go to strtof().
+
+#include "BasicTypes.hpp"
+
+namespace core
+{
+
+   namespace fastfloat
+   {
+      // Reads one number "[+-]digits[.digits][(e|E)[+-]digits]", "nan" or "inf[inity]" at it.
+      // Returns the iterator behind the number, it without touching value if there is none.
+      const char *ParseFloat(const char *it, const char *end, float &value);
+
+      // Reads up to numMax blank separated numbers, e.g. the "x y z" of a vertex, and stops at
+      // the end of the line. Characters behind a number up to the next blank are skipped like
+      // core::fast_atof() ignores them. numValues is the number of values read, the returned
+      // iterator points to the first token which is not a number or to the line end.
+      const char *ParseFloats(const char *it, const char *end, float *pValues, uint32 numMax, uint32 &numValues);
+
+   } // namespace fastfloat
+
+} // namespace core
+
+#endif
@@ -12,6 +12,7 @@ namespace core
 
       File::File()
       {
+         stream = NULL;
          isOpen = false;
       }
 
@@ -90,6 +91,20 @@ namespace core
          return fileSize;
       }
 
+      size_t File::Read(void *bufferOut, const size_t numBytes) const
+      {
+         assert(isOpen);
+
+         return fread(bufferOut, 1, numBytes, stream);
+      }
+
+      size_t File::Write(const void *pData, const size_t numBytes)
+      {
+         assert(isOpen && mode != FMODE_READ);
+
+         return fwrite(pData, 1, numBytes, stream);
+      }
+
       bool File::Seek(const uint32 finalPos, const bool relative) const
       {
          assert(isOpen);
@@ -104,6 +119,7 @@ namespace core
          if (stream)
             fclose(stream);
 
+         stream = NULL;
          isOpen = false;
       }
 
@@ -45,6 +45,11 @@ namespace core
          template <typename TCharType> bool CopyToBuffer(TCharType *bufferOut) const;
          template <typename TCharType> bool CopyToBuffer( vector<TCharType> &bufferOut) const;
          
+         // read up to numBytes at the file pointer, returns the number of bytes read (0 at the end of the file)
+         size_t Read(void *bufferOut, const size_t numBytes) const;
+         // write numBytes at the file pointer, returns the number of bytes written
+         size_t Write(const void *pData, const size_t numBytes);
+
          int32 GetPosition() const;
          int32 GetSize() const;
 
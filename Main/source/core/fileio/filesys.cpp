@@ -56,6 +56,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cctype>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
 //#ifdef __unix__
 //#include <sys/param.h>
 //#include <stdlib.h>
@@ -77,6 +86,22 @@ namespace core
          return true;
       }
 
+      bool GetFileStatus(const std::string &path, uint64 &size, uint64 &modifiedTime)
+      {
+#ifdef _WIN32
+         struct ::_stat64 status;
+         if (::_stat64(path.c_str(), &status) != 0)
+            return false;
+#else
+         struct ::stat status;
+         if (::stat(path.c_str(), &status) != 0)
+            return false;
+#endif
+         size = (uint64)status.st_size;
+         modifiedTime = (uint64)status.st_mtime;
+         return true;
+      }
+
       //File* FileSys::Open(const char* strFile, const char* strMode)
       //{
       //   assert(NULL != strFile);
@@ -220,6 +245,96 @@ namespace core
          return ret;
       }
 
+      bool MatchWildcard(const char *name, const char *pattern)
+      {
+         // position behind the last '*' and the name position it was tried with
+         const char *pStar = NULL;
+         const char *pRetry = NULL;
+         while ('\0' != *name)
+         {
+            if ('*' == *pattern)
+            {
+               pStar = ++pattern;
+               pRetry = name;
+            }
+            else if ('?' == *pattern || ::tolower((unsigned char)*pattern) == ::tolower((unsigned char)*name))
+            {
+               ++pattern;
+               ++name;
+            }
+            else if (NULL != pStar)
+            {
+               // let the last '*' take one more character
+               pattern = pStar;
+               name = ++pRetry;
+            }
+            else
+               return false;
+         }
+
+         while ('*' == *pattern)
+            ++pattern;
+         return '\0' == *pattern;
+      }
+
+      bool ListFiles(const std::string &directory, std::vector<std::string> &files,
+         const char *pattern, bool recursive)
+      {
+         std::string prefix = directory;
+         if (!prefix.empty() && prefix[prefix.size() - 1] != '/' && prefix[prefix.size() - 1] != '\\')
+            prefix += '/';
+
+         std::vector<std::string> subdirectories;
+#ifdef _WIN32
+         WIN32_FIND_DATAA data;
+         const HANDLE hFind = ::FindFirstFileA((prefix + "*").c_str(), &data);
+         if (INVALID_HANDLE_VALUE == hFind)
+            return false;
+
+         do
+         {
+            const char *name = data.cFileName;
+            if (0 == strcmp(name, ".") || 0 == strcmp(name, ".."))
+               continue;
+
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+               subdirectories.push_back(prefix + name);
+            else if (MatchWildcard(name, pattern))
+               files.push_back(prefix + name);
+         } while (::FindNextFileA(hFind, &data));
+         ::FindClose(hFind);
+#else
+         DIR *pDir = ::opendir(prefix.c_str());
+         if (NULL == pDir)
+            return false;
+
+         while (const struct ::dirent *pEntry = ::readdir(pDir))
+         {
+            const char *name = pEntry->d_name;
+            if (0 == strcmp(name, ".") || 0 == strcmp(name, ".."))
+               continue;
+
+            struct ::stat status;
+            const std::string path = prefix + name;
+            if (::stat(path.c_str(), &status) != 0)
+               continue;
+
+            if (S_ISDIR(status.st_mode))
+               subdirectories.push_back(path);
+            else if (MatchWildcard(name, pattern))
+               files.push_back(path);
+         }
+         ::closedir(pDir);
+#endif
+
+         if (recursive)
+         {
+            for (size_t i = 0; i < subdirectories.size(); i++)
+               ListFiles(subdirectories[i], files, pattern, true);
+         }
+         return true;
+      }
+
       //bool SearchFileHeaderForToken(File* pFile,
       //   const std::string &pFileName,
       //   const char** tokens,
@@ -44,12 +44,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "file.hpp"
 using core::fileio::File;
 
+#include <string>
+#include <vector>
+
 namespace core
 {
 
    namespace filesys
    {
       bool Exists(const char* pFile);
+
+      // size in bytes and time of the last modification (seconds since 1970) of a file,
+      // false if the file doesn't exist
+      bool GetFileStatus(const std::string &path, uint64 &size, uint64 &modifiedTime);
       //char GetDirectorySeparator() const; // OS specific
       //File* Open(const char* pFile, const char* pMode = "rb");
       //void Close(File* pFile);
@@ -73,6 +80,15 @@ namespace core
          const char* ext2 = NULL);
 
       std::string GetExtension(const std::string &path);
+
+      // Appends the paths of the files in a directory whose names match pattern to files, with
+      // recursive also those in its subdirectories. Returns false if the directory can't be read.
+      bool ListFiles(const std::string &directory, std::vector<std::string> &files,
+         const char *pattern = "*", bool recursive = false);
+
+      // Matches a file name against a pattern with the wildcards '*' (any sequence) and '?'
+      // (any character), case insensitive. Example: MatchWildcard("Crate.OBJ", "*.obj") is true
+      bool MatchWildcard(const char *name, const char *pattern);
    } // namespace filesys
 
 } // namespace core
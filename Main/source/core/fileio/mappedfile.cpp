@@ -0,0 +1,90 @@
+#include "core/fileio/mappedfile.hpp"
+
+#include <Windows.h>
+
+#include <cassert>
+
+namespace core
+{
+
+   namespace fileio
+   {
+
+      MappedFile::MappedFile() :
+         fileHandle(INVALID_HANDLE_VALUE),
+         mappingHandle(NULL),
+         data(NULL),
+         fileSize(0),
+         isOpen(false),
+         isCopyOnWrite(false)
+      {
+      }
+
+      bool MappedFile::Open(const std::string &path, bool copyOnWrite)
+      {
+         if (isOpen)
+            Close();
+
+         this->path = path;
+
+         fileHandle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+         if (fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+         LARGE_INTEGER size;
+         if (!::GetFileSizeEx(fileHandle, &size) || (uint64)size.QuadPart > (uint64)(size_t)-1)
+         {
+            Close();
+            return false;
+         }
+         fileSize = (size_t)size.QuadPart;
+
+         // a zero-length file cannot be mapped, but it is a valid (empty) file
+         if (fileSize > 0)
+         {
+            mappingHandle = ::CreateFileMappingA(fileHandle, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+            if (mappingHandle == NULL)
+            {
+               Close();
+               return false;
+            }
+
+            data = (const char*)::MapViewOfFile(mappingHandle, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+            if (data == NULL)
+            {
+               Close();
+               return false;
+            }
+         }
+
+         isCopyOnWrite = copyOnWrite;
+         isOpen = true;
+         return true;
+      }
+
+      void MappedFile::Close()
+      {
+         if (data)
+            ::UnmapViewOfFile(data);
+         if (mappingHandle)
+            ::CloseHandle(mappingHandle);
+         if (fileHandle != INVALID_HANDLE_VALUE)
+            ::CloseHandle(fileHandle);
+
+         data = NULL;
+         mappingHandle = NULL;
+         fileHandle = INVALID_HANDLE_VALUE;
+         fileSize = 0;
+         isOpen = false;
+         isCopyOnWrite = false;
+      }
+
+      MappedFile::~MappedFile()
+      {
+         Close();
+      }
+
+   } // namespace fileio
+
+} // namespace core
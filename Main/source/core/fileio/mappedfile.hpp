@@ -0,0 +1,53 @@
+#ifndef _MAPPEDFILE_HPP_INCLUDED_
+#define _MAPPEDFILE_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include <string>
+#include <cassert>
+
+namespace core
+{
+
+   namespace fileio
+   {
+
+      // read-only view of a whole file mapped into the address space. The data is not
+      // zero-terminated, parsers working on it have to respect GetSize()
+      class MappedFile
+      {
+      protected:
+         void *fileHandle;
+         void *mappingHandle;
+         const char *data;
+         std::string path;
+         size_t fileSize;
+         bool isOpen;
+         bool isCopyOnWrite;
+      private:
+         // no copying allowed, the view belongs to exactly one object
+         MappedFile(const MappedFile &);
+         MappedFile &operator=(const MappedFile &);
+      public:
+         MappedFile();
+         virtual ~MappedFile(void);
+         // a copy-on-write view may be modified through GetWritableData(), the changes
+         // are private to the view and never written back to the file
+         bool Open(const std::string &path, bool copyOnWrite = false);
+         bool IsOpen() const { return isOpen; }
+         std::string GetFilePath() const { return path; }
+         void Close();
+
+         // first byte of the mapped view, NULL for empty files
+         const char *GetData() const { return data; }
+         char *GetWritableData() const { assert(isCopyOnWrite); return const_cast<char*>(data); }
+         // one past the last byte of the mapped view
+         const char *GetEnd() const { return data + fileSize; }
+         size_t GetSize() const { return fileSize; }
+      };
+
+   } // namespace fileio
+
+} // namespace core
+
+#endif
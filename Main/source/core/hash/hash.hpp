@@ -117,6 +117,19 @@ namespace core
       return hash;
    }
 
+   // 64 bit FNV-1a, slower than SuperFastHash() but with much fewer collisions, used to
+   // fingerprint whole files. Pass the previous result as hash to continue a hash.
+   inline uint64 Fnv1a64(const void *data, size_t len, uint64 hash = 14695981039346656037ULL)
+   {
+      const uint8 *p = (const uint8*)data;
+      for (size_t i = 0; i < len; i++)
+      {
+         hash ^= p[i];
+         hash *= 1099511628211ULL;
+      }
+      return hash;
+   }
+
 } // namespace core
 
 #endif
\ No newline at end of file
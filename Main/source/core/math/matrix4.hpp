@@ -133,7 +133,7 @@ namespace core
       inline void Matrix4<T>::SetIdentity()
       {
          m[0][1] = m[0][2] = m[0][3] = m[1][0] = m[1][2] = m[1][3] =
-             m[2][0] = m[2][1] = m[2][3] = (T)0;
+             m[2][0] = m[2][1] = m[2][3] = m[3][0] = m[3][1] = m[3][2] = (T)0;
 
          m[0][0] = m[1][1] = m[2][2] = m[3][3] = (T)1;
       }
@@ -0,0 +1,169 @@
+#include "core/thread/threadpool.hpp"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include <cassert>
+
+namespace core
+{
+
+   namespace thread
+   {
+
+      ThreadPool::ThreadPool(uint32 numThreads) :
+         stop(false)
+      {
+         if (numThreads == 0)
+            numThreads = std::thread::hardware_concurrency();
+         if (numThreads == 0)
+            numThreads = 1;
+
+         workers.reserve(numThreads);
+         for (uint32 i = 0; i < numThreads; i++)
+            workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+      }
+
+      ThreadPool::~ThreadPool()
+      {
+         {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            stop = true;
+         }
+         queueCondition.notify_all();
+
+         for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+      }
+
+      void ThreadPool::Enqueue(const Task_t &task)
+      {
+         {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            assert(!stop);
+            tasks.push_back(task);
+         }
+         queueCondition.notify_one();
+      }
+
+      void ThreadPool::WorkerLoop()
+      {
+         for (;;)
+         {
+            Task_t task;
+            {
+               std::unique_lock<std::mutex> lock(queueMutex);
+               while (!stop && tasks.empty())
+                  queueCondition.wait(lock);
+
+               if (tasks.empty())
+                  return;
+
+               task.swap(tasks.front());
+               tasks.pop_front();
+            }
+
+            try
+            {
+               task();
+            }
+            catch (...)
+            {
+               // an exception leaving the thread function would terminate the process
+               assert(!"ThreadPool: unhandled exception in task");
+            }
+         }
+      }
+
+      // shared between the caller of ParallelFor() and the helper tasks, a helper
+      // may start after the caller has already returned
+      struct ParallelForState
+      {
+         std::function<void(uint32)> func;
+         uint32 count;
+         std::atomic<uint32> next;
+         std::atomic<bool> failed;
+
+         std::mutex mutex;
+         std::condition_variable finished;
+         uint32 numDone;
+         std::exception_ptr error;
+
+         ParallelForState(uint32 count, const std::function<void(uint32)> &func) :
+            func(func),
+            count(count),
+            next(0),
+            failed(false),
+            numDone(0)
+         {
+         }
+      };
+
+      static void RunParallelForItems(ParallelForState &state)
+      {
+         uint32 numDone = 0;
+         for (;;)
+         {
+            const uint32 i = state.next++;
+            if (i >= state.count)
+               break;
+
+            if (!state.failed)
+            {
+               try
+               {
+                  state.func(i);
+               }
+               catch (...)
+               {
+                  std::unique_lock<std::mutex> lock(state.mutex);
+                  if (!state.error)
+                     state.error = std::current_exception();
+                  state.failed = true;
+               }
+            }
+            numDone++;
+         }
+
+         if (numDone > 0)
+         {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.numDone += numDone;
+            if (state.numDone == state.count)
+               state.finished.notify_all();
+         }
+      }
+
+      void ParallelFor(ThreadPool &pool, uint32 count, const std::function<void(uint32)> &func)
+      {
+         if (count == 0)
+            return;
+
+         if (count == 1)
+         {
+            func(0);
+            return;
+         }
+
+         std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, func);
+
+         const uint32 numHelpers = (count - 1 < pool.GetNumThreads()) ? count - 1 : pool.GetNumThreads();
+         for (uint32 i = 0; i < numHelpers; i++)
+            pool.Enqueue([state]() { RunParallelForItems(*state); });
+
+         // every item is either done or being worked on by a running thread once
+         // this returns, so waiting below can't block on a queued helper
+         RunParallelForItems(*state);
+
+         std::unique_lock<std::mutex> lock(state->mutex);
+         while (state->numDone != state->count)
+            state->finished.wait(lock);
+
+         if (state->error)
+            std::rethrow_exception(state->error);
+      }
+
+   } // namespace thread
+
+} // namespace core
@@ -0,0 +1,56 @@
+#ifndef _THREADPOOL_HPP_INCLUDED_
+#define _THREADPOOL_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core
+{
+
+   namespace thread
+   {
+
+      // fixed set of worker threads processing a FIFO task queue
+      class ThreadPool
+      {
+      public:
+         typedef std::function<void()> Task_t;
+      protected:
+         std::vector<std::thread> workers;
+         std::deque<Task_t> tasks;
+         std::mutex queueMutex;
+         std::condition_variable queueCondition;
+         bool stop;
+      private:
+         // no copying allowed, the threads belong to exactly one pool
+         ThreadPool(const ThreadPool &);
+         ThreadPool &operator=(const ThreadPool &);
+
+         void WorkerLoop();
+      public:
+         // numThreads == 0 starts one thread per hardware thread
+         explicit ThreadPool(uint32 numThreads = 0);
+         // finishes all queued tasks before the threads are joined
+         virtual ~ThreadPool(void);
+
+         // tasks have to handle their own errors, see ParallelFor() for a way to get them back
+         void Enqueue(const Task_t &task);
+         uint32 GetNumThreads() const { return (uint32)workers.size(); }
+      };
+
+      // calls func(i) for every i in [0, count) and returns when all calls are done. The calling
+      // thread takes part in the work, so it is safe to call this from inside a pool task. The
+      // first exception thrown by func is rethrown to the caller, remaining calls are skipped
+      void ParallelFor(ThreadPool &pool, uint32 count, const std::function<void(uint32)> &func);
+
+   } // namespace thread
+
+} // namespace core
+
+#endif
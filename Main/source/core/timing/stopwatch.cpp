@@ -0,0 +1,42 @@
+#include "core/timing/stopwatch.hpp"
+
+#include <Windows.h>
+
+namespace core
+{
+
+   namespace timing
+   {
+
+      // the counter frequency is fixed at boot, so it is queried once
+      static double GetMilliSecsPerTick()
+      {
+         LARGE_INTEGER frequency;
+         ::QueryPerformanceFrequency(&frequency);
+         return 1000.0 / (double)frequency.QuadPart;
+      }
+
+      static const double MILLISECS_PER_TICK = GetMilliSecsPerTick();
+
+      Stopwatch::Stopwatch()
+      {
+         Restart();
+      }
+
+      void Stopwatch::Restart()
+      {
+         LARGE_INTEGER ticks;
+         ::QueryPerformanceCounter(&ticks);
+         startTicks = ticks.QuadPart;
+      }
+
+      double Stopwatch::GetMilliSecs() const
+      {
+         LARGE_INTEGER ticks;
+         ::QueryPerformanceCounter(&ticks);
+         return (double)(ticks.QuadPart - startTicks) * MILLISECS_PER_TICK;
+      }
+
+   } // namespace timing
+
+} // namespace core
@@ -0,0 +1,32 @@
+#ifndef _STOPWATCH_HPP_INCLUDED_
+#define _STOPWATCH_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+namespace core
+{
+
+   namespace timing
+   {
+
+      // measures elapsed wall time with the performance counter
+      class Stopwatch
+      {
+      private:
+         int64 startTicks;
+
+      public:
+         // starts running
+         Stopwatch();
+
+         void Restart();
+
+         // time since the construction or the last Restart()
+         double GetMilliSecs() const;
+      };
+
+   } // namespace timing
+
+} // namespace core
+
+#endif
@@ -1,9 +1,74 @@
-
 #include "oglbuffer.hpp"
 
+#include <cassert>
+
+using namespace gfx::vertexpacking;
+
 namespace oglbuffer
 {
-   void generateBufferFromScene(const scene::Scene *sc, GLSLShader &shader, uint32 &vaoID, uint32 &vboIndicesID)
+   // appends the 32 bit indices in the size of the index buffer, Mesh::GetIndexSize()
+   // picked TIndex so that every vertex index fits
+   template <typename TIndex>
+   static void appendIndices(const uint32 *pIndices, uint32 numIndices, std::vector<TIndex> &indices)
+   {
+      for (uint32 i = 0; i < numIndices; ++i)
+      {
+         assert(pIndices[i] == static_cast<TIndex>(pIndices[i]));
+         indices.push_back(static_cast<TIndex>(pIndices[i]));
+      }
+   }
+
+   // Copies the triangles of a mesh into one array, points, lines and polygons can't be
+   // drawn as triangles and are left out
+   template <typename TIndex>
+   static void gatherTriangles(const Mesh *mesh, std::vector<TIndex> &indices)
+   {
+      indices.clear();
+      if (mesh->HasTriangleIndexBuffer())
+      {
+         indices.reserve(mesh->m_numIndices);
+         appendIndices(mesh->m_pIndices, mesh->m_numIndices, indices);
+         return;
+      }
+
+      indices.reserve(mesh->GetNumTriangles() * 3);
+      for (uint32 t = 0; t < mesh->m_numFaces; ++t)
+      {
+         const Face* face = &mesh->m_pFaces[t];
+         if (face->m_numIndices != 3)
+            continue;
+
+         appendIndices(face->m_pIndexArray, 3, indices);
+      }
+   }
+
+   static GLenum getComponentType(eComponentType type)
+   {
+      switch (type)
+      {
+      case COMPONENT_HALF: return GL_HALF_FLOAT;
+      case COMPONENT_UNORM16: return GL_UNSIGNED_SHORT;
+      case COMPONENT_SNORM16: return GL_SHORT;
+      default: return GL_FLOAT;
+      }
+   }
+
+   // points a shader attribute at its place in the packed vertices, attributes the shader
+   // doesn't use are left out
+   static void setAttributePointer(GLSLShader &shader, const char *name, const VertexLayout &layout, eAttribute attribute)
+   {
+      if (!layout.HasAttribute(attribute) || !shader.HasAttribute(name))
+         return;
+
+      const VertexAttribute &a = layout.m_attributes[attribute];
+      const GLboolean normalized = (a.m_type == COMPONENT_UNORM16 || a.m_type == COMPONENT_SNORM16) ? GL_TRUE : GL_FALSE;
+      glEnableVertexAttribArray(shader[name]);
+      glVertexAttribPointer(shader[name], a.m_numComponents, getComponentType(a.m_type), normalized, layout.m_stride,
+         (GLvoid*)(size_t)a.m_offset);
+   }
+
+   void generateBufferFromScene(const scene::Scene *sc, GLSLShader &shader, uint32 &vaoID, uint32 &vboIndicesID,
+      std::vector<MeshDrawInfo> &drawInfos, const VertexFormat &format)
    {
       //vertex array and vertex buffer object IDs
       vaoID = 0;
@@ -11,6 +76,20 @@ namespace oglbuffer
       uint32 iboOffset = 0, vboOffset = 0;
       uint32 vertsSize, idxSize;
       sc->GetSceneByteSize(vertsSize, idxSize);
+      drawInfos.assign(sc->m_numMeshes, MeshDrawInfo());
+
+      // one layout for all meshes so they can share the attribute pointers
+      bool normals = false, tangents = false, texCoords = false;
+      uint32 numVertices = 0;
+      for (uint32 n = 0; n < sc->m_numMeshes; ++n)
+      {
+         normals = normals || sc->m_ppMeshes[n]->HasNormals();
+         tangents = tangents || sc->m_ppMeshes[n]->HasTangentsAndBitangents();
+         texCoords = texCoords || sc->m_ppMeshes[n]->HasTextureCoords(0);
+         numVertices += sc->m_ppMeshes[n]->m_numVertices;
+      }
+      const VertexLayout layout(format, normals, tangents, texCoords);
+      vertsSize = numVertices * layout.m_stride;
 
       glGenVertexArrays(1, &vaoID);
       glBindVertexArray(vaoID);
@@ -21,53 +100,76 @@ namespace oglbuffer
       glGenBuffers(1, &vboIndicesID);
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndicesID);
       glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxSize, NULL, GL_STATIC_DRAW);
+
+      // the vertices of all meshes lie one after the other, the draw calls of a mesh
+      // start at its first vertex with MeshDrawInfo::m_baseVertex
+      setAttributePointer(shader, "vVertex", layout, ATTRIBUTE_POSITION);
+      setAttributePointer(shader, "vNormal", layout, ATTRIBUTE_NORMAL);
+      setAttributePointer(shader, "vTangent", layout, ATTRIBUTE_TANGENT);
+      setAttributePointer(shader, "vUV", layout, ATTRIBUTE_TEXCOORD);
+
+      std::vector<uint8> vertices;
+      std::vector<uint16> shortIndices;
+      std::vector<uint32> indices;
       // For each mesh
       for (uint32 n = 0; n < sc->m_numMeshes; ++n)
       {
          const Mesh* mesh = sc->m_ppMeshes[n];
+         MeshDrawInfo &info = drawInfos[n];
+         info.m_baseVertex = (int32)(vboOffset / layout.m_stride);
 
-         // create array with faces
-         // have to convert from Assimp format to array
-         uint32 *faceArray;
-         faceArray = (uint32 *)malloc(sizeof(uint32) * mesh->m_numFaces * 3);
-         uint32 faceIndex = 0;
-
-         for (uint32 t = 0; t < mesh->m_numFaces; ++t)
+         // the same layout as scene::Scene::GetSceneByteSize(), a range starts at a multiple of its index size
+         if (mesh->HasFaces())
          {
-            const Face* face = &mesh->m_pFaces[t];
+            const uint32 indexSize = mesh->GetIndexSize();
+            iboOffset = (iboOffset + indexSize - 1) / indexSize * indexSize;
+            info.m_indexOffset = iboOffset;
+            info.m_numIndices = mesh->GetNumTriangles() * 3;
 
-            memcpy(&faceArray[faceIndex], face->m_pIndexArray, 3 * sizeof(uint32));
-            faceIndex += 3;
+            if (indexSize == sizeof(uint16))
+            {
+               info.m_indexType = GL_UNSIGNED_SHORT;
+               gatherTriangles(mesh, shortIndices);
+               if (!shortIndices.empty())
+                  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboOffset, sizeof(uint16) * info.m_numIndices, &shortIndices[0]);
+            }
+            else if (mesh->HasTriangleIndexBuffer())
+            {
+               // triangulated meshes bring their indices in one block
+               info.m_indexType = GL_UNSIGNED_INT;
+               glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboOffset, sizeof(uint32) * info.m_numIndices, mesh->m_pIndices);
+            }
+            else
+            {
+               info.m_indexType = GL_UNSIGNED_INT;
+               gatherTriangles(mesh, indices);
+               if (!indices.empty())
+                  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboOffset, sizeof(uint32) * info.m_numIndices, &indices[0]);
+            }
+            iboOffset += indexSize * info.m_numIndices;
          }
 
-         // buffer for faces
-        
-         glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboOffset, sizeof(uint32) * mesh->m_numFaces * 3, faceArray);
-         iboOffset += sizeof(uint32) * mesh->m_numFaces * 3;
-         // buffer for vertex positions
-
-         if (mesh->HasPositions())
+         // the packed vertices of the mesh
+         if (mesh->m_numVertices > 0)
          {
-            glEnableVertexAttribArray(shader["vVertex"]);
-            glVertexAttribPointer(shader["vVertex"], 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (GLvoid*)0);
-            glBufferSubData(GL_ARRAY_BUFFER, vboOffset, sizeof(float) * 3 * mesh->m_numVertices, mesh->m_pVertices);
-            vboOffset += sizeof(Vector3f) * mesh->m_numVertices ;
+            vertices.resize(mesh->m_numVertices * layout.m_stride);
+            info.m_bounds = PackVertices(mesh, layout, &vertices[0]);
+            glBufferSubData(GL_ARRAY_BUFFER, vboOffset, vertices.size(), &vertices[0]);
+            vboOffset += (uint32)vertices.size();
          }
-
-         // buffer for vertex normals
-         //if (mesh->HasNormals())
-         //{       
-         //   glEnableVertexAttribArray(shader["vNormal"]);
-         //   glVertexAttribPointer(shader["vNormal"], 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3,(GLvoid*)12);
-         //   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * mesh->m_numFaces, mesh->m_pNormals, GL_STATIC_DRAW);
-
-         //}
-         // unbind buffers
-         
-         free(faceArray);
       }
+      // the index buffer stays bound to the vertex array object
+      glBindVertexArray(0);
       glBindBuffer(GL_ARRAY_BUFFER, 0);
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
    }
-}
\ No newline at end of file
+
+   void drawMesh(const MeshDrawInfo &info)
+   {
+      if (info.m_numIndices == 0)
+         return;
+
+      glDrawElementsBaseVertex(GL_TRIANGLES, info.m_numIndices, info.m_indexType, (GLvoid*)(size_t)info.m_indexOffset,
+         info.m_baseVertex);
+   }
+}
@@ -11,6 +11,11 @@ using scene::Scene;
 using oglshader::GLSLShader;
 
 #include "core/basicTypes.hpp"
+
+#include "vertexpacking.hpp"
+
+#include <vector>
+
 namespace oglbuffer
 {
 
@@ -27,8 +32,30 @@ namespace oglbuffer
          m_texcoord = texcoord;
       }
    };
- 
-   void generateBufferFromScene(const scene::Scene *sc, GLSLShader &shader, uint32 &vaoID, uint32 &vboIndicesID);
+
+   // where the triangles of one mesh are in the buffers of generateBufferFromScene()
+   struct MeshDrawInfo
+   {
+      uint32 m_indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, see mesh2::Mesh::GetIndexSize()
+      uint32 m_indexOffset; // in bytes
+      uint32 m_numIndices;
+      int32 m_baseVertex; // the first vertex of the mesh in the vertex buffer
+      gfx::vertexpacking::PackedBounds m_bounds; // the shader unpacks the positions with it
+
+      MeshDrawInfo() : m_indexType(0), m_indexOffset(0), m_numIndices(0), m_baseVertex(0) { }
+   };
+
+   // Uploads the vertices and triangles of all meshes, drawInfos gets one entry per mesh.
+   // The indices of a mesh are 16 bit if its vertices allow it. All vertices are packed in
+   // one interleaved layout with the attributes any mesh has, see gfx::vertexpacking, and
+   // bound to the shader attributes vVertex, vNormal, vTangent and vUV which it registered.
+   // The default format needs no decoding, the quantized formats need a shader for them.
+   void generateBufferFromScene(const scene::Scene *sc, GLSLShader &shader, uint32 &vaoID, uint32 &vboIndicesID,
+      std::vector<MeshDrawInfo> &drawInfos,
+      const gfx::vertexpacking::VertexFormat &format = gfx::vertexpacking::VertexFormat());
+
+   // draws the triangles of one mesh, the vertex array object of the scene has to be bound
+   void drawMesh(const MeshDrawInfo &info);
 
 } // namespace oglbuffer
 
@@ -0,0 +1,331 @@
+#include "vertexpacking.hpp"
+
+#include "core/math/mathcommon.hpp"
+using core::math::FloatIntUnion32;
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace gfx
+{
+
+   namespace vertexpacking
+   {
+
+      static void SetAttribute(VertexAttribute &attribute, eComponentType type, uint32 numComponents, uint32 &stride)
+      {
+         attribute.m_type = type;
+         attribute.m_numComponents = numComponents;
+         attribute.m_offset = stride;
+         // keeps the next attribute aligned to 4 bytes
+         stride += (GetComponentSize(type) * numComponents + 3) & ~3u;
+      }
+
+      VertexLayout::VertexLayout(const VertexFormat &format, bool normals, bool tangents, bool texCoords)
+         : m_format(format)
+         , m_stride(0)
+      {
+         memset(m_attributes, 0, sizeof(m_attributes));
+         // tangents come with normals only, the handedness needs both
+         tangents = tangents && normals;
+
+         // 16 bit positions are padded to 4 components anyway, the fourth one holds the handedness
+         switch (format.m_position)
+         {
+         case POSITION_FLOAT: SetAttribute(m_attributes[ATTRIBUTE_POSITION], COMPONENT_FLOAT, tangents ? 4 : 3, m_stride); break;
+         case POSITION_HALF: SetAttribute(m_attributes[ATTRIBUTE_POSITION], COMPONENT_HALF, 4, m_stride); break;
+         case POSITION_UNORM16: SetAttribute(m_attributes[ATTRIBUTE_POSITION], COMPONENT_UNORM16, 4, m_stride); break;
+         }
+
+         const eComponentType directionType = format.m_direction == DIRECTION_OCT16 ? COMPONENT_SNORM16 : COMPONENT_FLOAT;
+         const uint32 directionComponents = format.m_direction == DIRECTION_OCT16 ? 2 : 3;
+         if (normals)
+            SetAttribute(m_attributes[ATTRIBUTE_NORMAL], directionType, directionComponents, m_stride);
+         if (tangents)
+            SetAttribute(m_attributes[ATTRIBUTE_TANGENT], directionType, directionComponents, m_stride);
+
+         if (texCoords)
+            SetAttribute(m_attributes[ATTRIBUTE_TEXCOORD], format.m_texCoord == TEXCOORD_HALF ? COMPONENT_HALF : COMPONENT_FLOAT, 2, m_stride);
+      }
+
+      uint32 GetComponentSize(eComponentType type)
+      {
+         return type == COMPONENT_FLOAT ? sizeof(float) : sizeof(uint16);
+      }
+
+      uint16 FloatToHalf(float value)
+      {
+         const FloatIntUnion32 bits(value);
+         const uint32 sign = (bits.i >> 16) & 0x8000;
+         const uint32 magnitude = bits.i & 0x7fffffff;
+
+         // infinity and NaN
+         if (magnitude >= 0x7f800000)
+            return (uint16)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+         // rounds to more than 65504
+         if (magnitude >= 0x477ff000)
+            return (uint16)(sign | 0x7c00);
+
+         uint32 half, remainder, halfway;
+         if (magnitude < 0x38800000)
+         {
+            // denormal, anything below 2^-25 rounds to zero
+            if (magnitude < 0x33000000)
+               return (uint16)sign;
+            const uint32 shift = 126 - (magnitude >> 23);
+            const uint32 mantissa = (magnitude & 0x7fffff) | 0x800000;
+            half = mantissa >> shift;
+            remainder = mantissa & ((1u << shift) - 1);
+            halfway = 1u << (shift - 1);
+         }
+         else
+         {
+            // rebias the exponent from 127 to 15, a carry of the rounding ends up in the exponent
+            half = (magnitude - 0x38000000) >> 13;
+            remainder = magnitude & 0x1fff;
+            halfway = 0x1000;
+         }
+
+         if (remainder > halfway || (remainder == halfway && (half & 1)))
+            ++half;
+         return (uint16)(sign | half);
+      }
+
+      float HalfToFloat(uint16 value)
+      {
+         const uint32 exponent = (value >> 10) & 0x1f;
+         const uint32 mantissa = value & 0x3ff;
+
+         FloatIntUnion32 bits;
+         if (exponent == 0)
+         {
+            bits.f = mantissa * (1.0f / 16777216.0f);
+            bits.i |= (uint32)(value & 0x8000) << 16;
+         }
+         else if (exponent == 31)
+            bits.i = ((uint32)(value & 0x8000) << 16) | 0x7f800000 | (mantissa << 13);
+         else
+            bits.i = ((uint32)(value & 0x8000) << 16) | ((exponent + 112) << 23) | (mantissa << 13);
+         return bits.f;
+      }
+
+      static inline float UnpackSnorm16(int16 value)
+      {
+         // the GL maps -32768 and -32767 both to -1
+         return std::max<float>(value / 32767.0f, -1.0f);
+      }
+
+      Vector3f OctDecode(int16 x, int16 y)
+      {
+         float u = UnpackSnorm16(x);
+         float v = UnpackSnorm16(y);
+         const float z = 1.0f - fabsf(u) - fabsf(v);
+         // folds the lower hemisphere back
+         const float t = std::max<float>(-z, 0.0f);
+         u += u >= 0.0f ? -t : t;
+         v += v >= 0.0f ? -t : t;
+
+         const float length = sqrtf(u * u + v * v + z * z);
+         return Vector3f(u / length, v / length, z / length);
+      }
+
+      void OctEncode(const Vector3f &direction, int16 &x, int16 &y)
+      {
+         const float l1 = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+         // undefined directions (zero or NaN) become +z
+         if (!(l1 > 0.0f))
+         {
+            x = y = 0;
+            return;
+         }
+
+         float u = direction.x / l1;
+         float v = direction.y / l1;
+         if (direction.z < 0.0f)
+         {
+            const float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+            v = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+            u = foldedU;
+         }
+
+         // rounding both coordinates on their own isn't always the closest direction,
+         // the four neighbouring grid points are tried
+         const float baseU = floorf(core::math::Clamp(u, -1.0f, 1.0f) * 32767.0f);
+         const float baseV = floorf(core::math::Clamp(v, -1.0f, 1.0f) * 32767.0f);
+         // the dot products differ in the last bits of a float, they are compared in double
+         double bestDot = -2.0;
+         for (uint32 i = 0; i < 4; ++i)
+         {
+            const int16 candidateX = (int16)core::math::Clamp(baseU + (i & 1), -32767.0f, 32767.0f);
+            const int16 candidateY = (int16)core::math::Clamp(baseV + (i >> 1), -32767.0f, 32767.0f);
+            const Vector3f decoded = OctDecode(candidateX, candidateY);
+            const double dot = (double)decoded.x * direction.x + (double)decoded.y * direction.y + (double)decoded.z * direction.z;
+            if (dot > bestDot)
+            {
+               bestDot = dot;
+               x = candidateX;
+               y = candidateY;
+            }
+         }
+      }
+
+      // writes the first numValues of values in the type, the rest of the components is zero
+      static void WriteComponents(const VertexAttribute &attribute, const float *pValues, uint32 numValues, uint8 *pVertex)
+      {
+         uint8 *pDest = pVertex + attribute.m_offset;
+         for (uint32 c = 0; c < attribute.m_numComponents; ++c)
+         {
+            const float value = c < numValues ? pValues[c] : 0.0f;
+            uint16 packed;
+            switch (attribute.m_type)
+            {
+            case COMPONENT_FLOAT:
+               memcpy(pDest + c * sizeof(float), &value, sizeof(float));
+               continue;
+            case COMPONENT_HALF:
+               packed = FloatToHalf(value);
+               break;
+            case COMPONENT_UNORM16:
+               packed = (uint16)(core::math::Clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+               break;
+            default:
+               packed = (uint16)(int16)floorf(core::math::Clamp(value, -1.0f, 1.0f) * 32767.0f + 0.5f);
+               break;
+            }
+            memcpy(pDest + c * sizeof(uint16), &packed, sizeof(uint16));
+         }
+      }
+
+      static void ReadComponents(const VertexAttribute &attribute, const uint8 *pVertex, float *pValues)
+      {
+         const uint8 *pSource = pVertex + attribute.m_offset;
+         for (uint32 c = 0; c < attribute.m_numComponents; ++c)
+         {
+            if (attribute.m_type == COMPONENT_FLOAT)
+            {
+               memcpy(&pValues[c], pSource + c * sizeof(float), sizeof(float));
+               continue;
+            }
+
+            uint16 packed;
+            memcpy(&packed, pSource + c * sizeof(uint16), sizeof(uint16));
+            switch (attribute.m_type)
+            {
+            case COMPONENT_HALF: pValues[c] = HalfToFloat(packed); break;
+            case COMPONENT_UNORM16: pValues[c] = packed / 65535.0f; break;
+            default: pValues[c] = UnpackSnorm16((int16)packed); break;
+            }
+         }
+      }
+
+      static void WriteDirection(const VertexLayout &layout, const VertexAttribute &attribute, const Vector3f &direction,
+         uint8 *pVertex)
+      {
+         if (layout.m_format.m_direction == DIRECTION_OCT16)
+         {
+            int16 packed[2];
+            OctEncode(direction, packed[0], packed[1]);
+            memcpy(pVertex + attribute.m_offset, packed, sizeof(packed));
+         }
+         else
+            WriteComponents(attribute, &direction.x, 3, pVertex);
+      }
+
+      static Vector3f ReadDirection(const VertexLayout &layout, const VertexAttribute &attribute, const uint8 *pVertex)
+      {
+         if (layout.m_format.m_direction == DIRECTION_OCT16)
+         {
+            int16 packed[2];
+            memcpy(packed, pVertex + attribute.m_offset, sizeof(packed));
+            return OctDecode(packed[0], packed[1]);
+         }
+
+         float values[3];
+         ReadComponents(attribute, pVertex, values);
+         return Vector3f(values[0], values[1], values[2]);
+      }
+
+      PackedBounds PackVertices(const mesh2::Mesh *pMesh, const VertexLayout &layout, uint8 *pDest)
+      {
+         memset(pDest, 0, (size_t)pMesh->m_numVertices * layout.m_stride);
+
+         PackedBounds bounds;
+         if (layout.m_format.m_position == POSITION_UNORM16 && pMesh->HasPositions() && pMesh->m_numVertices > 0)
+         {
+            Vector3f minimum = pMesh->m_pVertices[0], maximum = pMesh->m_pVertices[0];
+            for (uint32 v = 1; v < pMesh->m_numVertices; ++v)
+            {
+               const Vector3f &p = pMesh->m_pVertices[v];
+               minimum = Vector3f(std::min<float>(minimum.x, p.x), std::min<float>(minimum.y, p.y), std::min<float>(minimum.z, p.z));
+               maximum = Vector3f(std::max<float>(maximum.x, p.x), std::max<float>(maximum.y, p.y), std::max<float>(maximum.z, p.z));
+            }
+            bounds.m_offset = minimum;
+            bounds.m_scale = Vector3f(maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z);
+         }
+
+         const VertexAttribute &position = layout.m_attributes[ATTRIBUTE_POSITION];
+         const VertexAttribute &normal = layout.m_attributes[ATTRIBUTE_NORMAL];
+         const VertexAttribute &tangent = layout.m_attributes[ATTRIBUTE_TANGENT];
+         const VertexAttribute &texCoord = layout.m_attributes[ATTRIBUTE_TEXCOORD];
+         const bool hasTangents = layout.HasAttribute(ATTRIBUTE_TANGENT) && pMesh->HasTangentsAndBitangents() && pMesh->HasNormals();
+
+         for (uint32 v = 0; v < pMesh->m_numVertices; ++v)
+         {
+            uint8 *pVertex = pDest + (size_t)v * layout.m_stride;
+
+            float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            if (pMesh->HasPositions())
+            {
+               const Vector3f &p = pMesh->m_pVertices[v];
+               values[0] = bounds.m_scale.x != 0.0f ? (p.x - bounds.m_offset.x) / bounds.m_scale.x : 0.0f;
+               values[1] = bounds.m_scale.y != 0.0f ? (p.y - bounds.m_offset.y) / bounds.m_scale.y : 0.0f;
+               values[2] = bounds.m_scale.z != 0.0f ? (p.z - bounds.m_offset.z) / bounds.m_scale.z : 0.0f;
+            }
+            if (hasTangents)
+            {
+               const Vector3f &n = pMesh->m_pNormals[v], &t = pMesh->m_pTangents[v], &b = pMesh->m_pBiTangets[v];
+               const float handedness = (n.y * t.z - n.z * t.y) * b.x + (n.z * t.x - n.x * t.z) * b.y + (n.x * t.y - n.y * t.x) * b.z;
+               values[3] = handedness < 0.0f ? 0.0f : 1.0f;
+            }
+            WriteComponents(position, values, 4, pVertex);
+
+            if (layout.HasAttribute(ATTRIBUTE_NORMAL) && pMesh->HasNormals())
+               WriteDirection(layout, normal, pMesh->m_pNormals[v], pVertex);
+            if (hasTangents)
+               WriteDirection(layout, tangent, pMesh->m_pTangents[v], pVertex);
+            if (layout.HasAttribute(ATTRIBUTE_TEXCOORD) && pMesh->HasTextureCoords(0))
+               WriteComponents(texCoord, &pMesh->m_pTextureCoords[0][v].x, 2, pVertex);
+         }
+         return bounds;
+      }
+
+      void UnpackVertex(const VertexLayout &layout, const PackedBounds &bounds, const uint8 *pVertex, UnpackedVertex &vertex)
+      {
+         float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+         ReadComponents(layout.m_attributes[ATTRIBUTE_POSITION], pVertex, values);
+         vertex.m_position = Vector3f(bounds.m_offset.x + values[0] * bounds.m_scale.x,
+            bounds.m_offset.y + values[1] * bounds.m_scale.y, bounds.m_offset.z + values[2] * bounds.m_scale.z);
+
+         const Vector3f zero(0.0f, 0.0f, 0.0f);
+         vertex.m_normal = layout.HasAttribute(ATTRIBUTE_NORMAL) ? ReadDirection(layout, layout.m_attributes[ATTRIBUTE_NORMAL], pVertex) : zero;
+         vertex.m_tangent = zero;
+         vertex.m_bitangent = zero;
+         if (layout.HasAttribute(ATTRIBUTE_TANGENT))
+         {
+            const Vector3f &n = vertex.m_normal;
+            const Vector3f t = ReadDirection(layout, layout.m_attributes[ATTRIBUTE_TANGENT], pVertex);
+            const float sign = values[3] * 2.0f - 1.0f;
+            vertex.m_tangent = t;
+            vertex.m_bitangent = Vector3f((n.y * t.z - n.z * t.y) * sign, (n.z * t.x - n.x * t.z) * sign, (n.x * t.y - n.y * t.x) * sign);
+         }
+
+         float texCoord[2] = { 0.0f, 0.0f };
+         if (layout.HasAttribute(ATTRIBUTE_TEXCOORD))
+            ReadComponents(layout.m_attributes[ATTRIBUTE_TEXCOORD], pVertex, texCoord);
+         vertex.m_texCoord = Vector3f(texCoord[0], texCoord[1], 0.0f);
+      }
+
+   } // namespace vertexpacking
+
+} // namespace gfx
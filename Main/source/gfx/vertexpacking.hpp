@@ -0,0 +1,143 @@
+#ifndef _VERTEXPACKING_HPP_INCLUDED_
+#define _VERTEXPACKING_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "model/mesh2.hpp"
+
+namespace gfx
+{
+
+   namespace vertexpacking
+   {
+
+      // how the positions of a vertex are stored
+      enum ePositionFormat
+      {
+         POSITION_FLOAT, // 3 floats, 4 if the layout has tangents
+         POSITION_HALF, // 4 half floats
+         POSITION_UNORM16 // 4 16 bit normalized values relative to the bounds of the mesh
+      };
+
+      // how normals and tangents are stored
+      enum eDirectionFormat
+      {
+         DIRECTION_FLOAT, // 3 floats
+         DIRECTION_OCT16 // octahedral encoding in 2 16 bit signed normalized values
+      };
+
+      // how the first UV channel is stored
+      enum eTexCoordFormat
+      {
+         TEXCOORD_FLOAT, // 2 floats
+         TEXCOORD_HALF // 2 half floats
+      };
+
+      struct VertexFormat
+      {
+         ePositionFormat m_position;
+         eDirectionFormat m_direction;
+         eTexCoordFormat m_texCoord;
+
+         // The default are plain floats which shaders read without decoding. POSITION_UNORM16
+         // needs the bounds and DIRECTION_OCT16 an octahedral decode in the vertex shader.
+         VertexFormat(ePositionFormat position = POSITION_FLOAT, eDirectionFormat direction = DIRECTION_FLOAT,
+            eTexCoordFormat texCoord = TEXCOORD_FLOAT)
+            : m_position(position)
+            , m_direction(direction)
+            , m_texCoord(texCoord)
+         {
+         }
+      };
+
+      // the type of the components of an attribute, half floats and both 16 bit types
+      // take 2 bytes, floats 4
+      enum eComponentType
+      {
+         COMPONENT_FLOAT,
+         COMPONENT_HALF,
+         COMPONENT_UNORM16,
+         COMPONENT_SNORM16
+      };
+
+      enum eAttribute
+      {
+         ATTRIBUTE_POSITION,
+         ATTRIBUTE_NORMAL,
+         ATTRIBUTE_TANGENT,
+         ATTRIBUTE_TEXCOORD,
+         NUM_ATTRIBUTES
+      };
+
+      struct VertexAttribute
+      {
+         eComponentType m_type;
+         uint32 m_numComponents; // 0 if the layout doesn't have the attribute
+         uint32 m_offset; // in bytes from the start of the vertex
+      };
+
+      // The interleaved layout of one packed vertex, every attribute starts at a multiple of
+      // 4 bytes. Bitangents aren't stored, the fourth position component holds the
+      // handedness instead if there are tangents: 1 if the bitangent points along
+      // cross(normal, tangent), 0 if it points the other way.
+      struct VertexLayout
+      {
+         VertexFormat m_format;
+         VertexAttribute m_attributes[NUM_ATTRIBUTES];
+         uint32 m_stride;
+
+         VertexLayout(const VertexFormat &format, bool normals, bool tangents, bool texCoords);
+
+         bool HasAttribute(eAttribute attribute) const { return m_attributes[attribute].m_numComponents != 0; }
+      };
+
+      // Unpacked positions are m_offset + value * m_scale per component. The bounds are the
+      // identity unless the positions are POSITION_UNORM16, the shader needs them then.
+      struct PackedBounds
+      {
+         Vector3f m_offset;
+         Vector3f m_scale;
+
+         PackedBounds() : m_offset(0.0f, 0.0f, 0.0f), m_scale(1.0f, 1.0f, 1.0f) { }
+      };
+
+      // one vertex as the shader sees it after unpacking
+      struct UnpackedVertex
+      {
+         Vector3f m_position;
+         Vector3f m_normal;
+         Vector3f m_tangent;
+         Vector3f m_bitangent;
+         Vector3f m_texCoord;
+      };
+
+      uint32 GetComponentSize(eComponentType type);
+
+      // Writes the vertices of the mesh in the layout to pDest, which must have room for
+      // m_numVertices * m_stride bytes. Attributes of the layout the mesh doesn't have are
+      // written as zero, which decodes as a zero vector except for DIRECTION_OCT16 normals
+      // and tangents: they decode as +Z. Returns the bounds the positions are unpacked with.
+      PackedBounds PackVertices(const mesh2::Mesh *pMesh, const VertexLayout &layout, uint8 *pDest);
+
+      // Decodes one vertex written by PackVertices() the way the GL does, attributes the
+      // layout doesn't have are zero.
+      void UnpackVertex(const VertexLayout &layout, const PackedBounds &bounds, const uint8 *pVertex,
+         UnpackedVertex &vertex);
+
+      // IEEE 754 half floats, rounded to the nearest
+      uint16 FloatToHalf(float value);
+      float HalfToFloat(uint16 value);
+
+      // Maps a unit vector onto the octahedron unfolded to [-1, 1]^2, picking the
+      // quantized point which decodes closest to the direction.
+      void OctEncode(const Vector3f &direction, int16 &x, int16 &y);
+      Vector3f OctDecode(int16 x, int16 y);
+
+   } // namespace vertexpacking
+
+} // namespace gfx
+
+#endif
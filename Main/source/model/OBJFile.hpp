@@ -43,6 +43,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "mesh2.hpp"
 using mesh2::ePrimitiveType;
@@ -54,48 +55,38 @@ namespace objfile
    struct ObjFace;
    struct ObjMaterial;
 
-   // data structure for a simple obj-face, describes discredit,l.ation and materials
+   // data structure for a simple obj-face, describes discredit,l.ation and materials. The indices
+   // are stored in the index streams of the mesh owning the face, see Mesh
    struct ObjFace
    {
-   //protected:
-      //friend void model::objparser::ObjParser::GetFace(ePrimitiveType type);
-      
-      typedef std::vector<uint32> IndexList;
-
       ePrimitiveType m_primitiveType;
 
-      IndexList *m_pVertexIndices;
-      IndexList *m_pNormalIndices;
-      IndexList *m_pTexCoordIndices;
-
-      ObjMaterial *m_pMaterial;
+      // first index and number of indices in Mesh::m_vertexIndices, m_texCoordIndices and m_normalIndices
+      uint32 m_vertexOffset;
+      uint32 m_numVertices;
+      uint32 m_texCoordOffset;
+      uint32 m_numTexCoords;
+      uint32 m_normalOffset;
+      uint32 m_numNormals;
 
-   //public:
+      // index of the material in Model::m_materialLib, Mesh::m_noMaterial if none is assigned
+      uint32 m_materialIndex;
+      // smoothing group set by the last 's' statement, 0 if smoothing is off
+      uint32 m_smoothingGroup;
 
-      ObjFace(std::vector<uint32> *pVertices,
-         std::vector<uint32> *pNormals,
-         std::vector<uint32> *pTexCoords,
-         ePrimitiveType pt = PRIMITIVE_TYPE_POLYGON) :
+      ObjFace(ePrimitiveType pt = PRIMITIVE_TYPE_POLYGON) :
          m_primitiveType(pt),
-         m_pVertexIndices(pVertices),
-         m_pNormalIndices(pNormals),
-         m_pTexCoordIndices(pTexCoords),
-         m_pMaterial(0L)
+         m_vertexOffset(0),
+         m_numVertices(0),
+         m_texCoordOffset(0),
+         m_numTexCoords(0),
+         m_normalOffset(0),
+         m_numNormals(0),
+         m_materialIndex(~0u),
+         m_smoothingGroup(0)
       {
          // empty
       }
-     
-      ~ObjFace()
-      {
-         delete m_pVertexIndices;
-         m_pVertexIndices = NULL;
-
-         delete m_pNormalIndices;
-         m_pNormalIndices = NULL;
-
-         delete m_pTexCoordIndices;
-         m_pTexCoordIndices = NULL;
-      }
    };
 
    //	Stores all objects of an objfile object definition
@@ -190,8 +181,12 @@ namespace objfile
    // data structure to store a mesh
    struct Mesh
    {
-      //	Array with pointer to all stored faces
-      std::vector<ObjFace*> m_faces;
+      //	Array with all stored faces
+      std::vector<ObjFace> m_faces;
+      // Index streams of all faces, one allocation per stream instead of three per face
+      std::vector<uint32> m_vertexIndices;
+      std::vector<uint32> m_texCoordIndices;
+      std::vector<uint32> m_normalIndices;
       //	Assigned material
       ObjMaterial *m_pMaterial;
       //	Number of stored indices.
@@ -214,17 +209,47 @@ namespace objfile
          memset(m_numUVCoordinates, 0, sizeof(uint32) * mesh2::MAX_NUMBER_OF_TEXTURECOORDS);
       }
 
-      ~Mesh()
+      // Appends a face with the material of the mesh, the index lists are copied into the streams.
+      void AddFace(ePrimitiveType type, const uint32 *pVertices, uint32 numVertices,
+         const uint32 *pTexCoords, uint32 numTexCoords, const uint32 *pNormals, uint32 numNormals,
+         uint32 smoothingGroup = 0)
       {
-         for (std::vector<ObjFace*>::iterator it = m_faces.begin();
-            it != m_faces.end(); ++it)
-         {
-            delete *it;
-         }
+         ObjFace face(type);
+         face.m_vertexOffset = Append(m_vertexIndices, pVertices, numVertices);
+         face.m_numVertices = numVertices;
+         face.m_texCoordOffset = Append(m_texCoordIndices, pTexCoords, numTexCoords);
+         face.m_numTexCoords = numTexCoords;
+         face.m_normalOffset = Append(m_normalIndices, pNormals, numNormals);
+         face.m_numNormals = numNormals;
+         face.m_materialIndex = m_materialIndex;
+         face.m_smoothingGroup = smoothingGroup;
+
+         if (m_faces.size() == m_faces.capacity())
+            m_faces.reserve(m_faces.empty() ? 16 : m_faces.size() * 2);
+         m_faces.push_back(face);
+
+         m_numIndices += numVertices;
+         m_numUVCoordinates[0] += numTexCoords;
+         if (numNormals > 0)
+            m_hasNormals = true;
       }
 
       bool HasNormals() { return m_hasNormals; }
       uint32 GetMaterialIndex() { return m_materialIndex; }
+
+   private:
+      // appends count indices, the stream doubles its capacity when it is full. Returns the offset of the first one
+      static uint32 Append(std::vector<uint32> &stream, const uint32 *pIndices, uint32 count)
+      {
+         const uint32 offset = (uint32)stream.size();
+         if (count == 0)
+            return offset;
+
+         if (stream.size() + count > stream.capacity())
+            stream.reserve(std::max<size_t>(stream.capacity() * 2, stream.size() + count));
+         stream.insert(stream.end(), pIndices, pIndices + count);
+         return offset;
+      }
    };
 
    // data structure to store all obj-specific model datas
@@ -245,6 +270,8 @@ namespace objfile
       objfile::ObjMaterial *m_pDefaultMaterial;
       //	Vector with all generated materials
       std::vector<std::string> m_materialLib;
+      //	Paths of all referenced material library files, also the missing ones
+      std::vector<std::string> m_materialLibFiles;
       //	Vector with all generated group
       std::vector<std::string> m_groupLib;
       //	Vector with all generated vertices
@@ -260,6 +287,10 @@ namespace objfile
       //	Vector with generated m_texture coordinates
       //std::vector<Vector2f> m_textureCoord2;
       std::vector<Vector3f> m_textureCoord;
+      //	Smoothing group of the following faces, 0 if smoothing is off
+      uint32 m_smoothingGroup;
+      //	True, if the file contains smoothing group statements
+      bool m_hasSmoothingGroups;
 
       Mesh *m_pCurrentMesh;
 
@@ -274,6 +305,8 @@ namespace objfile
          m_pDefaultMaterial(NULL),
          m_pGroupFaceIDs(NULL),
          m_strActiveGroup(""),
+         m_smoothingGroup(0),
+         m_hasSmoothingGroups(false),
          m_pCurrentMesh(NULL)
       {
          // empty
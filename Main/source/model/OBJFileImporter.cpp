@@ -69,6 +69,29 @@ using mesh2::PRIMITIVE_TYPE_TRIANGLE;
 #include "../core/fileio/filesys.hpp"
 using core::filesys::HasExtension;
 
+#include "../core/fileio/mappedfile.hpp"
+using core::fileio::MappedFile;
+
+#include "../core/thread/threadpool.hpp"
+using core::thread::ThreadPool;
+
+#include "../core/charscan.hpp"
+
+#include "importer.hpp"
+#include "config.hpp"
+#include "importReport.hpp"
+using importer::ImportPhaseTimer;
+using importer::IMPORT_PHASE_READ;
+using importer::IMPORT_PHASE_PARSE;
+using importer::IMPORT_PHASE_CREATE_MESHES;
+using importer::IMPORT_PHASE_CREATE_MATERIALS;
+
+#include "progressHandler.hpp"
+using importer::UpdateProgress;
+
+#include <stdexcept>
+#include <algorithm>
+
 namespace objfileimporter
 {
    using namespace std;
@@ -92,7 +115,16 @@ namespace objfileimporter
    ObjFileImporter::ObjFileImporter() :
       m_pDataBuffer(),
       m_pRootObject(NULL),
-      m_strAbsPath("")
+      m_strAbsPath(""),
+      m_useMappedRead(true),
+      m_useParallelParse(true),
+      m_weldVertices(false),
+      m_useSceneArena(false),
+      m_pArena(NULL),
+      m_pThreadPool(NULL),
+      m_pReport(NULL),
+      m_pProgressHandler(NULL),
+      m_pMtlCache(NULL)
    {
       //FileSys filesys;
       m_strAbsPath = '/'; //= io.getOsSeparator();
@@ -118,6 +150,23 @@ namespace objfileimporter
       }
    }
 
+   void ObjFileImporter::SetupProperties(const importer::Importer *pImp, uint32 flags)
+   {
+      const bool weldByDefault = pImp->GetPostProcessPipeline().NeedsSharedVertices(flags);
+      m_useMappedRead = pImp->GetPropertyBool(CONFIG_IMPORT_OBJ_MAPPED_READ, true);
+      m_useParallelParse = pImp->GetPropertyBool(CONFIG_IMPORT_OBJ_PARALLEL_PARSE, true);
+      m_weldVertices = pImp->GetPropertyBool(CONFIG_IMPORT_OBJ_WELD_VERTICES, weldByDefault);
+      m_useSceneArena = pImp->GetPropertyBool(CONFIG_IMPORT_SCENE_ARENA, false);
+      m_pThreadPool = pImp->GetThreadPool();
+      m_pProgressHandler = pImp->GetProgressHandler();
+      m_pMtlCache = pImp->GetMtlLibraryCache();
+   }
+
+   ThreadPool *ObjFileImporter::GetThreadPool()
+   {
+      return m_useParallelParse ? m_pThreadPool : NULL;
+   }
+
    const eImporterDesc* ObjFileImporter::GetInfo() const
    {
       return &desc;
@@ -126,64 +175,139 @@ namespace objfileimporter
    //	Obj-file import implementation
    void ObjFileImporter::InternReadFile(const std::string &pFileName, scene::Scene* pScene)
    {
-     
-      //pFile->Open(pFileName, true);
-      //ScopedPtr<File> file(pFileName);
-
-      File *file = new File();
-
-      file->Open(pFileName, true);
-      //if (!file->Get()) {
-      //   //throw DeadlyImportError("Failed to open file " + pFile + ".");
-      //}
-
-      // Get the file-size and validate it, throwing an exception when fails
-      size_t fileSize = file->GetSize();
-      if (fileSize < ObjMinSize) {
-         //throw DeadlyImportError("OBJ-file is too small.");
-      }
+      m_materialLibFiles.clear();
 
-      // Allocate buffer and read file into it
-      //TextFileToBuffer(file.Get(), m_pDataBuffer);
-      file->CopyToBuffer(m_pDataBuffer);
-
-      // Get the model name
-      std::string strModelName;
-      std::string::size_type pos = pFileName.find_last_of("\\/");
-      if (pos != std::string::npos)
-      {
-         strModelName = pFileName.substr(pos + 1, pFileName.size() - pos - 1);
-      }
-      else
-      {
-         strModelName = pFileName;
-      }
-
-      // process all '\'
-      std::vector<char> ::iterator iter = m_pDataBuffer.begin();
-      while (iter != m_pDataBuffer.end())
+      if (m_useMappedRead)
       {
-         if (*iter == '\\')
+         MappedFile file;
+         ImportPhaseTimer readTimer(m_pReport, IMPORT_PHASE_READ);
+         if (file.Open(pFileName))
          {
-            // remove '\'
-            iter = m_pDataBuffer.erase(iter);
-            // remove next character
-            while (*iter == '\r' || *iter == '\n')
-               iter = m_pDataBuffer.erase(iter);
+            readTimer.Stop();
+            UpdateProgress(m_pProgressHandler, 0.1f);
+
+            // parse the mapped view in place, line continuations ('\\' at the end
+            // of a line) are resolved by the tokenizer, so no copy is needed
+            ImportPhaseTimer parseTimer(m_pReport, IMPORT_PHASE_PARSE);
+            ObjParser parser(file.GetData(), file.GetEnd(), pFileName, GetThreadPool(), m_pMtlCache);
+            parseTimer.Stop();
+            UpdateProgress(m_pProgressHandler, 0.5f);
+            AddModelStatistics(parser.GetModel(), file.GetData(), file.GetEnd());
+
+            // And create the proper return structures out of it
+            CreateDataFromImport(parser.GetModel(), pScene);
+
+            file.Close();
+            return;
          }
-         else
-            ++iter;
+         // the file can't be mapped (e.g. on some network shares), so fall
+         // back to the buffered read
       }
 
+      ImportPhaseTimer readTimer(m_pReport, IMPORT_PHASE_READ);
+      File file;
+      if (!file.Open(pFileName, true))
+         throw std::runtime_error("Failed to open file " + pFileName + ".");
+
+      // Allocate buffer and read file into it
+      file.CopyToBuffer(m_pDataBuffer);
+      readTimer.Stop();
+      UpdateProgress(m_pProgressHandler, 0.1f);
+
       // parse the file into a temporary representation
-      ObjParser parser(m_pDataBuffer, strModelName, file);
+      ImportPhaseTimer parseTimer(m_pReport, IMPORT_PHASE_PARSE);
+      ObjParser parser(m_pDataBuffer, pFileName, &file, GetThreadPool(), m_pMtlCache);
+      parseTimer.Stop();
+      UpdateProgress(m_pProgressHandler, 0.5f);
+      // the buffer holds a terminating zero behind the file content
+      if (!m_pDataBuffer.empty())
+         AddModelStatistics(parser.GetModel(), &m_pDataBuffer[0], &m_pDataBuffer[0] + std::min(m_pDataBuffer.size(), (size_t)file.GetSize()));
 
       // And create the proper return structures out of it
       CreateDataFromImport(parser.GetModel(), pScene);
 
       // Clean up allocated storage for the next import 
       m_pDataBuffer.clear();
-      file->Close();
+      file.Close();
+   }
+
+   void ObjFileImporter::InternReadMemory(const char *pBegin, const char *pEnd, const std::string &modelName, scene::Scene* pScene)
+   {
+      m_materialLibFiles.clear();
+
+      ImportPhaseTimer parseTimer(m_pReport, IMPORT_PHASE_PARSE);
+      ObjParser parser(pBegin, pEnd, modelName, GetThreadPool(), m_pMtlCache);
+      parseTimer.Stop();
+      UpdateProgress(m_pProgressHandler, 0.5f);
+      AddModelStatistics(parser.GetModel(), pBegin, pEnd);
+
+      CreateDataFromImport(parser.GetModel(), pScene);
+   }
+
+   void ObjFileImporter::AddModelStatistics(const objfile::Model* pModel, const char *pBegin, const char *pEnd)
+   {
+      if (NULL == m_pReport || NULL == pModel)
+         return;
+
+      m_pReport->m_bytesRead += pEnd - pBegin;
+
+      uint64 numLines = 0;
+      for (const char *it = pBegin; it != pEnd; ++numLines)
+      {
+         it = core::charscan::FindChar<'\n'>(it, pEnd);
+         if (it != pEnd)
+            ++it;
+      }
+      m_pReport->m_numLines += numLines;
+
+      m_pReport->m_numPositions += pModel->m_pVertices.size();
+      m_pReport->m_numTexCoords += pModel->m_textureCoord.size();
+      m_pReport->m_numNormals += pModel->m_pNormals.size();
+      for (size_t i = 0; i < pModel->m_meshes.size(); i++)
+         m_pReport->m_numFaces += pModel->m_meshes[i]->m_faces.size();
+   }
+
+   // The arena size for the meshes and nodes. How many vertices welding leaves is only known
+   // later, their streams are left to the blocks the arena adds.
+   static size_t EstimateArenaSize(const objfile::Model* pModel, bool weldVertices)
+   {
+      // the alignment of every array costs at most a few bytes
+      size_t size = pModel->m_objects.size() * (sizeof(Node*) + 2 * sizeof(uint32) + 16);
+      for (size_t i = 0; i < pModel->m_meshes.size(); i++)
+      {
+         const objfile::Mesh *pObjMesh = pModel->m_meshes[i];
+         if (NULL == pObjMesh)
+            continue;
+         const bool hasNormals = !pModel->m_pNormals.empty() && pObjMesh->m_hasNormals;
+         const bool hasTexCoords = !pModel->m_textureCoord.empty() && pObjMesh->m_numUVCoordinates[0];
+         size_t vertexSize = sizeof(uint32); // the face index of the corner
+         if (!weldVertices)
+         {
+            vertexSize += sizeof(Vector3f);
+            vertexSize += hasNormals ? sizeof(Vector3f) : 0;
+            vertexSize += hasTexCoords ? sizeof(Vector3f) : 0;
+            vertexSize += (!hasNormals && pModel->m_hasSmoothingGroups) ? sizeof(uint32) : 0;
+         }
+
+         // a line of n corners becomes n - 1 segments of two vertices
+         size_t numVertices = 0, numFaces = 0;
+         for (size_t f = 0; f < pObjMesh->m_faces.size(); f++)
+         {
+            const objfile::ObjFace &face = pObjMesh->m_faces[f];
+            if (face.m_primitiveType == PRIMITIVE_TYPE_LINE)
+            {
+               numVertices += (face.m_numVertices - 1) * 2;
+               numFaces += face.m_numVertices - 1;
+            }
+            else
+            {
+               numVertices += face.m_numVertices;
+               numFaces += (face.m_primitiveType == PRIMITIVE_TYPE_POINT) ? face.m_numVertices : 1;
+            }
+         }
+         size += numVertices * vertexSize + numFaces * sizeof(mesh2::Face) + 64;
+      }
+      return size;
    }
 
    //	Create the data from parsed obj-file
@@ -192,8 +316,19 @@ namespace objfileimporter
          return;
       }
 
+      m_materialLibFiles = pModel->m_materialLibFiles;
+
+      // the scene owns the arena, a cached scene brings its own storage
+      m_pArena = NULL;
+      if (m_useSceneArena && NULL == pScene->m_pStorage)
+      {
+         m_pArena = new scene::SceneArena(EstimateArenaSize(pModel, m_weldVertices));
+         pScene->m_pStorage = m_pArena;
+      }
+
       // Create the root node of the scene
       pScene->m_pRootNode = new Node;
+      pScene->m_pRootNode->m_ownsArrays = (NULL == m_pArena);
       if (!pModel->m_modelName.empty())
       {
          // Set the name of the scene
@@ -206,10 +341,22 @@ namespace objfileimporter
       }
 
       // Create nodes for the whole scene	
+      ImportPhaseTimer meshTimer(m_pReport, IMPORT_PHASE_CREATE_MESHES);
       std::vector<Mesh*> MeshArray;
+      std::vector<Node*> children;
       for (size_t index = 0; index < pModel->m_objects.size(); index++)
       {
-         CreateNodes(pModel, pModel->m_objects[index], pScene->m_pRootNode, pScene, MeshArray);
+         Node *pChild = CreateNodes(pModel, pModel->m_objects[index], pScene->m_pRootNode, pScene, MeshArray);
+         if (NULL != pChild)
+            children.push_back(pChild);
+      }
+
+      // the children of the root are allocated once they are known
+      if (!children.empty())
+      {
+         pScene->m_pRootNode->m_numChildren = static_cast<uint32>(children.size());
+         pScene->m_pRootNode->m_ppChildren = NewArray<Node*>(children.size());
+         std::copy(children.begin(), children.end(), pScene->m_pRootNode->m_ppChildren);
       }
 
       // Create mesh pointer buffer for this scene
@@ -222,7 +369,17 @@ namespace objfileimporter
          }
       }
 
+      meshTimer.Stop();
+      UpdateProgress(m_pProgressHandler, 0.85f);
+
+      ImportPhaseTimer materialTimer(m_pReport, IMPORT_PHASE_CREATE_MATERIALS);
       CreateMaterials(pModel, pScene); // Create all materials
+      materialTimer.Stop();
+
+      // vertices are shared between faces
+      if (m_weldVertices)
+         pScene->m_flags = (scene::eSceneFlags)(pScene->m_flags | scene::SCENE_FLAGS_NON_VERBOSE_FORMAT);
+      m_pArena = NULL;
    }
 
    //	Creates all nodes of the model
@@ -237,13 +394,12 @@ namespace objfileimporter
       // Store older mesh size to be able to computes mesh offsets for new mesh instances
       const size_t oldMeshSize = MeshArray.size();
       Node *pNode = new Node;
+      pNode->m_ownsArrays = (NULL == m_pArena);
 
       pNode->m_name = pObject->m_strObjName;
 
-      // If we have a parent node, store it
-      if (pParent != NULL) {
-         AppendChildToParentNode(pParent, pNode);
-      }
+      // If we have a parent node, store it, the caller adds the node to its children
+      pNode->m_pParentNode = pParent;
 
       for (size_t i = 0; i< pObject->m_meshes.size(); i++)
       {
@@ -259,16 +415,16 @@ namespace objfileimporter
       {
          size_t numChilds = pObject->m_SubObjects.size();
          pNode->m_numChildren = static_cast<uint32>(numChilds);
-         pNode->m_ppChildren = new Node*[numChilds];
+         pNode->m_ppChildren = NewArray<Node*>(numChilds);
          pNode->m_numMeshes = 1;
-         pNode->m_ppMeshes = new uint32[1];
+         pNode->m_ppMeshes = NewArray<uint32>(1);
       }
 
       // Set mesh instances into scene- and node-instances
       const size_t meshSizeDiff = MeshArray.size() - oldMeshSize;
       if (meshSizeDiff > 0)
       {
-         pNode->m_ppMeshes = new uint32[meshSizeDiff];
+         pNode->m_ppMeshes = NewArray<uint32>(meshSizeDiff);
          pNode->m_numMeshes = static_cast<uint32>(meshSizeDiff);
          size_t index = 0;
          for (size_t i = oldMeshSize; i < MeshArray.size(); i++)
@@ -282,6 +438,19 @@ namespace objfileimporter
       return pNode;
    }
 
+   // Gives a face its m_numIndices sized index array, the next part of pBlock if there is one.
+   static void AllocateIndexArray(mesh2::Face &face, uint32 *&pBlock)
+   {
+      if (NULL == pBlock)
+      {
+         face.m_pIndexArray = new uint32[face.m_numIndices];
+         return;
+      }
+      face.m_pIndexArray = pBlock;
+      face.m_ownsIndexArray = false;
+      pBlock += face.m_numIndices;
+   }
+
    Mesh *ObjFileImporter::CreateTopology(const objfile::Model* pModel, const objfile::Object* pData, uint32 meshIndex)
    {
       // Checking preconditions
@@ -298,26 +467,30 @@ namespace objfileimporter
       }
       assert(NULL != pObjMesh);
       Mesh* pMesh = new Mesh;
+      pMesh->m_ownsArrays = (NULL == m_pArena);
+      uint32 numFaceIndices = 0;
       for (size_t index = 0; index < pObjMesh->m_faces.size(); index++)
       {
-         objfile::ObjFace *const inp = pObjMesh->m_faces[index];
-         assert(NULL != inp);
+         const objfile::ObjFace &inp = pObjMesh->m_faces[index];
 
-         if (inp->m_primitiveType == PRIMITIVE_TYPE_LINE) {
-            pMesh->m_numFaces += inp->m_pVertexIndices->size() - 1;
+         if (inp.m_primitiveType == PRIMITIVE_TYPE_LINE) {
+            pMesh->m_numFaces += inp.m_numVertices - 1;
+            numFaceIndices += (inp.m_numVertices - 1) * 2;
             pMesh->m_primitiveTypes |= PRIMITIVE_TYPE_LINE;
          }
-         else if (inp->m_primitiveType == PRIMITIVE_TYPE_POINT) {
-            pMesh->m_numFaces += inp->m_pVertexIndices->size();
+         else if (inp.m_primitiveType == PRIMITIVE_TYPE_POINT) {
+            pMesh->m_numFaces += inp.m_numVertices;
+            numFaceIndices += inp.m_numVertices;
             pMesh->m_primitiveTypes |= PRIMITIVE_TYPE_POINT;
          }
          else {
             ++pMesh->m_numFaces;
-            if (inp->m_pVertexIndices->size() > 3) {
+            numFaceIndices += inp.m_numVertices;
+            if (inp.m_numVertices > 3) {
                pMesh->m_primitiveTypes |= PRIMITIVE_TYPE_POLYGON;
             }
             else {
-               pMesh->m_primitiveTypes |= PRIMITIVE_TYPE_POLYGON;
+               pMesh->m_primitiveTypes |= PRIMITIVE_TYPE_TRIANGLE;
             }
          }
       }
@@ -325,7 +498,10 @@ namespace objfileimporter
       uint32 uiIdxCount(0u);
       if (pMesh->m_numFaces > 0)
       {
-         pMesh->m_pFaces = new mesh2::Face[pMesh->m_numFaces];
+         pMesh->m_pFaces = NewArray<mesh2::Face>(pMesh->m_numFaces);
+
+         // with an arena the index arrays of the faces lie one after the other in one block
+         uint32 *pIndexBlock = (NULL != m_pArena) ? m_pArena->Allocate<uint32>(numFaceIndices) : NULL;
          if (pObjMesh->m_materialIndex != objfile::Mesh::m_noMaterial)
          {
             pMesh->m_materialIndex = pObjMesh->m_materialIndex;
@@ -336,29 +512,29 @@ namespace objfileimporter
          // Copy all data from all stored meshes
          for (size_t index = 0; index < pObjMesh->m_faces.size(); index++)
          {
-            objfile::ObjFace* const inp = pObjMesh->m_faces[index];
-            if (inp->m_primitiveType == PRIMITIVE_TYPE_LINE) {
-               for (size_t i = 0; i < inp->m_pVertexIndices->size() - 1; ++i) {
+            const objfile::ObjFace &inp = pObjMesh->m_faces[index];
+            if (inp.m_primitiveType == PRIMITIVE_TYPE_LINE) {
+               for (size_t i = 0; i < inp.m_numVertices - 1; ++i) {
                   mesh2::Face &f = pMesh->m_pFaces[outIndex++];
                   uiIdxCount += f.m_numIndices = 2;
-                  f.m_pIndexArray = new uint32[2];
+                  AllocateIndexArray(f, pIndexBlock);
                }
                continue;
             }
-            else if (inp->m_primitiveType == PRIMITIVE_TYPE_POINT) {
-               for (size_t i = 0; i < inp->m_pVertexIndices->size(); ++i) {
+            else if (inp.m_primitiveType == PRIMITIVE_TYPE_POINT) {
+               for (size_t i = 0; i < inp.m_numVertices; ++i) {
                   mesh2::Face &f = pMesh->m_pFaces[outIndex++];
                   uiIdxCount += f.m_numIndices = 1;
-                  f.m_pIndexArray = new uint32[1];
+                  AllocateIndexArray(f, pIndexBlock);
                }
                continue;
             }
 
             mesh2::Face *pFace = &pMesh->m_pFaces[outIndex++];
-            const uint32 uiNumIndices = (uint32)pObjMesh->m_faces[index]->m_pVertexIndices->size();
+            const uint32 uiNumIndices = inp.m_numVertices;
             uiIdxCount += pFace->m_numIndices = (uint32)uiNumIndices;
             if (pFace->m_numIndices > 0) {
-               pFace->m_pIndexArray = new uint32[uiNumIndices];
+               AllocateIndexArray(*pFace, pIndexBlock);
             }
          }
       }
@@ -386,19 +562,27 @@ namespace objfileimporter
       if (NULL == pObjMesh || pObjMesh->m_numIndices < 1)
          return;
 
+      if (m_weldVertices)
+      {
+         CreateWeldedVertexArray(pModel, pObjMesh, pMesh);
+         return;
+      }
+
       // Copy vertices of this mesh instance
       pMesh->m_numVertices = numIndices;
-      pMesh->m_pVertices = new Vector3f[pMesh->m_numVertices];
+      pMesh->m_pVertices = NewArray<Vector3f>(pMesh->m_numVertices);
 
-      // Allocate buffer for normal vectors
+      // Allocate buffer for normal vectors, the smoothing groups are only needed to generate them
       if (!pModel->m_pNormals.empty() && pObjMesh->m_hasNormals)
-         pMesh->m_pNormals = new Vector3f[pMesh->m_numVertices];
+         pMesh->m_pNormals = NewArray<Vector3f>(pMesh->m_numVertices);
+      else if (pModel->m_hasSmoothingGroups)
+         pMesh->m_pSmoothingGroups = NewArray<uint32>(pMesh->m_numVertices);
 
       // Allocate buffer for m_texture coordinates
       if (!pModel->m_textureCoord.empty() && pObjMesh->m_numUVCoordinates[0])
       {
          pMesh->m_numUVComponents[0] = 2;
-         pMesh->m_pTextureCoords[0] = new Vector3f[pMesh->m_numVertices];
+         pMesh->m_pTextureCoords[0] = NewArray<Vector3f>(pMesh->m_numVertices);
       }
 
       // Copy vertices, normals and textures into Mesh instance
@@ -406,23 +590,25 @@ namespace objfileimporter
       for (size_t index = 0; index < pObjMesh->m_faces.size(); index++)
       {
          // Get source face
-         objfile::ObjFace *pSourceFace = pObjMesh->m_faces[index];
+         const objfile::ObjFace *pSourceFace = &pObjMesh->m_faces[index];
 
          // Copy all index arrays
-         for (size_t vertexIndex = 0, outVertexIndex = 0; vertexIndex < pSourceFace->m_pVertexIndices->size(); vertexIndex++)
+         for (size_t vertexIndex = 0, outVertexIndex = 0; vertexIndex < pSourceFace->m_numVertices; vertexIndex++)
          {
-            const uint32 vertex = pSourceFace->m_pVertexIndices->at(vertexIndex);
+            const uint32 vertex = pObjMesh->m_vertexIndices[pSourceFace->m_vertexOffset + vertexIndex];
 
             // Where is DeadlyImportError?
        /*     if (vertex >= pModel->m_pVertices.size())
                throw DeadlyImportError("OBJ: vertex index out of range");*/
 
             pMesh->m_pVertices[newIndex] = pModel->m_pVertices[vertex];
+            if (pMesh->m_pSmoothingGroups)
+               pMesh->m_pSmoothingGroups[newIndex] = pSourceFace->m_smoothingGroup;
 
             // Copy all normals 
-            if (!pModel->m_pNormals.empty() && vertexIndex < pSourceFace->m_pNormalIndices->size())
+            if (!pModel->m_pNormals.empty() && vertexIndex < pSourceFace->m_numNormals)
             {
-               const uint32 normal = pSourceFace->m_pNormalIndices->at(vertexIndex);
+               const uint32 normal = pObjMesh->m_normalIndices[pSourceFace->m_normalOffset + vertexIndex];
   /*             if (normal >= pModel->m_pNormals.size())
                   throw DeadlyImportError("OBJ: vertex normal index out of range");*/
 
@@ -430,9 +616,9 @@ namespace objfileimporter
             }
 
             // Copy all m_texture coordinates
-            if (!pModel->m_textureCoord.empty() && vertexIndex < pSourceFace->m_pTexCoordIndices->size())
+            if (!pModel->m_textureCoord.empty() && vertexIndex < pSourceFace->m_numTexCoords)
             {
-               const uint32 tex = pSourceFace->m_pTexCoordIndices->at(vertexIndex);
+               const uint32 tex = pObjMesh->m_texCoordIndices[pSourceFace->m_texCoordOffset + vertexIndex];
                assert(tex < pModel->m_textureCoord.size());
 
                //if (tex >= pModel->m_textureCoord.size())
@@ -447,7 +633,7 @@ namespace objfileimporter
             // Get destination face
             mesh2::Face *pDestFace = &pMesh->m_pFaces[outIndex];
 
-            const bool last = (vertexIndex == pSourceFace->m_pVertexIndices->size() - 1);
+            const bool last = (vertexIndex == pSourceFace->m_numVertices - 1);
             if (pSourceFace->m_primitiveType != PRIMITIVE_TYPE_LINE || !last)
             {
                pDestFace->m_pIndexArray[outVertexIndex] = newIndex;
@@ -469,9 +655,12 @@ namespace objfileimporter
                if (vertexIndex) {
                   if (!last) {
                      pMesh->m_pVertices[newIndex + 1] = pMesh->m_pVertices[newIndex];
-                     if (!pSourceFace->m_pNormalIndices->empty() && !pModel->m_pNormals.empty()) {
+                     if (pSourceFace->m_numNormals > 0 && !pModel->m_pNormals.empty()) {
                         pMesh->m_pNormals[newIndex + 1] = pMesh->m_pNormals[newIndex];
                      }
+                     if (pMesh->m_pSmoothingGroups) {
+                        pMesh->m_pSmoothingGroups[newIndex + 1] = pMesh->m_pSmoothingGroups[newIndex];
+                     }
                      if (!pModel->m_textureCoord.empty()) {
                         for (size_t i = 0; i < pMesh->GetNumUVChannels(); i++) {
                            pMesh->m_pTextureCoords[i][newIndex + 1] = pMesh->m_pTextureCoords[i][newIndex];
@@ -491,6 +680,136 @@ namespace objfileimporter
       }
    }
 
+   // Hash of a (v, vt, vn) index triple and a smoothing group
+   static uint32 HashCorner(uint32 vertex, uint32 texCoord, uint32 normal, uint32 smoothingGroup)
+   {
+      uint32 hash = vertex * 0x9e3779b1u;
+      hash ^= texCoord * 0x85ebca6bu + (hash << 6) + (hash >> 2);
+      hash ^= normal * 0xc2b2ae35u + (hash << 6) + (hash >> 2);
+      hash ^= smoothingGroup * 0x27d4eb2fu + (hash << 6) + (hash >> 2);
+      return hash ^ (hash >> 16);
+   }
+
+   void ObjFileImporter::CreateWeldedVertexArray(const objfile::Model* pModel, const objfile::Mesh* pObjMesh, Mesh* pMesh)
+   {
+      static const uint32 NO_INDEX = ~0u;
+
+      const bool hasNormals = !pModel->m_pNormals.empty() && pObjMesh->m_hasNormals;
+      const bool hasTexCoords = !pModel->m_textureCoord.empty() && pObjMesh->m_numUVCoordinates[0];
+      // without normals the vertices are split between smoothing groups, so the normals
+      // generated later only average over the faces of one group
+      const bool hasSmoothingGroups = pModel->m_hasSmoothingGroups && !hasNormals;
+
+      // distinct (v, vt, vn, smoothing group) keys in order of appearance, NO_INDEX for a
+      // missing texture coordinate or normal, and the vertex of every face corner
+      std::vector<uint32> vertexKeys;
+      vertexKeys.reserve(pObjMesh->m_numIndices * 4);
+      std::vector<uint32> cornerVertices(pObjMesh->m_numIndices);
+
+      // open addressing table with at least twice as many slots as corners, a slot holds the
+      // vertex number + 1, 0 marks a free one
+      uint32 tableSize = 16;
+      while (tableSize < pObjMesh->m_numIndices * 2)
+         tableSize <<= 1;
+      std::vector<uint32> table(tableSize, 0);
+
+      uint32 numVertices = 0, corner = 0;
+      for (size_t index = 0; index < pObjMesh->m_faces.size(); index++)
+      {
+         const objfile::ObjFace &face = pObjMesh->m_faces[index];
+         for (uint32 i = 0; i < face.m_numVertices; i++, corner++)
+         {
+            const uint32 vertex = pObjMesh->m_vertexIndices[face.m_vertexOffset + i];
+            const uint32 texCoord = (hasTexCoords && i < face.m_numTexCoords) ?
+               pObjMesh->m_texCoordIndices[face.m_texCoordOffset + i] : NO_INDEX;
+            const uint32 normal = (hasNormals && i < face.m_numNormals) ?
+               pObjMesh->m_normalIndices[face.m_normalOffset + i] : NO_INDEX;
+            const uint32 smoothingGroup = hasSmoothingGroups ? face.m_smoothingGroup : 0;
+
+            // the corners of a flat shaded polygon share their vertices with no other face
+            const bool shared = !hasSmoothingGroups || smoothingGroup != 0 || face.m_primitiveType != PRIMITIVE_TYPE_POLYGON;
+            uint32 slot = HashCorner(vertex, texCoord, normal, smoothingGroup) & (tableSize - 1);
+            for (;;)
+            {
+               const uint32 entry = shared ? table[slot] : 0;
+               if (entry == 0)
+               {
+                  if (shared)
+                     table[slot] = numVertices + 1;
+                  vertexKeys.push_back(vertex);
+                  vertexKeys.push_back(texCoord);
+                  vertexKeys.push_back(normal);
+                  vertexKeys.push_back(smoothingGroup);
+                  cornerVertices[corner] = numVertices++;
+                  break;
+               }
+
+               const uint32 *pKey = &vertexKeys[(entry - 1) * 4];
+               if (pKey[0] == vertex && pKey[1] == texCoord && pKey[2] == normal && pKey[3] == smoothingGroup)
+               {
+                  cornerVertices[corner] = entry - 1;
+                  break;
+               }
+               slot = (slot + 1) & (tableSize - 1);
+            }
+         }
+      }
+
+      // Copy the distinct vertices into the mesh
+      pMesh->m_numVertices = numVertices;
+      pMesh->m_pVertices = NewArray<Vector3f>(numVertices);
+      if (hasNormals)
+         pMesh->m_pNormals = NewArray<Vector3f>(numVertices);
+      if (hasTexCoords)
+      {
+         pMesh->m_numUVComponents[0] = 2;
+         pMesh->m_pTextureCoords[0] = NewArray<Vector3f>(numVertices);
+      }
+      if (hasSmoothingGroups)
+         pMesh->m_pSmoothingGroups = NewArray<uint32>(numVertices);
+
+      for (uint32 i = 0; i < numVertices; i++)
+      {
+         const uint32 *pKey = &vertexKeys[i * 4];
+         pMesh->m_pVertices[i] = pModel->m_pVertices[pKey[0]];
+         if (hasTexCoords)
+            pMesh->m_pTextureCoords[0][i] = (pKey[1] != NO_INDEX) ? pModel->m_textureCoord[pKey[1]] : Vector3f(0.0f, 0.0f, 0.0f);
+         if (hasNormals)
+            pMesh->m_pNormals[i] = (pKey[2] != NO_INDEX) ? pModel->m_pNormals[pKey[2]] : Vector3f(0.0f, 0.0f, 0.0f);
+         if (hasSmoothingGroups)
+            pMesh->m_pSmoothingGroups[i] = pKey[3];
+      }
+
+      // Let the faces refer to the shared vertices, lines are split into segments like in the verbose format
+      uint32 outIndex = 0;
+      corner = 0;
+      for (size_t index = 0; index < pObjMesh->m_faces.size(); index++)
+      {
+         const objfile::ObjFace &face = pObjMesh->m_faces[index];
+         const uint32 *pCornerVertices = &cornerVertices[corner];
+         if (face.m_primitiveType == PRIMITIVE_TYPE_LINE)
+         {
+            for (uint32 i = 0; i + 1 < face.m_numVertices; i++)
+            {
+               mesh2::Face &f = pMesh->m_pFaces[outIndex++];
+               f.m_pIndexArray[0] = pCornerVertices[i];
+               f.m_pIndexArray[1] = pCornerVertices[i + 1];
+            }
+         }
+         else if (face.m_primitiveType == PRIMITIVE_TYPE_POINT)
+         {
+            for (uint32 i = 0; i < face.m_numVertices; i++)
+               pMesh->m_pFaces[outIndex++].m_pIndexArray[0] = pCornerVertices[i];
+         }
+         else
+         {
+            mesh2::Face &f = pMesh->m_pFaces[outIndex++];
+            std::copy(pCornerVertices, pCornerVertices + face.m_numVertices, f.m_pIndexArray);
+         }
+         corner += face.m_numVertices;
+      }
+   }
+
    //	Counts all stored meshes 
    void ObjFileImporter::CountObjects(const std::vector<objfile::Object*> &rObjects, int32 &iNumMeshes)
    {
@@ -667,38 +986,6 @@ namespace objfileimporter
       assert(pScene->m_numMaterials == numMaterials);
    }
 
-   //	Appends this node to the parent node
-   void ObjFileImporter::AppendChildToParentNode(Node *pParent, Node *pChild)
-   {
-      // Checking preconditions
-      assert(NULL != pParent);
-      assert(NULL != pChild);
-
-      // Assign parent to child
-      pChild->m_pParentNode = pParent;
-
-      // If already children was assigned to the parent node, store them in a 
-      std::vector<Node*> temp;
-      if (pParent->m_ppChildren != NULL)
-      {
-         assert(0 != pParent->m_numChildren);
-         for (size_t index = 0; index < pParent->m_numChildren; index++)
-         {
-            temp.push_back(pParent->m_ppChildren[index]);
-         }
-         delete[] pParent->m_ppChildren;
-      }
-
-      // Copy node instances into parent node
-      pParent->m_numChildren++;
-      pParent->m_ppChildren = new Node*[pParent->m_numChildren];
-      for (size_t index = 0; index < pParent->m_numChildren - 1; index++)
-      {
-         pParent->m_ppChildren[index] = temp[index];
-      }
-      pParent->m_ppChildren[pParent->m_numChildren - 1] = pChild;
-   }
-
 }	// namespace objfileimporter
 
 //#endif // !! ASSIMP_BUILD_NO_OBJ_IMPORTER
\ No newline at end of file
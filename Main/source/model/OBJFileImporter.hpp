@@ -49,7 +49,31 @@ using core::fileio::File;
 #include "OBJFile.hpp"
 #include "material.hpp"
 #include "scene/scene.hpp"
+#include "scene/sceneArena.hpp"
 #include "ImporterDesc.hpp"
+#include "importReport.hpp"
+#include "progressHandler.hpp"
+
+namespace importer
+{
+   class Importer;
+}
+
+namespace model
+{
+   namespace objmtlimporter
+   {
+      class MtlLibraryCache;
+   }
+}
+
+namespace core
+{
+   namespace thread
+   {
+      class ThreadPool;
+   }
+}
 
 namespace objfileimporter
 {
@@ -61,11 +85,39 @@ namespace objfileimporter
       
       std::string m_strAbsPath; //	Absolute pathname of model in file system
 
+      bool m_useMappedRead; // parse a mapped view of the file instead of a copy
+      bool m_useParallelParse; // parse large files in chunks on the thread pool
+      bool m_weldVertices; // emit each (v, vt, vn) triple once instead of one vertex per face corner
+      bool m_useSceneArena; // allocate the arrays of the scene from a scene::SceneArena
+
+      scene::SceneArena *m_pArena; // of the scene being created, NULL if the arrays are allocated one by one
+
+      core::thread::ThreadPool *m_pThreadPool; // owned by the importer::Importer, NULL if single threaded
+
+      std::vector<std::string> m_materialLibFiles; // material libraries referenced by the last import
+
+      importer::ImportReport *m_pReport; // NULL if no report is collected
+      importer::ProgressHandler *m_pProgressHandler; // of the importer::Importer, may be NULL
+      model::objmtlimporter::MtlLibraryCache *m_pMtlCache; // of the importer::Importer, may be NULL
+
+      // Fills the source file counters of the report.
+      void AddModelStatistics(const objfile::Model* pModel, const char *pBegin, const char *pEnd);
+
+      // Returns the thread pool for parallel parsing, NULL if disabled.
+      core::thread::ThreadPool *GetThreadPool();
+
       const eImporterDesc* GetInfo() const; // Appends the supported extension.
 
       // Create the data from imported content.
       void CreateDataFromImport(const objfile::Model* pModel, scene::Scene* pScene);
 
+      // Allocates an array of the scene being created, from the arena if there is one.
+      template <typename T>
+      T *NewArray(size_t count)
+      {
+         return (NULL != m_pArena) ? m_pArena->Allocate<T>(count) : new T[count];
+      }
+
       // Creates all nodes stored in imported content.
       scene::Node *CreateNodes(const objfile::Model* pModel, const objfile::Object* pData,
          scene::Node *pParent, scene::Scene* pScene, std::vector<mesh2::Mesh*> &MeshArray);
@@ -77,6 +129,10 @@ namespace objfileimporter
       void CreateVertexArrayFromModel(const objfile::Model* pModel, const objfile::Object* pCurrentObject,
          uint32 uiMeshIndex, mesh2::Mesh* pMesh, uint32 numIndices);
 
+      // Fills the vertex arrays with one vertex per distinct (v, vt, vn) triple of the mesh and
+      // lets the faces refer to them, the faces must be allocated already.
+      void CreateWeldedVertexArray(const objfile::Model* pModel, const objfile::Mesh* pObjMesh, mesh2::Mesh* pMesh);
+
       // Object counter helper method.
       void CountObjects(const std::vector<objfile::Object*> &rObjects, int32 &iNumMeshes);
 
@@ -88,17 +144,24 @@ namespace objfileimporter
       // Adds special property for the used m_texture mapping mode of the model.
       //void addTextureMappingModeProperty(Material* mat, aiTextureType type, int32 clampMode = 1);
 
-      //	Appends a child node to a parent node and updates the data structures.
-      void AppendChildToParentNode(scene::Node *pParent, scene::Node *pChild);
-
    public:
       ObjFileImporter();
       ~ObjFileImporter();
       // Returns whether the class can handle the format of the given file. 
       //	See BaseImporter::CanRead() for details.
       bool CanRead(const std::string &fileName, File* file, bool checkSig) const;
+      // Reads the configuration properties of the importer, the vertices are welded by
+      // default if a post processing step selected by flags needs shared vertices.
+      void SetupProperties(const importer::Importer *pImp, uint32 flags);
       //TODO: implement later, we need the scene.h code here
       void InternReadFile(const std::string &filePath, scene::Scene* pScene);
+      // Imports the OBJ content in [pBegin, pEnd) in place, the range is owned by the caller
+      // and only read during the call. Material libraries are looked up like for a file.
+      void InternReadMemory(const char *pBegin, const char *pEnd, const std::string &modelName, scene::Scene* pScene);
+      // The report the next imports add their timing and counters to, may be NULL.
+      void SetImportReport(importer::ImportReport *pReport) { m_pReport = pReport; }
+      // Paths of the material libraries the last imported file referenced.
+      const std::vector<std::string> &GetMaterialLibFiles() const { return m_materialLibFiles; }
    };
 } // namespace objfileimporter
 
@@ -54,7 +54,7 @@ using objtools::IsEndOfBuffer;
 using objtools::tokenize;
 
 //#include "ObjFileData.h"
-#include "../core/fast_atof.hpp"
+#include "../core/charscan.hpp"
 
 //#include "ParsingUtils.h"
 #include "material.hpp"
@@ -94,8 +94,24 @@ namespace model
     const std::string TypeOption			= "-type";
 
     ObjMtlImporter::ObjMtlImporter(const std::vector<char> &buffer, objfile::Model *pModel) :
-        m_dataIterator( buffer.begin() ),
-        m_dataIteratorEndOfBuffer( buffer.end() ),
+        m_dataIterator( buffer.empty() ? NULL : &buffer[0] ),
+        m_dataIteratorEndOfBuffer( buffer.empty() ? NULL : &buffer[0] + buffer.size() ),
+        m_pModelInstance( pModel ),
+        m_uiCurrentLine( 0 )
+    {
+        assert( NULL != m_pModelInstance );
+
+        if ( NULL == m_pModelInstance->m_pDefaultMaterial )
+        {
+            m_pModelInstance->m_pDefaultMaterial = new objfile::ObjMaterial;
+            m_pModelInstance->m_pDefaultMaterial->m_materialName = "default";
+        }
+        Load();
+    }
+
+    ObjMtlImporter::ObjMtlImporter(const char *pBegin, const char *pEnd, objfile::Model *pModel) :
+        m_dataIterator( pBegin ),
+        m_dataIteratorEndOfBuffer( pEnd ),
         m_pModelInstance( pModel ),
         m_uiCurrentLine( 0 )
     {
@@ -137,6 +153,8 @@ namespace model
             case 'K':
                 {
                     ++m_dataIterator;
+                    if (m_dataIterator == m_dataIteratorEndOfBuffer)
+                        break;
                     if (*m_dataIterator == 'a') // ambient color
                     {
                         ++m_dataIterator;
@@ -173,6 +191,8 @@ namespace model
             case 'n':
                 {
                     ++m_dataIterator;
+                    if (m_dataIterator == m_dataIteratorEndOfBuffer)
+                        break;
                     switch(*m_dataIterator)
                     {
                     case 's':	// Specular exponent
@@ -221,13 +241,13 @@ namespace model
         assert( NULL != pColor );
 
         float r( 0.0f ), g( 0.0f ), b( 0.0f );
-        m_dataIterator = GetFloat<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, r);
+        m_dataIterator = GetFloat(m_dataIterator, m_dataIteratorEndOfBuffer, r);
         pColor->r = r;
 
         // we have to check if color is default 0 with only one token
-        if( !core::IsLineEnd( *m_dataIterator ) ) {
-           m_dataIterator = GetFloat<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, g);
-           m_dataIterator = GetFloat<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, b);
+        if( m_dataIterator != m_dataIteratorEndOfBuffer && !core::IsLineEnd( *m_dataIterator ) ) {
+           m_dataIterator = GetFloat(m_dataIterator, m_dataIteratorEndOfBuffer, g);
+           m_dataIterator = GetFloat(m_dataIterator, m_dataIteratorEndOfBuffer, b);
         }
 
         pColor->g = g;
@@ -242,17 +262,14 @@ namespace model
 
     void ObjMtlImporter::GetFloatValue( float &value )
     {
-       m_dataIterator = CopyNextWord<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_buffer, BUFFERSIZE);
-        value = (float)core::fast_atof(m_buffer);
+        m_dataIterator = GetFloat(m_dataIterator, m_dataIteratorEndOfBuffer, value);
     }
 
     void ObjMtlImporter::CreateMaterial()
     {
-        std::string line( "" );
-        while( !core::IsLineEnd( *m_dataIterator ) ) {
-            line += *m_dataIterator;
-            ++m_dataIterator;
-        }
+        const char *pStart = m_dataIterator;
+        m_dataIterator = core::charscan::FindLineEnd( m_dataIterator, m_dataIteratorEndOfBuffer );
+        std::string line( pStart, m_dataIterator );
 
         std::vector<std::string> token;
         //int32 string<T, TAlloc>::Tokenize(TContainer &ret, const T* const delimiter, const int32 count,
@@ -284,50 +301,49 @@ namespace model
         std::string *out( NULL );
         int32 clampIndex = -1;
 
-        const char *pPtr( &(*m_dataIterator) );
-        if ( !strncmp( pPtr, DiffuseTexture.c_str(), DiffuseTexture.size() ) ) {
+        if ( IsToken( DiffuseTexture ) ) {
             // Diffuse m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->m_texture;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_DIFFUSE;
         }
-        else if (!strncmp(pPtr, AmbientTexture.c_str(), AmbientTexture.size())) {
+        else if (IsToken(AmbientTexture)) {
             // Ambient m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureAmbient;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_AMBIENT;
         }
-        else if (!strncmp(pPtr, SpecularTexture.c_str(), SpecularTexture.size())) {
+        else if (IsToken(SpecularTexture)) {
             // Specular m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->textureSpecular;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_SPECULAR;
         }
-        else if (!strncmp(pPtr, OpacityTexture.c_str(), OpacityTexture.size())) {
+        else if (IsToken(OpacityTexture)) {
             // Opacity m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureOpacity;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_OPACITY;
         }
-        else if (!strncmp(pPtr, EmmissiveTexture.c_str(), EmmissiveTexture.size())) {
+        else if (IsToken(EmmissiveTexture)) {
             // Emissive m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureEmissive;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_EMISSIVE;
         }
-        else if (!strncmp(pPtr, BumpTexture1.c_str(), BumpTexture1.size()) ||
-           !strncmp(pPtr, BumpTexture2.c_str(), BumpTexture2.size()) ||
-           !strncmp(pPtr, BumpTexture3.c_str(), BumpTexture3.size())) {
+        else if (IsToken(BumpTexture1) ||
+           IsToken(BumpTexture2) ||
+           IsToken(BumpTexture3)) {
             // Bump m_texture
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureBump;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_BUMP;
         }
-        else if (!strncmp(pPtr, NormalTexture.c_str(), NormalTexture.size())) {
+        else if (IsToken(NormalTexture)) {
             // Normal map
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureNormal;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_NORMALS;
         }
-        else if (!strncmp(pPtr, DisplacementTexture.c_str(), DisplacementTexture.size())) {
+        else if (IsToken(DisplacementTexture)) {
             // Displacement m_texture
             out = &m_pModelInstance->m_pCurrentMaterial->m_textureDisplacement;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_DISPLACEMENT;
         }
-        else if (!strncmp(pPtr, SpecularityTexture.c_str(), SpecularityTexture.size())) {
+        else if (IsToken(SpecularityTexture)) {
             // Specularity scaling (glossiness)
             out = & m_pModelInstance->m_pCurrentMaterial->m_textureSpecularity;
             clampIndex = objfile::ObjMaterial::TEXTURE_TYPE_SHININESS;
@@ -345,6 +361,12 @@ namespace model
         *out = strTexture;
     }
 
+    bool ObjMtlImporter::IsToken(const std::string &token) const
+    {
+        const size_t numChars = m_dataIteratorEndOfBuffer - m_dataIterator;
+        return numChars >= token.size() && !strncmp(m_dataIterator, token.c_str(), token.size());
+    }
+
     /* Texture Option
      * /////////////////////////////////////////////////////////////////////////////
      * According to http://en.wikipedia.org/wiki/Wavefront_.obj_file#Texture_options
@@ -365,11 +387,10 @@ namespace model
         //If there is any more m_texture option
         while (!IsEndOfBuffer(m_dataIterator, m_dataIteratorEndOfBuffer) && *m_dataIterator == '-')
         {
-            const char *pPtr( &(*m_dataIterator) );
             //skip option key and value
             int32 skipToken = 1;
 
-            if (!strncmp(pPtr, ClampOption.c_str(), ClampOption.size()))
+            if (IsToken(ClampOption))
             {
                 ConstDataArrayIterator_t it = GetNextToken<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer);
                 char value[3];
@@ -381,23 +402,23 @@ namespace model
 
                 skipToken = 2;
             }
-            else if (!strncmp(pPtr, BlendUOption.c_str(), BlendUOption.size())
-               || !strncmp(pPtr, BlendVOption.c_str(), BlendVOption.size())
-               || !strncmp(pPtr, BoostOption.c_str(), BoostOption.size())
-               || !strncmp(pPtr, ResolutionOption.c_str(), ResolutionOption.size())
-               || !strncmp(pPtr, BumpOption.c_str(), BumpOption.size())
-               || !strncmp(pPtr, ChannelOption.c_str(), ChannelOption.size())
-               || !strncmp(pPtr, TypeOption.c_str(), TypeOption.size()))
+            else if (IsToken(BlendUOption)
+               || IsToken(BlendVOption)
+               || IsToken(BoostOption)
+               || IsToken(ResolutionOption)
+               || IsToken(BumpOption)
+               || IsToken(ChannelOption)
+               || IsToken(TypeOption))
             {
                 skipToken = 2;
             }
-            else if (!strncmp(pPtr, ModifyMapOption.c_str(), ModifyMapOption.size()))
+            else if (IsToken(ModifyMapOption))
             {
                 skipToken = 3;
             }
-            else if (!strncmp(pPtr, OffsetOption.c_str(), OffsetOption.size())
-               || !strncmp(pPtr, ScaleOption.c_str(), ScaleOption.size())
-               || !strncmp(pPtr, TurbulenceOption.c_str(), TurbulenceOption.size())
+            else if (IsToken(OffsetOption)
+               || IsToken(ScaleOption)
+               || IsToken(TurbulenceOption)
                     )
             {
                 skipToken = 4;
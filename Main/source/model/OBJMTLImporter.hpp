@@ -58,8 +58,8 @@ namespace model
     public:
        static const size_t BUFFERSIZE = 2048;
        typedef std::vector<char> DataArray_t;
-       typedef std::vector<char>::iterator DataArrayIterator_t;
-       typedef std::vector<char>::const_iterator ConstDataArrayIterator_t;
+       // works on a plain character range like ObjParser
+       typedef const char* ConstDataArrayIterator_t;
     private:
 
     	std::string m_strAbsPath;
@@ -91,9 +91,13 @@ namespace model
 
     	void GetTextureName();
     	void GetTextureOption(bool &clamp);
+      // Returns true, if the current position starts with the given token.
+      bool IsToken(const std::string &token) const;
 
     public:
     	ObjMtlImporter( const std::vector<char> &buffer, objfile::Model *pModel );
+      // loads the range [pBegin, pEnd), which does not need to be zero-terminated
+      ObjMtlImporter(const char *pBegin, const char *pEnd, objfile::Model *pModel);
     	~ObjMtlImporter();
     };
 
@@ -53,7 +53,6 @@ using core::SkipToken;
 #include "OBJTools.hpp"
 using objtools::SkipLine;
 using objtools::GetNextWord;
-using core::fast_atof;
 
 #include "OBJFile.hpp"
 using objfile::Model;
@@ -61,12 +60,21 @@ using objfile::Model;
 #include "OBJMTLImporter.hpp"
 using model::objmtlimporter::ObjMtlImporter;
 
+#include "mtlLibraryCache.hpp"
+using model::objmtlimporter::MtlLibrary;
+using model::objmtlimporter::MtlLibraryCache;
+
 //#include "material.hpp"
 
 using objtools::GetName;
 using objtools::IsEndOfBuffer;
 using objtools::CopyNextWord;
 using objtools::GetNextToken;
+using objtools::IsLineContinuation;
+using objtools::GetLineFloats;
+using objtools::GetFaceCorner;
+using objtools::GetSmoothingGroup;
+using objtools::GetTokenEnd;
 
 using core::IsSpaceOrNewLine;
 using core::SkipSpaces;
@@ -75,6 +83,12 @@ using core::SkipSpaces;
 //#include "../include/assimp/types.h"
 //#include "FileSys.h"
 
+#include "core/thread/threadpool.hpp"
+#include "core/charscan.hpp"
+
+#include "core/fileio/mappedfile.hpp"
+using core::fileio::MappedFile;
+
 #include <algorithm>
 using std::fill_n;
 
@@ -88,21 +102,41 @@ namespace model
 
       const size_t ObjParser::BUFFERSIZE;
 
-      ObjParser::ObjParser(std::vector<char> &data, const std::string &strModelName, const File *file) :
-         m_dataIterator(data.begin()),
-         m_dataIteratorEndOfBuffer(data.end()),
+      ObjParser::ObjParser(std::vector<char> &data, const std::string &strModelName, const File *file,
+         core::thread::ThreadPool *pThreadPool, MtlLibraryCache *pMtlCache) :
+         m_dataIterator(data.empty() ? NULL : &data[0]),
+         m_dataIteratorEndOfBuffer(data.empty() ? NULL : &data[0] + data.size()),
          m_pModelInstance(NULL),
-         m_currentLine(0)
+         m_currentLine(0),
+         m_pThreadPool(pThreadPool),
+         m_pMtlCache(pMtlCache)
       {
          assert(file->IsOpen());
 
-         //file->CopyToBuffer(m_data);
+         Init(file->GetFilePath());
+      }
+
+      ObjParser::ObjParser(const char *pBegin, const char *pEnd, const std::string &strModelName,
+         core::thread::ThreadPool *pThreadPool, MtlLibraryCache *pMtlCache) :
+         m_dataIterator(pBegin),
+         m_dataIteratorEndOfBuffer(pEnd),
+         m_pModelInstance(NULL),
+         m_currentLine(0),
+         m_pThreadPool(pThreadPool),
+         m_pMtlCache(pMtlCache)
+      {
+         assert(pBegin <= pEnd);
+
+         Init(strModelName);
+      }
 
+      void ObjParser::Init(const std::string &strModelName)
+      {
          fill_n(m_buffer, BUFFERSIZE, 0);
 
          // Create the model instance to store all the data
          m_pModelInstance = new objfile::Model();
-         m_pModelInstance->m_modelName = file->GetFilePath();
+         m_pModelInstance->m_modelName = strModelName;
          
          // create default material and store it
          m_pModelInstance->m_pDefaultMaterial = new objfile::ObjMaterial();
@@ -129,202 +163,417 @@ namespace model
          if (m_dataIterator == m_dataIteratorEndOfBuffer)
             return;
 
+         if (NULL != m_pThreadPool && ParseFileParallel())
+            return;
+
          while (m_dataIterator != m_dataIteratorEndOfBuffer)
          {
-            switch (*m_dataIterator)
+            ParseStatement();
+         }
+      }
+
+      void ObjParser::ParseStatement()
+      {
+         switch (*m_dataIterator)
+         {
+         case 'v': // Parse a vertex m_texture coordinate
+         {
+            ++m_dataIterator;
+            if (m_dataIterator == m_dataIteratorEndOfBuffer) {
+               break;
+            }
+            else if (*m_dataIterator == ' ' || *m_dataIterator == '\t') {
+               // read in vertex definition
+               GetVector3(m_pModelInstance->m_pVertices);
+            }
+            else if (*m_dataIterator == 't') {
+               // read in m_texture coordinate ( 2D or 3D )
+               m_dataIterator++;
+               GetVector(m_pModelInstance->m_textureCoord);
+            }
+            else if (*m_dataIterator == 'n') {
+               // Read in normal vector definition
+               m_dataIterator++;
+               GetVector3(m_pModelInstance->m_pNormals);
+            }
+            else {
+               m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+            }
+         }
+         break;
+
+         case 'p': // Parse a face, line or point statement
+         case 'l':
+         case 'f':
+         {
+            GetFace(*m_dataIterator == 'f' ? PRIMITIVE_TYPE_POLYGON : (*m_dataIterator == 'l'
+               ? PRIMITIVE_TYPE_LINE : PRIMITIVE_TYPE_POINT));
+         }
+         break;
+
+         case '#': // Parse a comment
+         {
+            GetComment();
+         }
+         break;
+
+         case 'u': // Parse a material desc. setter
+         {
+            GetMaterialDesc();
+         }
+         break;
+
+         case 'm': // Parse a material library or merging group ('mg')
+         {
+            if (m_dataIterator + 1 != m_dataIteratorEndOfBuffer && *(m_dataIterator + 1) == 'g')
+               GetGroupNumberAndResolution();
+            else
+               GetMaterialLib();
+         }
+         break;
+
+         case 'g': // Parse group name
+         {
+            GetGroupName();
+         }
+         break;
+
+         case 's': // Parse a smoothing group
+         {
+            GetGroupNumber();
+         }
+         break;
+
+         case 'o': // Parse object name
+         {
+            GetObjectName();
+         }
+         break;
+
+         default:
+         {
+            m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+         }
+            break;
+            }
+      }
+
+      // first element of an index list, NULL for an empty one
+      static const uint32 *GetData(const std::vector<uint32> &indices)
+      {
+         return indices.empty() ? NULL : &indices[0];
+      }
+
+      // Returns the start of the line after the first line break at or behind pPos, which is
+      // not part of a line continuation. Lines starting with a blank are not used, the serial
+      // parser handles them depending on the line before. Returns pEnd if there is none.
+      static const char *FindChunkBoundary(const char *pPos, const char *pBegin, const char *pEnd)
+      {
+         while (pPos != pEnd)
+         {
+            pPos = core::charscan::FindChar<'\n'>(pPos, pEnd);
+            if (pPos == pEnd)
+               break;
+
+            const char *pPrev = pPos;
+            if (pPrev != pBegin && *(pPrev - 1) == '\r')
+               --pPrev;
+            ++pPos;
+            if ((pPrev == pBegin || *(pPrev - 1) != '\\') && (pPos == pEnd || !core::IsSpace(*pPos)))
+               return pPos;
+         }
+         return pEnd;
+      }
+
+      void ObjParser::ParseChunkData(ParseChunk &chunk)
+      {
+         const char *it = chunk.m_pBegin;
+         const char *end = chunk.m_pEnd;
+         uint32 currentLine = 0;
+         float values[3];
+         uint32 numValues;
+
+         while (it != end)
+         {
+            switch (*it)
             {
-            case 'v': // Parse a vertex m_texture coordinate
+            case 'v':
             {
-               ++m_dataIterator;
-               if (*m_dataIterator == ' ' || *m_dataIterator == '\t') {
-                  // read in vertex definition
-                  GetVector3(m_pModelInstance->m_pVertices);
+               ++it;
+               if (it == end) {
+                  break;
                }
-               else if (*m_dataIterator == 't') {
-                  // read in m_texture coordinate ( 2D or 3D )
-                  m_dataIterator++;
-                  GetVector(m_pModelInstance->m_textureCoord);
+               else if (*it == ' ' || *it == '\t') {
+                  it = GetLineFloats(it, end, values, 3, numValues);
+                  std::fill(values + numValues, values + 3, 0.0f);
+                  chunk.m_vertices.push_back(Vector3f(values[0], values[1], values[2]));
                }
-               else if (*m_dataIterator == 'n') {
-                  // Read in normal vector definition
-                  m_dataIterator++;
-                  GetVector3(m_pModelInstance->m_pNormals);
+               else if (*it == 't') {
+                  it = GetLineFloats(it + 1, end, values, 3, numValues);
+                  std::fill(values + numValues, values + 3, 0.0f);
+                  chunk.m_texCoords.push_back(Vector3f(values[0], values[1], values[2]));
                }
+               else if (*it == 'n') {
+                  it = GetLineFloats(it + 1, end, values, 3, numValues);
+                  std::fill(values + numValues, values + 3, 0.0f);
+                  chunk.m_normals.push_back(Vector3f(values[0], values[1], values[2]));
+               }
+               it = SkipLine<const char*>(it, end, currentLine);
             }
             break;
 
-            case 'p': // Parse a face, line or point statement
+            case 'p':
             case 'l':
             case 'f':
             {
-               GetFace(*m_dataIterator == 'f' ? PRIMITIVE_TYPE_POLYGON : (*m_dataIterator == 'l'
-                  ? PRIMITIVE_TYPE_LINE : PRIMITIVE_TYPE_POINT));
-            }
-            break;
+               ChunkFace face;
+               face.m_type = (*it == 'f' ? PRIMITIVE_TYPE_POLYGON : (*it == 'l' ? PRIMITIVE_TYPE_LINE : PRIMITIVE_TYPE_POINT));
+               face.m_firstCorner = (uint32)chunk.m_corners.size() / 3;
+               face.m_numCorners = 0;
+               face.m_numVertices = (uint32)chunk.m_vertices.size();
+               face.m_numTexCoords = (uint32)chunk.m_texCoords.size();
+               face.m_numNormals = (uint32)chunk.m_normals.size();
+
+               // each corner is v, v/vt, v//vn or v/vt/vn
+               it = GetNextToken<const char*>(it, end);
+               while (it != end && !core::IsLineEnd(*it))
+               {
+                  int32 corner[3];
+                  it = GetFaceCorner(it, end, corner);
+                  chunk.m_corners.insert(chunk.m_corners.end(), corner, corner + 3);
+                  face.m_numCorners++;
 
-            case '#': // Parse a comment
-            {
-               GetComment();
+                  it = GetNextWord<const char*>(it, end);
+               }
+               chunk.m_faces.push_back(face);
+               it = SkipLine<const char*>(it, end, currentLine);
             }
             break;
 
-            case 'u': // Parse a material desc. setter
+            case '#': // same as GetComment()
             {
-               GetMaterialDesc();
+               it = core::charscan::FindChar<'\n'>(it, end);
+               if (it != end)
+                  ++it;
             }
             break;
 
-            case 'm': // Parse a material library or merging group ('mg')
+            case 'u':
+            case 'm':
+            case 'g':
+            case 'o':
+            case 's': // the smoothing group applies to the faces behind it
             {
-               if (*(m_dataIterator + 1) == 'g')
-                  GetGroupNumberAndResolution();
-               else
-                  GetMaterialLib();
+               ChunkStatement statement;
+               statement.m_pLine = it;
+               statement.m_numFacesBefore = (uint32)chunk.m_faces.size();
+               chunk.m_statements.push_back(statement);
+               it = SkipLine<const char*>(it, end, currentLine);
             }
             break;
 
-            case 'g': // Parse group name
+            default:
             {
-               GetGroupName();
+               it = SkipLine<const char*>(it, end, currentLine);
             }
             break;
-
-            case 's': // parse group number (shouldn't this be smoothing option?)
-            {
-               GetGroupNumber(); // ??
             }
-            break;
+         }
+      }
 
-            case 'o': // Parse object name
-            {
-               GetObjectName();
-            }
-            break;
+      void ObjParser::ResolveChunk(ParseChunk &chunk)
+      {
+         std::copy(chunk.m_vertices.begin(), chunk.m_vertices.end(), m_pModelInstance->m_pVertices.begin() + chunk.m_baseVertex);
+         std::copy(chunk.m_texCoords.begin(), chunk.m_texCoords.end(), m_pModelInstance->m_textureCoord.begin() + chunk.m_baseTexCoord);
+         std::copy(chunk.m_normals.begin(), chunk.m_normals.end(), m_pModelInstance->m_pNormals.begin() + chunk.m_baseNormal);
 
-            default:
+         chunk.m_objFaces.resize(chunk.m_faces.size());
+         chunk.m_vertexIndices.reserve(chunk.m_corners.size() / 3);
+         for (size_t i = 0; i < chunk.m_faces.size(); i++)
+         {
+            const ChunkFace &face = chunk.m_faces[i];
+
+            // sizes of the arrays when the face was read, relative indices count back from there
+            const int32 vSize = (int32)(chunk.m_baseVertex + face.m_numVertices);
+            const int32 vtSize = (int32)(chunk.m_baseTexCoord + face.m_numTexCoords);
+            const int32 vnSize = (int32)(chunk.m_baseNormal + face.m_numNormals);
+
+            objfile::ObjFace &objFace = chunk.m_objFaces[i];
+            objFace.m_primitiveType = face.m_type;
+            objFace.m_vertexOffset = (uint32)chunk.m_vertexIndices.size();
+            objFace.m_texCoordOffset = (uint32)chunk.m_texCoordIndices.size();
+            objFace.m_normalOffset = (uint32)chunk.m_normalIndices.size();
+
+            const int32 *pCorner = &chunk.m_corners[face.m_firstCorner * 3];
+            for (uint32 c = 0; c < face.m_numCorners; c++, pCorner += 3)
             {
-               m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
-            }
-            break;
+               if (pCorner[0] != 0)
+                  chunk.m_vertexIndices.push_back(pCorner[0] > 0 ? pCorner[0] - 1 : vSize + pCorner[0]);
+               if (pCorner[1] != 0)
+                  chunk.m_texCoordIndices.push_back(pCorner[1] > 0 ? pCorner[1] - 1 : vtSize + pCorner[1]);
+               if (pCorner[2] != 0)
+                  chunk.m_normalIndices.push_back(pCorner[2] > 0 ? pCorner[2] - 1 : vnSize + pCorner[2]);
             }
+
+            objFace.m_numVertices = (uint32)chunk.m_vertexIndices.size() - objFace.m_vertexOffset;
+            objFace.m_numTexCoords = (uint32)chunk.m_texCoordIndices.size() - objFace.m_texCoordOffset;
+            objFace.m_numNormals = (uint32)chunk.m_normalIndices.size() - objFace.m_normalOffset;
          }
       }
 
-      void ObjParser::CopyNextWord(char *pBuffer, size_t length)
+      bool ObjParser::ParseFileParallel()
       {
-         size_t index = 0;
-         m_dataIterator = GetNextWord<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer);
-         while (m_dataIterator != m_dataIteratorEndOfBuffer && !IsSpaceOrNewLine(*m_dataIterator)) {
-            pBuffer[index] = *m_dataIterator;
-            index++;
-            if (index == length - 1) {
-               break;
+         const char *pBegin = m_dataIterator;
+         const char *pEnd = m_dataIteratorEndOfBuffer;
+         const size_t size = pEnd - pBegin;
+
+         // a few chunks per thread, so threads finishing early can take over work
+         size_t numChunks = std::min<size_t>(size / PARALLEL_MIN_CHUNK_SIZE, m_pThreadPool->GetNumThreads() * 4);
+         if (numChunks < 2)
+            return false;
+
+         std::vector<ParseChunk> chunks(numChunks);
+         const char *pChunkBegin = pBegin;
+         for (size_t i = 0; i < numChunks; i++)
+         {
+            const char *pChunkEnd = (i + 1 == numChunks) ? pEnd :
+               FindChunkBoundary(std::max(pChunkBegin, pBegin + size / numChunks * (i + 1)), pBegin, pEnd);
+
+            chunks[i].m_pBegin = pChunkBegin;
+            chunks[i].m_pEnd = pChunkEnd;
+            pChunkBegin = pChunkEnd;
+         }
+
+         // 1. read vertex data and faces
+         core::thread::ParallelFor(*m_pThreadPool, (uint32)numChunks, [&chunks](uint32 i) {
+            ParseChunkData(chunks[i]);
+         });
+
+         // 2. place the vertex data of every chunk behind the preceding ones and resolve the face indices
+         uint32 numVertices = 0, numTexCoords = 0, numNormals = 0;
+         for (size_t i = 0; i < numChunks; i++)
+         {
+            chunks[i].m_baseVertex = numVertices;
+            chunks[i].m_baseTexCoord = numTexCoords;
+            chunks[i].m_baseNormal = numNormals;
+            numVertices += (uint32)chunks[i].m_vertices.size();
+            numTexCoords += (uint32)chunks[i].m_texCoords.size();
+            numNormals += (uint32)chunks[i].m_normals.size();
+         }
+         m_pModelInstance->m_pVertices.resize(numVertices);
+         m_pModelInstance->m_textureCoord.resize(numTexCoords);
+         m_pModelInstance->m_pNormals.resize(numNormals);
+
+         core::thread::ParallelFor(*m_pThreadPool, (uint32)numChunks, [this, &chunks](uint32 i) {
+            ResolveChunk(chunks[i]);
+            std::vector<Vector3f>().swap(chunks[i].m_vertices);
+            std::vector<Vector3f>().swap(chunks[i].m_texCoords);
+            std::vector<Vector3f>().swap(chunks[i].m_normals);
+            std::vector<int32>().swap(chunks[i].m_corners);
+         });
+
+         // 3. build objects and meshes in file order, the state statements go through the serial handlers
+         for (size_t i = 0; i < numChunks; i++)
+         {
+            ParseChunk &chunk = chunks[i];
+            size_t face = 0;
+            for (size_t s = 0; s <= chunk.m_statements.size(); s++)
+            {
+               const size_t numFaces = (s < chunk.m_statements.size()) ? chunk.m_statements[s].m_numFacesBefore : chunk.m_objFaces.size();
+               for (; face < numFaces; face++)
+               {
+                  // Ignoring empty face
+                  const objfile::ObjFace &objFace = chunk.m_objFaces[face];
+                  if (objFace.m_numVertices == 0)
+                     continue;
+                  StoreFace(objFace.m_primitiveType,
+                     &chunk.m_vertexIndices[0] + objFace.m_vertexOffset, objFace.m_numVertices,
+                     GetData(chunk.m_texCoordIndices) + objFace.m_texCoordOffset, objFace.m_numTexCoords,
+                     GetData(chunk.m_normalIndices) + objFace.m_normalOffset, objFace.m_numNormals);
+               }
+
+               if (s < chunk.m_statements.size())
+               {
+                  m_dataIterator = chunk.m_statements[s].m_pLine;
+                  m_dataIteratorEndOfBuffer = chunk.m_pEnd;
+                  ParseStatement();
+               }
             }
-            m_dataIterator++;
          }
 
-         assert(index < length);
-         pBuffer[index] = '\0';
+         m_dataIterator = pEnd;
+         m_dataIteratorEndOfBuffer = pEnd;
+         return true;
+      }
+
+      void ObjParser::CopyNextWord(char *pBuffer, size_t length)
+      {
+         m_dataIterator = objtools::CopyNextWord<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, pBuffer, length);
       }
 
       void ObjParser::CopyNextLine(char *pBuffer, size_t length)
       {
          size_t index = 0u;
 
-         // some OBJ files have line continuations using \ (such as in C++ et al)
-         bool continuation = false;
-         for (; m_dataIterator != m_dataIteratorEndOfBuffer && index < length - 1; m_dataIterator++)
+         // some OBJ files have line continuations using \ (such as in C++ et al), the
+         // line is copied in runs up to the next line end or backslash
+         while (m_dataIterator != m_dataIteratorEndOfBuffer && index < length - 1)
          {
-            const char c = *m_dataIterator;
-            if (c == '\\') {
-               continuation = true;
-               continue;
-            }
+            ConstDataArrayIterator_t pRunEnd = objtools::ScanFor<objtools::LineEndOrBackslash>(m_dataIterator, m_dataIteratorEndOfBuffer);
+            const size_t numChars = std::min<size_t>(pRunEnd - m_dataIterator, length - 1 - index);
+            std::copy(m_dataIterator, m_dataIterator + numChars, pBuffer + index);
+            index += numChars;
+            m_dataIterator += numChars;
+            if (m_dataIterator != pRunEnd || pRunEnd == m_dataIteratorEndOfBuffer)
+               break;
 
-            if (c == '\n' || c == '\r') {
-               if (continuation) {
+            if (IsLineContinuation(m_dataIterator, m_dataIteratorEndOfBuffer)) {
+               m_dataIterator = objtools::SkipLineContinuation(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+               if (index < length - 1)
                   pBuffer[index++] = ' ';
-                  continue;
-               }
+            }
+            else if (*m_dataIterator == '\\') {
+               pBuffer[index++] = '\\';
+               ++m_dataIterator;
+            }
+            else {
                break;
             }
-
-            continuation = false;
-            pBuffer[index++] = c;
          }
          assert(index < length);
          pBuffer[index] = '\0';
       }
 
       void ObjParser::GetVector(std::vector<Vector3f> &point3d_array) {
-         size_t numComponents(0);
-         const char* tmp(&m_dataIterator[0]);
-         while (!core::IsLineEnd(*tmp)) {
-            if (!SkipSpaces(&tmp)) {
-               break;
-            }
-            SkipToken(tmp);
-            numComponents++;
-         }
-         float x, y, z;
-         if (2 == numComponents) {
-            CopyNextWord(m_buffer, BUFFERSIZE);
-            x = (float)fast_atof(m_buffer);
-
-            CopyNextWord(m_buffer, BUFFERSIZE);
-            y = (float)fast_atof(m_buffer);
-            z = 0.0;
-         }
-         else if (3 == numComponents) {
-            CopyNextWord(m_buffer, BUFFERSIZE);
-            x = (float)fast_atof(m_buffer);
-
-            CopyNextWord(m_buffer, BUFFERSIZE);
-            y = (float)fast_atof(m_buffer);
-
-            CopyNextWord(m_buffer, BUFFERSIZE);
-            z = (float)fast_atof(m_buffer);
-         }
-         else {
-            assert(!"Invalid number of components");
-         }
-         point3d_array.push_back(Vector3f(x, y, z));
+         // 2d or 3d, the missing component is zero
+         float values[3];
+         uint32 numValues;
+         m_dataIterator = GetLineFloats(m_dataIterator, m_dataIteratorEndOfBuffer, values, 3, numValues);
+         assert(numValues >= 2 && "Invalid number of components");
+         std::fill(values + numValues, values + 3, 0.0f);
+         point3d_array.push_back(Vector3f(values[0], values[1], values[2]));
          m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
       }
 
       void ObjParser::GetVector3(std::vector<Vector3f> &point3d_array) {
-         float x, y, z;
-         CopyNextWord(m_buffer, BUFFERSIZE);
-         x = (float)fast_atof(m_buffer);
-
-         CopyNextWord(m_buffer, BUFFERSIZE);
-         y = (float)fast_atof(m_buffer);
-
-         CopyNextWord(m_buffer, BUFFERSIZE);
-         z = (float)fast_atof(m_buffer);
-
-         point3d_array.push_back(Vector3f(x, y, z));
+         float values[3] = { 0.0f, 0.0f, 0.0f };
+         uint32 numValues;
+         m_dataIterator = GetLineFloats(m_dataIterator, m_dataIteratorEndOfBuffer, values, 3, numValues);
+         point3d_array.push_back(Vector3f(values[0], values[1], values[2]));
          m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
       }
 
       void ObjParser::GetVector2(std::vector<Vector2f> &point2d_array) {
-         float x, y;
-         CopyNextWord(m_buffer, BUFFERSIZE);
-         x = (float)fast_atof(m_buffer);
-
-         CopyNextWord(m_buffer, BUFFERSIZE);
-         y = (float)fast_atof(m_buffer);
-
-         point2d_array.push_back(Vector2f(x, y));
-
+         float values[2] = { 0.0f, 0.0f };
+         uint32 numValues;
+         m_dataIterator = GetLineFloats(m_dataIterator, m_dataIteratorEndOfBuffer, values, 2, numValues);
+         point2d_array.push_back(Vector2f(values[0], values[1]));
          m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
       }
 
       void ObjParser::GetFace(ePrimitiveType type)
       {
          CopyNextLine(m_buffer, BUFFERSIZE);
-         if (m_dataIterator == m_dataIteratorEndOfBuffer)
-            return;
 
          char *pPtr = m_buffer;
          char *pEnd = &pPtr[BUFFERSIZE];
@@ -332,10 +581,9 @@ namespace model
          if (pPtr == pEnd || *pPtr == '\0')
             return;
 
-         std::vector<uint32> *pIndices = new std::vector < uint32 > ;
-         std::vector<uint32> *pTexID = new std::vector < uint32 > ;
-         std::vector<uint32> *pNormalID = new std::vector < uint32 > ;
-         bool hasNormal = false;
+         m_faceVertices.clear();
+         m_faceTexCoords.clear();
+         m_faceNormals.clear();
 
          const int32 vSize = m_pModelInstance->m_pVertices.size();
          const int32 vtSize = m_pModelInstance->m_textureCoord.size();
@@ -387,16 +635,15 @@ namespace model
                   // Store parsed index
                   if (0 == iPos)
                   {
-                     pIndices->push_back(iVal - 1);
+                     m_faceVertices.push_back(iVal - 1);
                   }
                   else if (1 == iPos)
                   {
-                     pTexID->push_back(iVal - 1);
+                     m_faceTexCoords.push_back(iVal - 1);
                   }
                   else if (2 == iPos)
                   {
-                     pNormalID->push_back(iVal - 1);
-                     hasNormal = true;
+                     m_faceNormals.push_back(iVal - 1);
                   }
                   else
                   {
@@ -408,16 +655,15 @@ namespace model
                   // Store relatively index
                   if (0 == iPos)
                   {
-                     pIndices->push_back(vSize + iVal);
+                     m_faceVertices.push_back(vSize + iVal);
                   }
                   else if (1 == iPos)
                   {
-                     pTexID->push_back(vtSize + iVal);
+                     m_faceTexCoords.push_back(vtSize + iVal);
                   }
                   else if (2 == iPos)
                   {
-                     pNormalID->push_back(vnSize + iVal);
-                     hasNormal = true;
+                     m_faceNormals.push_back(vnSize + iVal);
                   }
                   else
                   {
@@ -428,21 +674,24 @@ namespace model
             pPtr += iStep;
          }
 
-         if (pIndices->empty())
+         if (m_faceVertices.empty())
          {
             //DefaultLogger::Get()->error("Obj: Ignoring empty face");
             m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
             return;
          }
 
-         objfile::ObjFace *face = new objfile::ObjFace(pIndices, pNormalID, pTexID, type);
+         StoreFace(type, &m_faceVertices[0], (uint32)m_faceVertices.size(),
+            GetData(m_faceTexCoords), (uint32)m_faceTexCoords.size(),
+            GetData(m_faceNormals), (uint32)m_faceNormals.size());
 
-         // Set active material, if one set
-         if (NULL != m_pModelInstance->m_pCurrentMaterial)
-            face->m_pMaterial = m_pModelInstance->m_pCurrentMaterial;
-         else
-            face->m_pMaterial = m_pModelInstance->m_pDefaultMaterial;
+         // Skip the rest of the line
+         m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+      }
 
+      void ObjParser::StoreFace(ePrimitiveType type, const uint32 *pVertices, uint32 numVertices,
+         const uint32 *pTexCoords, uint32 numTexCoords, const uint32 *pNormals, uint32 numNormals)
+      {
          // Create a default object, if nothing is there
          if (NULL == m_pModelInstance->m_pCurrent)
             CreateObject("defaultobject");
@@ -454,15 +703,8 @@ namespace model
          }
 
          // Store the face
-         m_pModelInstance->m_pCurrentMesh->m_faces.push_back(face);
-         m_pModelInstance->m_pCurrentMesh->m_numIndices += (uint32)face->m_pVertexIndices->size();
-         m_pModelInstance->m_pCurrentMesh->m_numUVCoordinates[0] += (uint32)face->m_pTexCoordIndices[0].size();
-         if (!m_pModelInstance->m_pCurrentMesh->m_hasNormals && hasNormal)
-         {
-            m_pModelInstance->m_pCurrentMesh->m_hasNormals = true;
-         }
-         // Skip the rest of the line
-         m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+         m_pModelInstance->m_pCurrentMesh->AddFace(type, pVertices, numVertices, pTexCoords, numTexCoords, pNormals, numNormals,
+            m_pModelInstance->m_smoothingGroup);
       }
 
       //	Get values for a new material description
@@ -485,9 +727,7 @@ namespace model
             return;
 
          const char *pStart = &(*m_dataIterator);
-         while (m_dataIterator != m_dataIteratorEndOfBuffer && !IsSpaceOrNewLine(*m_dataIterator)) {
-            m_dataIterator++;
-         }
+         m_dataIterator = core::charscan::FindSpaceOrNewLine(m_dataIterator, m_dataIteratorEndOfBuffer);
 
          // Get name
          std::string strName(pStart, &(*m_dataIterator));
@@ -520,18 +760,9 @@ namespace model
       //	Get a comment, values will be skipped
       void ObjParser::GetComment()
       {
-         while (m_dataIterator != m_dataIteratorEndOfBuffer)
-         {
-            if ('\n' == (*m_dataIterator))
-            {
-               ++m_dataIterator;
-               break;
-            }
-            else
-            {
-               ++m_dataIterator;
-            }
-         }
+         m_dataIterator = core::charscan::FindChar<'\n'>(m_dataIterator, m_dataIteratorEndOfBuffer);
+         if (m_dataIterator != m_dataIteratorEndOfBuffer)
+            ++m_dataIterator;
       }
 
       void ObjParser::GetMaterialLib()
@@ -543,16 +774,25 @@ namespace model
          }
 
          const char *pStart = &(*m_dataIterator);
-         while (m_dataIterator != m_dataIteratorEndOfBuffer && !core::IsLineEnd(*m_dataIterator)) {
-            ++m_dataIterator;
-         }
+         m_dataIterator = core::charscan::FindLineEnd(m_dataIterator, m_dataIteratorEndOfBuffer);
 
          // Check for existence
          const std::string strMatName(pStart, &(*m_dataIterator));
          //std::string strMatName(pStart, &(*m_dataIterator));
+         m_pModelInstance->m_materialLibFiles.push_back(strMatName);
+
+         if (NULL != m_pMtlCache)
+         {
+            const std::shared_ptr<const MtlLibrary> pLibrary = m_pMtlCache->Get(strMatName);
+            if (!pLibrary)
+               m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
+            else
+               pLibrary->AddToModel(m_pModelInstance);
+            return;
+         }
 
          //IOStream *pFile = m_pIO->Open(strMatName);
-         File file;
+         MappedFile file;
 
          if (!file.Open(strMatName))
          {
@@ -561,17 +801,9 @@ namespace model
             return;
          }
 
-         // Import material library data from file
-         std::vector<char> buffer;
-
-         file.CopyToBuffer(buffer);
-         //BaseImporter::TextFileToBuffer(pFile, buffer);
-         //m_pIO->Close(pFile);
+         // Importing the material library, it is read directly from the mapped file
+         ObjMtlImporter mtlImporter(file.GetData(), file.GetEnd(), m_pModelInstance);
          file.Close();
-
-         // Importing the material library
-
-         ObjMtlImporter mtlImporter(buffer, m_pModelInstance);
       }
 
       //	Set a new material definition as the current material.
@@ -660,10 +892,14 @@ namespace model
          m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
       }
 
-      //	Not supported
+      // Sets the smoothing group of the following faces, "s off" and "s 0" turn smoothing off
       void ObjParser::GetGroupNumber()
       {
-         // Not used
+         if (GetTokenEnd<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer) == m_dataIterator + 1)
+         {
+            m_dataIterator = GetSmoothingGroup(m_dataIterator + 1, m_dataIteratorEndOfBuffer, m_pModelInstance->m_smoothingGroup);
+            m_pModelInstance->m_hasSmoothingGroups = true;
+         }
 
          m_dataIterator = SkipLine<ConstDataArrayIterator_t>(m_dataIterator, m_dataIteratorEndOfBuffer, m_currentLine);
       }
@@ -685,9 +921,7 @@ namespace model
             return;
          }
          const char *pStart = &(*m_dataIterator);
-         while (m_dataIterator != m_dataIteratorEndOfBuffer && !IsSpaceOrNewLine(*m_dataIterator)) {
-            ++m_dataIterator;
-         }
+         m_dataIterator = core::charscan::FindSpaceOrNewLine(m_dataIterator, m_dataIteratorEndOfBuffer);
 
          std::string strObjectName(pStart, &(*m_dataIterator));
          if (!strObjectName.empty())
@@ -67,8 +67,20 @@ using core::fileio::File;
 
 #include "OBJFile.hpp"
 
+namespace core
+{
+   namespace thread
+   {
+      class ThreadPool;
+   }
+}
+
 namespace model
 {
+  namespace objmtlimporter
+  {
+     class MtlLibraryCache;
+  }
   
   namespace objparser
   {
@@ -88,10 +100,13 @@ namespace model
        public:
           static const size_t BUFFERSIZE = 4096;
           static const std::string DEFAULT_MATERIAL_NAME;
+          // smallest part of a file which is parsed by one task in parallel mode
+          static const size_t PARALLEL_MIN_CHUNK_SIZE = 256 * 1024;
 
           typedef std::vector<char> DataArray_t;
-          typedef std::vector<char>::iterator DataArrayIterator_t;
-          typedef std::vector<char>::const_iterator ConstDataArrayIterator_t;
+          // the parser works on a plain character range, so the data can come from a
+          // buffer as well as from a mapped file (see core::fileio::MappedFile)
+          typedef const char* ConstDataArrayIterator_t;
        private:
           //DataArrayIterator_t m_dataIterator;
           ConstDataArrayIterator_t m_dataIterator;
@@ -107,8 +122,75 @@ namespace model
           
           File *m_file;
 
+          // index lists of the face being read, kept to reuse their memory
+          std::vector<uint32> m_faceVertices;
+          std::vector<uint32> m_faceTexCoords;
+          std::vector<uint32> m_faceNormals;
+
+          // pool for the parallel mode, NULL to parse on the calling thread only
+          core::thread::ThreadPool *m_pThreadPool;
+
+          // shared material libraries, NULL to parse every referenced library
+          objmtlimporter::MtlLibraryCache *m_pMtlCache;
+
+          // A line of a chunk which changes the parser state (usemtl, mtllib, g, o, s). These
+          // are replayed in file order when the chunks are merged.
+          struct ChunkStatement
+          {
+             const char *m_pLine;
+             uint32 m_numFacesBefore;
+          };
+
+          // A face as written in the file, the indices are resolved when the chunks are merged.
+          struct ChunkFace
+          {
+             ePrimitiveType m_type;
+             uint32 m_firstCorner; // v/vt/vn triples in ParseChunk::m_corners
+             uint32 m_numCorners;
+             uint32 m_numVertices; // chunk-local counts when the face was read,
+             uint32 m_numTexCoords; // needed for relative indices
+             uint32 m_numNormals;
+          };
+
+          // Part of the file starting and ending at a line boundary, parsed by one task.
+          struct ParseChunk
+          {
+             const char *m_pBegin;
+             const char *m_pEnd;
+             std::vector<Vector3f> m_vertices;
+             std::vector<Vector3f> m_texCoords;
+             std::vector<Vector3f> m_normals;
+             std::vector<int32> m_corners; // 0 if not given, OBJ indices start at 1
+             std::vector<ChunkFace> m_faces;
+             std::vector<ChunkStatement> m_statements;
+             // resolved faces (m_numVertices is 0 for empty ones) and their index streams
+             std::vector<objfile::ObjFace> m_objFaces;
+             std::vector<uint32> m_vertexIndices;
+             std::vector<uint32> m_texCoordIndices;
+             std::vector<uint32> m_normalIndices;
+             // number of elements in all preceding chunks
+             uint32 m_baseVertex;
+             uint32 m_baseTexCoord;
+             uint32 m_baseNormal;
+
+             ParseChunk() : m_pBegin(NULL), m_pEnd(NULL), m_baseVertex(0), m_baseTexCoord(0), m_baseNormal(0) { }
+          };
+
+          // Creates the model instance and parses the data range.
+          void Init(const std::string &strModelName);
           //	Parse the loaded file
           void ParseFile();
+          // Parse the statement at the current position and move to the next one.
+          void ParseStatement();
+          // Parse the file in chunks on the thread pool, returns false if the file is too small.
+          bool ParseFileParallel();
+          // Reads the vertex data and faces of a chunk, runs on a worker thread.
+          static void ParseChunkData(ParseChunk &chunk);
+          // Copies the vertex data of a chunk into the model and resolves its faces.
+          void ResolveChunk(ParseChunk &chunk);
+          // Adds a face to the current mesh, creates object and mesh if needed.
+          void StoreFace(ePrimitiveType type, const uint32 *pVertices, uint32 numVertices,
+             const uint32 *pTexCoords, uint32 numTexCoords, const uint32 *pNormals, uint32 numNormals);
           //	Method to copy the new delimited word in the current line.
           void CopyNextWord(char *pBuffer, size_t length);
           //	Method to copy the new line.
@@ -131,7 +213,7 @@ namespace model
           void GetNewMaterial();
           // Gets the group name from file.
           void GetGroupName();
-          // Gets the group number from file.
+          // Gets the smoothing group of the following faces from file.
           void GetGroupNumber();
           // Gets the group number and resolution from file.
           void GetGroupNumberAndResolution();
@@ -149,7 +231,14 @@ namespace model
           void ReportErrorTokenInFace();
        public:
 
-          ObjParser::ObjParser(std::vector<char> &data, const std::string &strModelName, const File *file);
+          ObjParser::ObjParser(std::vector<char> &data, const std::string &strModelName, const File *file,
+             core::thread::ThreadPool *pThreadPool = NULL, objmtlimporter::MtlLibraryCache *pMtlCache = NULL);
+          // parse the range [pBegin, pEnd), the range does not need to be zero-terminated
+          // and must stay valid until the constructor returns. With a thread pool large
+          // files are split into chunks which are parsed in parallel, with a material
+          // library cache the libraries are taken from the cache
+          ObjParser(const char *pBegin, const char *pEnd, const std::string &strModelName,
+             core::thread::ThreadPool *pThreadPool = NULL, objmtlimporter::MtlLibraryCache *pMtlCache = NULL);
 
           ~ObjParser();
           objfile::Model *GetModel() const;
@@ -0,0 +1,286 @@
+#include "OBJStreamReader.hpp"
+
+#include "OBJTools.hpp"
+using objtools::GetNextWord;
+using objtools::GetTokenEnd;
+using objtools::GetName;
+using objtools::GetLineFloats;
+using objtools::GetFaceCorner;
+using objtools::GetSmoothingGroup;
+
+#include "core/charscan.hpp"
+
+#include <cassert>
+#include <cstring>
+
+namespace model
+{
+
+   namespace objparser
+   {
+
+      using mesh2::PRIMITIVE_TYPE_POLYGON;
+      using mesh2::PRIMITIVE_TYPE_LINE;
+      using mesh2::PRIMITIVE_TYPE_POINT;
+
+      // true if the line break at pBreak belongs to a line continuation
+      static bool IsContinued(const char *pLine, const char *pBreak)
+      {
+         if (*pBreak == '\n' && pBreak != pLine && *(pBreak - 1) == '\r')
+            --pBreak;
+         return (pBreak != pLine && *(pBreak - 1) == '\\');
+      }
+
+      static bool IsKeyword(const char *it, const char *end, const char *keyword)
+      {
+         const size_t length = strlen(keyword);
+         return ((size_t)(end - it) == length && strncmp(it, keyword, length) == 0);
+      }
+
+      // OBJ indices start at 1, negative ones count back from the last element read
+      static uint32 ResolveIndex(int32 index, uint32 numElements)
+      {
+         return (index > 0) ? (uint32)(index - 1) : (uint32)((int32)numElements + index);
+      }
+
+      ObjStreamReader::ObjStreamReader() :
+         m_pos(0),
+         m_size(0),
+         m_endOfFile(true),
+         m_currentLine(0),
+         m_numVertices(0),
+         m_numTexCoords(0),
+         m_numNormals(0)
+      {
+      }
+
+      bool ObjStreamReader::Open(const std::string &path, size_t windowSize)
+      {
+         if (IsOpen())
+            Close();
+
+         if (!m_file.Open(path, true))
+            return false;
+
+         m_window.resize(windowSize > 0 ? windowSize : DEFAULT_WINDOW_SIZE);
+         m_pos = 0;
+         m_size = 0;
+         m_endOfFile = false;
+         m_currentLine = 0;
+         m_numVertices = 0;
+         m_numTexCoords = 0;
+         m_numNormals = 0;
+         return true;
+      }
+
+      void ObjStreamReader::Close()
+      {
+         if (m_file.IsOpen())
+            m_file.Close();
+
+         std::vector<char>().swap(m_window);
+         m_pos = 0;
+         m_size = 0;
+         m_endOfFile = true;
+      }
+
+      void ObjStreamReader::FillWindow()
+      {
+         const size_t remaining = m_size - m_pos;
+         if (remaining > 0 && m_pos > 0)
+            memmove(&m_window[0], &m_window[m_pos], remaining);
+         m_pos = 0;
+         m_size = remaining;
+
+         // the unread part is a single line which is longer than the window
+         if (m_size == m_window.size())
+            m_window.resize(m_window.size() * 2);
+
+         const size_t numRead = m_file.Read(&m_window[m_size], m_window.size() - m_size);
+         m_size += numRead;
+         if (numRead == 0)
+            m_endOfFile = true;
+      }
+
+      bool ObjStreamReader::GetLine(const char *&pLine, const char *&pLineEnd)
+      {
+         for (;;)
+         {
+            const char *pBegin = &m_window[0] + m_pos;
+            const char *pEnd = &m_window[0] + m_size;
+
+            uint32 continuedLines = 0;
+            const char *it = pBegin;
+            while ((it = core::charscan::FindLineEnd(it, pEnd)) != pEnd)
+            {
+               // "\r\n" is one line break, the '\n' may still be unread
+               if (*it == '\r' && it + 1 == pEnd && !m_endOfFile)
+               {
+                  it = pEnd;
+                  break;
+               }
+               if (!IsContinued(pBegin, it))
+                  break;
+               if (*it == '\r' && it + 1 != pEnd && *(it + 1) == '\n')
+                  ++it;
+               ++it;
+               continuedLines++;
+            }
+
+            if (it != pEnd || (m_endOfFile && pBegin != pEnd))
+            {
+               pLine = pBegin;
+               pLineEnd = it;
+               if (it != pEnd && *it == '\r' && it + 1 != pEnd && *(it + 1) == '\n')
+                  ++it;
+               m_pos = (it != pEnd) ? (size_t)(it + 1 - &m_window[0]) : m_size;
+               m_currentLine += continuedLines + 1;
+               return true;
+            }
+
+            if (m_endOfFile)
+               return false;
+
+            FillWindow();
+         }
+      }
+
+      bool ObjStreamReader::ParseLine(const char *it, const char *end, Element &element)
+      {
+         it = GetNextWord<const char*>(it, end);
+         const char *pKeyEnd = GetTokenEnd<const char*>(it, end);
+         const size_t keyLength = pKeyEnd - it;
+         if (keyLength == 0 || *it == '#')
+            return false;
+
+         if (*it == 'v' && keyLength <= 2)
+         {
+            if (keyLength == 1)
+               element.m_type = ELEMENT_VERTEX;
+            else if (it[1] == 't')
+               element.m_type = ELEMENT_TEXCOORD;
+            else if (it[1] == 'n')
+               element.m_type = ELEMENT_NORMAL;
+            else
+               return false;
+
+            float values[3] = { 0.0f, 0.0f, 0.0f };
+            uint32 numValues;
+            GetLineFloats(pKeyEnd, end, values, 3, numValues);
+            element.m_value = Vector3f(values[0], values[1], values[2]);
+
+            if (element.m_type == ELEMENT_VERTEX)
+               m_numVertices++;
+            else if (element.m_type == ELEMENT_TEXCOORD)
+               m_numTexCoords++;
+            else
+               m_numNormals++;
+            return true;
+         }
+
+         if (keyLength == 1 && (*it == 'f' || *it == 'l' || *it == 'p'))
+         {
+            element.m_type = ELEMENT_FACE;
+            element.m_primitiveType = (*it == 'f' ? PRIMITIVE_TYPE_POLYGON : (*it == 'l' ? PRIMITIVE_TYPE_LINE : PRIMITIVE_TYPE_POINT));
+            element.m_vertexIndices.clear();
+            element.m_texCoordIndices.clear();
+            element.m_normalIndices.clear();
+
+            it = GetNextWord<const char*>(pKeyEnd, end);
+            while (it != end)
+            {
+               int32 corner[3];
+               it = GetFaceCorner(it, end, corner);
+               if (corner[0] != 0)
+                  element.m_vertexIndices.push_back(ResolveIndex(corner[0], m_numVertices));
+               if (corner[1] != 0)
+                  element.m_texCoordIndices.push_back(ResolveIndex(corner[1], m_numTexCoords));
+               if (corner[2] != 0)
+                  element.m_normalIndices.push_back(ResolveIndex(corner[2], m_numNormals));
+               it = GetNextWord<const char*>(it, end);
+            }
+            // faces without vertices are dropped like ObjParser does
+            return !element.m_vertexIndices.empty();
+         }
+
+         if (keyLength == 1 && *it == 's')
+         {
+            element.m_type = ELEMENT_SMOOTHING_GROUP;
+            GetSmoothingGroup(pKeyEnd, end, element.m_smoothingGroup);
+            return true;
+         }
+
+         if (IsKeyword(it, pKeyEnd, "usemtl"))
+            element.m_type = ELEMENT_USE_MATERIAL;
+         else if (IsKeyword(it, pKeyEnd, "mtllib"))
+            element.m_type = ELEMENT_MATERIAL_LIB;
+         else if (IsKeyword(it, pKeyEnd, "g"))
+            element.m_type = ELEMENT_GROUP;
+         else if (IsKeyword(it, pKeyEnd, "o"))
+            element.m_type = ELEMENT_OBJECT;
+         else
+            return false; // comments and unsupported statements
+
+         GetName<const char*>(GetNextWord<const char*>(pKeyEnd, end), end, element.m_name);
+         return true;
+      }
+
+      bool ObjStreamReader::Next(Element &element)
+      {
+         assert(IsOpen());
+
+         const char *pLine, *pLineEnd;
+         while (GetLine(pLine, pLineEnd))
+         {
+            if (ParseLine(pLine, pLineEnd, element))
+               return true;
+         }
+         return false;
+      }
+
+      void ObjStreamReader::Read(ObjStreamConsumer &consumer)
+      {
+         Element element;
+         while (Next(element))
+         {
+            switch (element.m_type)
+            {
+            case ELEMENT_VERTEX:
+               consumer.OnVertex(element.m_value);
+               break;
+            case ELEMENT_TEXCOORD:
+               consumer.OnTexCoord(element.m_value);
+               break;
+            case ELEMENT_NORMAL:
+               consumer.OnNormal(element.m_value);
+               break;
+            case ELEMENT_FACE:
+               consumer.OnFace(element.m_primitiveType, element.m_vertexIndices, element.m_texCoordIndices, element.m_normalIndices);
+               break;
+            case ELEMENT_USE_MATERIAL:
+               consumer.OnUseMaterial(element.m_name);
+               break;
+            case ELEMENT_MATERIAL_LIB:
+               consumer.OnMaterialLib(element.m_name);
+               break;
+            case ELEMENT_GROUP:
+               consumer.OnGroup(element.m_name);
+               break;
+            case ELEMENT_OBJECT:
+               consumer.OnObject(element.m_name);
+               break;
+            case ELEMENT_SMOOTHING_GROUP:
+               consumer.OnSmoothingGroup(element.m_smoothingGroup);
+               break;
+            }
+         }
+      }
+
+      ObjStreamReader::~ObjStreamReader()
+      {
+         Close();
+      }
+
+   } // namespace objparser
+
+} // namespace model
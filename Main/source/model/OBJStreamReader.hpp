@@ -0,0 +1,130 @@
+#ifndef _OBJSTREAMREADER_HPP_INCLUDED_
+#define _OBJSTREAMREADER_HPP_INCLUDED_
+
+// pull-mode reader for obj waveform files of any size
+
+#include <vector>
+#include <string>
+
+#include "mesh2.hpp"
+using mesh2::ePrimitiveType;
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "core/fileio/file.hpp"
+using core::fileio::File;
+
+namespace model
+{
+
+   namespace objparser
+   {
+
+      class ObjStreamConsumer;
+
+      // Reads an obj file front to back in windows of a fixed size and hands out one element
+      // (vertex, face, state statement) at a time. Only the current window is kept in memory,
+      // face indices are resolved with the running element counts, so the memory needed does
+      // not depend on the file size. Use ObjParser to build an objfile::Model instead.
+      class ObjStreamReader
+      {
+      public:
+         static const size_t DEFAULT_WINDOW_SIZE = 1024 * 1024;
+
+         enum eElementType
+         {
+            ELEMENT_VERTEX,       // v, m_value
+            ELEMENT_TEXCOORD,     // vt, m_value
+            ELEMENT_NORMAL,       // vn, m_value
+            ELEMENT_FACE,         // f, l or p, m_primitiveType and the index lists
+            ELEMENT_USE_MATERIAL, // usemtl, m_name
+            ELEMENT_MATERIAL_LIB, // mtllib, m_name
+            ELEMENT_GROUP,        // g, m_name
+            ELEMENT_OBJECT,       // o, m_name
+            ELEMENT_SMOOTHING_GROUP // s, m_smoothingGroup
+         };
+
+         struct Element
+         {
+            eElementType m_type;
+            Vector3f m_value;
+            ePrimitiveType m_primitiveType;
+            // zero-based positions in the sequence of v, vt and vn elements read so far.
+            // The lists are reused by the next element, copy them to keep them.
+            std::vector<uint32> m_vertexIndices;
+            std::vector<uint32> m_texCoordIndices;
+            std::vector<uint32> m_normalIndices;
+            std::string m_name;
+            // 0 for "s off"
+            uint32 m_smoothingGroup;
+         };
+
+      private:
+         File m_file;
+         // window into the file, m_pos is the start of the unread data, m_size the end of the valid data
+         std::vector<char> m_window;
+         size_t m_pos;
+         size_t m_size;
+         bool m_endOfFile;
+         uint32 m_currentLine;
+         uint32 m_numVertices;
+         uint32 m_numTexCoords;
+         uint32 m_numNormals;
+
+         // no copying allowed
+         ObjStreamReader(const ObjStreamReader &);
+         ObjStreamReader &operator=(const ObjStreamReader &);
+
+         // Moves the unread data to the front of the window and reads behind it, the window
+         // grows if a single line doesn't fit into it.
+         void FillWindow();
+         // Returns the next line without its line break, lines continued by '\\' are joined.
+         bool GetLine(const char *&pLine, const char *&pLineEnd);
+         // Returns false if the line holds no element (comment, empty or unsupported statement).
+         bool ParseLine(const char *it, const char *end, Element &element);
+      public:
+         ObjStreamReader();
+         ~ObjStreamReader();
+
+         // windowSize is the number of bytes read at once, it is the memory budget of the reader
+         bool Open(const std::string &path, size_t windowSize = DEFAULT_WINDOW_SIZE);
+         bool IsOpen() const { return m_file.IsOpen(); }
+         void Close();
+
+         // Reads the next element, returns false at the end of the file.
+         bool Next(Element &element);
+         // Passes all remaining elements to the consumer.
+         void Read(ObjStreamConsumer &consumer);
+
+         // number of lines read so far
+         uint32 GetCurrentLine() const { return m_currentLine; }
+         uint32 GetNumVertices() const { return m_numVertices; }
+         uint32 GetNumTexCoords() const { return m_numTexCoords; }
+         uint32 GetNumNormals() const { return m_numNormals; }
+      };
+
+      // Callback interface of ObjStreamReader::Read(), the default handlers ignore the element.
+      class ObjStreamConsumer
+      {
+      public:
+         virtual ~ObjStreamConsumer() { }
+         virtual void OnVertex(const Vector3f &position) { }
+         virtual void OnTexCoord(const Vector3f &texCoord) { }
+         virtual void OnNormal(const Vector3f &normal) { }
+         // indices are zero-based, the texture coordinate and normal lists may be empty
+         virtual void OnFace(ePrimitiveType type, const std::vector<uint32> &vertexIndices,
+            const std::vector<uint32> &texCoordIndices, const std::vector<uint32> &normalIndices) { }
+         virtual void OnUseMaterial(const std::string &name) { }
+         virtual void OnMaterialLib(const std::string &name) { }
+         virtual void OnGroup(const std::string &name) { }
+         virtual void OnObject(const std::string &name) { }
+         // group is 0 if smoothing is turned off
+         virtual void OnSmoothingGroup(uint32 group) { }
+      };
+
+   } // namespace objparser
+
+} // namespace model
+
+#endif
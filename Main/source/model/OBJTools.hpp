@@ -44,37 +44,98 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef _OBJTOOLS_HPP_INCLUDED_
 #define _OBJTOOLS_HPP_INCLUDED_
 
-#include "../core/fast_atof.hpp"
 //#include "ParsingUtils.h"
 #include <vector>
 
 //#include "core/string/string.hpp"
 //using core::string::String_c;
 #include "core/charTypes.hpp"
+#include "core/charscan.hpp"
+#include "core/fastfloat.hpp"
+
+#include <algorithm>
 
 using core::IsSpaceOrNewLine;
 
 namespace objtools
 {
-   /**	@brief	Returns true, if the last entry of the buffer is reached.
+   // character classes of the tokenizer, '\\' is included to find line continuations
+   typedef core::charscan::Or<core::charscan::LineEnd, '\\'> LineEndOrBackslash;
+   typedef core::charscan::Or<core::charscan::SpaceOrNewLine, '\\'> TokenEnd;
+   typedef core::charscan::Not<core::charscan::Blank> NotBlank;
+
+   /**	@brief	Returns the first position holding a character of the class TClass.
+   *	@param	it	Iterator of current position.
+   *	@param	end	Iterator with end of buffer.
+   *	@return	Iterator to the found character, end if there is none.
+   *	@note	Character pointers are scanned block-wise (see core/charscan.hpp),
+   *			other iterators one character at a time.
+   */
+   template<class TClass, typename TIterator>
+   inline TIterator ScanFor(TIterator it, TIterator end)
+   {
+      while (it != end && !TClass::Match(*it))
+         ++it;
+      return it;
+   }
+
+   template<class TClass>
+   inline const char *ScanFor(const char *it, const char *end)
+   {
+      return core::charscan::Find<TClass>(it, end);
+   }
+
+   template<class TClass>
+   inline char *ScanFor(char *it, char *end)
+   {
+      return core::charscan::Find<TClass>(it, end);
+   }
+
+   /**	@brief	Returns true, if the end of the buffer is reached.
    *	@param	it	Iterator of current position.
    *	@param	end	Iterator with end of buffer.
    *	@return	true, if the end of the buffer is reached.
+   *	@note	end is one past the last valid character, buffers do not need to be
+   *			zero-terminated (see ObjFileImporter's mapped read mode).
    */
    template<typename TChar>
    inline bool IsEndOfBuffer(TChar it, TChar end)
    {
-      if (it == end)
-      {
-         return true;
-      }
-      else
-      {
-         end--;
-      }
       return (it == end);
    }
 
+   /**	@brief	Returns true, if a line continuation ('\\' followed by a line break) starts at it.
+   *	@param	it	Iterator of current position.
+   *	@param	end	Iterator with end of buffer.
+   *	@return	true, if the current line is continued on the next one.
+   */
+   template<typename TChar>
+   inline bool IsLineContinuation(TChar it, TChar end)
+   {
+      if (it == end || *it != '\\')
+         return false;
+      ++it;
+      return (it != end && (*it == '\n' || *it == '\r'));
+   }
+
+   /**	@brief	Skips a line continuation, the backslash and the line break behind it.
+   *	@param	it	Iterator set to the backslash, see IsLineContinuation().
+   *	@param	end	Iterator with end of buffer.
+   *	@param	currentLine	Current line number in format
+   *	@return	Iterator to the first character of the continued line
+   */
+   template<typename TChar>
+   inline TChar SkipLineContinuation(TChar it, TChar end, uint32 &currentLine)
+   {
+      ++it;
+      if (it != end && *it == '\r')
+         ++it;
+      if (it != end && *it == '\n')
+         ++it;
+      currentLine++;
+      return it;
+   }
+
    /**	@brief	Returns next word separated by a space
    *	@param	pBuffer	Pointer to data buffer
    *	@param	pEnd	Pointer to end of buffer
@@ -83,33 +144,47 @@ namespace objtools
    template<typename TCHAR>
    inline TCHAR GetNextWord(TCHAR pBuffer, TCHAR pEnd)
    {
+      uint32 continuedLines = 0;
       while (!IsEndOfBuffer(pBuffer, pEnd))
       {
-         if (!IsSpaceOrNewLine(*pBuffer) || core::IsLineEnd(*pBuffer))
+         pBuffer = ScanFor<NotBlank>(pBuffer, pEnd);
+         if (!IsLineContinuation(pBuffer, pEnd))
             break;
-         pBuffer++;
+         pBuffer = SkipLineContinuation(pBuffer, pEnd, continuedLines);
       }
       return pBuffer;
    }
 
-   /**	@brief	Returns pointer a next token
+   /**	@brief	Returns the end of the token starting at pBuffer
    *	@param	pBuffer	Pointer to data buffer
    *	@param	pEnd	Pointer to end of buffer
-   *	@return	Pointer to next token
+   *	@return	Pointer to the first space, line end or line continuation
    */
    template<typename TCHAR>
-   inline TCHAR GetNextToken(TCHAR pBuffer, TCHAR pEnd)
+   inline TCHAR GetTokenEnd(TCHAR pBuffer, TCHAR pEnd)
    {
-      while (!IsEndOfBuffer(pBuffer, pEnd))
+      for (;;)
       {
-         if (IsSpaceOrNewLine(*pBuffer))
-            break;
+         pBuffer = ScanFor<TokenEnd>(pBuffer, pEnd);
+         if (IsEndOfBuffer(pBuffer, pEnd) || *pBuffer != '\\' || IsLineContinuation(pBuffer, pEnd))
+            return pBuffer;
+         // a backslash inside of a token
          pBuffer++;
       }
-      return GetNextWord(pBuffer, pEnd);
    }
 
-   /**	@brief	Skips a line
+   /**	@brief	Returns pointer a next token
+   *	@param	pBuffer	Pointer to data buffer
+   *	@param	pEnd	Pointer to end of buffer
+   *	@return	Pointer to next token
+   */
+   template<typename TCHAR>
+   inline TCHAR GetNextToken(TCHAR pBuffer, TCHAR pEnd)
+   {
+      return GetNextWord(GetTokenEnd(pBuffer, pEnd), pEnd);
+   }
+
+   /**	@brief	Skips a line, a line continued by '\\' counts as one line.
    *	@param	currentPos		Iterator set to current position
    *	@param	end		Iterator set to end of scratch buffer for readout
    *	@param	currentLine	Current line number in format
@@ -117,8 +192,14 @@ namespace objtools
    */
    template<typename TIterator>
    inline TIterator SkipLine(TIterator currentPos, TIterator end, uint32 &currentLine) {
-      while (!IsEndOfBuffer(currentPos, end) && !core::IsLineEnd(*currentPos)) {
-         currentPos++;
+      while (!IsEndOfBuffer(currentPos, end)) {
+         currentPos = ScanFor<LineEndOrBackslash>(currentPos, end);
+         if (IsEndOfBuffer(currentPos, end) || core::IsLineEnd(*currentPos))
+            break;
+         if (IsLineContinuation(currentPos, end))
+            currentPos = SkipLineContinuation(currentPos, end, currentLine);
+         else
+            currentPos++;
       }
       if (currentPos != end)
       {
@@ -126,9 +207,7 @@ namespace objtools
          currentLine++;
       }
       // fix .. from time to time there are spaces at the beginning of a material line
-      while (currentPos != end && (*currentPos == '\t' || *currentPos == ' '))
-         currentPos++;
-      return currentPos;
+      return ScanFor<NotBlank>(currentPos, end);
    }
 
    /**	@brief	Get a name from the current line. Preserve space in the middle,
@@ -146,26 +225,17 @@ namespace objtools
          return end;
       }
 
-      const char *pStart = &(*it);
-      while (!IsEndOfBuffer(it, end) && !core::IsLineEnd(*it)) {
-         ++it;
-      }
+      const TChar start = it;
+      it = ScanFor<core::charscan::LineEnd>(it, end);
 
-      while (IsEndOfBuffer(it, end) || core::IsLineEnd(*it) || IsSpaceOrNewLine(*it)) {
+      // trim trailing spaces, if there is no name we end up at the start again
+      while (it != start && IsSpaceOrNewLine(*(it - 1))) {
          --it;
       }
-      ++it;
 
       // Get name
-      // if there is no name, and the previous char is a separator, come back to start
-      while (&(*it) < pStart) {
-         ++it;
-      }
-      std::string strName(pStart, &(*it));
-      if (strName.empty())
-         return it;
-      else
-         name = strName;
+      if (it != start)
+         name = std::string(&(*start), &(*(it - 1)) + 1);
 
       return it;
    }
@@ -180,36 +250,131 @@ namespace objtools
    template<typename TChar>
    inline TChar CopyNextWord(TChar it, TChar end, char *pBuffer, size_t length)
    {
-      size_t index = 0;
       it = GetNextWord<TChar>(it, end);
-      while (!IsSpaceOrNewLine(*it) && !IsEndOfBuffer(it, end))
+      const TChar wordEnd = GetTokenEnd<TChar>(it, end);
+
+      // the word is cut if it doesn't fit into the buffer
+      const size_t index = std::min<size_t>(wordEnd - it, length - 1);
+      std::copy(it, it + index, pBuffer);
+      pBuffer[index] = '\0';
+      return it + index;
+   }
+
+   /**	@brief	Get next float from given line, the number is read in place
+   *	@param	it		set to current position
+   *	@param	end		set to end of scratch buffer for readout
+   *	@param	value	Separated float value, unchanged if the word is no number.
+   *	@return	Current-iterator with new position
+   */
+   inline const char *GetFloat(const char *it, const char *end, float &value)
+   {
+      it = GetNextWord<const char*>(it, end);
+      core::fastfloat::ParseFloat(it, end, value);
+      return GetTokenEnd<const char*>(it, end);
+   }
+
+   /**	@brief	Reads up to numMax floats of the current line in place, the line may be
+   *			continued by '\\' between the numbers.
+   *	@param	it		set to current position
+   *	@param	end		set to end of scratch buffer for readout
+   *	@param	pValues	Array for at least numMax values
+   *	@param	numMax	Maximum number of values to read
+   *	@param	numValues	Number of values found in the line
+   *	@return	Current-iterator with new position
+   */
+   inline const char *GetLineFloats(const char *it, const char *end, float *pValues, uint32 numMax, uint32 &numValues)
+   {
+      numValues = 0;
+      while (numValues < numMax)
       {
-         pBuffer[index] = *it;
-         index++;
-         if (index == length - 1)
+         it = GetNextWord<const char*>(it, end);
+         if (it == end || core::IsLineEnd(*it))
             break;
-         ++it;
+
+         const char *pNext = core::fastfloat::ParseFloat(it, end, pValues[numValues]);
+         if (pNext == it)
+            break;
+         numValues++;
+
+         // characters behind the number are skipped like core::fast_atof() ignores them
+         it = GetTokenEnd<const char*>(pNext, end);
       }
-      pBuffer[index] = '\0';
       return it;
    }
 
-   /**	@brief	Get next float from given line
-   *	@param	it		set to current position
+   /**	@brief	Reads a face index, the range is not zero-terminated so atoi() can't be used here.
+   *	@param	it		set to the first digit or sign
    *	@param	end		set to end of scratch buffer for readout
-   *	@param	value	Separated float value.
-   *	@return	Current-iterator with new position
+   *	@param	value	Index as written in the file
+   *	@return	Iterator behind the index, it if there is no number
    */
-   template<typename TChar>
-   inline TChar GetFloat(TChar it, TChar end, float &value)
+   inline const char *GetFaceIndex(const char *it, const char *end, int32 &value)
    {
-      char buffer[1024];
-      it = CopyNextWord<TChar>(it, end, buffer, 1024);
-      value = (float)core::fast_atof(buffer);
+      bool negative = false;
+      if (*it == '-' || *it == '+')
+      {
+         negative = (*it == '-');
+         ++it;
+      }
+
+      value = 0;
+      while (it != end && *it >= '0' && *it <= '9')
+      {
+         value = value * 10 + (*it - '0');
+         ++it;
+      }
+      if (negative)
+         value = -value;
+      return it;
+   }
 
+   /**	@brief	Reads a face corner, which is v, v/vt, v//vn or v/vt/vn.
+   *	@param	it		set to the first character of the corner
+   *	@param	end		set to end of scratch buffer for readout
+   *	@param	pCorner	v, vt and vn index as written in the file, 0 if not given
+   *	@return	Iterator behind the corner
+   */
+   inline const char *GetFaceCorner(const char *it, const char *end, int32 *pCorner)
+   {
+      pCorner[0] = pCorner[1] = pCorner[2] = 0;
+      uint32 slot = 0;
+      const char *pCornerEnd = GetTokenEnd<const char*>(it, end);
+      while (it != pCornerEnd)
+      {
+         if (*it == '/') {
+            slot++;
+            ++it;
+         }
+         else {
+            const char *pStart = it;
+            int32 value;
+            it = GetFaceIndex(it, pCornerEnd, value);
+            if (it == pStart)
+               ++it; // not a number, skip it like the serial parser does
+            else if (slot < 3)
+               pCorner[slot] = value;
+         }
+      }
       return it;
    }
 
+   /**	@brief	Reads the argument of a smoothing group statement, a group number or "off".
+   *	@param	it		set behind the 's'
+   *	@param	end		set to end of scratch buffer for readout
+   *	@param	group	Smoothing group, 0 for "off" and anything else which is no positive number
+   *	@return	Iterator behind the argument
+   */
+   inline const char *GetSmoothingGroup(const char *it, const char *end, uint32 &group)
+   {
+      it = GetNextWord<const char*>(it, end);
+      const char *pStart = it;
+      int32 value = 0;
+      if (it != end)
+         it = GetFaceIndex(it, end, value);
+      group = (it != pStart && value > 0) ? (uint32)value : 0;
+      return GetTokenEnd<const char*>(it, end);
+   }
+
    /**	@brief	Will perform a simple tokenize.
    *	@param	str			string to tokenize.
    *	@param	tokens		Array with tokens, will be empty if no token was found.
@@ -0,0 +1,145 @@
+#include "asyncImporter.hpp"
+
+#include "scene/scene.hpp"
+
+namespace importer
+{
+
+   ImportTask::ImportTask(const std::string &file, uint32 flags, ProgressHandler *pHandler) :
+      m_file(file),
+      m_flags(flags),
+      m_pHandler(pHandler),
+      m_canceled(false),
+      m_done(false),
+      m_progress(0.f),
+      m_pScene(NULL)
+   {
+      m_report.Reset(file);
+   }
+
+   ImportTask::~ImportTask()
+   {
+      delete m_pScene;
+   }
+
+   void ImportTask::Run(const Importer &settings, core::thread::ThreadPool *pPool)
+   {
+      Scene *pScene = NULL;
+      ImportReport report;
+      report.Reset(m_file);
+
+      if (!m_canceled)
+      {
+         Importer importer(settings);
+         importer.SetThreadPool(pPool);
+         importer.SetProgressHandler(this);
+         pScene = importer.ReadFile(m_file, m_flags);
+         report = importer.GetImportReport();
+      }
+
+      // a scene finished after Cancel() is dropped as well
+      if (m_canceled)
+      {
+         delete pScene;
+         pScene = NULL;
+      }
+
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_pScene = pScene;
+         m_report = report;
+         m_done = true;
+      }
+      m_finished.notify_all();
+   }
+
+   bool ImportTask::Update(float percentage)
+   {
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_progress = percentage;
+      }
+
+      if (NULL != m_pHandler && !m_pHandler->Update(percentage))
+         m_canceled = true;
+      return !m_canceled;
+   }
+
+   bool ImportTask::IsDone() const
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      return m_done;
+   }
+
+   float ImportTask::GetProgress() const
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      return m_progress;
+   }
+
+   void ImportTask::Wait() const
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_done)
+         m_finished.wait(lock);
+   }
+
+   Scene *ImportTask::GetScene()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_done)
+         m_finished.wait(lock);
+
+      Scene *pScene = m_pScene;
+      m_pScene = NULL;
+      return pScene;
+   }
+
+   ImportReport ImportTask::GetImportReport() const
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_done)
+         m_finished.wait(lock);
+      return m_report;
+   }
+
+   AsyncImporter::AsyncImporter(const Importer &settings, uint32 numThreads) :
+      m_settings(settings),
+      m_numPending(0),
+      m_pool(numThreads)
+   {
+   }
+
+   AsyncImporter::~AsyncImporter()
+   {
+      // The imports still need the pool, their parse and post processing queue work on
+      // it, which a pool being destroyed doesn't accept anymore.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (m_numPending > 0)
+         m_idle.wait(lock);
+   }
+
+   void AsyncImporter::RunTask(const ImportTaskPtr &task)
+   {
+      task->Run(m_settings, &m_pool);
+
+      // notified under the lock, the destructor may return as soon as it is released
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (0 == --m_numPending)
+         m_idle.notify_all();
+   }
+
+   ImportTaskPtr AsyncImporter::ReadFileAsync(const std::string &file, uint32 flags, ProgressHandler *pHandler)
+   {
+      // ImportTask's constructor is private, so make_shared can't be used
+      ImportTaskPtr task(new ImportTask(file, flags, pHandler));
+
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_numPending++;
+      }
+      m_pool.Enqueue([this, task]() { RunTask(task); });
+      return task;
+   }
+
+} // namespace importer
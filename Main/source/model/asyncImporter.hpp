@@ -0,0 +1,116 @@
+#ifndef _ASYNCIMPORTER_HPP_INCLUDED_
+#define _ASYNCIMPORTER_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/thread/threadpool.hpp"
+
+#include "importer.hpp"
+#include "importReport.hpp"
+#include "progressHandler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace importer
+{
+
+   class AsyncImporter;
+
+   // One import started by AsyncImporter::ReadFileAsync(). The methods may be called from
+   // any thread while the import runs on a worker thread.
+   class ImportTask : private ProgressHandler
+   {
+      friend class AsyncImporter;
+   private:
+      const std::string m_file;
+      const uint32 m_flags;
+      ProgressHandler *m_pHandler; // of the caller, may be NULL
+
+      std::atomic<bool> m_canceled;
+
+      mutable std::mutex m_mutex;
+      mutable std::condition_variable m_finished;
+      bool m_done;
+      float m_progress;
+      Scene *m_pScene; // owned until GetScene() hands it out
+      ImportReport m_report;
+
+      ImportTask(const ImportTask &);
+      ImportTask &operator=(const ImportTask &);
+
+      ImportTask(const std::string &file, uint32 flags, ProgressHandler *pHandler);
+
+      // runs the import on the calling thread with a copy of the settings of an importer
+      void Run(const Importer &settings, core::thread::ThreadPool *pPool);
+
+      // called by the importer on the worker thread
+      bool Update(float percentage);
+   public:
+      ~ImportTask();
+
+      const std::string &GetFile() const { return m_file; }
+
+      // Asks the import to stop at its next progress update. A task which hasn't started
+      // yet is skipped, GetScene() returns NULL for a canceled task.
+      void Cancel() { m_canceled = true; }
+      bool IsCanceled() const { return m_canceled; }
+
+      // true once the import has finished, failed or was canceled
+      bool IsDone() const;
+      // the last progress of the import in [0, 1]
+      float GetProgress() const;
+      // blocks until IsDone()
+      void Wait() const;
+
+      // Waits for the import and returns the scene, NULL if the import failed or was
+      // canceled. The caller takes ownership of the scene, later calls return NULL.
+      Scene *GetScene();
+      // waits for the import and returns its report
+      ImportReport GetImportReport() const;
+   };
+
+   typedef std::shared_ptr<ImportTask> ImportTaskPtr;
+
+   // Imports files on a pool of worker threads without blocking the caller. Any number of
+   // imports may run at once, each uses its own Importer with the properties of the
+   // importer the AsyncImporter was created with. Parallel parsing and post processing of
+   // a single file share the same pool.
+   class AsyncImporter
+   {
+   private:
+      const Importer m_settings;
+
+      // imports queued or running, the destructor waits until there are none
+      std::mutex m_mutex;
+      std::condition_variable m_idle;
+      uint32 m_numPending;
+
+      core::thread::ThreadPool m_pool; // destroyed first, no task outlives m_settings
+
+      // runs a queued import on a worker thread
+      void RunTask(const ImportTaskPtr &task);
+
+      AsyncImporter(const AsyncImporter &);
+      AsyncImporter &operator=(const AsyncImporter &);
+   public:
+      // numThreads == 0 starts one thread per hardware thread. Later changes of settings
+      // don't affect the AsyncImporter.
+      explicit AsyncImporter(const Importer &settings, uint32 numThreads = 0);
+      // waits for the imports which are queued or running, cancel them first to return early
+      ~AsyncImporter();
+
+      // Queues the import of a file and returns immediately, see Importer::ReadFile() for
+      // the flags. pHandler, which may be NULL, is called on the worker thread and has to
+      // stay valid until the task is done.
+      ImportTaskPtr ReadFileAsync(const std::string &file, uint32 flags, ProgressHandler *pHandler = NULL);
+
+      uint32 GetNumThreads() const { return m_pool.GetNumThreads(); }
+   };
+
+} // namespace importer
+
+#endif
@@ -0,0 +1,292 @@
+#include "bakeTransform.hpp"
+
+using mesh2::Mesh;
+using mesh2::Face;
+using mesh2::AnimMesh;
+using mesh2::Meshlet;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include <cmath>
+#include <algorithm>
+
+// Four vertices are transformed at once with SSE, define BAKETRANSFORM_NO_SIMD to use the
+// scalar code only.
+#if !defined(BAKETRANSFORM_NO_SIMD)
+#  if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#     define BAKETRANSFORM_SSE
+#     include <xmmintrin.h>
+#  endif
+#endif
+
+namespace postprocess
+{
+
+   BakeTransform::BakeTransform(const Matrix4f &transform)
+   {
+      m_identity = true;
+      for (uint8 r = 0; r < 3; r++)
+      {
+         for (uint8 c = 0; c < 4; c++)
+         {
+            m_position[r][c] = transform(r, c);
+            m_identity = m_identity && m_position[r][c] == (r == c ? 1.0f : 0.0f);
+         }
+         for (uint8 c = 0; c < 3; c++)
+            m_direction[r][c] = transform(r, c);
+      }
+
+      // the cofactors are the inverse transpose times the determinant, its sign keeps the
+      // normals on the side the flipped winding faces
+      const float (&a)[3][3] = m_direction;
+      m_normal[0][0] = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+      m_normal[0][1] = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+      m_normal[0][2] = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+      m_normal[1][0] = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+      m_normal[1][1] = a[0][0] * a[2][2] - a[0][2] * a[2][0];
+      m_normal[1][2] = a[0][1] * a[2][0] - a[0][0] * a[2][1];
+      m_normal[2][0] = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+      m_normal[2][1] = a[0][2] * a[1][0] - a[0][0] * a[1][2];
+      m_normal[2][2] = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+      m_determinant = a[0][0] * m_normal[0][0] + a[0][1] * m_normal[0][1] + a[0][2] * m_normal[0][2];
+      m_mirrored = m_determinant < 0.0f;
+      if (m_mirrored)
+      {
+         for (uint32 r = 0; r < 3; r++)
+            for (uint32 c = 0; c < 3; c++)
+               m_normal[r][c] = -m_normal[r][c];
+      }
+   }
+
+   Matrix4f BakeTransform::GetInverse() const
+   {
+      // m_normal is the transposed inverse times the absolute determinant
+      const float scale = 1.0f / fabsf(m_determinant);
+      Matrix4f inverse = Matrix4f::IDENTITY;
+      for (uint8 r = 0; r < 3; r++)
+      {
+         for (uint8 c = 0; c < 3; c++)
+            inverse(r, c) = m_normal[c][r] * scale;
+      }
+      for (uint8 r = 0; r < 3; r++)
+         inverse(r, 3) = -(inverse(r, 0) * m_position[0][3] + inverse(r, 1) * m_position[1][3] + inverse(r, 2) * m_position[2][3]);
+      return inverse;
+   }
+
+   float BakeTransform::GetMaxScale() const
+   {
+      // the square root of the largest eigenvalue of A^T A, bounded by its largest row sum
+      float maxSum = 0.0f;
+      for (uint32 r = 0; r < 3; r++)
+      {
+         float sum = 0.0f;
+         for (uint32 c = 0; c < 3; c++)
+            sum += fabsf(m_direction[0][r] * m_direction[0][c] + m_direction[1][r] * m_direction[1][c] + m_direction[2][r] * m_direction[2][c]);
+         maxSum = std::max<float>(maxSum, sum);
+      }
+      return sqrtf(maxSum);
+   }
+
+   bool BakeTransform::IsSimilarity() const
+   {
+      // the columns are orthogonal and have the same length
+      float products[3][3];
+      for (uint32 r = 0; r < 3; r++)
+      {
+         for (uint32 c = 0; c < 3; c++)
+            products[r][c] = m_direction[0][r] * m_direction[0][c] + m_direction[1][r] * m_direction[1][c] + m_direction[2][r] * m_direction[2][c];
+      }
+      const float scale = products[0][0];
+      const float tolerance = scale * 1e-4f;
+      return scale > 0.0f && fabsf(products[1][1] - scale) <= tolerance && fabsf(products[2][2] - scale) <= tolerance &&
+         fabsf(products[0][1]) <= tolerance && fabsf(products[0][2]) <= tolerance && fabsf(products[1][2]) <= tolerance;
+   }
+
+#ifdef BAKETRANSFORM_SSE
+   // four packed Vector3f as x, y and z of each
+   static inline void LoadVectors(const Vector3f *pSource, __m128 &x, __m128 &y, __m128 &z)
+   {
+      const float *pFloats = &pSource->x;
+      const __m128 v0 = _mm_loadu_ps(pFloats); // x0 y0 z0 x1
+      const __m128 v1 = _mm_loadu_ps(pFloats + 4); // y1 z1 x2 y2
+      const __m128 v2 = _mm_loadu_ps(pFloats + 8); // z2 x3 y3 z3
+      x = _mm_shuffle_ps(v0, _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+      y = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+      z = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2)), v2, _MM_SHUFFLE(3, 0, 2, 0));
+   }
+
+   static inline void StoreVectors(Vector3f *pDest, __m128 x, __m128 y, __m128 z)
+   {
+      float *pFloats = &pDest->x;
+      const __m128 xyLow = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+      const __m128 xyHigh = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+      _mm_storeu_ps(pFloats, _mm_shuffle_ps(xyLow, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+      _mm_storeu_ps(pFloats + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), xyHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+      _mm_storeu_ps(pFloats + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+   }
+
+   // the row r of m times (x, y, z)
+   static inline __m128 MultiplyRow(const float *pRow, __m128 x, __m128 y, __m128 z)
+   {
+      return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[0]), x), _mm_mul_ps(_mm_set1_ps(pRow[1]), y)), _mm_mul_ps(_mm_set1_ps(pRow[2]), z));
+   }
+#endif
+
+   void TransformPositions(const float (&m)[3][4], const Vector3f *pSource, Vector3f *pDest, uint32 count)
+   {
+      uint32 i = 0;
+#ifdef BAKETRANSFORM_SSE
+      for (; i + 4 <= count; i += 4)
+      {
+         __m128 x, y, z;
+         LoadVectors(pSource + i, x, y, z);
+         StoreVectors(pDest + i, _mm_add_ps(MultiplyRow(m[0], x, y, z), _mm_set1_ps(m[0][3])),
+            _mm_add_ps(MultiplyRow(m[1], x, y, z), _mm_set1_ps(m[1][3])),
+            _mm_add_ps(MultiplyRow(m[2], x, y, z), _mm_set1_ps(m[2][3])));
+      }
+#endif
+      for (; i < count; i++)
+      {
+         const Vector3f p = pSource[i];
+         pDest[i].x = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3];
+         pDest[i].y = m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3];
+         pDest[i].z = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3];
+      }
+   }
+
+   void TransformDirections(const float (&m)[3][3], const Vector3f *pSource, Vector3f *pDest, uint32 count)
+   {
+      uint32 i = 0;
+#ifdef BAKETRANSFORM_SSE
+      const __m128 zero = _mm_setzero_ps();
+      const __m128 one = _mm_set1_ps(1.0f);
+      for (; i + 4 <= count; i += 4)
+      {
+         __m128 x, y, z;
+         LoadVectors(pSource + i, x, y, z);
+         const __m128 tx = MultiplyRow(m[0], x, y, z), ty = MultiplyRow(m[1], x, y, z), tz = MultiplyRow(m[2], x, y, z);
+
+         // zero vectors stay zero, divided by one
+         const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+         const __m128 valid = _mm_cmpgt_ps(length, zero);
+         const __m128 divisor = _mm_or_ps(_mm_and_ps(valid, length), _mm_andnot_ps(valid, one));
+         StoreVectors(pDest + i, _mm_div_ps(tx, divisor), _mm_div_ps(ty, divisor), _mm_div_ps(tz, divisor));
+      }
+#endif
+      for (; i < count; i++)
+      {
+         const Vector3f d = pSource[i];
+         Vector3f t(m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z,
+            m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z,
+            m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z);
+         const float length = sqrtf(t.x * t.x + t.y * t.y + t.z * t.z);
+         if (length > 0.0f)
+            t = Vector3f(t.x / length, t.y / length, t.z / length);
+         pDest[i] = t;
+      }
+   }
+
+   void BakeVertices(const Mesh *pSource, const BakeTransform &transform, Mesh *pDest, uint32 first)
+   {
+      const uint32 n = pSource->m_numVertices;
+      TransformPositions(transform.m_position, pSource->m_pVertices, pDest->m_pVertices + first, n);
+      if (pSource->HasNormals())
+         TransformDirections(transform.m_normal, pSource->m_pNormals, pDest->m_pNormals + first, n);
+      if (pSource->HasTangentsAndBitangents())
+      {
+         TransformDirections(transform.m_direction, pSource->m_pTangents, pDest->m_pTangents + first, n);
+         TransformDirections(transform.m_direction, pSource->m_pBiTangets, pDest->m_pBiTangets + first, n);
+      }
+
+      if (pSource == pDest)
+         return;
+      if (pSource->HasSmoothingGroups())
+         std::copy(pSource->m_pSmoothingGroups, pSource->m_pSmoothingGroups + n, pDest->m_pSmoothingGroups + first);
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+      {
+         if (pSource->HasVertexColors(a))
+            std::copy(pSource->m_pColors[a], pSource->m_pColors[a] + n, pDest->m_pColors[a] + first);
+      }
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+      {
+         if (pSource->HasTextureCoords(a))
+            std::copy(pSource->m_pTextureCoords[a], pSource->m_pTextureCoords[a] + n, pDest->m_pTextureCoords[a] + first);
+      }
+   }
+
+   // the replaced streams of an animation mesh, the others come from the host mesh
+   static void BakeAnimMesh(AnimMesh *pAnimMesh, const BakeTransform &transform)
+   {
+      const uint32 n = pAnimMesh->m_numVertices;
+      if (NULL != pAnimMesh->m_pVertices)
+         TransformPositions(transform.m_position, pAnimMesh->m_pVertices, pAnimMesh->m_pVertices, n);
+      if (NULL != pAnimMesh->m_pNormals)
+         TransformDirections(transform.m_normal, pAnimMesh->m_pNormals, pAnimMesh->m_pNormals, n);
+      if (NULL != pAnimMesh->m_pTangents)
+         TransformDirections(transform.m_direction, pAnimMesh->m_pTangents, pAnimMesh->m_pTangents, n);
+      if (NULL != pAnimMesh->m_pBiTangets)
+         TransformDirections(transform.m_direction, pAnimMesh->m_pBiTangets, pAnimMesh->m_pBiTangets, n);
+   }
+
+   // moves the bounds of the clusters along, the cones only keep their angle if the
+   // transformation does
+   static void BakeMeshlets(Mesh *pMesh, const BakeTransform &transform)
+   {
+      const float scale = transform.GetMaxScale();
+      const bool similarity = transform.IsSimilarity();
+      for (uint32 m = 0; m < pMesh->m_numMeshlets; m++)
+      {
+         Meshlet &meshlet = pMesh->m_pMeshlets[m];
+         TransformPositions(transform.m_position, &meshlet.m_center, &meshlet.m_center, 1);
+         meshlet.m_radius *= scale;
+         if (meshlet.m_coneCutoff >= 1.0f)
+            continue;
+
+         if (similarity)
+            TransformDirections(transform.m_normal, &meshlet.m_coneAxis, &meshlet.m_coneAxis, 1);
+         else
+         {
+            meshlet.m_coneAxis = Vector3f(0.0f, 0.0f, 0.0f);
+            meshlet.m_coneCutoff = 1.0f;
+         }
+      }
+   }
+
+   void BakeMesh(Mesh *pMesh, const BakeTransform &transform)
+   {
+      if (transform.m_identity)
+         return;
+
+      pMesh->TakeOwnership();
+      BakeVertices(pMesh, transform, pMesh, 0);
+      for (uint32 a = 0; a < pMesh->m_numAnimMeshes; a++)
+         BakeAnimMesh(pMesh->m_ppAnimMeshes[a], transform);
+      if (pMesh->HasMeshlets())
+         BakeMeshlets(pMesh, transform);
+
+      // the bones see the vertices in the old space
+      if (pMesh->HasBones() && transform.IsInvertible())
+      {
+         const Matrix4f inverse = transform.GetInverse();
+         for (uint32 b = 0; b < pMesh->m_numBones; b++)
+            pMesh->m_ppBones[b]->mOffsetMatrix = pMesh->m_ppBones[b]->mOffsetMatrix * inverse;
+      }
+
+      if (!transform.m_mirrored)
+         return;
+      for (uint32 f = 0; f < pMesh->m_numFaces; f++)
+      {
+         Face &face = pMesh->m_pFaces[f];
+         std::reverse(face.m_pIndexArray, face.m_pIndexArray + face.m_numIndices);
+      }
+      for (uint32 l = 0; l < pMesh->m_numLods; l++)
+      {
+         uint32 *pIndices = pMesh->m_pLods[l].m_pIndices;
+         for (uint32 i = 0; i + 2 < pMesh->m_pLods[l].m_numIndices; i += 3)
+            std::swap(pIndices[i], pIndices[i + 2]);
+      }
+      for (uint32 t = 0; t < pMesh->m_numMeshletTriangles; t++)
+         std::swap(pMesh->m_pMeshletTriangles[t * 3], pMesh->m_pMeshletTriangles[t * 3 + 2]);
+   }
+
+} // namespace postprocess
@@ -0,0 +1,67 @@
+#ifndef _BAKETRANSFORM_HPP_INCLUDED_
+#define _BAKETRANSFORM_HPP_INCLUDED_
+
+// Transforms the vertices of meshes into another space, shared by the steps which move
+// meshes out of their nodes (PROCESS_MERGE_MESHES, PROCESS_PRE_TRANSFORM_VERTICES).
+
+#include "core/BasicTypes.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "core/math/matrix4.hpp"
+using core::math::Matrix4f;
+
+#include "mesh2.hpp"
+
+namespace postprocess
+{
+
+   // The rows of an affine transformation for positions, its upper 3x3 part for tangents
+   // and the inverse transpose of that for normals.
+   struct BakeTransform
+   {
+      float m_position[3][4];
+      float m_direction[3][3];
+      float m_normal[3][3];
+      float m_determinant; // of m_direction
+      bool m_mirrored; // the winding of the faces has to be flipped
+      bool m_identity;
+
+      explicit BakeTransform(const Matrix4f &transform);
+
+      // false if the transformation squashes space into a plane
+      bool IsInvertible() const { return m_determinant != 0.0f; }
+
+      // the inverse of the transformation, only valid if IsInvertible()
+      Matrix4f GetInverse() const;
+
+      // The largest factor the transformation stretches a length by, or a bit more for
+      // skewed transformations.
+      float GetMaxScale() const;
+
+      // true if the transformation keeps angles, it only rotates, mirrors and scales uniformly
+      bool IsSimilarity() const;
+   };
+
+   // Transforms count positions, four at once with SSE. pSource and pDest may be the same
+   // array.
+   void TransformPositions(const float (&m)[3][4], const Vector3f *pSource, Vector3f *pDest, uint32 count);
+
+   // Transforms and normalizes count directions, four at once with SSE. pSource and pDest
+   // may be the same array.
+   void TransformDirections(const float (&m)[3][3], const Vector3f *pSource, Vector3f *pDest, uint32 count);
+
+   // Writes the transformed vertex streams of pSource to pDest starting at vertex first,
+   // the other streams are copied. The streams of pDest have to be allocated like those of
+   // pSource, both may be the same mesh.
+   void BakeVertices(const mesh2::Mesh *pSource, const BakeTransform &transform, mesh2::Mesh *pDest, uint32 first);
+
+   // Transforms a mesh in place: the vertex streams, the faces, levels of detail and
+   // meshlets of mirrored transformations, the meshlet bounds, the bone offsets and the
+   // animation meshes.
+   void BakeMesh(mesh2::Mesh *pMesh, const BakeTransform &transform);
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,29 @@
+#include "baseProcess.hpp"
+
+#include "scene/scene.hpp"
+
+#include "core/thread/threadpool.hpp"
+
+namespace postprocess
+{
+
+   void MeshProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene || pScene->m_numMeshes == 0)
+         return;
+
+      if (NULL != context.m_pThreadPool && pScene->m_numMeshes > 1)
+      {
+         const PostProcessContext &constContext = context;
+         core::thread::ParallelFor(*context.m_pThreadPool, pScene->m_numMeshes, [this, pScene, &constContext](uint32 i) {
+            ProcessMesh(pScene->m_ppMeshes[i], constContext);
+         });
+      }
+      else
+      {
+         for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+            ProcessMesh(pScene->m_ppMeshes[i], context);
+      }
+   }
+
+} // namespace postprocess
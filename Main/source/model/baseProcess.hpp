@@ -0,0 +1,86 @@
+#ifndef _BASEPROCESS_HPP_INCLUDED_
+#define _BASEPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+namespace scene
+{
+   struct Scene;
+}
+
+namespace mesh2
+{
+   class Mesh;
+}
+
+namespace core
+{
+   namespace thread
+   {
+      class ThreadPool;
+   }
+}
+
+namespace importer
+{
+   class Importer;
+   class ProgressHandler;
+   struct ImportReport;
+}
+
+namespace postprocess
+{
+
+   // what the steps of one PostProcessPipeline::Execute() call share
+   struct PostProcessContext
+   {
+      const importer::Importer *m_pImporter; // for the configuration properties, may be NULL
+      core::thread::ThreadPool *m_pThreadPool; // NULL to run on the calling thread only
+      importer::ProgressHandler *m_pProgressHandler; // may be NULL
+      importer::ImportReport *m_pReport; // for the stats of the steps, may be NULL
+
+      PostProcessContext() : m_pImporter(NULL), m_pThreadPool(NULL), m_pProgressHandler(NULL), m_pReport(NULL) { }
+   };
+
+   // A post processing step, selected by one ePostProcessSteps flag. Steps are shared by
+   // importers which may run at the same time, so Execute() is const and keeps its state
+   // on the stack.
+   class BaseProcess
+   {
+   public:
+      virtual ~BaseProcess() { }
+
+      // short name used in the import report, e.g. "triangulate"
+      virtual const char *GetName() const = 0;
+      // the ePostProcessSteps flag selecting the step
+      virtual uint32 GetFlag() const = 0;
+      // steps which have to run before this one, they are enabled with it
+      virtual uint32 GetRequiredFlags() const { return 0; }
+      // steps which run before this one if they are enabled as well
+      virtual uint32 GetRunAfterFlags() const { return 0; }
+      // true if the step only has an effect on meshes whose triangles share vertices, the
+      // importers weld the vertices by default then
+      virtual bool NeedsSharedVertices() const { return false; }
+
+      // Processes the scene, throws std::exception if the scene can't be processed. The
+      // properties of the importer are read here, see PostProcessContext::m_pImporter.
+      virtual void Execute(scene::Scene *pScene, PostProcessContext &context) const = 0;
+   };
+
+   // A step which processes every mesh on its own, the meshes are processed in parallel on
+   // the thread pool of the context. A mesh loaded from the scene cache or imported into a
+   // scene::SceneArena doesn't own its arrays, call mesh2::Mesh::TakeOwnership() before
+   // replacing or resizing them.
+   class MeshProcess : public BaseProcess
+   {
+   public:
+      // calls ProcessMesh() for every mesh
+      virtual void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      // Called at the same time for different meshes, the context must only be read.
+      virtual void ProcessMesh(mesh2::Mesh *pMesh, const PostProcessContext &context) const = 0;
+   };
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,118 @@
+#include "batchImporter.hpp"
+
+#include "scene/scene.hpp"
+
+#include "core/fileio/filesys.hpp"
+#include "core/timing/stopwatch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <utility>
+
+namespace importer
+{
+
+   void BatchReport::Reset()
+   {
+      m_numFiles = 0;
+      m_numSucceeded = 0;
+      m_numFromCache = 0;
+      m_numThreads = 0;
+      m_totalTime = 0.0;
+      m_importTime = 0.0;
+      m_bytesRead = 0;
+      m_numSceneVertices = 0;
+      m_numSceneFaces = 0;
+      m_numMtlLoads = 0;
+      m_numMtlHits = 0;
+   }
+
+   void BatchReport::Add(const ImportReport &report)
+   {
+      m_numFiles++;
+      m_numSucceeded += report.m_succeeded ? 1 : 0;
+      m_numFromCache += report.m_fromCache ? 1 : 0;
+      m_importTime += report.m_totalTime;
+      m_bytesRead += report.m_bytesRead;
+      m_numSceneVertices += report.m_numSceneVertices;
+      m_numSceneFaces += report.m_numSceneFaces;
+   }
+
+   std::string BatchReport::ToJson() const
+   {
+      char buffer[1024];
+      sprintf(buffer, "{\"files\": %u, \"succeeded\": %u, \"fromCache\": %u, \"threads\": %u, "
+         "\"totalMs\": %.3f, \"importMs\": %.3f, \"filesPerSecond\": %.3f, \"megaBytesPerSecond\": %.3f, "
+         "\"bytesRead\": %llu, \"vertices\": %llu, \"faces\": %llu, \"mtlLoads\": %u, \"mtlHits\": %u}",
+         m_numFiles, m_numSucceeded, m_numFromCache, m_numThreads,
+         m_totalTime, m_importTime, GetFilesPerSecond(), GetMegaBytesPerSecond(),
+         (unsigned long long)m_bytesRead, (unsigned long long)m_numSceneVertices, (unsigned long long)m_numSceneFaces,
+         m_numMtlLoads, m_numMtlHits);
+      return buffer;
+   }
+
+   BatchImporter::BatchImporter(const Importer &settings, uint32 numThreads) :
+      m_settings(settings),
+      m_pool(numThreads)
+   {
+   }
+
+   uint32 BatchImporter::AddDirectory(const std::string &directory, const char *pattern, bool recursive)
+   {
+      const size_t numFiles = m_files.size();
+      core::filesys::ListFiles(directory, m_files, pattern, recursive);
+      return (uint32)(m_files.size() - numFiles);
+   }
+
+   BatchReport BatchImporter::Run(uint32 flags, const SceneCallback_t &callback)
+   {
+      const core::timing::Stopwatch stopwatch;
+
+      // libraries may have changed since the last run
+      m_mtlCache.Clear();
+      const uint32 numMtlLoads = m_mtlCache.GetNumLoads();
+      const uint32 numMtlHits = m_mtlCache.GetNumHits();
+
+      // largest files first, so a big file doesn't start last and finish alone
+      std::vector<std::pair<uint64, uint32> > order(m_files.size());
+      for (uint32 i = 0; i < (uint32)m_files.size(); i++)
+      {
+         uint64 size = 0, modifiedTime;
+         core::filesys::GetFileStatus(m_files[i], size, modifiedTime);
+         order[i] = std::make_pair(size, i);
+      }
+      std::stable_sort(order.begin(), order.end(),
+         [](const std::pair<uint64, uint32> &a, const std::pair<uint64, uint32> &b) { return a.first > b.first; });
+
+      BatchReport report;
+      std::mutex reportMutex;
+      core::thread::ParallelFor(m_pool, (uint32)order.size(), [&](uint32 i) {
+         const std::string &file = m_files[order[i].second];
+
+         // an importer per file, parallel parsing of large files shares the pool
+         Importer importer(m_settings);
+         importer.SetThreadPool(&m_pool);
+         importer.SetMtlLibraryCache(&m_mtlCache);
+         Scene *pScene = importer.ReadFile(file, flags);
+
+         {
+            std::unique_lock<std::mutex> lock(reportMutex);
+            report.Add(importer.GetImportReport());
+         }
+
+         if (callback)
+            callback(file, pScene, importer.GetImportReport());
+         else
+            delete pScene;
+      });
+
+      // the calling thread takes part in the work
+      report.m_numThreads = m_pool.GetNumThreads() + 1;
+      report.m_numMtlLoads = m_mtlCache.GetNumLoads() - numMtlLoads;
+      report.m_numMtlHits = m_mtlCache.GetNumHits() - numMtlHits;
+      report.m_totalTime = stopwatch.GetMilliSecs();
+      return report;
+   }
+
+} // namespace importer
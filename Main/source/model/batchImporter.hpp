@@ -0,0 +1,86 @@
+#ifndef _BATCHIMPORTER_HPP_INCLUDED_
+#define _BATCHIMPORTER_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/thread/threadpool.hpp"
+
+#include "importer.hpp"
+#include "importReport.hpp"
+#include "mtlLibraryCache.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace importer
+{
+
+   // Totals of a BatchImporter::Run() call. All times are wall times in milliseconds.
+   struct BatchReport
+   {
+      uint32 m_numFiles;
+      uint32 m_numSucceeded;
+      uint32 m_numFromCache; // loaded from the scene cache
+      uint32 m_numThreads;
+      double m_totalTime; // of the whole batch
+      double m_importTime; // sum of the times of the single imports
+      uint64 m_bytesRead;
+      uint64 m_numSceneVertices;
+      uint64 m_numSceneFaces;
+      uint32 m_numMtlLoads; // material libraries parsed
+      uint32 m_numMtlHits; // material library references served by the cache
+
+      BatchReport() { Reset(); }
+
+      void Reset();
+
+      // adds a finished import
+      void Add(const ImportReport &report);
+
+      double GetFilesPerSecond() const { return m_totalTime > 0.0 ? m_numFiles * 1000.0 / m_totalTime : 0.0; }
+      double GetMegaBytesPerSecond() const { return m_totalTime > 0.0 ? m_bytesRead / (1024.0 * 1024.0) * 1000.0 / m_totalTime : 0.0; }
+
+      // the report as a JSON object
+      std::string ToJson() const;
+   };
+
+   // Imports a list of files on all cores, e.g. the assets of a directory tree in an offline
+   // conversion. Each file is imported by its own Importer with the properties of the importer
+   // the BatchImporter was created with, material libraries referenced by several OBJ files are
+   // parsed only once per Run(). Large files are started first to keep all threads busy.
+   class BatchImporter
+   {
+   public:
+      // Receives the result of an import on the thread which imported it, it takes ownership
+      // of the scene, which is NULL if the import failed. Calls may happen at the same time.
+      typedef std::function<void(const std::string &file, Scene *pScene, const ImportReport &report)> SceneCallback_t;
+   private:
+      const Importer m_settings;
+      core::thread::ThreadPool m_pool;
+      model::objmtlimporter::MtlLibraryCache m_mtlCache;
+      std::vector<std::string> m_files;
+
+      BatchImporter(const BatchImporter &);
+      BatchImporter &operator=(const BatchImporter &);
+   public:
+      // numThreads == 0 starts one thread per hardware thread
+      explicit BatchImporter(const Importer &settings, uint32 numThreads = 0);
+
+      void AddFile(const std::string &path) { m_files.push_back(path); }
+
+      // Adds the files of a directory whose names match pattern (see core::filesys::MatchWildcard()),
+      // returns the number of files added.
+      uint32 AddDirectory(const std::string &directory, const char *pattern = "*.obj", bool recursive = true);
+
+      const std::vector<std::string> &GetFiles() const { return m_files; }
+      void ClearFiles() { m_files.clear(); }
+
+      // Imports all files with the post processing steps of flags and returns when all are
+      // done. Without a callback the scenes are deleted right away.
+      BatchReport Run(uint32 flags, const SceneCallback_t &callback = SceneCallback_t());
+   };
+
+} // namespace importer
+
+#endif
@@ -0,0 +1,261 @@
+#include "buildMeshletsProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::Meshlet;
+
+#include "scene/scene.hpp"
+
+#include "config.hpp"
+#include "importer.hpp"
+#include "importReport.hpp"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace postprocess
+{
+
+   static const uint32 DEFAULT_MAX_VERTICES = 64;
+   static const uint32 DEFAULT_MAX_TRIANGLES = 124;
+
+   // the cluster's vertices are addressed by uint8
+   static const uint32 MAX_MESHLET_VERTICES = 255;
+   static const uint8 NOT_IN_MESHLET = 0xff;
+
+   static const uint32 NO_TRIANGLE = 0xffffffff;
+
+   // Fills the bounding sphere and the normal cone of a cluster whose vertices and
+   // triangles are at the end of the arrays.
+   static void ComputeBounds(Meshlet &meshlet, const Vector3f *pPositions, const std::vector<uint32> &vertices,
+      const std::vector<uint8> &triangles)
+   {
+      const uint32 *pVertices = &vertices[meshlet.m_firstVertex];
+      const uint8 *pTriangles = &triangles[meshlet.m_firstTriangle * 3];
+
+      // a sphere around the bounding box
+      Vector3f lower = pPositions[pVertices[0]], upper = lower;
+      for (uint32 i = 1; i < meshlet.m_numVertices; i++)
+      {
+         const Vector3f &p = pPositions[pVertices[i]];
+         lower.x = std::min<float>(lower.x, p.x);
+         lower.y = std::min<float>(lower.y, p.y);
+         lower.z = std::min<float>(lower.z, p.z);
+         upper.x = std::max<float>(upper.x, p.x);
+         upper.y = std::max<float>(upper.y, p.y);
+         upper.z = std::max<float>(upper.z, p.z);
+      }
+      meshlet.m_center.x = (lower.x + upper.x) * 0.5f;
+      meshlet.m_center.y = (lower.y + upper.y) * 0.5f;
+      meshlet.m_center.z = (lower.z + upper.z) * 0.5f;
+      float radius = 0.0f;
+      for (uint32 i = 0; i < meshlet.m_numVertices; i++)
+      {
+         const Vector3f &p = pPositions[pVertices[i]];
+         const float dx = p.x - meshlet.m_center.x, dy = p.y - meshlet.m_center.y, dz = p.z - meshlet.m_center.z;
+         radius = std::max<float>(radius, dx * dx + dy * dy + dz * dz);
+      }
+      meshlet.m_radius = sqrtf(radius);
+
+      // the mean of the triangle normals and the largest deviation from it
+      std::vector<float> normals(meshlet.m_numTriangles * 3, 0.0f);
+      float axis[3] = { 0.0f, 0.0f, 0.0f };
+      for (uint32 t = 0; t < meshlet.m_numTriangles; t++)
+      {
+         const Vector3f &p0 = pPositions[pVertices[pTriangles[t * 3]]];
+         const Vector3f &p1 = pPositions[pVertices[pTriangles[t * 3 + 1]]];
+         const Vector3f &p2 = pPositions[pVertices[pTriangles[t * 3 + 2]]];
+         const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+         const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+         float *pNormal = &normals[t * 3];
+         pNormal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+         pNormal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+         pNormal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+         const float length = sqrtf(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+         for (uint32 k = 0; k < 3; k++)
+         {
+            pNormal[k] = (length > 0.0f) ? pNormal[k] / length : 0.0f;
+            axis[k] += pNormal[k];
+         }
+      }
+
+      meshlet.m_coneAxis = Vector3f(0.0f, 0.0f, 0.0f);
+      meshlet.m_coneCutoff = 1.0f;
+      const float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+      if (axisLength <= 0.0f)
+         return;
+      for (uint32 k = 0; k < 3; k++)
+         axis[k] /= axisLength;
+
+      float minDot = 1.0f;
+      for (uint32 t = 0; t < meshlet.m_numTriangles; t++)
+      {
+         const float *pNormal = &normals[t * 3];
+         if (pNormal[0] != 0.0f || pNormal[1] != 0.0f || pNormal[2] != 0.0f)
+            minDot = std::min<float>(minDot, pNormal[0] * axis[0] + pNormal[1] * axis[1] + pNormal[2] * axis[2]);
+      }
+
+      meshlet.m_coneAxis = Vector3f(axis[0], axis[1], axis[2]);
+      if (minDot > 0.0f)
+         meshlet.m_coneCutoff = sqrtf(1.0f - minDot * minDot);
+   }
+
+   void BuildMeshletsProcess::BuildMeshlets(Mesh *pMesh, uint32 maxVertices, uint32 maxTriangles)
+   {
+      if (!pMesh->HasTriangleIndexBuffer() || !pMesh->HasPositions())
+         return;
+
+      // the clusters are replaced below
+      pMesh->TakeOwnership();
+      delete[] pMesh->m_pMeshlets;
+      delete[] pMesh->m_pMeshletVertices;
+      delete[] pMesh->m_pMeshletTriangles;
+      pMesh->m_pMeshlets = NULL;
+      pMesh->m_pMeshletVertices = NULL;
+      pMesh->m_pMeshletTriangles = NULL;
+      pMesh->m_numMeshlets = pMesh->m_numMeshletVertices = pMesh->m_numMeshletTriangles = 0;
+
+      maxVertices = std::min<uint32>(std::max<uint32>(maxVertices, 3), MAX_MESHLET_VERTICES);
+      maxTriangles = std::max<uint32>(maxTriangles, 1);
+
+      const uint32 *pIndices = pMesh->m_pIndices;
+      const uint32 numTriangles = pMesh->m_numIndices / 3;
+      const uint32 numVertices = pMesh->m_numVertices;
+
+      // the triangles of every vertex
+      std::vector<uint32> offsets(numVertices + 1, 0), vertexTriangles(numTriangles * 3);
+      for (uint32 i = 0; i < numTriangles * 3; i++)
+         offsets[pIndices[i] + 1]++;
+      for (uint32 v = 0; v < numVertices; v++)
+         offsets[v + 1] += offsets[v];
+      std::vector<uint32> fill(offsets.begin(), offsets.end() - 1);
+      for (uint32 i = 0; i < numTriangles * 3; i++)
+         vertexTriangles[fill[pIndices[i]]++] = i / 3;
+
+      std::vector<Meshlet> meshlets;
+      std::vector<uint32> vertices;
+      std::vector<uint8> triangles;
+      std::vector<uint8> local(numVertices, NOT_IN_MESHLET); // index in the current cluster
+      std::vector<bool> emitted(numTriangles, false);
+      uint32 nextUnemitted = 0;
+
+      Meshlet meshlet;
+
+      // the vertices of a triangle which the current cluster doesn't have yet
+      const auto countNew = [&](uint32 t) -> uint32 {
+         const uint32 a = pIndices[t * 3], b = pIndices[t * 3 + 1], c = pIndices[t * 3 + 2];
+         return (local[a] == NOT_IN_MESHLET ? 1 : 0) + (local[b] == NOT_IN_MESHLET && b != a ? 1 : 0) +
+            (local[c] == NOT_IN_MESHLET && c != a && c != b ? 1 : 0);
+      };
+
+      for (uint32 numEmitted = 0; numEmitted < numTriangles; numEmitted++)
+      {
+         // grow the cluster by the neighbour adding the fewest vertices, the earliest of them
+         // to keep the triangle order
+         uint32 best = NO_TRIANGLE, bestNew = 4;
+         for (uint32 i = meshlet.m_firstVertex; i < meshlet.m_firstVertex + meshlet.m_numVertices; i++)
+         {
+            for (uint32 j = offsets[vertices[i]]; j < offsets[vertices[i] + 1]; j++)
+            {
+               const uint32 t = vertexTriangles[j];
+               if (emitted[t])
+                  continue;
+               const uint32 numNew = countNew(t);
+               if (numNew < bestNew || (numNew == bestNew && t < best))
+               {
+                  best = t;
+                  bestNew = numNew;
+               }
+            }
+         }
+
+         // nothing connected is left, continue with the next triangle in mesh order
+         if (best == NO_TRIANGLE)
+         {
+            while (emitted[nextUnemitted])
+               nextUnemitted++;
+            best = nextUnemitted;
+            bestNew = countNew(best);
+         }
+
+         // the cluster is full, start the next one
+         if (meshlet.m_numVertices + bestNew > maxVertices || meshlet.m_numTriangles == maxTriangles)
+         {
+            ComputeBounds(meshlet, pMesh->m_pVertices, vertices, triangles);
+            meshlets.push_back(meshlet);
+            for (uint32 i = meshlet.m_firstVertex; i < meshlet.m_firstVertex + meshlet.m_numVertices; i++)
+               local[vertices[i]] = NOT_IN_MESHLET;
+
+            meshlet = Meshlet();
+            meshlet.m_firstVertex = (uint32)vertices.size();
+            meshlet.m_firstTriangle = (uint32)triangles.size() / 3;
+         }
+
+         for (uint32 k = 0; k < 3; k++)
+         {
+            const uint32 v = pIndices[best * 3 + k];
+            if (local[v] == NOT_IN_MESHLET)
+            {
+               local[v] = (uint8)meshlet.m_numVertices++;
+               vertices.push_back(v);
+            }
+            triangles.push_back(local[v]);
+         }
+         meshlet.m_numTriangles++;
+         emitted[best] = true;
+      }
+
+      if (meshlet.m_numTriangles > 0)
+      {
+         ComputeBounds(meshlet, pMesh->m_pVertices, vertices, triangles);
+         meshlets.push_back(meshlet);
+      }
+      if (meshlets.empty())
+         return;
+
+      pMesh->m_numMeshlets = (uint32)meshlets.size();
+      pMesh->m_pMeshlets = new Meshlet[meshlets.size()];
+      std::copy(meshlets.begin(), meshlets.end(), pMesh->m_pMeshlets);
+      pMesh->m_numMeshletVertices = (uint32)vertices.size();
+      pMesh->m_pMeshletVertices = new uint32[vertices.size()];
+      std::copy(vertices.begin(), vertices.end(), pMesh->m_pMeshletVertices);
+      pMesh->m_numMeshletTriangles = (uint32)triangles.size() / 3;
+      pMesh->m_pMeshletTriangles = new uint8[triangles.size()];
+      std::copy(triangles.begin(), triangles.end(), pMesh->m_pMeshletTriangles);
+   }
+
+   void BuildMeshletsProcess::ProcessMesh(Mesh *pMesh, const PostProcessContext &context) const
+   {
+      uint32 maxVertices = DEFAULT_MAX_VERTICES, maxTriangles = DEFAULT_MAX_TRIANGLES;
+      if (NULL != context.m_pImporter)
+      {
+         maxVertices = (uint32)std::max<int32>(context.m_pImporter->GetPropertyInteger(CONFIG_PP_MESHLET_MAX_VERTICES, DEFAULT_MAX_VERTICES), 0);
+         maxTriangles = (uint32)std::max<int32>(context.m_pImporter->GetPropertyInteger(CONFIG_PP_MESHLET_MAX_TRIANGLES, DEFAULT_MAX_TRIANGLES), 0);
+      }
+      BuildMeshlets(pMesh, maxVertices, maxTriangles);
+   }
+
+   void BuildMeshletsProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      MeshProcess::Execute(pScene, context);
+      if (NULL == pScene || NULL == context.m_pReport)
+         return;
+
+      uint64 numMeshlets = 0, numVertices = 0, numTriangles = 0;
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+      {
+         const Mesh *pMesh = pScene->m_ppMeshes[i];
+         numMeshlets += pMesh->m_numMeshlets;
+         numVertices += pMesh->m_numMeshletVertices;
+         numTriangles += pMesh->m_numMeshletTriangles;
+      }
+      if (numMeshlets == 0)
+         return;
+
+      context.m_pReport->AddPostProcessStat(GetName(), "meshlets", (double)numMeshlets);
+      context.m_pReport->AddPostProcessStat(GetName(), "averageVertices", (double)numVertices / numMeshlets);
+      context.m_pReport->AddPostProcessStat(GetName(), "averageTriangles", (double)numTriangles / numMeshlets);
+   }
+
+} // namespace postprocess
@@ -0,0 +1,34 @@
+#ifndef _BUILDMESHLETSPROCESS_HPP_INCLUDED_
+#define _BUILDMESHLETSPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_BUILD_MESHLETS, see postprocess.hpp.
+   class BuildMeshletsProcess : public MeshProcess
+   {
+   public:
+      const char *GetName() const { return "buildMeshlets"; }
+      uint32 GetFlag() const { return PROCESS_BUILD_MESHLETS; }
+      uint32 GetRequiredFlags() const { return PROCESS_TRIANGULATE; }
+      // the clusters follow the cache optimized triangle order
+      uint32 GetRunAfterFlags() const { return PROCESS_IMPROVE_CACHE_LOCALITY | PROCESS_MERGE_MESHES | PROCESS_PRE_TRANSFORM_VERTICES; }
+
+      // partitions the meshes and adds the cluster counts and fill to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      void ProcessMesh(mesh2::Mesh *pMesh, const PostProcessContext &context) const;
+
+      // Replaces the clusters of one mesh, meshes with anything but triangles are left
+      // alone. maxVertices is at most 255.
+      static void BuildMeshlets(mesh2::Mesh *pMesh, uint32 maxVertices, uint32 maxTriangles);
+   };
+
+} // namespace postprocess
+
+#endif
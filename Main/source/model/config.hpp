@@ -0,0 +1,203 @@
+/*
+---------------------------------------------------------------------------
+Open Asset Import Library (assimp)
+---------------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms,
+with or without modification, are permitted provided that the following
+conditions are met:
+
+* Redistributions of source code must retain the above
+copyright notice, this list of conditions and the
+following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the
+following disclaimer in the documentation and/or other
+materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+contributors may be used to endorse or promote products
+derived from this software without specific prior
+written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+---------------------------------------------------------------------------
+*/
+
+/** @file config.hpp
+*  @brief Defines the names of all configuration properties, which can be
+*  set through Importer::SetPropertyInteger() and friends.
+*/
+
+#ifndef _CONFIG_HPP_INCLUDED_
+#define _CONFIG_HPP_INCLUDED_
+
+// ###########################################################################
+// GENERAL SETTINGS
+// ###########################################################################
+
+/** @brief Number of worker threads used by the importer.
+*
+* 0 starts one thread per hardware thread, 1 disables threading.
+* Property type: integer. Default value: 0.
+*/
+#define CONFIG_IMPORT_THREAD_COUNT "IMPORT_THREAD_COUNT"
+
+/** @brief Directory of the binary scene cache.
+*
+* If set, every imported scene is written to this directory after post
+* processing and the next import of the same file with the same flags and
+* properties maps the cached scene instead of parsing the file again. A
+* cached scene is dropped as soon as the source file or one of its material
+* libraries changes. The directory must exist.
+* Property type: string. Default value: "" (no cache).
+*/
+#define CONFIG_IMPORT_CACHE_DIRECTORY "IMPORT_CACHE_DIRECTORY"
+
+/** @brief Build the name index of the imported scene.
+*
+* scene::Scene::FindNode() and FindNodes() look the names up in a hash table
+* instead of searching the hierarchy, worth it for scenes with many nodes
+* and many lookups. The index is rebuilt after post processing steps run on
+* the scene, other changes to the hierarchy have to call
+* scene::Scene::InvalidateNodeIndex().
+* Property type: bool. Default value: false.
+*/
+#define CONFIG_IMPORT_BUILD_NODE_INDEX "IMPORT_BUILD_NODE_INDEX"
+
+/** @brief Allocate the arrays of an imported scene from one arena.
+*
+* The vertex streams, faces and face indices of the meshes and the child and
+* mesh lists of the nodes are carved out of a few large blocks of a
+* scene::SceneArena instead of thousands of separate allocations. Deleting
+* the scene frees them all at once. Arrays replaced by post processing are
+* copied out of the arena and their old memory stays unused until then.
+* Scenes loaded from the scene cache are mapped instead.
+* Property type: bool. Default value: false.
+*/
+#define CONFIG_IMPORT_SCENE_ARENA "IMPORT_SCENE_ARENA"
+
+// ###########################################################################
+// OBJ IMPORTER SETTINGS
+// ###########################################################################
+
+/** @brief Read OBJ files through a read-only memory mapping.
+*
+* The parser works directly on the mapped range instead of a private copy
+* of the file, this saves one full copy of the file content. If the file
+* can't be mapped the importer falls back to the buffered read.
+* Property type: bool. Default value: true.
+*/
+#define CONFIG_IMPORT_OBJ_MAPPED_READ "IMPORT_OBJ_MAPPED_READ"
+
+/** @brief Parse large OBJ files in parallel.
+*
+* The file is split into chunks at line boundaries, the vertex data and faces
+* of the chunks are read on the worker threads and merged in file order
+* afterwards. Only used if the file is large enough to be split.
+* Property type: bool. Default value: true.
+*/
+#define CONFIG_IMPORT_OBJ_PARALLEL_PARSE "IMPORT_OBJ_PARALLEL_PARSE"
+
+/** @brief Weld identical OBJ face corners into shared vertices.
+*
+* Every face corner with the same position, texture coordinate and normal
+* index is emitted once and referenced by all faces using it. Without it
+* every face corner becomes a vertex of its own. Sets
+* SCENE_FLAGS_NON_VERBOSE_FORMAT on the imported scene.
+* Property type: bool. Default value: true if a post processing step which
+* needs shared vertices runs (see postprocess::BaseProcess::NeedsSharedVertices(),
+* e.g. PROCESS_IMPROVE_CACHE_LOCALITY), false otherwise.
+*/
+#define CONFIG_IMPORT_OBJ_WELD_VERTICES "IMPORT_OBJ_WELD_VERTICES"
+
+// ###########################################################################
+// POST PROCESSING SETTINGS
+// ###########################################################################
+
+/** @brief Size of the vertex cache PROCESS_IMPROVE_CACHE_LOCALITY optimizes for.
+*
+* The number of vertices the post-transform cache of the target GPU holds,
+* the cache miss ratios in the import report are simulated with a FIFO
+* cache of this size. Values below 4 are raised to 4.
+* Property type: integer. Default value: 32.
+*/
+#define CONFIG_PP_ICL_CACHE_SIZE "PP_ICL_CACHE_SIZE"
+
+/** @brief Let PROCESS_IMPROVE_CACHE_LOCALITY reorder triangles against overdraw.
+*
+* The cache optimized triangle order is split into clusters at the
+* triangles which miss the cache with all corners, and the clusters are
+* sorted so that the ones facing outwards are drawn first. This trades a
+* slightly higher cache miss ratio for fewer overdrawn pixels.
+* Property type: bool. Default value: false.
+*/
+#define CONFIG_PP_ICL_OPTIMIZE_OVERDRAW "PP_ICL_OPTIMIZE_OVERDRAW"
+
+/** @brief Triangle counts of the levels PROCESS_GENERATE_LODS generates.
+*
+* Blank separated ratios between 0 and 1 relative to the triangles of the
+* mesh, at most 8 levels. A level which can't get below the previous one
+* within CONFIG_PP_LOD_MAX_ERROR ends the chain. The index buffers of the
+* levels are ordered for a vertex cache of CONFIG_PP_ICL_CACHE_SIZE entries.
+* Property type: string. Default value: "0.5 0.25 0.125".
+*/
+#define CONFIG_PP_LOD_RATIOS "PP_LOD_RATIOS"
+
+/** @brief Largest error PROCESS_GENERATE_LODS accepts for a level.
+*
+* The error is the approximate distance the surface moves, relative to the
+* largest extent of the mesh's bounding box. A level stops simplifying
+* before it gets above this and may keep more triangles than its ratio.
+* Property type: float. Default value: 0.05.
+*/
+#define CONFIG_PP_LOD_MAX_ERROR "PP_LOD_MAX_ERROR"
+
+/** @brief Most vertices of a cluster built by PROCESS_BUILD_MESHLETS.
+*
+* Values above 255 are lowered to 255, the clusters address their vertices
+* with one byte.
+* Property type: integer. Default value: 64.
+*/
+#define CONFIG_PP_MESHLET_MAX_VERTICES "PP_MESHLET_MAX_VERTICES"
+
+/** @brief Most triangles of a cluster built by PROCESS_BUILD_MESHLETS.
+*
+* Property type: integer. Default value: 124.
+*/
+#define CONFIG_PP_MESHLET_MAX_TRIANGLES "PP_MESHLET_MAX_TRIANGLES"
+
+/** @brief Most vertices of a mesh merged by PROCESS_MERGE_MESHES.
+*
+* A merged mesh is started anew before it would get more vertices, a single
+* mesh above the limit is kept as it is. The default keeps the merged meshes
+* within 16 bit indices, see mesh2::Mesh::GetIndexSize().
+* Property type: integer. Default value: 65535.
+*/
+#define CONFIG_PP_MERGE_MAX_VERTICES "PP_MERGE_MAX_VERTICES"
+
+/** @brief Nodes whose meshes PROCESS_MERGE_MESHES leaves alone.
+*
+* Blank separated names of nodes which move at runtime. Their subtrees keep
+* their meshes and transformations, only the meshes of the other nodes are
+* merged.
+* Property type: string. Default value: "".
+*/
+#define CONFIG_PP_MERGE_KEEP_NODES "PP_MERGE_KEEP_NODES"
+
+#endif
@@ -0,0 +1,665 @@
+#include "generateLodsProcess.hpp"
+
+#include "improveCacheLocalityProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::MeshLod;
+
+#include "scene/scene.hpp"
+
+#include "config.hpp"
+#include "importer.hpp"
+#include "importReport.hpp"
+
+#include "core/fastfloat.hpp"
+#include "core/thread/threadpool.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+#include <functional>
+
+namespace postprocess
+{
+
+   static const char *DEFAULT_LOD_RATIOS = "0.5 0.25 0.125";
+   static const float DEFAULT_MAX_ERROR = 0.05f;
+   static const uint32 DEFAULT_CACHE_SIZE = 32;
+   static const uint32 MAX_LODS = 8;
+
+   static const uint32 NO_VERTEX = 0xffffffff;
+
+   // weight of the planes through border and seam edges, relative to the surface planes
+   static const double BORDER_WEIGHT = 10.0;
+
+   // the squared attribute distances of a collapse add to its squared relative position error
+   static const double NORMAL_WEIGHT = 0.0025;
+   static const double TEXCOORD_WEIGHT = 0.01;
+
+   // a collapse may turn the normal of a remaining triangle by about 75 degrees at most
+   static const double MIN_NORMAL_COSINE = 0.25;
+
+   // The squared distance to a set of planes, error(p) = p'Ap + 2b'p + c with the symmetric
+   // matrix A. The planes are weighted, by area for the triangles.
+   struct GenerateLodsProcess::Quadric
+   {
+      double m_a00, m_a11, m_a22, m_a01, m_a02, m_a12;
+      double m_b0, m_b1, m_b2;
+      double m_c;
+      double m_weight;
+
+      Quadric() : m_a00(0.0), m_a11(0.0), m_a22(0.0), m_a01(0.0), m_a02(0.0), m_a12(0.0),
+         m_b0(0.0), m_b1(0.0), m_b2(0.0), m_c(0.0), m_weight(0.0)
+      {
+      }
+
+      // the plane n'p + d = 0 with the normalized normal n
+      void AddPlane(double nx, double ny, double nz, double d, double weight)
+      {
+         m_a00 += weight * nx * nx;
+         m_a11 += weight * ny * ny;
+         m_a22 += weight * nz * nz;
+         m_a01 += weight * nx * ny;
+         m_a02 += weight * nx * nz;
+         m_a12 += weight * ny * nz;
+         m_b0 += weight * nx * d;
+         m_b1 += weight * ny * d;
+         m_b2 += weight * nz * d;
+         m_c += weight * d * d;
+         m_weight += weight;
+      }
+
+      void Add(const Quadric &other)
+      {
+         m_a00 += other.m_a00;
+         m_a11 += other.m_a11;
+         m_a22 += other.m_a22;
+         m_a01 += other.m_a01;
+         m_a02 += other.m_a02;
+         m_a12 += other.m_a12;
+         m_b0 += other.m_b0;
+         m_b1 += other.m_b1;
+         m_b2 += other.m_b2;
+         m_c += other.m_c;
+         m_weight += other.m_weight;
+      }
+
+      // the weighted mean of the squared distances
+      double GetError(const Vector3f &p) const
+      {
+         if (m_weight <= 0.0)
+            return 0.0;
+         const double x = p.x, y = p.y, z = p.z;
+         const double r = m_a00 * x * x + m_a11 * y * y + m_a22 * z * z +
+            2.0 * (m_a01 * x * y + m_a02 * x * z + m_a12 * y * z) +
+            2.0 * (m_b0 * x + m_b1 * y + m_b2 * z) + m_c;
+         return fabs(r) / m_weight;
+      }
+   };
+
+   // Half edge collapses on a triangle list, a vertex moves onto a neighbour and its
+   // triangles with both of them disappear. Vertices with the same position form a ring
+   // of wedges, a position with two wedges lies on an attribute seam, both of them collapse
+   // along the seam at the same time.
+   struct GenerateLodsProcess::Simplifier
+   {
+      enum eVertexKind
+      {
+         KIND_MANIFOLD, // may collapse onto any neighbour
+         KIND_BORDER, // may only collapse along the open border
+         KIND_SEAM, // may only collapse along the seam, together with its other wedge
+         KIND_LOCKED // doesn't move
+      };
+
+      struct Collapse
+      {
+         uint32 m_from;
+         uint32 m_to;
+         double m_cost;
+
+         bool operator<(const Collapse &other) const { return m_cost < other.m_cost; }
+      };
+
+      const SimplifyInput &m_input;
+      double m_scale; // the largest extent of the bounding box
+      std::vector<uint32> m_indices; // the current triangle list
+
+      std::vector<uint32> m_remap; // the first wedge of every position
+      std::vector<uint32> m_wedge; // the next wedge with the same position
+      std::vector<uint8> m_kinds;
+      std::vector<Quadric> m_quadrics; // by m_remap
+
+      // Every corner of m_indices, grouped by vertex at m_offsets: the half edge leaving the
+      // vertex in the corner's triangle and the triangle.
+      std::vector<uint32> m_offsets;
+      std::vector<uint32> m_edgeTargets;
+      std::vector<uint32> m_triangles;
+
+      explicit Simplifier(const SimplifyInput &input) : m_input(input), m_scale(1.0),
+         m_indices(input.m_pIndices, input.m_pIndices + input.m_numIndices)
+      {
+         BuildAdjacency();
+         BuildWedges();
+         Classify();
+         BuildQuadrics();
+      }
+
+      const Vector3f &GetPosition(uint32 v) const { return m_input.m_pPositions[v]; }
+
+      void BuildAdjacency()
+      {
+         const uint32 numVertices = m_input.m_numVertices;
+         m_offsets.assign(numVertices + 1, 0);
+         for (size_t i = 0; i < m_indices.size(); i++)
+            m_offsets[m_indices[i] + 1]++;
+         for (uint32 v = 0; v < numVertices; v++)
+            m_offsets[v + 1] += m_offsets[v];
+
+         m_edgeTargets.resize(m_indices.size());
+         m_triangles.resize(m_indices.size());
+         std::vector<uint32> fill(m_offsets.begin(), m_offsets.end() - 1);
+         for (uint32 t = 0; t < m_indices.size() / 3; t++)
+         {
+            for (uint32 k = 0; k < 3; k++)
+            {
+               const uint32 v = m_indices[t * 3 + k];
+               m_edgeTargets[fill[v]] = m_indices[t * 3 + (k + 1) % 3];
+               m_triangles[fill[v]++] = t;
+            }
+         }
+      }
+
+      bool HasEdge(uint32 a, uint32 b) const
+      {
+         for (uint32 i = m_offsets[a]; i < m_offsets[a + 1]; i++)
+         {
+            if (m_edgeTargets[i] == b)
+               return true;
+         }
+         return false;
+      }
+
+      // an edge with a single triangle, a border or seam edge
+      bool IsOpenEdge(uint32 a, uint32 b) const
+      {
+         return !HasEdge(a, b) || !HasEdge(b, a);
+      }
+
+      void BuildWedges()
+      {
+         const uint32 numVertices = m_input.m_numVertices;
+         m_remap.resize(numVertices);
+         m_wedge.resize(numVertices);
+         std::vector<uint32> used;
+         for (uint32 v = 0; v < numVertices; v++)
+         {
+            m_remap[v] = m_wedge[v] = v;
+            if (m_offsets[v + 1] > m_offsets[v])
+               used.push_back(v);
+         }
+         if (used.empty())
+            return;
+
+         float lower[3] = { GetPosition(used[0]).x, GetPosition(used[0]).y, GetPosition(used[0]).z };
+         float upper[3] = { lower[0], lower[1], lower[2] };
+         for (size_t i = 1; i < used.size(); i++)
+         {
+            const Vector3f &p = GetPosition(used[i]);
+            const float c[3] = { p.x, p.y, p.z };
+            for (uint32 k = 0; k < 3; k++)
+            {
+               lower[k] = std::min(lower[k], c[k]);
+               upper[k] = std::max(upper[k], c[k]);
+            }
+         }
+         m_scale = std::max(std::max(upper[0] - lower[0], upper[1] - lower[1]), upper[2] - lower[2]);
+         if (m_scale <= 0.0)
+            m_scale = 1.0;
+
+         // vertices with the same position end up next to each other
+         const Vector3f *pPositions = m_input.m_pPositions;
+         std::sort(used.begin(), used.end(), [pPositions](uint32 a, uint32 b) {
+            const Vector3f &pa = pPositions[a], &pb = pPositions[b];
+            if (pa.x != pb.x) return pa.x < pb.x;
+            if (pa.y != pb.y) return pa.y < pb.y;
+            if (pa.z != pb.z) return pa.z < pb.z;
+            return a < b;
+         });
+
+         for (size_t first = 0, last; first < used.size(); first = last)
+         {
+            const Vector3f &p = GetPosition(used[first]);
+            for (last = first + 1; last < used.size(); last++)
+            {
+               const Vector3f &q = GetPosition(used[last]);
+               if (q.x != p.x || q.y != p.y || q.z != p.z)
+                  break;
+            }
+            for (size_t i = first; i < last; i++)
+            {
+               m_remap[used[i]] = used[first];
+               m_wedge[used[i]] = used[(i + 1 < last) ? i + 1 : first];
+            }
+         }
+      }
+
+      void Classify()
+      {
+         const uint32 numVertices = m_input.m_numVertices;
+
+         // the open half edge leaving and entering every vertex, NO_VERTEX if there is
+         // none and the vertex itself if there are several
+         std::vector<uint32> openOut(numVertices, NO_VERTEX), openIn(numVertices, NO_VERTEX);
+         for (uint32 v = 0; v < numVertices; v++)
+         {
+            for (uint32 i = m_offsets[v]; i < m_offsets[v + 1]; i++)
+            {
+               const uint32 w = m_edgeTargets[i];
+               if (HasEdge(w, v))
+                  continue;
+               openOut[v] = (openOut[v] == NO_VERTEX) ? w : v;
+               openIn[w] = (openIn[w] == NO_VERTEX) ? v : w;
+            }
+         }
+
+         m_kinds.assign(numVertices, KIND_LOCKED);
+         for (uint32 v = 0; v < numVertices; v++)
+         {
+            if (m_remap[v] != v || m_offsets[v + 1] == m_offsets[v])
+               continue;
+
+            const uint32 w = m_wedge[v];
+            if (w == v)
+            {
+               if (openOut[v] == NO_VERTEX && openIn[v] == NO_VERTEX)
+                  m_kinds[v] = KIND_MANIFOLD;
+               else if (IsSingle(openOut[v], v) && IsSingle(openIn[v], v))
+                  m_kinds[v] = KIND_BORDER;
+            }
+            else if (m_wedge[w] == v)
+            {
+               // the open edges of both wedges have to run along the same positions
+               if (IsSingle(openOut[v], v) && IsSingle(openIn[v], v) && IsSingle(openOut[w], w) && IsSingle(openIn[w], w) &&
+                  m_remap[openOut[v]] == m_remap[openIn[w]] && m_remap[openIn[v]] == m_remap[openOut[w]])
+               {
+                  m_kinds[v] = m_kinds[w] = KIND_SEAM;
+               }
+            }
+         }
+      }
+
+      static bool IsSingle(uint32 open, uint32 v)
+      {
+         return open != NO_VERTEX && open != v;
+      }
+
+      void BuildQuadrics()
+      {
+         m_quadrics.assign(m_input.m_numVertices, Quadric());
+         for (uint32 t = 0; t < m_indices.size() / 3; t++)
+         {
+            const uint32 *pTriangle = &m_indices[t * 3];
+            const Vector3f &p0 = GetPosition(pTriangle[0]), &p1 = GetPosition(pTriangle[1]), &p2 = GetPosition(pTriangle[2]);
+            const double e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            const double e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+            double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length <= 0.0)
+               continue;
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+
+            const double d = -(n[0] * p0.x + n[1] * p0.y + n[2] * p0.z);
+            for (uint32 k = 0; k < 3; k++)
+               m_quadrics[m_remap[pTriangle[k]]].AddPlane(n[0], n[1], n[2], d, length * 0.5);
+
+            // a plane perpendicular to the triangle keeps border and seam edges in place
+            for (uint32 k = 0; k < 3; k++)
+            {
+               const uint32 a = pTriangle[k], b = pTriangle[(k + 1) % 3];
+               if (HasEdge(b, a))
+                  continue;
+
+               const Vector3f &pa = GetPosition(a), &pb = GetPosition(b);
+               const double e[3] = { pb.x - pa.x, pb.y - pa.y, pb.z - pa.z };
+               double m[3] = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0] };
+               const double edgeLength = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+               if (edgeLength <= 0.0)
+                  continue;
+               m[0] /= edgeLength;
+               m[1] /= edgeLength;
+               m[2] /= edgeLength;
+
+               const double md = -(m[0] * pa.x + m[1] * pa.y + m[2] * pa.z);
+               m_quadrics[m_remap[a]].AddPlane(m[0], m[1], m[2], md, edgeLength * edgeLength * BORDER_WEIGHT);
+               m_quadrics[m_remap[b]].AddPlane(m[0], m[1], m[2], md, edgeLength * edgeLength * BORDER_WEIGHT);
+            }
+         }
+      }
+
+      // The vertices moving with a collapse of from onto to, false if it isn't allowed. A
+      // seam collapse moves the other wedge as well, otherwise partnerFrom is NO_VERTEX.
+      bool CanCollapse(uint32 from, uint32 to, uint32 &partnerFrom, uint32 &partnerTo) const
+      {
+         partnerFrom = partnerTo = NO_VERTEX;
+         const uint8 kindFrom = m_kinds[m_remap[from]], kindTo = m_kinds[m_remap[to]];
+         if (m_remap[from] == m_remap[to])
+            return false;
+
+         switch (kindFrom)
+         {
+         case KIND_MANIFOLD:
+            return true;
+         case KIND_BORDER:
+            return kindTo == KIND_BORDER && IsOpenEdge(from, to);
+         case KIND_SEAM:
+            if (kindTo != KIND_SEAM || !IsOpenEdge(from, to))
+               return false;
+            partnerFrom = m_wedge[from];
+            partnerTo = m_wedge[to];
+            return HasEdge(partnerFrom, partnerTo) || HasEdge(partnerTo, partnerFrom);
+         default:
+            return false;
+         }
+      }
+
+      // the squared position error relative to the mesh size
+      double GetPositionCost(uint32 from, uint32 to) const
+      {
+         Quadric quadric = m_quadrics[m_remap[from]];
+         quadric.Add(m_quadrics[m_remap[to]]);
+         return quadric.GetError(GetPosition(to)) / (m_scale * m_scale);
+      }
+
+      double GetAttributeCost(uint32 from, uint32 to) const
+      {
+         double cost = 0.0;
+         if (NULL != m_input.m_pNormals)
+         {
+            const Vector3f &a = m_input.m_pNormals[from], &b = m_input.m_pNormals[to];
+            cost += NORMAL_WEIGHT * ((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+         }
+         if (NULL != m_input.m_pTextureCoords)
+         {
+            const Vector3f &a = m_input.m_pTextureCoords[from], &b = m_input.m_pTextureCoords[to];
+            cost += TEXCOORD_WEIGHT * ((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+         }
+         return cost;
+      }
+
+      // true if moving from onto the position of to turns one of the remaining triangles around from over
+      bool IsFlipping(uint32 from, uint32 to) const
+      {
+         const Vector3f &pFrom = GetPosition(from), &pTo = GetPosition(to);
+         for (uint32 i = m_offsets[from]; i < m_offsets[from + 1]; i++)
+         {
+            const uint32 t = m_triangles[i];
+            uint32 corner = 0;
+            while (m_indices[t * 3 + corner] != from)
+               corner++;
+            const uint32 q = m_indices[t * 3 + (corner + 1) % 3], r = m_indices[t * 3 + (corner + 2) % 3];
+            if (m_remap[q] == m_remap[to] || m_remap[r] == m_remap[to])
+               continue;
+
+            const Vector3f &pq = GetPosition(q), &pr = GetPosition(r);
+            const double n0[3] = {
+               (pq.y - pFrom.y) * (pr.z - pFrom.z) - (pq.z - pFrom.z) * (pr.y - pFrom.y),
+               (pq.z - pFrom.z) * (pr.x - pFrom.x) - (pq.x - pFrom.x) * (pr.z - pFrom.z),
+               (pq.x - pFrom.x) * (pr.y - pFrom.y) - (pq.y - pFrom.y) * (pr.x - pFrom.x) };
+            const double n1[3] = {
+               (pq.y - pTo.y) * (pr.z - pTo.z) - (pq.z - pTo.z) * (pr.y - pTo.y),
+               (pq.z - pTo.z) * (pr.x - pTo.x) - (pq.x - pTo.x) * (pr.z - pTo.z),
+               (pq.x - pTo.x) * (pr.y - pTo.y) - (pq.y - pTo.y) * (pr.x - pTo.x) };
+            const double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+            const double lengths = sqrt((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+            if (dot < MIN_NORMAL_COSINE * lengths)
+               return true;
+         }
+         return false;
+      }
+
+      // Runs the cheapest collapses which don't share a position, up to targetIndices and
+      // maxCost. error is raised to the position cost of the collapses, returns false if
+      // none was possible.
+      bool CollapsePass(uint32 targetIndices, double maxCost, double &error)
+      {
+         BuildAdjacency();
+
+         // every edge in the cheaper direction
+         std::vector<Collapse> collapses;
+         uint32 partnerFrom, partnerTo;
+         for (size_t i = 0; i < m_indices.size(); i++)
+         {
+            const uint32 a = m_indices[i], b = m_indices[i - i % 3 + (i % 3 + 1) % 3];
+            if (a > b && HasEdge(b, a))
+               continue;
+
+            Collapse collapse = { NO_VERTEX, NO_VERTEX, 0.0 };
+            if (CanCollapse(a, b, partnerFrom, partnerTo))
+            {
+               collapse.m_from = a;
+               collapse.m_to = b;
+               collapse.m_cost = GetPositionCost(a, b) + GetAttributeCost(a, b) +
+                  ((partnerFrom != NO_VERTEX) ? GetAttributeCost(partnerFrom, partnerTo) : 0.0);
+            }
+            if (CanCollapse(b, a, partnerFrom, partnerTo))
+            {
+               const double cost = GetPositionCost(b, a) + GetAttributeCost(b, a) +
+                  ((partnerFrom != NO_VERTEX) ? GetAttributeCost(partnerFrom, partnerTo) : 0.0);
+               if (collapse.m_from == NO_VERTEX || cost < collapse.m_cost)
+               {
+                  collapse.m_from = b;
+                  collapse.m_to = a;
+                  collapse.m_cost = cost;
+               }
+            }
+            if (collapse.m_from != NO_VERTEX && collapse.m_cost <= maxCost)
+               collapses.push_back(collapse);
+         }
+         std::sort(collapses.begin(), collapses.end());
+
+         const uint32 numVertices = m_input.m_numVertices;
+         std::vector<uint32> targets(numVertices, NO_VERTEX);
+         std::vector<bool> locked(numVertices, false); // by position
+         uint32 numRemoved = 0;
+         const uint32 numRemovable = (uint32)(m_indices.size() - targetIndices) / 3;
+         bool collapsed = false;
+         for (size_t i = 0; i < collapses.size() && numRemoved < numRemovable; i++)
+         {
+            const uint32 from = collapses[i].m_from, to = collapses[i].m_to;
+            if (locked[m_remap[from]] || locked[m_remap[to]])
+               continue;
+
+            CanCollapse(from, to, partnerFrom, partnerTo);
+            if (IsFlipping(from, to) || (partnerFrom != NO_VERTEX && IsFlipping(partnerFrom, partnerTo)))
+               continue;
+
+            error = std::max(error, GetPositionCost(from, to));
+            targets[from] = to;
+            if (partnerFrom != NO_VERTEX)
+               targets[partnerFrom] = partnerTo;
+            m_quadrics[m_remap[to]].Add(m_quadrics[m_remap[from]]);
+            locked[m_remap[from]] = locked[m_remap[to]] = true;
+            numRemoved += (m_kinds[m_remap[from]] == KIND_BORDER) ? 1 : 2;
+            collapsed = true;
+         }
+         if (!collapsed)
+            return false;
+
+         // move the vertices and drop the triangles which lost their area
+         size_t numIndices = 0;
+         for (size_t t = 0; t < m_indices.size(); t += 3)
+         {
+            uint32 triangle[3];
+            for (uint32 k = 0; k < 3; k++)
+            {
+               const uint32 v = m_indices[t + k];
+               triangle[k] = (targets[v] != NO_VERTEX) ? targets[v] : v;
+            }
+            if (m_remap[triangle[0]] == m_remap[triangle[1]] || m_remap[triangle[1]] == m_remap[triangle[2]] ||
+               m_remap[triangle[2]] == m_remap[triangle[0]])
+               continue;
+            std::copy(triangle, triangle + 3, &m_indices[numIndices]);
+            numIndices += 3;
+         }
+         m_indices.resize(numIndices);
+         return true;
+      }
+   };
+
+   void GenerateLodsProcess::Simplify(const SimplifyInput &input, const std::vector<uint32> &targets, float maxError,
+      std::vector<SimplifyResult> &results)
+   {
+      results.clear();
+      if (NULL == input.m_pPositions || input.m_numIndices < 3)
+         return;
+
+      Simplifier simplifier(input);
+      const double maxCost = (double)maxError * maxError;
+      double error = 0.0;
+      size_t lastSize = input.m_numIndices;
+      for (size_t i = 0; i < targets.size(); i++)
+      {
+         while (simplifier.m_indices.size() > targets[i] && simplifier.CollapsePass(targets[i], maxCost, error))
+            ;
+
+         // the error limit is reached
+         if (simplifier.m_indices.size() >= lastSize)
+            break;
+
+         SimplifyResult result;
+         result.m_indices = simplifier.m_indices;
+         result.m_error = (float)sqrt(error);
+         results.push_back(result);
+         lastSize = simplifier.m_indices.size();
+         if (lastSize > targets[i])
+            break;
+      }
+   }
+
+   void GenerateLodsProcess::GenerateLods(Mesh *pMesh, const std::vector<float> &ratios, float maxError, uint32 cacheSize)
+   {
+      if (!pMesh->HasTriangleIndexBuffer() || !pMesh->HasPositions())
+         return;
+
+      // the levels are replaced below
+      pMesh->TakeOwnership();
+      for (uint32 l = 0; l < pMesh->m_numLods; l++)
+         delete[] pMesh->m_pLods[l].m_pIndices;
+      delete[] pMesh->m_pLods;
+      pMesh->m_pLods = NULL;
+      pMesh->m_numLods = 0;
+
+      const uint32 numTriangles = pMesh->m_numIndices / 3;
+      std::vector<uint32> targets;
+      for (size_t i = 0; i < ratios.size(); i++)
+      {
+         const uint32 target = std::max<uint32>((uint32)(numTriangles * ratios[i] + 0.5f), 1) * 3;
+         if (target < (targets.empty() ? pMesh->m_numIndices : targets.back()))
+            targets.push_back(target);
+      }
+      if (targets.empty())
+         return;
+
+      SimplifyInput input;
+      input.m_pPositions = pMesh->m_pVertices;
+      input.m_pNormals = pMesh->m_pNormals;
+      input.m_pTextureCoords = pMesh->m_pTextureCoords[0];
+      input.m_numVertices = pMesh->m_numVertices;
+      input.m_pIndices = pMesh->m_pIndices;
+      input.m_numIndices = pMesh->m_numIndices;
+
+      std::vector<SimplifyResult> results;
+      Simplify(input, targets, maxError, results);
+      if (results.empty())
+         return;
+
+      pMesh->m_pLods = new MeshLod[results.size()];
+      pMesh->m_numLods = (uint32)results.size();
+      for (size_t l = 0; l < results.size(); l++)
+      {
+         MeshLod &lod = pMesh->m_pLods[l];
+         lod.m_numIndices = (uint32)results[l].m_indices.size();
+         lod.m_pIndices = new uint32[lod.m_numIndices];
+         lod.m_error = results[l].m_error;
+         std::copy(results[l].m_indices.begin(), results[l].m_indices.end(), lod.m_pIndices);
+         ImproveCacheLocalityProcess::OptimizeTriangleOrder(lod.m_pIndices, lod.m_numIndices / 3, pMesh->m_numVertices, cacheSize);
+      }
+   }
+
+   void GenerateLodsProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene || pScene->m_numMeshes == 0)
+         return;
+
+      std::string ratioText = DEFAULT_LOD_RATIOS;
+      float maxError = DEFAULT_MAX_ERROR;
+      int32 cacheSize = DEFAULT_CACHE_SIZE;
+      if (NULL != context.m_pImporter)
+      {
+         ratioText = context.m_pImporter->GetPropertyString(CONFIG_PP_LOD_RATIOS, DEFAULT_LOD_RATIOS);
+         maxError = context.m_pImporter->GetPropertyFloat(CONFIG_PP_LOD_MAX_ERROR, DEFAULT_MAX_ERROR);
+         cacheSize = context.m_pImporter->GetPropertyInteger(CONFIG_PP_ICL_CACHE_SIZE, DEFAULT_CACHE_SIZE);
+      }
+      if (cacheSize < 4)
+         cacheSize = 4;
+
+      // the ratios between 0 and 1, finest first
+      float values[MAX_LODS];
+      uint32 numValues = 0;
+      core::fastfloat::ParseFloats(ratioText.c_str(), ratioText.c_str() + ratioText.size(), values, MAX_LODS, numValues);
+      std::vector<float> ratios;
+      for (uint32 i = 0; i < numValues; i++)
+      {
+         if (values[i] > 0.0f && values[i] < 1.0f)
+            ratios.push_back(values[i]);
+      }
+      std::sort(ratios.begin(), ratios.end(), std::greater<float>());
+      ratios.erase(std::unique(ratios.begin(), ratios.end()), ratios.end());
+      if (ratios.empty())
+         return;
+
+      if (NULL != context.m_pThreadPool && pScene->m_numMeshes > 1)
+      {
+         core::thread::ParallelFor(*context.m_pThreadPool, pScene->m_numMeshes, [pScene, &ratios, maxError, cacheSize](uint32 i) {
+            GenerateLods(pScene->m_ppMeshes[i], ratios, maxError, cacheSize);
+         });
+      }
+      else
+      {
+         for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+            GenerateLods(pScene->m_ppMeshes[i], ratios, maxError, cacheSize);
+      }
+
+      if (NULL == context.m_pReport)
+         return;
+
+      // the triangles of every level relative to the meshes which have it and its largest error
+      for (uint32 l = 0; l < ratios.size(); l++)
+      {
+         uint64 numIndices = 0, numLodIndices = 0;
+         float error = 0.0f;
+         for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+         {
+            const Mesh *pMesh = pScene->m_ppMeshes[i];
+            if (l >= pMesh->m_numLods)
+               continue;
+            numIndices += pMesh->m_numIndices;
+            numLodIndices += pMesh->m_pLods[l].m_numIndices;
+            error = std::max(error, pMesh->m_pLods[l].m_error);
+         }
+         if (numIndices == 0)
+            break;
+
+         char name[32];
+         sprintf(name, "lod%uRatio", l + 1);
+         context.m_pReport->AddPostProcessStat(GetName(), name, (double)numLodIndices / numIndices);
+         sprintf(name, "lod%uError", l + 1);
+         context.m_pReport->AddPostProcessStat(GetName(), name, error);
+      }
+   }
+
+} // namespace postprocess
@@ -0,0 +1,68 @@
+#ifndef _GENERATELODSPROCESS_HPP_INCLUDED_
+#define _GENERATELODSPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include <vector>
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_GENERATE_LODS, see postprocess.hpp.
+   class GenerateLodsProcess : public BaseProcess
+   {
+   private:
+      // the simplifier's state, defined in the source file
+      struct Quadric;
+      struct Simplifier;
+   public:
+      // A triangle list and the vertices it references, the attribute arrays may be NULL.
+      struct SimplifyInput
+      {
+         const Vector3f *m_pPositions;
+         const Vector3f *m_pNormals;
+         const Vector3f *m_pTextureCoords;
+         uint32 m_numVertices;
+         const uint32 *m_pIndices;
+         uint32 m_numIndices;
+      };
+
+      // one level of a simplified triangle list
+      struct SimplifyResult
+      {
+         std::vector<uint32> m_indices;
+         float m_error; // see mesh2::MeshLod::m_error
+      };
+
+      const char *GetName() const { return "generateLods"; }
+      uint32 GetFlag() const { return PROCESS_GENERATE_LODS; }
+      uint32 GetRequiredFlags() const { return PROCESS_TRIANGULATE; }
+      // the levels reference the vertices in their final order, the normals are part of the cost
+      uint32 GetRunAfterFlags() const { return PROCESS_IMPROVE_CACHE_LOCALITY | PROCESS_GEN_SMOOTH_NORMALS | PROCESS_MERGE_MESHES | PROCESS_PRE_TRANSFORM_VERTICES; }
+      bool NeedsSharedVertices() const { return true; }
+
+      // generates the levels of all meshes in parallel and adds their size and error to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      // Replaces the levels of detail of one mesh, meshes with anything but triangles are
+      // left alone. ratios are the triangle counts of the levels relative to the mesh,
+      // finest first. Levels which can't be simplified further within maxError are dropped.
+      static void GenerateLods(mesh2::Mesh *pMesh, const std::vector<float> &ratios, float maxError, uint32 cacheSize);
+
+      // Simplifies a triangle list by quadric error edge collapses towards each of the
+      // index counts in targets (descending), one result per target which could be reached
+      // or approached within maxError. Collapses keep vertex positions, borders and
+      // attribute seams, so the results reference a subset of the input vertices.
+      static void Simplify(const SimplifyInput &input, const std::vector<uint32> &targets, float maxError,
+         std::vector<SimplifyResult> &results);
+   };
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,223 @@
+#include "importReport.hpp"
+
+#include "scene/scene.hpp"
+using scene::Scene;
+using scene::Node;
+using mesh2::Mesh;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include "material.hpp"
+
+#include <cstdio>
+
+namespace importer
+{
+
+   static const char *PHASE_NAMES[NUM_IMPORT_PHASES] =
+   {
+      "cacheLoad",
+      "read",
+      "parse",
+      "createMeshes",
+      "createMaterials",
+      "postProcess",
+      "cacheSave"
+   };
+
+   const char *ImportReport::GetPhaseName(eImportPhase phase)
+   {
+      return PHASE_NAMES[phase];
+   }
+
+   void ImportReport::Reset(const std::string &file)
+   {
+      m_file = file;
+      m_succeeded = false;
+      m_fromCache = false;
+      m_totalTime = 0.0;
+      for (uint32 i = 0; i < NUM_IMPORT_PHASES; i++)
+         m_phaseTimes[i] = 0.0;
+      m_bytesRead = 0;
+      m_numLines = 0;
+      m_numPositions = 0;
+      m_numTexCoords = 0;
+      m_numNormals = 0;
+      m_numFaces = 0;
+      m_postProcessSteps.clear();
+      m_postProcessStats.clear();
+      m_numMeshes = 0;
+      m_numMaterials = 0;
+      m_numNodes = 0;
+      m_numSceneVertices = 0;
+      m_numSceneFaces = 0;
+      m_numAllocations = 0;
+   }
+
+   void ImportReport::AddPostProcessStep(const std::string &name, double time)
+   {
+      StepTime step;
+      step.m_name = name;
+      step.m_time = time;
+      m_postProcessSteps.push_back(step);
+   }
+
+   void ImportReport::AddPostProcessStat(const std::string &step, const std::string &name, double value)
+   {
+      StepStat stat;
+      stat.m_step = step;
+      stat.m_name = name;
+      stat.m_value = value;
+      m_postProcessStats.push_back(stat);
+   }
+
+   // counts the nodes of a subtree and the arrays they own
+   static void AddNodeStatistics(const Node *pNode, uint32 &numNodes, uint64 &numAllocations)
+   {
+      numNodes++;
+      numAllocations += 1;
+      if (pNode->m_ownsArrays)
+         numAllocations += (pNode->m_ppChildren ? 1 : 0) + (pNode->m_ppMeshes ? 1 : 0);
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+         AddNodeStatistics(pNode->m_ppChildren[i], numNodes, numAllocations);
+   }
+
+   void ImportReport::AddSceneStatistics(const Scene *pScene)
+   {
+      if (NULL == pScene)
+         return;
+
+      m_numMeshes = pScene->m_numMeshes;
+      m_numMaterials = pScene->m_numMaterials;
+      m_numAllocations = 1 + (pScene->m_ppMeshes ? 1 : 0) + (pScene->m_ppMaterials ? 1 : 0) + (pScene->m_pStorage ? pScene->m_pStorage->GetNumAllocations() : 0) +
+         (pScene->m_pMeshRemaps ? 1 : 0) + (pScene->HasNodeIndex() ? 2 : 0);
+
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+      {
+         const Mesh *pMesh = pScene->m_ppMeshes[i];
+         m_numSceneVertices += pMesh->m_numVertices;
+         m_numSceneFaces += pMesh->m_numFaces;
+         m_numAllocations += 1 + (pMesh->m_pLods ? 1 : 0);
+         if (!pMesh->m_ownsArrays)
+            continue;
+
+         for (uint32 l = 0; l < pMesh->m_numLods; l++)
+            m_numAllocations += pMesh->m_pLods[l].m_pIndices ? 1 : 0;
+         m_numAllocations += (pMesh->m_pMeshlets ? 1 : 0) + (pMesh->m_pMeshletVertices ? 1 : 0) +
+            (pMesh->m_pMeshletTriangles ? 1 : 0);
+
+         m_numAllocations += (pMesh->m_pVertices ? 1 : 0) + (pMesh->m_pNormals ? 1 : 0) +
+            (pMesh->m_pTangents ? 1 : 0) + (pMesh->m_pBiTangets ? 1 : 0) + (pMesh->m_pSmoothingGroups ? 1 : 0) +
+            (pMesh->m_pFaces ? 1 : 0) + (pMesh->m_pIndices ? 1 : 0);
+         for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+            m_numAllocations += pMesh->m_pColors[a] ? 1 : 0;
+         for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+            m_numAllocations += pMesh->m_pTextureCoords[a] ? 1 : 0;
+         for (uint32 f = 0; f < pMesh->m_numFaces; f++)
+            m_numAllocations += (pMesh->m_pFaces[f].m_ownsIndexArray && pMesh->m_pFaces[f].m_pIndexArray) ? 1 : 0;
+      }
+
+      // the material, its property array and every property with its data
+      for (uint32 i = 0; i < pScene->m_numMaterials; i++)
+         m_numAllocations += 2 + 2 * pScene->m_ppMaterials[i]->GetNumProperties();
+
+      if (NULL != pScene->m_pRootNode)
+         AddNodeStatistics(pScene->m_pRootNode, m_numNodes, m_numAllocations);
+   }
+
+   // appends str as a quoted JSON string
+   static void AppendJsonString(std::string &out, const std::string &str)
+   {
+      out += '"';
+      for (size_t i = 0; i < str.size(); i++)
+      {
+         const unsigned char c = (unsigned char)str[i];
+         if (c == '"' || c == '\\')
+         {
+            out += '\\';
+            out += (char)c;
+         }
+         else if (c < 0x20)
+         {
+            char escaped[8];
+            sprintf(escaped, "\\u%04x", c);
+            out += escaped;
+         }
+         else
+            out += (char)c;
+      }
+      out += '"';
+   }
+
+   static void AppendJsonNumber(std::string &out, const char *name, uint64 value, bool last = false)
+   {
+      char buffer[64];
+      sprintf(buffer, "\"%s\": %llu%s", name, (unsigned long long)value, last ? "" : ", ");
+      out += buffer;
+   }
+
+   static void AppendJsonTime(std::string &out, const char *name, double value, bool last = false)
+   {
+      char buffer[64];
+      sprintf(buffer, "\"%s\": %.3f%s", name, value, last ? "" : ", ");
+      out += buffer;
+   }
+
+   std::string ImportReport::ToJson() const
+   {
+      std::string out = "{\"file\": ";
+      AppendJsonString(out, m_file);
+      out += m_succeeded ? ", \"succeeded\": true" : ", \"succeeded\": false";
+      out += m_fromCache ? ", \"fromCache\": true, " : ", \"fromCache\": false, ";
+
+      AppendJsonTime(out, "totalMs", m_totalTime);
+      out += "\"phasesMs\": {";
+      for (uint32 i = 0; i < NUM_IMPORT_PHASES; i++)
+         AppendJsonTime(out, PHASE_NAMES[i], m_phaseTimes[i], i + 1 == NUM_IMPORT_PHASES);
+      out += "}, ";
+
+      out += "\"postProcessStepsMs\": {";
+      for (size_t i = 0; i < m_postProcessSteps.size(); i++)
+         AppendJsonTime(out, m_postProcessSteps[i].m_name.c_str(), m_postProcessSteps[i].m_time, i + 1 == m_postProcessSteps.size());
+      out += "}, ";
+
+      // one object per step, the stats of a step are added one after the other
+      out += "\"postProcessStats\": {";
+      for (size_t i = 0; i < m_postProcessStats.size(); i++)
+      {
+         const StepStat &stat = m_postProcessStats[i];
+         const bool first = (i == 0 || m_postProcessStats[i - 1].m_step != stat.m_step);
+         const bool last = (i + 1 == m_postProcessStats.size() || m_postProcessStats[i + 1].m_step != stat.m_step);
+         if (first)
+         {
+            if (i > 0)
+               out += ", ";
+            AppendJsonString(out, stat.m_step);
+            out += ": {";
+         }
+
+         char buffer[64];
+         sprintf(buffer, "\"%s\": %.4f%s", stat.m_name.c_str(), stat.m_value, last ? "}" : ", ");
+         out += buffer;
+      }
+      out += "}, ";
+
+      AppendJsonNumber(out, "bytesRead", m_bytesRead);
+      AppendJsonNumber(out, "lines", m_numLines);
+      AppendJsonNumber(out, "positions", m_numPositions);
+      AppendJsonNumber(out, "texCoords", m_numTexCoords);
+      AppendJsonNumber(out, "normals", m_numNormals);
+      AppendJsonNumber(out, "faces", m_numFaces);
+
+      out += "\"scene\": {";
+      AppendJsonNumber(out, "meshes", m_numMeshes);
+      AppendJsonNumber(out, "materials", m_numMaterials);
+      AppendJsonNumber(out, "nodes", m_numNodes);
+      AppendJsonNumber(out, "vertices", m_numSceneVertices);
+      AppendJsonNumber(out, "faces", m_numSceneFaces);
+      AppendJsonNumber(out, "allocations", m_numAllocations, true);
+      out += "}}";
+      return out;
+   }
+
+} // namespace importer
@@ -0,0 +1,123 @@
+#ifndef _IMPORTREPORT_HPP_INCLUDED_
+#define _IMPORTREPORT_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/timing/stopwatch.hpp"
+
+#include <string>
+#include <vector>
+
+namespace scene
+{
+   struct Scene;
+}
+
+namespace importer
+{
+
+   // the timed phases of an import, in the order they run
+   enum eImportPhase
+   {
+      IMPORT_PHASE_CACHE_LOAD, // looking up the scene cache
+      IMPORT_PHASE_READ, // mapping or reading the source file
+      IMPORT_PHASE_PARSE, // parsing the file and its material libraries
+      IMPORT_PHASE_CREATE_MESHES, // nodes, topology and vertex arrays of the scene
+      IMPORT_PHASE_CREATE_MATERIALS,
+      IMPORT_PHASE_POST_PROCESS,
+      IMPORT_PHASE_CACHE_SAVE,
+      NUM_IMPORT_PHASES
+   };
+
+   // Timing and counters of a single Importer::ReadFile() call, see
+   // Importer::GetImportReport(). All times are wall times in milliseconds.
+   struct ImportReport
+   {
+      std::string m_file;
+      bool m_succeeded;
+      bool m_fromCache; // the scene was loaded from the scene cache
+      double m_totalTime;
+      double m_phaseTimes[NUM_IMPORT_PHASES]; // 0 for phases which didn't run
+
+      // the source file, the cache file for a cached scene
+      uint64 m_bytesRead;
+
+      // the content of the source file, 0 for a cached scene
+      uint64 m_numLines;
+      uint64 m_numPositions;
+      uint64 m_numTexCoords;
+      uint64 m_numNormals;
+      uint64 m_numFaces;
+
+      // the time of every post processing step which ran, in the order they ran
+      struct StepTime
+      {
+         std::string m_name;
+         double m_time;
+      };
+      std::vector<StepTime> m_postProcessSteps;
+
+      // values measured by the post processing steps, e.g. the cache miss ratio before and
+      // after a step, grouped by step in the order they were added
+      struct StepStat
+      {
+         std::string m_step;
+         std::string m_name;
+         double m_value;
+      };
+      std::vector<StepStat> m_postProcessStats;
+
+      // the resulting scene
+      uint32 m_numMeshes;
+      uint32 m_numMaterials;
+      uint32 m_numNodes;
+      uint64 m_numSceneVertices;
+      uint64 m_numSceneFaces;
+      uint64 m_numAllocations; // heap blocks owned by the scene
+
+      ImportReport() { Reset(""); }
+
+      // clears all times and counters
+      void Reset(const std::string &file);
+
+      void AddPostProcessStep(const std::string &name, double time);
+
+      void AddPostProcessStat(const std::string &step, const std::string &name, double value);
+
+      // fills the counters of the resulting scene
+      void AddSceneStatistics(const scene::Scene *pScene);
+
+      // the report as a JSON object
+      std::string ToJson() const;
+
+      static const char *GetPhaseName(eImportPhase phase);
+   };
+
+   // Adds the time from its construction to its destruction to a phase of a report,
+   // the report may be NULL.
+   class ImportPhaseTimer
+   {
+   private:
+      ImportReport *m_pReport;
+      eImportPhase m_phase;
+      core::timing::Stopwatch m_stopwatch;
+
+      ImportPhaseTimer(const ImportPhaseTimer &);
+      ImportPhaseTimer &operator=(const ImportPhaseTimer &);
+   public:
+      ImportPhaseTimer(ImportReport *pReport, eImportPhase phase) : m_pReport(pReport), m_phase(phase) { }
+
+      ~ImportPhaseTimer() { Stop(); }
+
+      // ends the phase before the timer goes out of scope
+      void Stop()
+      {
+         if (NULL != m_pReport)
+            m_pReport->m_phaseTimes[m_phase] += m_stopwatch.GetMilliSecs();
+         m_pReport = NULL;
+      }
+   };
+
+} // namespace importer
+
+#endif
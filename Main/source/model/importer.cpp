@@ -41,13 +41,64 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "importer.hpp"
 #include "core/memory/pointer.hpp"
+#include "core/hash/Hash.hpp"
+#include "core/thread/threadpool.hpp"
+using core::thread::ThreadPool;
+
+#include "config.hpp"
+#include "postprocess.hpp"
+#include "sceneCache.hpp"
+
+#include "core/fileio/filesys.hpp"
+
+#include "core/timing/stopwatch.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <typeinfo>
 
 using core::fileio::File;
 
 namespace importer
 {
 
-   Importer::Importer()
+   // Sets a property in a hash map, returns true if it was set before.
+   template <class T>
+   static bool SetGenericProperty(std::map<uint32, T> &list, const char *szName, const T &value)
+   {
+      assert(NULL != szName);
+      const uint32 hash = core::SuperFastHash(szName);
+
+      typename std::map<uint32, T>::iterator it = list.find(hash);
+      if (it == list.end())
+      {
+         list.insert(std::pair<uint32, T>(hash, value));
+         return false;
+      }
+      (*it).second = value;
+      return true;
+   }
+
+   // Gets a property from a hash map, returns errorReturn if it doesn't exist.
+   template <class T>
+   static const T &GetGenericProperty(const std::map<uint32, T> &list, const char *szName, const T &errorReturn)
+   {
+      assert(NULL != szName);
+      const uint32 hash = core::SuperFastHash(szName);
+
+      typename std::map<uint32, T>::const_iterator it = list.find(hash);
+      if (it == list.end())
+         return errorReturn;
+
+      return (*it).second;
+   }
+
+   Importer::Importer() :
+      m_pThreadPool(NULL),
+      m_pSharedThreadPool(NULL),
+      m_pProgressHandler(NULL),
+      m_pMtlCache(NULL)
    {
    //   // allocate the pimpl first
    //   pimpl = new ImporterPimpl();
@@ -75,22 +126,196 @@ namespace importer
    //      (*it)->SetSharedData(pimpl->mPPShared);
    //   }
    }
+      Importer::Importer(const Importer &other) :
+         m_pThreadPool(NULL),
+         m_pSharedThreadPool(NULL),
+         m_pProgressHandler(NULL),
+         m_postProcessing(other.m_postProcessing),
+         m_pMtlCache(NULL),
+         m_intProperties(other.m_intProperties),
+         m_floatProperties(other.m_floatProperties),
+         m_stringProperties(other.m_stringProperties),
+         m_matrixProperties(other.m_matrixProperties)
+      {
+      }
+
       Importer::~Importer()
       {
-   //      // nothing to do here
+         delete m_pThreadPool;
+         m_pThreadPool = NULL;
+      }
+
+      ThreadPool *Importer::GetThreadPool() const
+      {
+         const int32 value = GetPropertyInteger(CONFIG_IMPORT_THREAD_COUNT, 0);
+         const uint32 numThreads = value > 0 ? (uint32)value : 0;
+         if (numThreads == 1)
+            return NULL;
+
+         if (NULL != m_pSharedThreadPool)
+            return m_pSharedThreadPool;
+
+         // the thread count may have changed since the last import
+         if (NULL != m_pThreadPool && numThreads != 0 && m_pThreadPool->GetNumThreads() != numThreads)
+         {
+            delete m_pThreadPool;
+            m_pThreadPool = NULL;
+         }
+
+         if (NULL == m_pThreadPool)
+            m_pThreadPool = new ThreadPool(numThreads);
+
+         // a single hardware thread gains nothing from splitting the work
+         return m_pThreadPool->GetNumThreads() > 1 ? m_pThreadPool : NULL;
+      }
+
+      bool Importer::SetPropertyInteger(const char* szName, int32 iValue)
+      {
+         return SetGenericProperty<int32>(m_intProperties, szName, iValue);
+      }
+
+      bool Importer::SetPropertyFloat(const char* szName, float fValue)
+      {
+         return SetGenericProperty<float>(m_floatProperties, szName, fValue);
+      }
+
+      bool Importer::SetPropertyString(const char* szName, const std::string &sValue)
+      {
+         return SetGenericProperty<std::string>(m_stringProperties, szName, sValue);
+      }
+
+      bool Importer::SetPropertyMatrix(const char* szName, const Matrix4f &sValue)
+      {
+         return SetGenericProperty<Matrix4f>(m_matrixProperties, szName, sValue);
+      }
+
+      int32 Importer::GetPropertyInteger(const char* szName, int32 iErrorReturn) const
+      {
+         return GetGenericProperty<int32>(m_intProperties, szName, iErrorReturn);
+      }
+
+      float Importer::GetPropertyFloat(const char* szName, float fErrorReturn) const
+      {
+         return GetGenericProperty<float>(m_floatProperties, szName, fErrorReturn);
+      }
+
+      const std::string &Importer::GetPropertyString(const char* szName, const std::string &sErrorReturn) const
+      {
+         return GetGenericProperty<std::string>(m_stringProperties, szName, sErrorReturn);
+      }
 
+      const Matrix4f Importer::GetPropertyMatrix(const char* szName, const Matrix4f &sErrorReturn) const
+      {
+         return GetGenericProperty<Matrix4f>(m_matrixProperties, szName, sErrorReturn);
       }
+      uint64 Importer::GetSettingsHash(uint32 flags) const
+      {
+         // properties which don't change the imported scene
+         const uint32 ignored[] = {
+            core::SuperFastHash(CONFIG_IMPORT_CACHE_DIRECTORY),
+            core::SuperFastHash(CONFIG_IMPORT_THREAD_COUNT),
+            core::SuperFastHash(CONFIG_IMPORT_BUILD_NODE_INDEX),
+            core::SuperFastHash(CONFIG_IMPORT_SCENE_ARENA),
+            core::SuperFastHash(CONFIG_IMPORT_OBJ_MAPPED_READ),
+            core::SuperFastHash(CONFIG_IMPORT_OBJ_PARALLEL_PARSE)
+         };
+         const uint32 *ignoredEnd = ignored + sizeof(ignored) / sizeof(ignored[0]);
+
+         uint64 hash = core::Fnv1a64(&flags, sizeof(flags));
+
+         // a step registered with RegisterPostProcessStep() may replace a built-in one
+         std::vector<const postprocess::BaseProcess*> steps;
+         m_postProcessing.GetSteps(flags, steps);
+         for (size_t i = 0; i < steps.size(); i++)
+         {
+            const char *pName = steps[i]->GetName();
+            const char *pType = typeid(*steps[i]).name();
+            hash = core::Fnv1a64(pName, strlen(pName) + 1, hash);
+            hash = core::Fnv1a64(pType, strlen(pType) + 1, hash);
+         }
+
+         for (std::map<uint32, int32>::const_iterator it = m_intProperties.begin(); it != m_intProperties.end(); ++it)
+         {
+            if (std::find(ignored, ignoredEnd, it->first) != ignoredEnd)
+               continue;
+            hash = core::Fnv1a64(&it->first, sizeof(it->first), hash);
+            hash = core::Fnv1a64(&it->second, sizeof(it->second), hash);
+         }
+         for (std::map<uint32, float>::const_iterator it = m_floatProperties.begin(); it != m_floatProperties.end(); ++it)
+         {
+            hash = core::Fnv1a64(&it->first, sizeof(it->first), hash);
+            hash = core::Fnv1a64(&it->second, sizeof(it->second), hash);
+         }
+         for (std::map<uint32, std::string>::const_iterator it = m_stringProperties.begin(); it != m_stringProperties.end(); ++it)
+         {
+            if (std::find(ignored, ignoredEnd, it->first) != ignoredEnd)
+               continue;
+            hash = core::Fnv1a64(&it->first, sizeof(it->first), hash);
+            hash = core::Fnv1a64(it->second.c_str(), it->second.size() + 1, hash);
+         }
+         for (std::map<uint32, Matrix4f>::const_iterator it = m_matrixProperties.begin(); it != m_matrixProperties.end(); ++it)
+         {
+            hash = core::Fnv1a64(&it->first, sizeof(it->first), hash);
+            hash = core::Fnv1a64(&it->second, sizeof(it->second), hash);
+         }
+         return hash;
+      }
+
       Scene* Importer::ReadFile(const std::string &path)
       {
+         return ReadFile(path, 0);
+      }
+
+      Scene* Importer::ReadFile(const std::string &path, uint32 flags)
+      {
+         m_report.Reset(path);
+         const core::timing::Stopwatch stopwatch;
+
+         Scene *scene = ImportScene(path, flags);
+         if (NULL != scene && GetPropertyInteger(CONFIG_IMPORT_BUILD_NODE_INDEX, 0) != 0)
+            scene->BuildNodeIndex();
+
+         m_report.m_succeeded = (NULL != scene);
+         m_report.AddSceneStatistics(scene);
+         m_report.m_totalTime = stopwatch.GetMilliSecs();
+         return scene;
+      }
+
+      Scene* Importer::ImportScene(const std::string &path, uint32 flags)
+      {
+         const scenecache::SceneCache cache(GetPropertyString(CONFIG_IMPORT_CACHE_DIRECTORY));
+         const bool useCache = !GetPropertyString(CONFIG_IMPORT_CACHE_DIRECTORY).empty();
+         const uint64 settingsHash = useCache ? GetSettingsHash(flags) : 0;
 
          // create a scene object to hold the data  
          //ScopeGuard<Scene> sc(new Scene);
 
-         Scene *scene = new Scene;
+         Scene *scene = NULL;
 
          try
          {
+            UpdateProgress(m_pProgressHandler, 0.f);
+            if (useCache)
+            {
+               ImportPhaseTimer timer(&m_report, IMPORT_PHASE_CACHE_LOAD);
+               Scene *cached = cache.Load(path, settingsHash);
+               if (NULL != cached)
+               {
+                  uint64 modifiedTime;
+                  core::filesys::GetFileStatus(cache.GetCachePath(path, settingsHash), m_report.m_bytesRead, modifiedTime);
+                  m_report.m_fromCache = true;
+                  if (NULL != m_pProgressHandler)
+                     m_pProgressHandler->Update(1.f);
+                  return cached;
+               }
+            }
+
+            scene = new Scene;
+            objFile.SetupProperties(this, flags);
+            objFile.SetImportReport(&m_report);
             objFile.InternReadFile(path, scene);
+
+            PostProcess(scene, flags);
          }
          catch (const std::exception &err)
          {
@@ -98,12 +323,107 @@ namespace importer
             //   // extract error description
             //   mErrorText = err.what();
             //   DefaultLogger::get()->error(mErrorText);
+            delete scene;
             return NULL;
          }
 
+         // a scene which can't be cached is imported again next time
+         if (useCache)
+         {
+            ImportPhaseTimer timer(&m_report, IMPORT_PHASE_CACHE_SAVE);
+            cache.Save(path, settingsHash, objFile.GetMaterialLibFiles(), scene);
+         }
+
+         // the scene is complete, the handler can't cancel the import any more
+         if (NULL != m_pProgressHandler)
+            m_pProgressHandler->Update(1.f);
+
          // return what we gathered from the import. 
          //sc.dismiss();
          return scene;
       }
 
+      void Importer::PostProcess(Scene *scene, uint32 flags)
+      {
+         ImportPhaseTimer timer(&m_report, IMPORT_PHASE_POST_PROCESS);
+         postprocess::PostProcessContext context;
+         context.m_pImporter = this;
+         context.m_pThreadPool = GetThreadPool();
+         context.m_pProgressHandler = m_pProgressHandler;
+
+         // the steps may change the hierarchy, an index built before is built again
+         const bool hadNodeIndex = scene->HasNodeIndex();
+         scene->InvalidateNodeIndex();
+         m_postProcessing.Execute(scene, flags, context, &m_report);
+         if (hadNodeIndex)
+            scene->BuildNodeIndex();
+         timer.Stop();
+
+         UpdateProgress(m_pProgressHandler, 0.95f);
+      }
+
+      bool Importer::ValidateFlags(uint32 flags) const
+      {
+         return m_postProcessing.ValidateFlags(flags);
+      }
+
+      Scene* Importer::ApplyPostProcessing(Scene *scene, uint32 flags)
+      {
+         if (NULL == scene)
+            return NULL;
+
+         try
+         {
+            PostProcess(scene, flags);
+         }
+         catch (const std::exception &)
+         {
+            delete scene;
+            return NULL;
+         }
+         return scene;
+      }
+
+      // name of a model imported from memory, the hint is appended as its extension
+      static const char *MEMORY_FILE_NAME = "$$$___magic___$$$";
+
+      Scene* Importer::ReadFileFromMemory(const void *pBuffer, size_t length, uint32 flags, const char *pHint)
+      {
+         const std::string name = std::string(MEMORY_FILE_NAME) + "." + ((NULL == pHint || '\0' == *pHint) ? "obj" : pHint);
+         m_report.Reset(name);
+         const core::timing::Stopwatch stopwatch;
+
+         if (NULL == pBuffer || 0 == length || !objFile.CanRead(name, NULL, false))
+            return NULL;
+
+         const char *pBegin = static_cast<const char*>(pBuffer);
+         Scene *scene = NULL;
+         try
+         {
+            UpdateProgress(m_pProgressHandler, 0.f);
+
+            scene = new Scene;
+            objFile.SetupProperties(this, flags);
+            objFile.SetImportReport(&m_report);
+            objFile.InternReadMemory(pBegin, pBegin + length, name, scene);
+
+            PostProcess(scene, flags);
+         }
+         catch (const std::exception &)
+         {
+            delete scene;
+            scene = NULL;
+         }
+
+         if (NULL != scene && GetPropertyInteger(CONFIG_IMPORT_BUILD_NODE_INDEX, 0) != 0)
+            scene->BuildNodeIndex();
+         if (NULL != scene && NULL != m_pProgressHandler)
+            m_pProgressHandler->Update(1.f);
+
+         m_report.m_succeeded = (NULL != scene);
+         m_report.AddSceneStatistics(scene);
+         m_report.m_totalTime = stopwatch.GetMilliSecs();
+         return scene;
+      }
+
 } // namespace importer
\ No newline at end of file
@@ -48,6 +48,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef _IMPORTER_HPP_INCLUDED_
 #define _IMPORTER_HPP_INCLUDED_
 
+#include <map>
+#include <string>
+
 #include "core/math/Matrix4.hpp"
 using core::math::Matrix4f;
 #include "model/objfileimporter.hpp"
@@ -55,6 +58,9 @@ using core::math::Matrix4f;
 #include "core/BasicTypes.hpp"
 //#include <cassert>
 #include "model/ImporterDesc.hpp"
+#include "model/importReport.hpp"
+#include "model/progressHandler.hpp"
+#include "model/postProcessPipeline.hpp"
 
 #include "core/fileio/file.hpp"
 using core::fileio::File;
@@ -245,25 +251,21 @@ namespace importer
 
       /** Supplies a custom progress handler to the importer. This
       *  interface exposes a #Update() callback, which is called
-      *  more or less periodically (please don't sue us if it
-      *  isn't as periodically as you'd like it to have ...).
-      *  This can be used to implement progress bars and loading
-      *  timeouts.
-      *  pHandler Progress callback interface. Pass NULL to
-      *    disable progress reporting.
+      *  at least once per import phase on the thread running the
+      *  import. This can be used to implement progress bars and
+      *  loading timeouts.
+      *  @param pHandler Progress callback interface, owned by the
+      *    caller. Pass NULL to disable progress reporting.
       *  Progress handlers can be used to abort the loading
       *    at almost any time.*/
-      //void SetProgressHandler(ProgressHandler* pHandler);
+      void SetProgressHandler(ProgressHandler* pHandler) { m_pProgressHandler = pHandler; }
 
 
       /** Retrieves the progress handler that is currently set.
-      * You can use #IsDefaultProgressHandler() to check whether the returned
-      * interface is the default handler provided by ASSIMP. The default
-      * handler is active as long the application doesn't supply its own
-      * custom handler via #SetProgressHandler().
-      * @return A valid ProgressHandler interface, never NULL.
+      * @return The handler passed to #SetProgressHandler(), NULL if
+      *   progress reporting is disabled.
       */
-      //ProgressHandler* GetProgressHandler() const;
+      ProgressHandler* GetProgressHandler() const { return m_pProgressHandler; }
 
 
       /** Checks whether a default progress handler is active
@@ -271,84 +273,47 @@ namespace importer
       * supply its own custom progress handler via #SetProgressHandler().
       * @return true by default
       */
-      bool IsDefaultProgressHandler() const;
+      bool IsDefaultProgressHandler() const { return NULL == m_pProgressHandler; }
 
 
       /** @brief Check whether a given set of postprocessing flags
       *  is supported.
       *
-      *  Some flags are mutually exclusive, others are probably
-      *  not available because your excluded them from your
-      *  Assimp builds. Calling this function is recommended if
-      *  you're unsure.
+      *  A set is supported if a step is registered for every flag and
+      *  the dependencies of the steps can be ordered. Steps required by
+      *  a flag are enabled along with it.
       *
-      *  @param pFlags Bitwise combination of the aiPostProcess flags.
+      *  @param pFlags Bitwise combination of the
+      *    #postprocess::ePostProcessSteps flags.
       *  @return true if this flag combination is fine.
       */
       bool ValidateFlags(uint32 pFlags) const;
 
 
-      /** Reads the given file and returns its contents if successful.
-      *
-      * If the call succeeds, the contents of the file are returned as a
-      * pointer to an Scene object. The returned data is intended to be
-      * read-only, the importer object keeps ownership of the data and will
-      * destroy it upon destruction. If the import fails, NULL is returned.
-      * A human-readable error description can be retrieved by calling
-      * GetErrorString(). The previous scene will be deleted during this call.
-      * @param pFile Path and filename to the file to be imported.
-      * @param pFlags Optional post processing steps to be executed after
-      *   a successful import. Provide a bitwise combination of the
-      *   #aiPostProcessSteps flags. If you wish to inspect the imported
-      *   scene first in order to fine-tune your post-processing setup,
-      *   consider to use #ApplyPostProcessing().
-      * @return A pointer to the imported data, NULL if the import failed.
-      *   The pointer to the scene remains in possession of the Importer
-      *   instance. Use GetOrphanedScene() to take ownership of it.
-      *
-      * @note Assimp is able to determine the file format of a file
-      * automatically.
-      */
-      
-      //const Scene* ReadFile(const char* pFile, uint32 pFlags);
-
       /** Reads the given file from a memory buffer and returns its
       *  contents if successful.
       *
-      * If the call succeeds, the contents of the file are returned as a
-      * pointer to an Scene object. The returned data is intended to be
-      * read-only, the importer object keeps ownership of the data and will
-      * destroy it upon destruction. If the import fails, NULL is returned.
-      * A human-readable error description can be retrieved by calling
-      * GetErrorString(). The previous scene will be deleted during this call.
-      * Calling this method doesn't affect the active File.
+      * The buffer is parsed in place, it is not copied and only has to stay
+      * valid until the call returns. It doesn't need to be zero-terminated.
+      * The import report is reset and filled like by ReadFile(), the scene
+      * cache is not used.
       * @param pBuffer Pointer to the file data
       * @param pLength Length of pBuffer, in bytes
-      * @param pFlags Optional post processing steps to be executed after
-      *   a successful import. Provide a bitwise combination of the
-      *   #aiPostProcessSteps flags. If you wish to inspect the imported
-      *   scene first in order to fine-tune your post-processing setup,
-      *   consider to use #ApplyPostProcessing().
-      * @param pHint An additional hint to the library. If this is a non
-      *   empty string, the library looks for a loader to support
-      *   the file extension specified by pHint and passes the file to
-      *   the first matching loader. If this loader is unable to completely
-      *   the request, the library continues and tries to determine the
-      *   file format on its own, a task that may or may not be successful.
-      *   Check the return value, and you'll know ...
+      * @param pFlags Post processing steps to be executed after a
+      *   successful import, a bitwise combination of the
+      *   #postprocess::ePostProcessSteps flags.
+      * @param pHint The file extension of the data without the dot, e.g.
+      *   "obj". An empty hint is treated as "obj", the import fails for
+      *   extensions no importer supports.
       * @return A pointer to the imported data, NULL if the import failed.
-      *   The pointer to the scene remains in possession of the Importer
-      *   instance. Use GetOrphanedScene() to take ownership of it.
+      *   The caller takes ownership of the scene.
       *
-      * @note This is a straightforward way to decode models from memory
-      * buffers, but it doesn't handle model formats that spread their
-      * data across multiple files or even directories. Examples include
-      * OBJ or MD3, which outsource parts of their material info into
-      * external scripts. If you need full functionality, provide
-      * a custom File to make Assimp find these files and use
-      * the regular ReadFile() API.
+      * @note Formats which spread their data across multiple files can't
+      * be resolved from the buffer alone. The material libraries an OBJ
+      * buffer references are opened as files, relative to the working
+      * directory.
       */
-      const Scene* ReadFileFromMemory(
+      Scene* ReadFileFromMemory(
          const void* pBuffer,
          size_t pLength,
          uint32 pFlags,
@@ -360,35 +325,37 @@ namespace importer
       *  This is strictly equivalent to calling #ReadFile() with the same
       *  flags. However, you can use this separate function to inspect
       *  the imported scene first to fine-tune your post-processing setup.
+      *  The time of every step is added to the import report.
+      *  @param pScene The scene, e.g. returned by #ReadFile().
       *  @param pFlags Provide a bitwise combination of the
-      *   #aiPostProcessSteps flags.
-      *  @return A pointer to the post-processed data. This is still the
-      *   same as the pointer returned by #ReadFile(). However, if
-      *   post-processing fails, the scene could now be NULL.
-      *   That's quite a rare case, post processing steps are not really
-      *   designed to 'fail'. To be exact, the #aiProcess_ValidateDS
-      *   flag is currently the only post processing step which can actually
-      *   cause the scene to be reset to NULL.
-      *
-      *  @note The method does nothing if no scene is currently bound
-      *    to the #Importer instance.  */
-      const Scene* ApplyPostProcessing(uint32 pFlags);
+      *   #postprocess::ePostProcessSteps flags.
+      *  @return pScene, NULL if post-processing failed (e.g. the flags
+      *   aren't valid, see #ValidateFlags()). The scene is deleted then,
+      *   since it may be left partly processed. */
+      Scene* ApplyPostProcessing(Scene* pScene, uint32 pFlags);
+
+      /** Registers a post processing step, a step registered for the
+      *  same flag before (e.g. a built-in one) is replaced. The Importer
+      *  takes ownership of the step, copies of the Importer share it. */
+      void RegisterPostProcessStep(postprocess::BaseProcess *pStep) { m_postProcessing.Register(pStep); }
+
+      const postprocess::PostProcessPipeline &GetPostProcessPipeline() const { return m_postProcessing; }
 
 
       /** Reads the given file and returns its contents if successful.
       *
-      * This function is provided for backward compatibility.
-      * See the const char* version for detailled docs.
-      * @see ReadFile(const char*, pFlags)  */
-      //const Scene* ReadFile(const std::string &pFile, uint32 pFlags);
+      * @param pFile Path and filename to the file to be imported.
+      * @param pFlags Post processing steps to be executed after a
+      *   successful import, a bitwise combination of the
+      *   #postprocess::ePostProcessSteps flags.
+      * @return A pointer to the imported data, NULL if the import failed.
+      *   The caller takes ownership of the scene. */
+      Scene* ReadFile(const std::string &pFile, uint32 pFlags);
       
       Scene* ReadFile(const std::string &pFile);
 
-      /** Frees the current scene.
-      *
-      *  The function does nothing if no scene has previously been
-      *  read via ReadFile(). FreeScene() is called automatically by the
-      *  destructor and ReadFile() itself.  */
+      /** Deletes a scene returned by ReadFile() or ReadFileFromMemory(),
+      *  the Importer doesn't keep the scenes it imported. NULL is ignored. */
       void FreeScene(const Scene *sc) { delete sc; sc = NULL; };
 
 
@@ -523,11 +490,65 @@ namespace importer
       //ImporterPimpl* Pimpl() { return pimpl; }
       //const ImporterPimpl* Pimpl() const { return pimpl; }
 
+      /** Returns the thread pool shared by the loaders and post processing
+      *  steps, NULL if #CONFIG_IMPORT_THREAD_COUNT disables threading.
+      *  The pool is created on first use and owned by the Importer. */
+      core::thread::ThreadPool *GetThreadPool() const;
+
+      /** Lets the importer use a pool owned by the caller instead of
+      *  creating its own, e.g. to share one pool between importers
+      *  running on the pool's threads. Pass NULL to use an own pool
+      *  again. #CONFIG_IMPORT_THREAD_COUNT 1 still disables threading. */
+      void SetThreadPool(core::thread::ThreadPool *pPool) { m_pSharedThreadPool = pPool; }
+
+      /** Lets the OBJ loader take material libraries from a cache owned
+      *  by the caller instead of parsing them for every file, e.g. to
+      *  share them between the importers of a batch. Pass NULL to parse
+      *  the libraries of every file again. */
+      void SetMtlLibraryCache(model::objmtlimporter::MtlLibraryCache *pCache) { m_pMtlCache = pCache; }
+      model::objmtlimporter::MtlLibraryCache *GetMtlLibraryCache() const { return m_pMtlCache; }
+
+      /** Returns the timing and counters of the last ReadFile() or
+      *  ReadFileFromMemory() call.
+      *
+      *  The report is reset by every call, use ImportReport::ToJson() to log it.
+      */
+      const ImportReport &GetImportReport() const { return m_report; }
+
    protected:
       objfileimporter::ObjFileImporter objFile;
+
+      mutable core::thread::ThreadPool *m_pThreadPool;
+      core::thread::ThreadPool *m_pSharedThreadPool; // see SetThreadPool(), not owned
+
+      ProgressHandler *m_pProgressHandler; // not owned, NULL if no progress is reported
+
+      postprocess::PostProcessPipeline m_postProcessing;
+      model::objmtlimporter::MtlLibraryCache *m_pMtlCache; // see SetMtlLibraryCache(), not owned
+
+      // configuration properties, keyed by the hash of their name
+      std::map<uint32, int32> m_intProperties;
+      std::map<uint32, float> m_floatProperties;
+      std::map<uint32, std::string> m_stringProperties;
+      std::map<uint32, Matrix4f> m_matrixProperties;
+
+      ImportReport m_report; // of the last ReadFile() or ReadFileFromMemory() call
       // Just because we don't want you to know how we're hacking around.
       //ImporterPimpl* pimpl;
 
+   private:
+      // the thread pool is not shared between importers
+      Importer &operator=(const Importer &other);
+
+      // Identifies the post processing flags, the steps they run and the properties which
+      // change the imported scene, the key of the scene cache (see CONFIG_IMPORT_CACHE_DIRECTORY).
+      uint64 GetSettingsHash(uint32 flags) const;
+
+      // Loads the scene from the cache or imports it, ReadFile() adds the totals to the report.
+      Scene* ImportScene(const std::string &pFile, uint32 pFlags);
+
+      // Runs the post processing steps of pFlags on a freshly imported scene.
+      void PostProcess(Scene *pScene, uint32 pFlags);
    }; // class Importer
 
    // For compatibility, the interface of some functions taking a std::string was
@@ -0,0 +1,436 @@
+#include "improveCacheLocalityProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::Bone;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include "scene/scene.hpp"
+
+#include "config.hpp"
+#include "importer.hpp"
+#include "importReport.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "core/thread/threadpool.hpp"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace postprocess
+{
+
+   static const uint32 DEFAULT_CACHE_SIZE = 32;
+   static const uint32 NO_TRIANGLE = 0xffffffff;
+
+   // the miss ratio of an overdraw cluster may exceed the one of the mesh by 5% at most
+   static const float OVERDRAW_THRESHOLD = 1.05f;
+
+   // Forsyth's vertex score: the three most recent vertices score the same so the next
+   // triangle doesn't have to reuse the last edge, older cache entries score less, and
+   // vertices with few triangles left are preferred so they leave the cache for good.
+   static float GetVertexScore(int32 cachePos, uint32 numActive, uint32 cacheSize)
+   {
+      if (numActive == 0)
+         return -1.0f;
+
+      float score = 0.0f;
+      if (cachePos >= 0)
+      {
+         if (cachePos < 3)
+            score = 0.75f;
+         else
+            score = powf(1.0f - (float)(cachePos - 3) / (float)(cacheSize - 3), 1.5f);
+      }
+      return score + 2.0f / sqrtf((float)numActive);
+   }
+
+   void ImproveCacheLocalityProcess::OptimizeTriangleOrder(uint32 *pIndices, uint32 numTriangles, uint32 numVertices, uint32 cacheSize)
+   {
+      // the not yet emitted triangles of every vertex, m_active of them at m_first in triangles
+      struct VertexData
+      {
+         uint32 m_first;
+         uint32 m_active;
+         int32 m_cachePos;
+         float m_score;
+      };
+      std::vector<VertexData> vertices(numVertices);
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         vertices[v].m_active = 0;
+         vertices[v].m_cachePos = -1;
+      }
+      for (uint32 i = 0; i < numTriangles * 3; i++)
+         vertices[pIndices[i]].m_active++;
+
+      uint32 offset = 0;
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         vertices[v].m_first = offset;
+         offset += vertices[v].m_active;
+         vertices[v].m_score = GetVertexScore(-1, vertices[v].m_active, cacheSize);
+         vertices[v].m_active = 0;
+      }
+
+      std::vector<uint32> triangles(numTriangles * 3);
+      for (uint32 t = 0; t < numTriangles; t++)
+      {
+         for (uint32 k = 0; k < 3; k++)
+         {
+            VertexData &vertex = vertices[pIndices[t * 3 + k]];
+            triangles[vertex.m_first + vertex.m_active++] = t;
+         }
+      }
+
+      std::vector<float> triangleScores(numTriangles);
+      std::vector<bool> emitted(numTriangles, false);
+      uint32 best = NO_TRIANGLE;
+      for (uint32 t = 0; t < numTriangles; t++)
+      {
+         triangleScores[t] = vertices[pIndices[t * 3]].m_score + vertices[pIndices[t * 3 + 1]].m_score +
+            vertices[pIndices[t * 3 + 2]].m_score;
+         if (best == NO_TRIANGLE || triangleScores[t] > triangleScores[best])
+            best = t;
+      }
+
+      std::vector<uint32> order;
+      order.reserve(numTriangles);
+      std::vector<uint32> cache, newCache;
+      cache.reserve(cacheSize + 3);
+      newCache.reserve(cacheSize + 3);
+      uint32 nextUnemitted = 0;
+
+      while (order.size() < numTriangles)
+      {
+         // nothing in the cache is left to draw, continue with the next triangle in mesh order
+         if (best == NO_TRIANGLE)
+         {
+            while (emitted[nextUnemitted])
+               nextUnemitted++;
+            best = nextUnemitted;
+         }
+
+         order.push_back(best);
+         emitted[best] = true;
+
+         const uint32 *pTriangle = &pIndices[best * 3];
+         for (uint32 k = 0; k < 3; k++)
+         {
+            VertexData &vertex = vertices[pTriangle[k]];
+            uint32 *pFirst = &triangles[vertex.m_first];
+            for (uint32 i = 0; i < vertex.m_active; i++)
+            {
+               if (pFirst[i] == best)
+               {
+                  std::swap(pFirst[i], pFirst[vertex.m_active - 1]);
+                  vertex.m_active--;
+                  break;
+               }
+            }
+         }
+
+         // the corners of the triangle move to the front of the cache
+         newCache.clear();
+         newCache.push_back(pTriangle[0]);
+         newCache.push_back(pTriangle[1]);
+         newCache.push_back(pTriangle[2]);
+         for (size_t i = 0; i < cache.size(); i++)
+         {
+            if (cache[i] != pTriangle[0] && cache[i] != pTriangle[1] && cache[i] != pTriangle[2])
+               newCache.push_back(cache[i]);
+         }
+         cache.swap(newCache);
+
+         // evicted vertices are rescored as well, their triangles lose the cache bonus
+         for (size_t i = 0; i < cache.size(); i++)
+         {
+            VertexData &vertex = vertices[cache[i]];
+            vertex.m_cachePos = (i < cacheSize) ? (int32)i : -1;
+            vertex.m_score = GetVertexScore(vertex.m_cachePos, vertex.m_active, cacheSize);
+         }
+
+         best = NO_TRIANGLE;
+         for (size_t i = 0; i < cache.size(); i++)
+         {
+            const VertexData &vertex = vertices[cache[i]];
+            for (uint32 j = 0; j < vertex.m_active; j++)
+            {
+               const uint32 t = triangles[vertex.m_first + j];
+               triangleScores[t] = vertices[pIndices[t * 3]].m_score + vertices[pIndices[t * 3 + 1]].m_score +
+                  vertices[pIndices[t * 3 + 2]].m_score;
+               if (best == NO_TRIANGLE || triangleScores[t] > triangleScores[best])
+                  best = t;
+            }
+         }
+         if (cache.size() > cacheSize)
+            cache.resize(cacheSize);
+      }
+
+      std::vector<uint32> sorted(numTriangles * 3);
+      for (uint32 t = 0; t < numTriangles; t++)
+         std::copy(&pIndices[order[t] * 3], &pIndices[order[t] * 3] + 3, &sorted[t * 3]);
+      std::copy(sorted.begin(), sorted.end(), pIndices);
+   }
+
+   // Splits the cache optimized triangle order into clusters and sorts them front to back,
+   // like the overdraw pass of Tipsify: clusters end where the cache is flushed or where
+   // their miss ratio is low enough, so reordering them costs little cache efficiency. Clusters
+   // facing away from the center of the mesh are drawn first, they are likely to occlude
+   // the others.
+   static void OptimizeOverdraw(uint32 *pIndices, uint32 numTriangles, const Vector3f *pVertices,
+      uint32 numVertices, uint32 cacheSize)
+   {
+      struct Cluster
+      {
+         uint32 m_first; // first triangle
+         uint32 m_count;
+         float m_sortKey;
+
+         bool operator<(const Cluster &other) const { return m_sortKey > other.m_sortKey; }
+      };
+      std::vector<Cluster> clusters;
+
+      std::vector<uint8> misses(numTriangles, 0);
+      std::vector<uint32> stamps(numVertices, 0);
+      uint32 time = cacheSize + 1;
+      for (uint32 t = 0; t < numTriangles; t++)
+      {
+         for (uint32 k = 0; k < 3; k++)
+         {
+            const uint32 v = pIndices[t * 3 + k];
+            if (time - stamps[v] > cacheSize)
+            {
+               stamps[v] = time++;
+               misses[t]++;
+            }
+         }
+      }
+      const float maxClusterMisses = OVERDRAW_THRESHOLD * (time - cacheSize - 1) / (float)numTriangles;
+
+      // a cluster ends before a triangle missing with all corners or as soon as its own miss
+      // ratio is within the threshold of the mesh
+      uint32 clusterMisses = 0;
+      for (uint32 t = 0; t < numTriangles; t++)
+      {
+         if (clusters.empty() || misses[t] == 3 || clusterMisses <= maxClusterMisses * clusters.back().m_count)
+         {
+            Cluster cluster = { t, 0, 0.0f };
+            clusters.push_back(cluster);
+            clusterMisses = 0;
+         }
+         clusters.back().m_count++;
+         clusterMisses += misses[t];
+      }
+
+      if (clusters.size() < 2)
+         return;
+
+      // the area weighted centers of the clusters and of the mesh
+      float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+      float meshArea = 0.0f;
+      std::vector<float> centers(clusters.size() * 3), normals(clusters.size() * 3);
+      for (size_t c = 0; c < clusters.size(); c++)
+      {
+         float *pCenter = &centers[c * 3], *pNormal = &normals[c * 3];
+         float area = 0.0f;
+         for (uint32 t = clusters[c].m_first; t < clusters[c].m_first + clusters[c].m_count; t++)
+         {
+            const Vector3f &a = pVertices[pIndices[t * 3]];
+            const Vector3f &b = pVertices[pIndices[t * 3 + 1]];
+            const Vector3f &p = pVertices[pIndices[t * 3 + 2]];
+            const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+            const float e2[3] = { p.x - a.x, p.y - a.y, p.z - a.z };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+            const float weight = triangleArea / 3.0f;
+            pCenter[0] += (a.x + b.x + p.x) * weight;
+            pCenter[1] += (a.y + b.y + p.y) * weight;
+            pCenter[2] += (a.z + b.z + p.z) * weight;
+            pNormal[0] += n[0];
+            pNormal[1] += n[1];
+            pNormal[2] += n[2];
+            area += triangleArea;
+         }
+
+         for (uint32 k = 0; k < 3; k++)
+            meshCenter[k] += pCenter[k];
+         meshArea += area;
+         for (uint32 k = 0; k < 3 && area > 0.0f; k++)
+            pCenter[k] /= area;
+      }
+      for (uint32 k = 0; k < 3 && meshArea > 0.0f; k++)
+         meshCenter[k] /= meshArea;
+
+      for (size_t c = 0; c < clusters.size(); c++)
+      {
+         const float *pCenter = &centers[c * 3], *pNormal = &normals[c * 3];
+         const float length = sqrtf(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+         const float dot = (pCenter[0] - meshCenter[0]) * pNormal[0] + (pCenter[1] - meshCenter[1]) * pNormal[1] +
+            (pCenter[2] - meshCenter[2]) * pNormal[2];
+         clusters[c].m_sortKey = (length > 0.0f) ? dot / length : 0.0f;
+      }
+      std::stable_sort(clusters.begin(), clusters.end());
+
+      std::vector<uint32> sorted;
+      sorted.reserve(numTriangles * 3);
+      for (size_t c = 0; c < clusters.size(); c++)
+         sorted.insert(sorted.end(), &pIndices[clusters[c].m_first * 3], &pIndices[(clusters[c].m_first + clusters[c].m_count) * 3]);
+      std::copy(sorted.begin(), sorted.end(), pIndices);
+   }
+
+   // replaces a vertex stream by its permutation, newArray[pRemap[v]] = array[v]
+   template <typename T>
+   static void RemapStream(T *&pArray, const uint32 *pRemap, uint32 numVertices)
+   {
+      if (NULL == pArray)
+         return;
+      T *pRemapped = new T[numVertices];
+      for (uint32 v = 0; v < numVertices; v++)
+         pRemapped[pRemap[v]] = pArray[v];
+      delete[] pArray;
+      pArray = pRemapped;
+   }
+
+   uint32 ImproveCacheLocalityProcess::CountCacheMisses(const uint32 *pIndices, uint32 numIndices, uint32 numVertices,
+      uint32 cacheSize)
+   {
+      // a vertex is in the cache if less than cacheSize misses happened after its own
+      std::vector<uint32> stamps(numVertices, 0);
+      uint32 time = cacheSize + 1;
+      uint32 misses = 0;
+      for (uint32 i = 0; i < numIndices; i++)
+      {
+         if (time - stamps[pIndices[i]] > cacheSize)
+         {
+            stamps[pIndices[i]] = time++;
+            misses++;
+         }
+      }
+      return misses;
+   }
+
+   void ImproveCacheLocalityProcess::OptimizeMesh(Mesh *pMesh, uint32 cacheSize, bool optimizeOverdraw, CacheStats &stats)
+   {
+      if (!pMesh->HasTriangleIndexBuffer() || pMesh->m_numVertices == 0)
+         return;
+
+      // the index buffer and the vertex streams are replaced below
+      pMesh->TakeOwnership();
+
+      uint32 *pIndices = pMesh->m_pIndices;
+      const uint32 numTriangles = pMesh->m_numIndices / 3;
+      const uint32 numVertices = pMesh->m_numVertices;
+
+      stats.m_numTriangles = numTriangles;
+      stats.m_missesBefore = CountCacheMisses(pIndices, numTriangles * 3, numVertices, cacheSize);
+
+      OptimizeTriangleOrder(pIndices, numTriangles, numVertices, cacheSize);
+      if (optimizeOverdraw && pMesh->HasPositions())
+         OptimizeOverdraw(pIndices, numTriangles, pMesh->m_pVertices, numVertices, cacheSize);
+
+      // the vertices in the order the triangles use them first, unused ones at the end
+      std::vector<uint32> remap(numVertices, NO_TRIANGLE);
+      uint32 numUsed = 0;
+      for (uint32 i = 0; i < numTriangles * 3; i++)
+      {
+         if (remap[pIndices[i]] == NO_TRIANGLE)
+            remap[pIndices[i]] = numUsed++;
+      }
+      stats.m_numVertices = numUsed;
+
+      // vertex animations refer to the vertices by their position in the arrays
+      if (pMesh->m_numAnimMeshes == 0)
+      {
+         uint32 next = numUsed;
+         for (uint32 v = 0; v < numVertices; v++)
+         {
+            if (remap[v] == NO_TRIANGLE)
+               remap[v] = next++;
+         }
+
+         for (uint32 i = 0; i < numTriangles * 3; i++)
+            pIndices[i] = remap[pIndices[i]];
+         for (uint32 l = 0; l < pMesh->m_numLods; l++)
+         {
+            for (uint32 i = 0; i < pMesh->m_pLods[l].m_numIndices; i++)
+               pMesh->m_pLods[l].m_pIndices[i] = remap[pMesh->m_pLods[l].m_pIndices[i]];
+         }
+         for (uint32 i = 0; i < pMesh->m_numMeshletVertices; i++)
+            pMesh->m_pMeshletVertices[i] = remap[pMesh->m_pMeshletVertices[i]];
+
+         const uint32 *pRemap = &remap[0];
+         RemapStream(pMesh->m_pVertices, pRemap, numVertices);
+         RemapStream(pMesh->m_pNormals, pRemap, numVertices);
+         RemapStream(pMesh->m_pTangents, pRemap, numVertices);
+         RemapStream(pMesh->m_pBiTangets, pRemap, numVertices);
+         RemapStream(pMesh->m_pSmoothingGroups, pRemap, numVertices);
+         for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+            RemapStream(pMesh->m_pColors[a], pRemap, numVertices);
+         for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+            RemapStream(pMesh->m_pTextureCoords[a], pRemap, numVertices);
+
+         for (uint32 b = 0; b < pMesh->m_numBones; b++)
+         {
+            Bone *pBone = pMesh->m_ppBones[b];
+            for (uint32 w = 0; w < pBone->mNumWeights; w++)
+               pBone->mWeights[w].mVertexId = remap[pBone->mWeights[w].mVertexId];
+         }
+      }
+
+      stats.m_missesAfter = CountCacheMisses(pIndices, numTriangles * 3, numVertices, cacheSize);
+   }
+
+   void ImproveCacheLocalityProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene || pScene->m_numMeshes == 0)
+         return;
+
+      int32 cacheSize = DEFAULT_CACHE_SIZE;
+      bool optimizeOverdraw = false;
+      if (NULL != context.m_pImporter)
+      {
+         cacheSize = context.m_pImporter->GetPropertyInteger(CONFIG_PP_ICL_CACHE_SIZE, DEFAULT_CACHE_SIZE);
+         optimizeOverdraw = context.m_pImporter->GetPropertyBool(CONFIG_PP_ICL_OPTIMIZE_OVERDRAW, false);
+      }
+      if (cacheSize < 4)
+         cacheSize = 4;
+
+      std::vector<CacheStats> stats(pScene->m_numMeshes);
+      if (NULL != context.m_pThreadPool && pScene->m_numMeshes > 1)
+      {
+         core::thread::ParallelFor(*context.m_pThreadPool, pScene->m_numMeshes, [pScene, cacheSize, optimizeOverdraw, &stats](uint32 i) {
+            OptimizeMesh(pScene->m_ppMeshes[i], cacheSize, optimizeOverdraw, stats[i]);
+         });
+      }
+      else
+      {
+         for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+            OptimizeMesh(pScene->m_ppMeshes[i], cacheSize, optimizeOverdraw, stats[i]);
+      }
+
+      CacheStats total;
+      for (size_t i = 0; i < stats.size(); i++)
+      {
+         total.m_numTriangles += stats[i].m_numTriangles;
+         total.m_numVertices += stats[i].m_numVertices;
+         total.m_missesBefore += stats[i].m_missesBefore;
+         total.m_missesAfter += stats[i].m_missesAfter;
+      }
+
+      if (NULL != context.m_pReport && total.m_numTriangles > 0)
+      {
+         const double numTriangles = (double)total.m_numTriangles;
+         const double numVertices = (double)total.m_numVertices;
+         context.m_pReport->AddPostProcessStat(GetName(), "acmrBefore", total.m_missesBefore / numTriangles);
+         context.m_pReport->AddPostProcessStat(GetName(), "acmrAfter", total.m_missesAfter / numTriangles);
+         context.m_pReport->AddPostProcessStat(GetName(), "atvrBefore", total.m_missesBefore / numVertices);
+         context.m_pReport->AddPostProcessStat(GetName(), "atvrAfter", total.m_missesAfter / numVertices);
+      }
+   }
+
+} // namespace postprocess
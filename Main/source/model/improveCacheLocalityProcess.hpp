@@ -0,0 +1,49 @@
+#ifndef _IMPROVECACHELOCALITYPROCESS_HPP_INCLUDED_
+#define _IMPROVECACHELOCALITYPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_IMPROVE_CACHE_LOCALITY, see postprocess.hpp.
+   class ImproveCacheLocalityProcess : public BaseProcess
+   {
+   public:
+      // cache misses of the meshes, summed up for the import report
+      struct CacheStats
+      {
+         uint64 m_numTriangles;
+         uint64 m_numVertices; // vertices used by the triangles
+         uint64 m_missesBefore;
+         uint64 m_missesAfter;
+
+         CacheStats() : m_numTriangles(0), m_numVertices(0), m_missesBefore(0), m_missesAfter(0) { }
+      };
+
+      const char *GetName() const { return "improveCacheLocality"; }
+      uint32 GetFlag() const { return PROCESS_IMPROVE_CACHE_LOCALITY; }
+      uint32 GetRequiredFlags() const { return PROCESS_TRIANGULATE; }
+      bool NeedsSharedVertices() const { return true; }
+
+      // optimizes the meshes in parallel and adds the ACMR and ATVR of all meshes to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      // Reorders the triangles and vertices of one mesh, meshes with anything but triangles
+      // are left alone. The stats are only filled for a processed mesh.
+      static void OptimizeMesh(mesh2::Mesh *pMesh, uint32 cacheSize, bool optimizeOverdraw, CacheStats &stats);
+
+      // Reorders the triangles of an index buffer in place with Forsyth's linear-speed vertex
+      // cache optimization, the cache is simulated as LRU with cacheSize entries.
+      static void OptimizeTriangleOrder(uint32 *pIndices, uint32 numTriangles, uint32 numVertices, uint32 cacheSize);
+
+      // the number of misses of a FIFO vertex cache with cacheSize entries drawing the triangles
+      static uint32 CountCacheMisses(const uint32 *pIndices, uint32 numIndices, uint32 numVertices, uint32 cacheSize);
+   };
+
+} // namespace postprocess
+
+#endif
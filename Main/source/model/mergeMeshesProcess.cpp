@@ -0,0 +1,396 @@
+#include "mergeMeshesProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::Face;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include "scene/scene.hpp"
+using scene::Node;
+using scene::MeshRemap;
+
+#include "bakeTransform.hpp"
+#include "config.hpp"
+#include "importer.hpp"
+#include "importReport.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "core/math/matrix4.hpp"
+using core::math::Matrix4f;
+
+#include "core/thread/threadpool.hpp"
+
+#include <cstring>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace postprocess
+{
+
+   static const uint32 DEFAULT_MAX_VERTICES = 0xffff;
+
+   // a mesh referenced by a node, with the transformation into the space of the root node
+   struct MeshInstance
+   {
+      uint32 m_node; // in pre-order
+      uint32 m_mesh;
+      Matrix4f m_transform;
+      bool m_merge;
+      uint32 m_chunk; // the merged mesh it goes to
+      uint32 m_firstVertex; // its place in the merged mesh
+      uint32 m_firstFace;
+      uint32 m_numVertices;
+      uint32 m_numFaces;
+   };
+
+   // the meshes of a group have the same material, primitives and vertex streams
+   static void GetMergeKey(const Mesh *pMesh, std::vector<uint32> &key)
+   {
+      uint32 streams = (pMesh->HasNormals() ? 1 : 0) | (pMesh->HasTangentsAndBitangents() ? 2 : 0) |
+         (pMesh->HasSmoothingGroups() ? 4 : 0) | (pMesh->m_pIndices ? 8 : 0);
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+         streams |= pMesh->HasVertexColors(a) ? (0x100 << a) : 0;
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+         streams |= pMesh->HasTextureCoords(a) ? (0x10000 << a) : 0;
+
+      key.clear();
+      key.push_back(pMesh->m_materialIndex);
+      key.push_back(pMesh->m_primitiveTypes);
+      key.push_back(streams);
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+         key.push_back(pMesh->HasTextureCoords(a) ? pMesh->m_numUVComponents[a] : 0);
+   }
+
+   static bool CanMerge(const Mesh *pMesh, uint32 maxVertices)
+   {
+      return pMesh->HasPositions() && pMesh->HasFaces() && !pMesh->HasBones() && pMesh->m_numAnimMeshes == 0 &&
+         !pMesh->HasLods() && !pMesh->HasMeshlets() && pMesh->m_numVertices <= maxVertices;
+   }
+
+   // Lists the nodes in pre-order and the meshes they reference, transform takes the node
+   // into the space of the root node.
+   static void CollectInstances(const Node *pNode, const Matrix4f &transform, bool isStatic, const std::set<std::string> &keepNodes,
+      uint32 &numNodes, std::vector<MeshInstance> &instances)
+   {
+      const uint32 node = numNodes++;
+      isStatic = isStatic && keepNodes.find(pNode->m_name) == keepNodes.end();
+      for (uint32 i = 0; i < pNode->m_numMeshes; i++)
+      {
+         MeshInstance instance;
+         instance.m_node = node;
+         instance.m_mesh = pNode->m_ppMeshes[i];
+         instance.m_transform = transform;
+         instance.m_merge = isStatic;
+         instance.m_chunk = 0;
+         instance.m_firstVertex = 0;
+         instance.m_firstFace = 0;
+         instance.m_numVertices = 0;
+         instance.m_numFaces = 0;
+         instances.push_back(instance);
+      }
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+      {
+         const Node *pChild = pNode->m_ppChildren[i];
+         CollectInstances(pChild, transform * pChild->m_transformation, isStatic, keepNodes, numNodes, instances);
+      }
+   }
+
+   // writes the faces of pSource behind first into pDest, the indices moved by vertexOffset
+   static void AppendFaces(const Mesh *pSource, bool mirrored, uint32 vertexOffset, Mesh *pDest, uint32 firstFace, uint32 &nextIndex)
+   {
+      for (uint32 f = 0; f < pSource->m_numFaces; f++)
+      {
+         const Face &source = pSource->m_pFaces[f];
+         Face &dest = pDest->m_pFaces[firstFace + f];
+         dest.m_numIndices = source.m_numIndices;
+         if (NULL != pDest->m_pIndices)
+         {
+            dest.m_pIndexArray = pDest->m_pIndices + nextIndex;
+            dest.m_ownsIndexArray = false;
+            nextIndex += source.m_numIndices;
+         }
+         else
+            dest.m_pIndexArray = new uint32[source.m_numIndices];
+
+         for (uint32 i = 0; i < source.m_numIndices; i++)
+            dest.m_pIndexArray[i] = source.m_pIndexArray[mirrored ? source.m_numIndices - 1 - i : i] + vertexOffset;
+      }
+   }
+
+   // Concatenates the meshes of a chunk in the space of the root node.
+   static Mesh *BuildMergedMesh(const scene::Scene *pScene, const std::vector<MeshInstance> &instances, const std::vector<uint32> &chunk)
+   {
+      const Mesh *pFirst = pScene->m_ppMeshes[instances[chunk[0]].m_mesh];
+      uint32 numVertices = 0, numFaces = 0, numIndices = 0;
+      for (size_t i = 0; i < chunk.size(); i++)
+      {
+         const Mesh *pSource = pScene->m_ppMeshes[instances[chunk[i]].m_mesh];
+         numVertices += pSource->m_numVertices;
+         numFaces += pSource->m_numFaces;
+         for (uint32 f = 0; f < pSource->m_numFaces; f++)
+            numIndices += pSource->m_pFaces[f].m_numIndices;
+      }
+
+      Mesh *pMesh = new Mesh;
+      pMesh->m_name = pFirst->m_name;
+      pMesh->m_primitiveTypes = pFirst->m_primitiveTypes;
+      pMesh->m_materialIndex = pFirst->m_materialIndex;
+      pMesh->m_numVertices = numVertices;
+      pMesh->m_numFaces = numFaces;
+      pMesh->m_pVertices = new Vector3f[numVertices];
+      if (pFirst->HasNormals())
+         pMesh->m_pNormals = new Vector3f[numVertices];
+      if (pFirst->HasTangentsAndBitangents())
+      {
+         pMesh->m_pTangents = new Vector3f[numVertices];
+         pMesh->m_pBiTangets = new Vector3f[numVertices];
+      }
+      if (pFirst->HasSmoothingGroups())
+         pMesh->m_pSmoothingGroups = new uint32[numVertices];
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+      {
+         if (pFirst->HasVertexColors(a))
+            pMesh->m_pColors[a] = new Color4f[numVertices];
+      }
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+      {
+         if (pFirst->HasTextureCoords(a))
+         {
+            pMesh->m_pTextureCoords[a] = new Vector3f[numVertices];
+            pMesh->m_numUVComponents[a] = pFirst->m_numUVComponents[a];
+         }
+      }
+      pMesh->m_pFaces = new Face[numFaces];
+      if (NULL != pFirst->m_pIndices)
+      {
+         pMesh->m_pIndices = new uint32[numIndices];
+         pMesh->m_numIndices = numIndices;
+      }
+
+      uint32 nextIndex = 0;
+      for (size_t i = 0; i < chunk.size(); i++)
+      {
+         const MeshInstance &instance = instances[chunk[i]];
+         const Mesh *pSource = pScene->m_ppMeshes[instance.m_mesh];
+         const BakeTransform transform(instance.m_transform);
+         BakeVertices(pSource, transform, pMesh, instance.m_firstVertex);
+         AppendFaces(pSource, transform.m_mirrored, instance.m_firstVertex, pMesh, instance.m_firstFace, nextIndex);
+      }
+      return pMesh;
+   }
+
+   // replaces the mesh list of a node
+   static void SetNodeMeshes(Node *pNode, const std::vector<uint32> &meshes)
+   {
+      pNode->TakeOwnership();
+      delete[] pNode->m_ppMeshes;
+      pNode->m_ppMeshes = NULL;
+      pNode->m_numMeshes = (uint32)meshes.size();
+      if (!meshes.empty())
+      {
+         pNode->m_ppMeshes = new uint32[meshes.size()];
+         std::copy(meshes.begin(), meshes.end(), pNode->m_ppMeshes);
+      }
+   }
+
+   // Gives the nodes their new mesh lists in pre-order, the instances of a node are
+   // consecutive in the same order.
+   static void RewriteNodes(Node *pNode, const std::vector<MeshInstance> &instances, const std::vector<uint32> &newIndices,
+      size_t &nextInstance)
+   {
+      std::vector<uint32> meshes;
+      for (uint32 i = 0; i < pNode->m_numMeshes; i++)
+      {
+         const MeshInstance &instance = instances[nextInstance++];
+         if (!instance.m_merge)
+            meshes.push_back(newIndices[instance.m_mesh]);
+      }
+      SetNodeMeshes(pNode, meshes);
+
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+         RewriteNodes(pNode->m_ppChildren[i], instances, newIndices, nextInstance);
+   }
+
+   void MergeMeshesProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene || NULL == pScene->m_pRootNode || pScene->m_numMeshes == 0)
+         return;
+
+      int32 maxVertices = DEFAULT_MAX_VERTICES;
+      std::string keepText;
+      if (NULL != context.m_pImporter)
+      {
+         maxVertices = context.m_pImporter->GetPropertyInteger(CONFIG_PP_MERGE_MAX_VERTICES, DEFAULT_MAX_VERTICES);
+         keepText = context.m_pImporter->GetPropertyString(CONFIG_PP_MERGE_KEEP_NODES);
+      }
+      if (maxVertices < 1)
+         maxVertices = DEFAULT_MAX_VERTICES;
+
+      std::set<std::string> keepNodes;
+      std::istringstream keepStream(keepText);
+      std::string name;
+      while (keepStream >> name)
+         keepNodes.insert(name);
+
+      // the meshes are moved into the space of the root node, which keeps its transformation
+      std::vector<MeshInstance> instances;
+      uint32 numNodes = 0;
+      CollectInstances(pScene->m_pRootNode, Matrix4f::IDENTITY, true, keepNodes, numNodes, instances);
+
+      std::vector<uint32> numReferences(pScene->m_numMeshes, 0);
+      for (size_t i = 0; i < instances.size(); i++)
+      {
+         MeshInstance &instance = instances[i];
+         if (instance.m_mesh >= pScene->m_numMeshes)
+            throw std::runtime_error("A node references a mesh which doesn't exist.");
+         numReferences[instance.m_mesh]++;
+         instance.m_numVertices = pScene->m_ppMeshes[instance.m_mesh]->m_numVertices;
+         instance.m_numFaces = pScene->m_ppMeshes[instance.m_mesh]->m_numFaces;
+         instance.m_merge = instance.m_merge && CanMerge(pScene->m_ppMeshes[instance.m_mesh], (uint32)maxVertices);
+      }
+
+      // The instances are appended to the open chunk of their group in node order, a chunk
+      // which would get too many vertices is closed
+      std::map<std::vector<uint32>, uint32> openChunks;
+      std::vector<std::vector<uint32> > chunks;
+      std::vector<uint32> chunkVertices, chunkFaces;
+      std::vector<uint32> key;
+      for (size_t i = 0; i < instances.size(); i++)
+      {
+         MeshInstance &instance = instances[i];
+         if (!instance.m_merge)
+            continue;
+
+         const Mesh *pMesh = pScene->m_ppMeshes[instance.m_mesh];
+         GetMergeKey(pMesh, key);
+         std::map<std::vector<uint32>, uint32>::iterator it = openChunks.find(key);
+         if (it == openChunks.end() || chunkVertices[it->second] + pMesh->m_numVertices > (uint32)maxVertices)
+         {
+            openChunks[key] = (uint32)chunks.size();
+            chunks.push_back(std::vector<uint32>());
+            chunkVertices.push_back(0);
+            chunkFaces.push_back(0);
+            it = openChunks.find(key);
+         }
+
+         const uint32 chunk = it->second;
+         instance.m_chunk = chunk;
+         instance.m_firstVertex = chunkVertices[chunk];
+         instance.m_firstFace = chunkFaces[chunk];
+         chunks[chunk].push_back((uint32)i);
+         chunkVertices[chunk] += pMesh->m_numVertices;
+         chunkFaces[chunk] += pMesh->m_numFaces;
+      }
+
+      // meshes still referenced as they are or not at all keep their place in the order,
+      // the merged meshes follow
+      const uint32 NO_MESH = 0xffffffff;
+      std::vector<bool> keepMesh(pScene->m_numMeshes, false);
+      for (uint32 m = 0; m < pScene->m_numMeshes; m++)
+         keepMesh[m] = (numReferences[m] == 0);
+      for (size_t i = 0; i < instances.size(); i++)
+      {
+         if (!instances[i].m_merge)
+            keepMesh[instances[i].m_mesh] = true;
+      }
+
+      std::vector<uint32> newIndices(pScene->m_numMeshes, NO_MESH);
+      std::vector<Mesh*> meshes;
+      for (uint32 m = 0; m < pScene->m_numMeshes; m++)
+      {
+         if (keepMesh[m])
+         {
+            newIndices[m] = (uint32)meshes.size();
+            meshes.push_back(pScene->m_ppMeshes[m]);
+         }
+      }
+      const uint32 firstMerged = (uint32)meshes.size();
+
+      // a mesh alone in its chunk and referenced nowhere else is transformed in place
+      std::vector<Mesh*> merged(chunks.size(), NULL);
+      std::vector<bool> reused(pScene->m_numMeshes, false);
+      for (size_t c = 0; c < chunks.size(); c++)
+      {
+         const uint32 mesh = instances[chunks[c][0]].m_mesh;
+         if (chunks[c].size() == 1 && numReferences[mesh] == 1)
+         {
+            merged[c] = pScene->m_ppMeshes[mesh];
+            reused[mesh] = true;
+         }
+      }
+
+      const std::function<void(uint32)> build = [pScene, &instances, &chunks, &merged](uint32 c) {
+         if (NULL != merged[c])
+            BakeMesh(merged[c], BakeTransform(instances[chunks[c][0]].m_transform));
+         else
+            merged[c] = BuildMergedMesh(pScene, instances, chunks[c]);
+      };
+      if (NULL != context.m_pThreadPool && chunks.size() > 1)
+         core::thread::ParallelFor(*context.m_pThreadPool, (uint32)chunks.size(), build);
+      else
+      {
+         for (uint32 c = 0; c < (uint32)chunks.size(); c++)
+            build(c);
+      }
+
+      for (uint32 m = 0; m < pScene->m_numMeshes; m++)
+      {
+         if (!keepMesh[m] && !reused[m])
+            delete pScene->m_ppMeshes[m];
+      }
+      meshes.insert(meshes.end(), merged.begin(), merged.end());
+
+      const uint32 numMeshesBefore = pScene->m_numMeshes;
+      delete[] pScene->m_ppMeshes;
+      pScene->m_ppMeshes = new Mesh*[meshes.size()];
+      std::copy(meshes.begin(), meshes.end(), pScene->m_ppMeshes);
+      pScene->m_numMeshes = (uint32)meshes.size();
+
+      size_t nextInstance = 0;
+      RewriteNodes(pScene->m_pRootNode, instances, newIndices, nextInstance);
+      if (!merged.empty())
+      {
+         std::vector<uint32> rootMeshes(pScene->m_pRootNode->m_ppMeshes, pScene->m_pRootNode->m_ppMeshes + pScene->m_pRootNode->m_numMeshes);
+         for (uint32 c = 0; c < (uint32)merged.size(); c++)
+            rootMeshes.push_back(firstMerged + c);
+         SetNodeMeshes(pScene->m_pRootNode, rootMeshes);
+      }
+
+      // where every reference went
+      delete[] pScene->m_pMeshRemaps;
+      pScene->m_pMeshRemaps = NULL;
+      pScene->m_numMeshRemaps = (uint32)instances.size();
+      if (!instances.empty())
+      {
+         pScene->m_pMeshRemaps = new MeshRemap[instances.size()];
+         for (size_t i = 0; i < instances.size(); i++)
+         {
+            const MeshInstance &instance = instances[i];
+            MeshRemap &remap = pScene->m_pMeshRemaps[i];
+            remap.m_node = instance.m_node;
+            remap.m_oldMesh = instance.m_mesh;
+            remap.m_newMesh = instance.m_merge ? firstMerged + instance.m_chunk : newIndices[instance.m_mesh];
+            remap.m_firstVertex = instance.m_firstVertex;
+            remap.m_numVertices = instance.m_numVertices;
+            remap.m_firstFace = instance.m_firstFace;
+            remap.m_numFaces = instance.m_numFaces;
+         }
+      }
+
+      if (NULL != context.m_pReport)
+      {
+         context.m_pReport->AddPostProcessStat(GetName(), "meshesBefore", numMeshesBefore);
+         context.m_pReport->AddPostProcessStat(GetName(), "meshesAfter", pScene->m_numMeshes);
+      }
+   }
+
+} // namespace postprocess
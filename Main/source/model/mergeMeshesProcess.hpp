@@ -0,0 +1,29 @@
+#ifndef _MERGEMESHESPROCESS_HPP_INCLUDED_
+#define _MERGEMESHESPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_MERGE_MESHES, see postprocess.hpp.
+   class MergeMeshesProcess : public BaseProcess
+   {
+   public:
+      const char *GetName() const { return "mergeMeshes"; }
+      uint32 GetFlag() const { return PROCESS_MERGE_MESHES; }
+      // the cache optimization works on the meshes of the instances, their ranges in the
+      // merged meshes keep the optimized order
+      uint32 GetRunAfterFlags() const { return PROCESS_TRIANGULATE | PROCESS_GEN_SMOOTH_NORMALS | PROCESS_CALC_TANGENT_SPACE | PROCESS_IMPROVE_CACHE_LOCALITY; }
+
+      // merges the meshes, builds the remap table of the scene and adds the number of
+      // meshes before and after to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+   };
+
+} // namespace postprocess
+
+#endif
@@ -61,6 +61,8 @@ using core::math::Vector3f;
 using gfx::color4f::Color4f;
 
 #include <string.h>
+#include <cmath>
+#include <algorithm>
 
    /** @brief A single face in a mesh, referring to multiple vertices.
    *
@@ -130,18 +132,28 @@ using gfx::color4f::Color4f;
          // Pointer to the indices array. Size of the array is given in numIndices.
          uint32* m_pIndexArray;
 
-         Face() : m_numIndices(0), m_pIndexArray(NULL) { }
+         // False if m_pIndexArray points into the index buffer of the mesh (see
+         // Mesh::m_pIndices), the face doesn't delete it then. Copies always own their array.
+         bool m_ownsIndexArray;
 
-         ~Face() { delete[] m_pIndexArray; }
+         Face() : m_numIndices(0), m_pIndexArray(NULL), m_ownsIndexArray(true) { }
 
-         Face(const Face &other) : m_pIndexArray(NULL) { *this = other; }
+         ~Face()
+         {
+            if (m_ownsIndexArray)
+               delete[] m_pIndexArray;
+         }
+
+         Face(const Face &other) : m_pIndexArray(NULL), m_ownsIndexArray(true) { *this = other; }
 
          Face& operator=(const Face &other)
          {
             if (&other == this)
                return *this;
 
-            delete[] m_pIndexArray;
+            if (m_ownsIndexArray)
+               delete[] m_pIndexArray;
+            m_ownsIndexArray = true;
             m_numIndices = other.m_numIndices;
             if (m_numIndices) {
                m_pIndexArray = new uint32[m_numIndices];
@@ -172,6 +184,69 @@ using gfx::color4f::Color4f;
          }
       }; // struct Face
 
+      // A coarser level of detail of a mesh, see Mesh::m_pLods.
+      struct MeshLod
+      {
+         // Triangle list over the vertices of the mesh, m_numIndices in size. The level
+         // only uses a subset of the vertices, the vertex arrays are shared with the mesh.
+         uint32* m_pIndices;
+         uint32 m_numIndices;
+
+         // The largest distance the surface moved, relative to the size of the mesh's
+         // bounding box, 0 for an exact copy.
+         float m_error;
+
+         MeshLod() : m_pIndices(NULL), m_numIndices(0), m_error(0.0f) { }
+      };
+
+      // A small cluster of triangles of a mesh, culled as a whole, see Mesh::m_pMeshlets.
+      struct Meshlet
+      {
+         // m_numVertices entries at Mesh::m_pMeshletVertices + m_firstVertex, the
+         // vertices of the mesh the cluster uses
+         uint32 m_firstVertex;
+         uint32 m_numVertices;
+
+         // m_numTriangles * 3 entries at Mesh::m_pMeshletTriangles + m_firstTriangle * 3,
+         // the corners as indices into the cluster's vertices
+         uint32 m_firstTriangle;
+         uint32 m_numTriangles;
+
+         // bounding sphere of the triangles
+         Vector3f m_center;
+         float m_radius;
+
+         // Normal cone: the triangle normals deviate by an angle a from the axis at most,
+         // m_coneCutoff is sin(a), all triangles face away from a viewer looking along a
+         // direction d with d * m_coneAxis >= m_coneCutoff. 1 if the cone is too wide to cull.
+         Vector3f m_coneAxis;
+         float m_coneCutoff;
+
+         Meshlet() : m_firstVertex(0), m_numVertices(0), m_firstTriangle(0), m_numTriangles(0),
+            m_center(0.0f, 0.0f, 0.0f), m_radius(0.0f), m_coneAxis(0.0f, 0.0f, 0.0f), m_coneCutoff(1.0f) { }
+
+         //! true if the bounding sphere lies completely behind the plane
+         //! a * x + b * y + c * z + d = 0, whose normalized normal points to the inside
+         bool IsOutside(float a, float b, float c, float d) const
+         {
+            return a * m_center.x + b * m_center.y + c * m_center.z + d < -m_radius;
+         }
+
+         //! true if all triangles face away from a camera at the position
+         bool IsBackFacing(const Vector3f &cameraPosition) const
+         {
+            const float dx = m_center.x - cameraPosition.x;
+            const float dy = m_center.y - cameraPosition.y;
+            const float dz = m_center.z - cameraPosition.z;
+            const float along = dx * m_coneAxis.x + dy * m_coneAxis.y + dz * m_coneAxis.z;
+            const float across = sqrtf(std::max<float>(dx * dx + dy * dy + dz * dz - along * along, 0.0f));
+
+            // the view direction onto any point of the sphere has to face away from all normals
+            const float cosine = sqrtf(std::max<float>(1.0f - m_coneCutoff * m_coneCutoff, 0.0f));
+            return along * cosine - across * m_coneCutoff > m_radius;
+         }
+      };
+
 
       // A single influence of a bone on a vertex.
       struct VertexWeight
@@ -228,6 +303,7 @@ using gfx::color4f::Color4f;
          Bone(const Bone& other)
             : m_name(other.m_name)
             , mNumWeights(other.mNumWeights)
+            , mWeights(NULL)
             , mOffsetMatrix(other.mOffsetMatrix)
          {
             if (other.mWeights && other.mNumWeights)
@@ -511,6 +587,15 @@ using gfx::color4f::Color4f;
          */
          uint32 m_numUVComponents[MAX_NUMBER_OF_TEXTURECOORDS];
 
+         /** Smoothing group of the faces using a vertex, NULL if the source
+         * file had none. A vertex belongs to the faces of a single group, 0
+         * marks a vertex used by one flat shaded face only. Normals are
+         * averaged over the vertices with the same position and group, see
+         * postprocess::PROCESS_GEN_SMOOTH_NORMALS. The array is m_numVertices
+         * in size.
+         */
+         uint32* m_pSmoothingGroups;
+
          /** The faces the mesh is constructed from.
          * Each face refers to a number of vertices by their indices.
          * This array is always present in a mesh, its size is given
@@ -519,6 +604,17 @@ using gfx::color4f::Color4f;
          */
          Face* m_pFaces;
 
+         /** Contiguous index buffer of all faces, NULL if every face owns its
+         * own index array. The triangulation step creates it, the faces then
+         * point into this buffer in face order, so a mesh of triangles can
+         * be uploaded to an index buffer with a single copy. The array is
+         * m_numIndices in size.
+         */
+         uint32* m_pIndices;
+
+         /** The number of indices in m_pIndices. */
+         uint32 m_numIndices;
+
          /** The number of bones this mesh contains.
          * Can be 0, in which case the m_ppBones array is NULL.
          */
@@ -559,6 +655,44 @@ using gfx::color4f::Color4f;
          *  mesh'es vertex components (usually positions, normals). */
          AnimMesh** m_ppAnimMeshes;
 
+         /** The number of levels of detail in m_pLods. */
+         uint32 m_numLods;
+
+         /** Coarser levels of detail of the mesh, finest first, NULL if there
+         * are none. The mesh itself is the finest level, the levels reference
+         * its vertices with index buffers of their own, see
+         * postprocess::PROCESS_GENERATE_LODS. The array belongs to the mesh,
+         * the index buffers follow m_ownsArrays.
+         */
+         MeshLod* m_pLods;
+
+         /** The number of clusters in m_pMeshlets. */
+         uint32 m_numMeshlets;
+
+         /** Clusters of at most 255 vertices with their bounds, NULL if the mesh
+         * wasn't partitioned, see postprocess::PROCESS_BUILD_MESHLETS. The
+         * clusters cover all triangles of the mesh, their vertex and triangle
+         * lists lie one after the other in m_pMeshletVertices and
+         * m_pMeshletTriangles. All three arrays follow m_ownsArrays.
+         */
+         Meshlet* m_pMeshlets;
+
+         /** The vertex lists of all clusters, m_numMeshletVertices in size. */
+         uint32* m_pMeshletVertices;
+         uint32 m_numMeshletVertices;
+
+         /** The triangles of all clusters with their corners as indices into the
+         * vertex list of their cluster, m_numMeshletTriangles * 3 in size.
+         */
+         uint8* m_pMeshletTriangles;
+         uint32 m_numMeshletTriangles;
+
+         /** False if the vertex streams, m_pFaces and m_pIndices belong to
+         * external memory (see scene::SceneStorage), the mesh doesn't delete
+         * them then. Call TakeOwnership() before replacing one of them.
+         */
+         bool m_ownsArrays;
+
          //! Default constructor. Initializes all members to 0
          Mesh()
             : m_primitiveTypes(0)
@@ -568,12 +702,24 @@ using gfx::color4f::Color4f;
             , m_pNormals(NULL)
             , m_pTangents(NULL)
             , m_pBiTangets(NULL)
+            , m_pSmoothingGroups(NULL)
             , m_pFaces(NULL)
+            , m_pIndices(NULL)
+            , m_numIndices(0)
             , m_numBones(0)
             , m_ppBones(NULL)
             , m_materialIndex(0)
             , m_numAnimMeshes(0)
             , m_ppAnimMeshes(NULL)
+            , m_numLods(0)
+            , m_pLods(NULL)
+            , m_numMeshlets(0)
+            , m_pMeshlets(NULL)
+            , m_pMeshletVertices(NULL)
+            , m_numMeshletVertices(0)
+            , m_pMeshletTriangles(NULL)
+            , m_numMeshletTriangles(0)
+            , m_ownsArrays(true)
          {
             for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
             {
@@ -588,15 +734,18 @@ using gfx::color4f::Color4f;
          //! Deletes all storage allocated for the mesh
          ~Mesh()
          {
-            delete[] m_pVertices;
-            delete[] m_pNormals;
-            delete[] m_pTangents;
-            delete[] m_pBiTangets;
-            for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++) {
-               delete[] m_pTextureCoords[a];
-            }
-            for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++) {
-               delete[] m_pColors[a];
+            if (m_ownsArrays) {
+               delete[] m_pVertices;
+               delete[] m_pNormals;
+               delete[] m_pTangents;
+               delete[] m_pBiTangets;
+               delete[] m_pSmoothingGroups;
+               for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++) {
+                  delete[] m_pTextureCoords[a];
+               }
+               for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++) {
+                  delete[] m_pColors[a];
+               }
             }
 
             // DO NOT REMOVE THIS ADDITIONAL CHECK
@@ -614,7 +763,63 @@ using gfx::color4f::Color4f;
                delete[] m_ppAnimMeshes;
             }
 
-            delete[] m_pFaces;
+            if (m_ownsArrays) {
+               for (uint32 a = 0; a < m_numLods; a++) {
+                  delete[] m_pLods[a].m_pIndices;
+               }
+               delete[] m_pMeshlets;
+               delete[] m_pMeshletVertices;
+               delete[] m_pMeshletTriangles;
+            }
+            delete[] m_pLods;
+
+            // the faces may point into the index buffer, so it goes last
+            if (m_ownsArrays) {
+               delete[] m_pFaces;
+               delete[] m_pIndices;
+            }
+         }
+
+         //! Copies the arrays which belong to external memory, afterwards the
+         //! mesh may replace and delete them like the arrays it allocated itself
+         void TakeOwnership()
+         {
+            if (m_ownsArrays)
+               return;
+
+            m_pVertices = CopyArray(m_pVertices, m_numVertices);
+            m_pNormals = CopyArray(m_pNormals, m_numVertices);
+            m_pTangents = CopyArray(m_pTangents, m_numVertices);
+            m_pBiTangets = CopyArray(m_pBiTangets, m_numVertices);
+            m_pSmoothingGroups = CopyArray(m_pSmoothingGroups, m_numVertices);
+            for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+               m_pTextureCoords[a] = CopyArray(m_pTextureCoords[a], m_numVertices);
+            for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+               m_pColors[a] = CopyArray(m_pColors[a], m_numVertices);
+
+            // faces pointing into the index buffer keep doing so, the others get a copy
+            uint32 *pIndices = CopyArray(m_pIndices, m_numIndices);
+            Face *pFaces = m_pFaces ? new Face[m_numFaces] : NULL;
+            for (uint32 i = 0; i < m_numFaces; i++)
+            {
+               const Face &face = m_pFaces[i];
+               if (m_pIndices && face.m_pIndexArray >= m_pIndices && face.m_pIndexArray < m_pIndices + m_numIndices)
+               {
+                  pFaces[i].m_pIndexArray = pIndices + (face.m_pIndexArray - m_pIndices);
+                  pFaces[i].m_numIndices = face.m_numIndices;
+                  pFaces[i].m_ownsIndexArray = false;
+               }
+               else
+                  pFaces[i] = face;
+            }
+            m_pFaces = pFaces;
+            m_pIndices = pIndices;
+            for (uint32 a = 0; a < m_numLods; a++)
+               m_pLods[a].m_pIndices = CopyArray(m_pLods[a].m_pIndices, m_pLods[a].m_numIndices);
+            m_pMeshlets = CopyArray(m_pMeshlets, m_numMeshlets);
+            m_pMeshletVertices = CopyArray(m_pMeshletVertices, m_numMeshletVertices);
+            m_pMeshletTriangles = CopyArray(m_pMeshletTriangles, m_numMeshletTriangles * 3);
+            m_ownsArrays = true;
          }
 
          //! Check whether the mesh contains positions. Provided no special
@@ -646,6 +851,12 @@ using gfx::color4f::Color4f;
             return m_pTangents != NULL && m_pBiTangets != NULL && m_numVertices > 0;
          }
 
+         //! Check whether the mesh contains smoothing groups
+         bool HasSmoothingGroups() const
+         {
+            return m_pSmoothingGroups != NULL && m_numVertices > 0;
+         }
+
          //! Check whether the mesh contains a vertex color set
          //! \param pIndex Index of the vertex color set
          bool HasVertexColors(uint32 pIndex) const
@@ -682,11 +893,60 @@ using gfx::color4f::Color4f;
             return n;
          }
 
+         //! Check whether the faces are stored in the contiguous index buffer
+         //! and all of them are triangles, see m_pIndices
+         bool HasTriangleIndexBuffer() const
+         {
+            return m_pIndices != NULL && m_primitiveTypes == PRIMITIVE_TYPE_TRIANGLE;
+         }
+
+         //! Get the number of faces with exactly three indices
+         uint32 GetNumTriangles() const
+         {
+            if (HasTriangleIndexBuffer())
+               return m_numIndices / 3;
+
+            uint32 n = 0;
+            for (uint32 i = 0; i < m_numFaces; i++)
+               n += (m_pFaces[i].m_numIndices == 3) ? 1 : 0;
+            return n;
+         }
+
+         //! Get the size of one index in bytes for uploading the triangles. Meshes with
+         //! fewer than 65536 vertices use 16 bit indices, 0xffff is never a vertex then.
+         uint32 GetIndexSize() const
+         {
+            return m_numVertices < 0x10000 ? sizeof(uint16) : sizeof(uint32);
+         }
+
+         //! Check whether the mesh has coarser levels of detail
+         bool HasLods() const
+         {
+            return m_pLods != NULL && m_numLods > 0;
+         }
+
+         //! Check whether the mesh is partitioned into clusters
+         bool HasMeshlets() const
+         {
+            return m_pMeshlets != NULL && m_numMeshlets > 0;
+         }
+
          //! Check whether the mesh contains bones
          inline bool HasBones() const
          {
             return m_ppBones != NULL && m_numBones > 0;
          }
+
+      private:
+         template <typename T>
+         static T *CopyArray(const T *pSource, uint32 count)
+         {
+            if (pSource == NULL)
+               return NULL;
+            T *pCopy = new T[count];
+            std::copy(pSource, pSource + count, pCopy);
+            return pCopy;
+         }
       };
 
 } // namespace mesh2
@@ -0,0 +1,91 @@
+#include "mtlLibraryCache.hpp"
+
+#include "OBJMTLImporter.hpp"
+
+#include "core/fileio/mappedfile.hpp"
+using core::fileio::MappedFile;
+
+namespace model
+{
+
+   namespace objmtlimporter
+   {
+
+      std::shared_ptr<const MtlLibrary> MtlLibrary::Load(const std::string &path)
+      {
+         MappedFile file;
+         if (!file.Open(path))
+            return std::shared_ptr<const MtlLibrary>();
+
+         // parse into an empty model, statements before the first newmtl go to its default material
+         objfile::Model model;
+         model.m_pDefaultMaterial = new objfile::ObjMaterial;
+         model.m_pCurrentMaterial = model.m_pDefaultMaterial;
+         ObjMtlImporter mtlImporter(file.GetData(), file.GetEnd(), &model);
+         file.Close();
+
+         std::shared_ptr<MtlLibrary> pLibrary = std::make_shared<MtlLibrary>();
+         pLibrary->m_materials.reserve(model.m_materialLib.size());
+         for (size_t i = 0; i < model.m_materialLib.size(); i++)
+            pLibrary->m_materials.push_back(*model.m_materialMap[model.m_materialLib[i]]);
+
+         // the default material isn't in the material map, so the model doesn't delete it
+         delete model.m_pDefaultMaterial;
+         model.m_pDefaultMaterial = NULL;
+         return pLibrary;
+      }
+
+      void MtlLibrary::AddToModel(objfile::Model *pModel) const
+      {
+         for (size_t i = 0; i < m_materials.size(); i++)
+         {
+            const objfile::ObjMaterial &material = m_materials[i];
+            std::map<std::string, objfile::ObjMaterial*>::iterator it = pModel->m_materialMap.find(material.m_materialName);
+            if (pModel->m_materialMap.end() == it)
+            {
+               pModel->m_pCurrentMaterial = new objfile::ObjMaterial(material);
+               pModel->m_materialLib.push_back(material.m_materialName);
+               pModel->m_materialMap[material.m_materialName] = pModel->m_pCurrentMaterial;
+            }
+            else
+            {
+               *it->second = material;
+               pModel->m_pCurrentMaterial = it->second;
+            }
+         }
+      }
+
+      std::shared_ptr<const MtlLibrary> MtlLibraryCache::Get(const std::string &path)
+      {
+         std::shared_ptr<Entry> pEntry;
+         {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            std::shared_ptr<Entry> &pSlot = m_entries[path];
+            if (!pSlot)
+               pSlot = std::make_shared<Entry>();
+            pEntry = pSlot;
+         }
+
+         // other files are parsed meanwhile, only requests for this one wait
+         std::unique_lock<std::mutex> lock(pEntry->m_mutex);
+         if (pEntry->m_loaded)
+         {
+            m_numHits++;
+            return pEntry->m_pLibrary;
+         }
+
+         pEntry->m_pLibrary = MtlLibrary::Load(path);
+         pEntry->m_loaded = true;
+         m_numLoads++;
+         return pEntry->m_pLibrary;
+      }
+
+      void MtlLibraryCache::Clear()
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_entries.clear();
+      }
+
+   } // namespace objmtlimporter
+
+} // namespace model
@@ -0,0 +1,77 @@
+#ifndef _MTLLIBRARYCACHE_HPP_INCLUDED_
+#define _MTLLIBRARYCACHE_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "OBJFile.hpp"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace model
+{
+
+   namespace objmtlimporter
+   {
+
+      // the materials of a parsed material library, in the order of their newmtl statements
+      struct MtlLibrary
+      {
+         std::vector<objfile::ObjMaterial> m_materials;
+
+         // Parses a material library file, NULL if it can't be opened.
+         static std::shared_ptr<const MtlLibrary> Load(const std::string &path);
+
+         // Adds the materials to a model like loading the file with ObjMtlImporter does, a
+         // material the model already has is replaced. The last material becomes the
+         // current material of the model.
+         void AddToModel(objfile::Model *pModel) const;
+      };
+
+      // Material libraries shared between the imports of several OBJ files, each file is
+      // parsed once no matter how many OBJ files reference it. The cache may be used by any
+      // number of threads at once. Files are identified by the path the OBJ file gives,
+      // changes of a file after it was parsed aren't noticed.
+      class MtlLibraryCache
+      {
+      private:
+         struct Entry
+         {
+            std::mutex m_mutex; // held while the file is parsed
+            bool m_loaded;
+            std::shared_ptr<const MtlLibrary> m_pLibrary; // NULL if the file can't be opened
+
+            Entry() : m_loaded(false) { }
+         };
+
+         std::mutex m_mutex;
+         std::map<std::string, std::shared_ptr<Entry> > m_entries;
+         std::atomic<uint32> m_numLoads;
+         std::atomic<uint32> m_numHits;
+
+         MtlLibraryCache(const MtlLibraryCache &);
+         MtlLibraryCache &operator=(const MtlLibraryCache &);
+      public:
+         MtlLibraryCache() : m_numLoads(0), m_numHits(0) { }
+
+         // Returns the library of a file, parses it on the first request. Concurrent first
+         // requests wait for one thread to parse the file. NULL if the file can't be opened.
+         std::shared_ptr<const MtlLibrary> Get(const std::string &path);
+
+         // drops all libraries, imports still using one keep it alive
+         void Clear();
+
+         // number of files parsed and number of requests served without parsing
+         uint32 GetNumLoads() const { return m_numLoads; }
+         uint32 GetNumHits() const { return m_numHits; }
+      };
+
+   } // namespace objmtlimporter
+
+} // namespace model
+
+#endif
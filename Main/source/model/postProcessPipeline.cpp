@@ -0,0 +1,142 @@
+#include "postProcessPipeline.hpp"
+
+#include "importReport.hpp"
+#include "progressHandler.hpp"
+
+#include "triangulateProcess.hpp"
+#include "tangentSpaceProcess.hpp"
+#include "mergeMeshesProcess.hpp"
+#include "preTransformVerticesProcess.hpp"
+#include "improveCacheLocalityProcess.hpp"
+#include "generateLodsProcess.hpp"
+#include "buildMeshletsProcess.hpp"
+
+#include "core/timing/stopwatch.hpp"
+
+#include <stdexcept>
+
+namespace postprocess
+{
+
+   PostProcessPipeline::PostProcessPipeline()
+   {
+      Register(new TriangulateProcess);
+      Register(new GenSmoothNormalsProcess);
+      Register(new CalcTangentSpaceProcess);
+      Register(new MergeMeshesProcess);
+      Register(new PreTransformVerticesProcess);
+      Register(new ImproveCacheLocalityProcess);
+      Register(new GenerateLodsProcess);
+      Register(new BuildMeshletsProcess);
+   }
+
+   void PostProcessPipeline::Register(BaseProcess *pStep)
+   {
+      for (size_t i = 0; i < m_steps.size(); i++)
+      {
+         if (m_steps[i]->GetFlag() == pStep->GetFlag())
+         {
+            m_steps[i].reset(pStep);
+            return;
+         }
+      }
+      m_steps.push_back(std::shared_ptr<const BaseProcess>(pStep));
+   }
+
+   const BaseProcess *PostProcessPipeline::GetStep(uint32 flag) const
+   {
+      for (size_t i = 0; i < m_steps.size(); i++)
+      {
+         if (m_steps[i]->GetFlag() == flag)
+            return m_steps[i].get();
+      }
+      return NULL;
+   }
+
+   uint32 PostProcessPipeline::ResolveFlags(uint32 flags) const
+   {
+      // required steps may require further steps
+      uint32 resolved = 0;
+      while (resolved != flags)
+      {
+         resolved = flags;
+         for (size_t i = 0; i < m_steps.size(); i++)
+         {
+            if (flags & m_steps[i]->GetFlag())
+               flags |= m_steps[i]->GetRequiredFlags();
+         }
+      }
+      return flags;
+   }
+
+   bool PostProcessPipeline::GetSteps(uint32 flags, std::vector<const BaseProcess*> &steps) const
+   {
+      flags = ResolveFlags(flags);
+
+      uint32 known = 0;
+      for (size_t i = 0; i < m_steps.size(); i++)
+         known |= m_steps[i]->GetFlag();
+      if (flags & ~known)
+         return false;
+
+      // repeatedly take the first registered step whose predecessors all ran
+      uint32 pending = flags;
+      while (0 != pending)
+      {
+         const BaseProcess *pNext = NULL;
+         for (size_t i = 0; i < m_steps.size() && NULL == pNext; i++)
+         {
+            const BaseProcess *pStep = m_steps[i].get();
+            const uint32 predecessors = (pStep->GetRequiredFlags() | pStep->GetRunAfterFlags()) & ~pStep->GetFlag();
+            if ((pending & pStep->GetFlag()) && 0 == (predecessors & pending))
+               pNext = pStep;
+         }
+
+         if (NULL == pNext)
+            return false;
+
+         steps.push_back(pNext);
+         pending &= ~pNext->GetFlag();
+      }
+      return true;
+   }
+
+   bool PostProcessPipeline::ValidateFlags(uint32 flags) const
+   {
+      std::vector<const BaseProcess*> steps;
+      return GetSteps(flags, steps);
+   }
+
+   bool PostProcessPipeline::NeedsSharedVertices(uint32 flags) const
+   {
+      std::vector<const BaseProcess*> steps;
+      GetSteps(flags, steps);
+      for (size_t i = 0; i < steps.size(); i++)
+      {
+         if (steps[i]->NeedsSharedVertices())
+            return true;
+      }
+      return false;
+   }
+
+   void PostProcessPipeline::Execute(scene::Scene *pScene, uint32 flags, PostProcessContext &context,
+      importer::ImportReport *pReport) const
+   {
+      std::vector<const BaseProcess*> steps;
+      if (!GetSteps(flags, steps))
+         throw std::runtime_error("Invalid post processing flags.");
+
+      context.m_pReport = pReport;
+
+      for (size_t i = 0; i < steps.size(); i++)
+      {
+         const core::timing::Stopwatch stopwatch;
+         steps[i]->Execute(pScene, context);
+
+         if (NULL != pReport)
+            pReport->AddPostProcessStep(steps[i]->GetName(), stopwatch.GetMilliSecs());
+         importer::UpdateProgress(context.m_pProgressHandler, 0.85f + 0.1f * (i + 1) / steps.size());
+      }
+   }
+
+} // namespace postprocess
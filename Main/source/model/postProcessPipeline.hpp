@@ -0,0 +1,60 @@
+#ifndef _POSTPROCESSPIPELINE_HPP_INCLUDED_
+#define _POSTPROCESSPIPELINE_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace importer
+{
+   struct ImportReport;
+}
+
+namespace postprocess
+{
+
+   // The registered post processing steps of an importer::Importer. A set of flags selects
+   // the steps to run, they run one after the other in dependency order (see
+   // BaseProcess::GetRequiredFlags() and GetRunAfterFlags()), steps without a dependency
+   // between them in the order they were registered. Copies share the step instances.
+   class PostProcessPipeline
+   {
+   private:
+      std::vector<std::shared_ptr<const BaseProcess> > m_steps; // in registration order
+   public:
+      // registers the built-in steps, see postprocess.hpp
+      PostProcessPipeline();
+
+      // Takes ownership of the step, a step registered for the same flag before is replaced.
+      void Register(BaseProcess *pStep);
+
+      // NULL if no step is registered for the flag
+      const BaseProcess *GetStep(uint32 flag) const;
+
+      // flags plus the flags of all steps they require
+      uint32 ResolveFlags(uint32 flags) const;
+
+      // true if every flag has a step and their dependencies can be ordered
+      bool ValidateFlags(uint32 flags) const;
+
+      // Appends the steps selected by flags to steps in the order they run, false if a
+      // flag has no step or the dependencies form a cycle.
+      bool GetSteps(uint32 flags, std::vector<const BaseProcess*> &steps) const;
+
+      // true if one of the steps selected by flags needs shared vertices
+      bool NeedsSharedVertices(uint32 flags) const;
+
+      // Runs the steps selected by flags, the time of every step is added to the report,
+      // which may be NULL. The report is handed to the steps as
+      // PostProcessContext::m_pReport. Exceptions of the steps are passed on, the scene may
+      // be partly processed then.
+      void Execute(scene::Scene *pScene, uint32 flags, PostProcessContext &context,
+         importer::ImportReport *pReport = NULL) const;
+   };
+
+} // namespace postprocess
+
+#endif
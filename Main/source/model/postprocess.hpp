@@ -0,0 +1,122 @@
+#ifndef _POSTPROCESS_HPP_INCLUDED_
+#define _POSTPROCESS_HPP_INCLUDED_
+
+// Post processing steps run by importer::Importer::ReadFile() after a successful
+// import. The flags can be combined bitwise.
+
+namespace postprocess
+{
+
+   enum ePostProcessSteps
+   {
+      /** Calculates the tangents and bitangents of every mesh.
+      *
+      * The U axis of the first UV channel is computed per triangle like
+      * MikkTSpace does, projected into the tangent plane of the vertex normal
+      * and averaged weighted by the corner angle over the corners with the
+      * same position, normal and texture coordinate. The bitangent is the
+      * cross product of normal and tangent, negated for mirrored mappings.
+      * Meshes without a UV channel or with tangents already are skipped.
+      * Large meshes are processed in parallel chunks. Enables
+      * PROCESS_TRIANGULATE and PROCESS_GEN_SMOOTH_NORMALS.
+      */
+      PROCESS_CALC_TANGENT_SPACE = 0x1,
+
+      /** Splits all polygons into triangles.
+      *
+      * Convex polygons are split as a fan, concave ones by ear clipping. Points
+      * and lines are kept. Afterwards the faces of every mesh point into its
+      * contiguous index buffer (mesh2::Mesh::m_pIndices), so meshes consisting
+      * of triangles only can be uploaded to the GPU with a single copy.
+      */
+      PROCESS_TRIANGULATE = 0x8,
+
+      /** Generates vertex normals for meshes which have none.
+      *
+      * The face normals are weighted by area and corner angle and averaged
+      * over the vertices with the same position. Smoothing groups of the
+      * source file are honoured (see mesh2::Mesh::m_pSmoothingGroups), the
+      * vertices of flat faces get the normal of their face. The face pass
+      * uses SSE and large meshes are processed in parallel chunks. Enables
+      * PROCESS_TRIANGULATE, meshes with points or lines are skipped.
+      */
+      PROCESS_GEN_SMOOTH_NORMALS = 0x40,
+
+      /** Reorders triangles and vertices of every mesh for the GPU caches.
+      *
+      * The triangles are reordered for the post-transform vertex cache
+      * (Forsyth's linear-speed optimization), optionally followed by a
+      * reordering of triangle clusters against overdraw, then the vertex
+      * arrays are reordered to the order the triangles first use them. The
+      * average cache miss ratio per triangle (ACMR) and per vertex (ATVR) of
+      * all meshes before and after are added to the import report. Requires
+      * shared vertices to have an effect, OBJ files are welded unless
+      * CONFIG_IMPORT_OBJ_WELD_VERTICES is set to false. Enables
+      * PROCESS_TRIANGULATE, meshes with points or lines are skipped.
+      * @see CONFIG_PP_ICL_CACHE_SIZE, CONFIG_PP_ICL_OPTIMIZE_OVERDRAW
+      */
+      PROCESS_IMPROVE_CACHE_LOCALITY = 0x800,
+
+      /** Generates a chain of coarser levels of detail for every mesh.
+      *
+      * The triangles are simplified by edge collapses ordered by their
+      * quadric error, with attribute differences of normals and the first UV
+      * channel added to the cost. Vertices keep their position, borders and
+      * attribute seams only collapse along themselves. Every level is an index
+      * buffer over the vertices of the mesh, see mesh2::Mesh::m_pLods, its
+      * size and error are added to the import report. Requires shared
+      * vertices like PROCESS_IMPROVE_CACHE_LOCALITY, OBJ files are welded
+      * unless CONFIG_IMPORT_OBJ_WELD_VERTICES is set to false. Enables
+      * PROCESS_TRIANGULATE and runs after PROCESS_IMPROVE_CACHE_LOCALITY.
+      * @see CONFIG_PP_LOD_RATIOS, CONFIG_PP_LOD_MAX_ERROR
+      */
+      PROCESS_GENERATE_LODS = 0x1000,
+
+      /** Partitions every mesh into small clusters of triangles for culling.
+      *
+      * The clusters grow over neighbouring triangles in the order of the
+      * index buffer, each gets a bounding sphere and a normal cone, see
+      * mesh2::Mesh::m_pMeshlets. The meshlets cover the full detail mesh, not
+      * the levels of PROCESS_GENERATE_LODS. Their number and fill are added
+      * to the import report. Enables PROCESS_TRIANGULATE and runs after
+      * PROCESS_IMPROVE_CACHE_LOCALITY.
+      * @see CONFIG_PP_MESHLET_MAX_VERTICES, CONFIG_PP_MESHLET_MAX_TRIANGLES
+      */
+      PROCESS_BUILD_MESHLETS = 0x2000,
+
+      /** Merges the meshes of static nodes which share material and format.
+      *
+      * The meshes referenced by nodes outside the subtrees named in
+      * CONFIG_PP_MERGE_KEEP_NODES are transformed into the space of the root
+      * node and concatenated per material, primitive types and vertex format,
+      * the merged meshes are referenced by the root node. Normals are
+      * transformed with the inverse transpose, mirroring transforms flip the
+      * winding. The nodes stay in the hierarchy, scene::Scene::m_pMeshRemaps
+      * tells where the mesh of every node went. Meshes with bones, levels of
+      * detail or meshlets are kept. Runs after PROCESS_TRIANGULATE,
+      * PROCESS_GEN_SMOOTH_NORMALS and PROCESS_CALC_TANGENT_SPACE, so the
+      * pieces don't share normals, after PROCESS_IMPROVE_CACHE_LOCALITY, so
+      * the ranges in the remap table stay valid, and before the steps building
+      * levels of detail and meshlets.
+      * @see CONFIG_PP_MERGE_MAX_VERTICES
+      */
+      PROCESS_MERGE_MESHES = 0x4000,
+
+      /** Bakes the world transformations into the meshes and flattens the hierarchy.
+      *
+      * The positions, normals and tangents of every mesh are transformed by
+      * the accumulated transformations of the node referencing it, normals
+      * with the inverse transpose. Mirroring transformations flip the winding,
+      * meshlet bounds and bone offsets move along. A mesh referenced by more
+      * than one node is copied for the others. Afterwards the root node is the
+      * only node, it has the identity transformation and references all
+      * meshes, scene::Scene::m_pMeshRemaps tells which node a mesh came from.
+      * Runs after PROCESS_MERGE_MESHES and before the steps building levels of
+      * detail and meshlets.
+      */
+      PROCESS_PRE_TRANSFORM_VERTICES = 0x8000
+   };
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,271 @@
+#include "preTransformVerticesProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::Bone;
+using mesh2::AnimMesh;
+using mesh2::MeshLod;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include "scene/scene.hpp"
+using scene::Node;
+using scene::MeshRemap;
+
+#include "bakeTransform.hpp"
+#include "importReport.hpp"
+
+#include "core/math/matrix4.hpp"
+using core::math::Matrix4f;
+
+#include "core/thread/threadpool.hpp"
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace postprocess
+{
+
+   static const uint32 NO_INSTANCE = 0xffffffff;
+
+   // a mesh referenced by a node, with the transformation into world space
+   struct WorldInstance
+   {
+      uint32 m_node; // in pre-order
+      uint32 m_mesh;
+      uint32 m_newMesh; // the mesh itself for its last reference, a copy for the others
+      Matrix4f m_transform;
+   };
+
+   // Lists the meshes referenced by the nodes in pre-order, transform takes the node into
+   // world space.
+   static void CollectInstances(const Node *pNode, const Matrix4f &transform, uint32 &numNodes, std::vector<WorldInstance> &instances)
+   {
+      const uint32 node = numNodes++;
+      for (uint32 i = 0; i < pNode->m_numMeshes; i++)
+      {
+         WorldInstance instance;
+         instance.m_node = node;
+         instance.m_mesh = pNode->m_ppMeshes[i];
+         instance.m_newMesh = instance.m_mesh;
+         instance.m_transform = transform;
+         instances.push_back(instance);
+      }
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+      {
+         const Node *pChild = pNode->m_ppChildren[i];
+         CollectInstances(pChild, transform * pChild->m_transformation, numNodes, instances);
+      }
+   }
+
+   template <typename T>
+   static T *CopyArray(const T *pSource, uint32 count)
+   {
+      if (NULL == pSource)
+         return NULL;
+      T *pCopy = new T[count];
+      std::copy(pSource, pSource + count, pCopy);
+      return pCopy;
+   }
+
+   static AnimMesh *CopyAnimMesh(const AnimMesh *pSource)
+   {
+      AnimMesh *pCopy = new AnimMesh;
+      const uint32 n = pCopy->m_numVertices = pSource->m_numVertices;
+      pCopy->m_pVertices = CopyArray(pSource->m_pVertices, n);
+      pCopy->m_pNormals = CopyArray(pSource->m_pNormals, n);
+      pCopy->m_pTangents = CopyArray(pSource->m_pTangents, n);
+      pCopy->m_pBiTangets = CopyArray(pSource->m_pBiTangets, n);
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+         pCopy->m_pColors[a] = CopyArray(pSource->m_pColors[a], n);
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+         pCopy->m_pTextureCoords[a] = CopyArray(pSource->m_pTextureCoords[a], n);
+      return pCopy;
+   }
+
+   // A deep copy of a mesh for another reference. The arrays are borrowed first and then
+   // copied by mesh2::Mesh::TakeOwnership().
+   static Mesh *CopyMesh(const Mesh *pSource)
+   {
+      Mesh *pCopy = new Mesh;
+      pCopy->m_name = pSource->m_name;
+      pCopy->m_primitiveTypes = pSource->m_primitiveTypes;
+      pCopy->m_materialIndex = pSource->m_materialIndex;
+      pCopy->m_numVertices = pSource->m_numVertices;
+      pCopy->m_numFaces = pSource->m_numFaces;
+      pCopy->m_numIndices = pSource->m_numIndices;
+      pCopy->m_pVertices = pSource->m_pVertices;
+      pCopy->m_pNormals = pSource->m_pNormals;
+      pCopy->m_pTangents = pSource->m_pTangents;
+      pCopy->m_pBiTangets = pSource->m_pBiTangets;
+      pCopy->m_pSmoothingGroups = pSource->m_pSmoothingGroups;
+      pCopy->m_pFaces = pSource->m_pFaces;
+      pCopy->m_pIndices = pSource->m_pIndices;
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+         pCopy->m_pColors[a] = pSource->m_pColors[a];
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+      {
+         pCopy->m_pTextureCoords[a] = pSource->m_pTextureCoords[a];
+         pCopy->m_numUVComponents[a] = pSource->m_numUVComponents[a];
+      }
+      // the mesh deletes its array of levels in any case, only the index buffers are borrowed
+      pCopy->m_numLods = pSource->m_numLods;
+      pCopy->m_pLods = CopyArray(pSource->m_pLods, pSource->m_numLods);
+      pCopy->m_numMeshlets = pSource->m_numMeshlets;
+      pCopy->m_pMeshlets = pSource->m_pMeshlets;
+      pCopy->m_numMeshletVertices = pSource->m_numMeshletVertices;
+      pCopy->m_pMeshletVertices = pSource->m_pMeshletVertices;
+      pCopy->m_numMeshletTriangles = pSource->m_numMeshletTriangles;
+      pCopy->m_pMeshletTriangles = pSource->m_pMeshletTriangles;
+      pCopy->m_ownsArrays = false;
+      pCopy->TakeOwnership();
+
+      if (pSource->HasBones())
+      {
+         pCopy->m_ppBones = new Bone*[pSource->m_numBones];
+         for (uint32 b = 0; b < pSource->m_numBones; b++)
+            pCopy->m_ppBones[b] = new Bone(*pSource->m_ppBones[b]);
+         pCopy->m_numBones = pSource->m_numBones;
+      }
+      if (pSource->m_numAnimMeshes && pSource->m_ppAnimMeshes)
+      {
+         pCopy->m_ppAnimMeshes = new AnimMesh*[pSource->m_numAnimMeshes];
+         for (uint32 a = 0; a < pSource->m_numAnimMeshes; a++)
+            pCopy->m_ppAnimMeshes[a] = CopyAnimMesh(pSource->m_ppAnimMeshes[a]);
+         pCopy->m_numAnimMeshes = pSource->m_numAnimMeshes;
+      }
+      return pCopy;
+   }
+
+   // calls func for [0, count), in parallel on the pool if there is one
+   static void ForEach(core::thread::ThreadPool *pPool, uint32 count, const std::function<void(uint32)> &func)
+   {
+      if (NULL != pPool && count > 1)
+         core::thread::ParallelFor(*pPool, count, func);
+      else
+      {
+         for (uint32 i = 0; i < count; i++)
+            func(i);
+      }
+   }
+
+   void PreTransformVerticesProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene || NULL == pScene->m_pRootNode)
+         return;
+
+      Node *pRoot = pScene->m_pRootNode;
+      std::vector<WorldInstance> instances;
+      uint32 numNodes = 0;
+      CollectInstances(pRoot, pRoot->m_transformation, numNodes, instances);
+
+      // the last reference of a mesh transforms it in place, the others transform a copy
+      std::vector<uint32> lastReference(pScene->m_numMeshes, NO_INSTANCE);
+      for (uint32 i = 0; i < (uint32)instances.size(); i++)
+      {
+         if (instances[i].m_mesh >= pScene->m_numMeshes)
+            throw std::runtime_error("A node references a mesh which doesn't exist.");
+         lastReference[instances[i].m_mesh] = i;
+      }
+
+      std::vector<Mesh*> meshes(pScene->m_ppMeshes, pScene->m_ppMeshes + pScene->m_numMeshes);
+      std::vector<uint32> copies, inPlace;
+      for (uint32 i = 0; i < (uint32)instances.size(); i++)
+      {
+         WorldInstance &instance = instances[i];
+         if (lastReference[instance.m_mesh] == i)
+            inPlace.push_back(i);
+         else
+         {
+            instance.m_newMesh = (uint32)meshes.size();
+            meshes.push_back(NULL);
+            copies.push_back(i);
+         }
+      }
+
+      // the copies are made from the meshes before they are transformed
+      ForEach(context.m_pThreadPool, (uint32)copies.size(), [pScene, &instances, &copies, &meshes](uint32 c) {
+         const WorldInstance &instance = instances[copies[c]];
+         Mesh *pCopy = CopyMesh(pScene->m_ppMeshes[instance.m_mesh]);
+         BakeMesh(pCopy, BakeTransform(instance.m_transform));
+         meshes[instance.m_newMesh] = pCopy;
+      });
+      ForEach(context.m_pThreadPool, (uint32)inPlace.size(), [pScene, &instances, &inPlace](uint32 i) {
+         const WorldInstance &instance = instances[inPlace[i]];
+         BakeMesh(pScene->m_ppMeshes[instance.m_mesh], BakeTransform(instance.m_transform));
+      });
+
+      const uint32 numMeshesBefore = pScene->m_numMeshes;
+      if (meshes.size() != pScene->m_numMeshes)
+      {
+         delete[] pScene->m_ppMeshes;
+         pScene->m_ppMeshes = new Mesh*[meshes.size()];
+         std::copy(meshes.begin(), meshes.end(), pScene->m_ppMeshes);
+         pScene->m_numMeshes = (uint32)meshes.size();
+      }
+
+      // the root references all meshes in node order and is the only node left
+      pRoot->TakeOwnership();
+      for (uint32 i = 0; i < pRoot->m_numChildren; i++)
+         delete pRoot->m_ppChildren[i];
+      delete[] pRoot->m_ppChildren;
+      pRoot->m_ppChildren = NULL;
+      pRoot->m_numChildren = 0;
+      pRoot->m_transformation.SetIdentity();
+      delete[] pRoot->m_ppMeshes;
+      pRoot->m_ppMeshes = NULL;
+      pRoot->m_numMeshes = (uint32)instances.size();
+      if (!instances.empty())
+      {
+         pRoot->m_ppMeshes = new uint32[instances.size()];
+         for (size_t i = 0; i < instances.size(); i++)
+            pRoot->m_ppMeshes[i] = instances[i].m_newMesh;
+      }
+
+      if (NULL != pScene->m_pMeshRemaps)
+      {
+         // The table of PROCESS_MERGE_MESHES keeps its node indices, they still tell the
+         // nodes of the hierarchy before. The merged meshes are referenced by the root.
+         std::map<std::pair<uint32, uint32>, uint32> newMeshes;
+         for (size_t i = 0; i < instances.size(); i++)
+            newMeshes[std::make_pair(instances[i].m_node, instances[i].m_mesh)] = instances[i].m_newMesh;
+         for (uint32 r = 0; r < pScene->m_numMeshRemaps; r++)
+         {
+            MeshRemap &remap = pScene->m_pMeshRemaps[r];
+            std::map<std::pair<uint32, uint32>, uint32>::const_iterator it = newMeshes.find(std::make_pair(remap.m_node, remap.m_newMesh));
+            if (it == newMeshes.end())
+               it = newMeshes.find(std::make_pair(0u, remap.m_newMesh));
+            if (it != newMeshes.end())
+               remap.m_newMesh = it->second;
+         }
+      }
+      else if (!instances.empty())
+      {
+         pScene->m_numMeshRemaps = (uint32)instances.size();
+         pScene->m_pMeshRemaps = new MeshRemap[instances.size()];
+         for (size_t i = 0; i < instances.size(); i++)
+         {
+            const Mesh *pMesh = pScene->m_ppMeshes[instances[i].m_newMesh];
+            MeshRemap &remap = pScene->m_pMeshRemaps[i];
+            remap.m_node = instances[i].m_node;
+            remap.m_oldMesh = instances[i].m_mesh;
+            remap.m_newMesh = instances[i].m_newMesh;
+            remap.m_firstVertex = 0;
+            remap.m_numVertices = pMesh->m_numVertices;
+            remap.m_firstFace = 0;
+            remap.m_numFaces = pMesh->m_numFaces;
+         }
+      }
+
+      if (NULL != context.m_pReport)
+      {
+         context.m_pReport->AddPostProcessStat(GetName(), "nodesBefore", numNodes);
+         context.m_pReport->AddPostProcessStat(GetName(), "meshesCopied", pScene->m_numMeshes - numMeshesBefore);
+      }
+   }
+
+} // namespace postprocess
@@ -0,0 +1,28 @@
+#ifndef _PRETRANSFORMVERTICESPROCESS_HPP_INCLUDED_
+#define _PRETRANSFORMVERTICESPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_PRE_TRANSFORM_VERTICES, see postprocess.hpp.
+   class PreTransformVerticesProcess : public BaseProcess
+   {
+   public:
+      const char *GetName() const { return "preTransformVertices"; }
+      uint32 GetFlag() const { return PROCESS_PRE_TRANSFORM_VERTICES; }
+      // the merge step needs the hierarchy to tell the static nodes apart
+      uint32 GetRunAfterFlags() const { return PROCESS_MERGE_MESHES; }
+
+      // bakes the meshes, flattens the hierarchy and adds the number of nodes and copied
+      // meshes to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+   };
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _PROGRESSHANDLER_HPP_INCLUDED_
+#define _PROGRESSHANDLER_HPP_INCLUDED_
+
+#include <stdexcept>
+
+namespace importer
+{
+
+   // Callback interface for the progress of an import, see Importer::SetProgressHandler().
+   // Update() is called on the thread running the import, at least once per import phase.
+   class ProgressHandler
+   {
+   public:
+      virtual ~ProgressHandler() { }
+
+      // percentage is the finished part of the import in [0, 1]. Return false to cancel
+      // the import, ReadFile() returns NULL then.
+      virtual bool Update(float percentage) = 0;
+   };
+
+   // thrown by the importers when the progress handler cancels an import
+   class ImportCanceledException : public std::runtime_error
+   {
+   public:
+      ImportCanceledException() : std::runtime_error("Import canceled by the progress handler.") { }
+   };
+
+   // Passes the progress to the handler, which may be NULL. Throws ImportCanceledException
+   // if the handler cancels the import.
+   inline void UpdateProgress(ProgressHandler *pHandler, float percentage)
+   {
+      if (NULL != pHandler && !pHandler->Update(percentage))
+         throw ImportCanceledException();
+   }
+
+} // namespace importer
+
+#endif
@@ -0,0 +1,905 @@
+#include "sceneCache.hpp"
+
+#include "scene/scene.hpp"
+using scene::Scene;
+using scene::Node;
+using mesh2::Mesh;
+using mesh2::Face;
+using mesh2::MAX_NUMBER_OF_COLOR_SETS;
+using mesh2::MAX_NUMBER_OF_TEXTURECOORDS;
+
+#include "material.hpp"
+using material::Material;
+using material::MaterialProperty;
+
+#include "core/hash/Hash.hpp"
+#include "core/fileio/filesys.hpp"
+#include "core/fileio/mappedfile.hpp"
+using core::fileio::MappedFile;
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace scenecache
+{
+
+   // increment whenever the layout of the records below changes
+   static const uint32 CACHE_VERSION = 5;
+   static const char CACHE_MAGIC[4] = { 'S', 'C', 'N', 'C' };
+
+   // every block starts at a multiple of this
+   static const uint64 CACHE_ALIGNMENT = 16;
+
+   // size of a dependency which didn't exist when the cache was written
+   static const uint64 MISSING_FILE = 0xffffffffffffffffULL;
+
+   // The records of a cache file, all offsets are relative to the start of the file.
+   struct CacheHeader
+   {
+      char m_magic[4];
+      uint32 m_version;
+      uint32 m_pointerSize; // the faces hold pointers, so the file only fits builds with
+      uint32 m_faceSize;    // the same pointer size and Face layout
+      uint64 m_settingsHash;
+      uint64 m_fileSize;
+      uint64 m_creationTime; // seconds since 1970
+      uint32 m_sceneFlags;
+      uint32 m_numDependencies;
+      uint32 m_numMeshes;
+      uint32 m_numNodes;
+      uint32 m_numMaterials;
+      uint32 m_numProperties;
+      uint32 m_numMeshRemaps;
+      uint64 m_dependencies; // CacheDependency[m_numDependencies], the source file first
+      uint64 m_meshes; // CacheMesh[m_numMeshes]
+      uint64 m_nodes; // CacheNode[m_numNodes] in pre-order, the root node first
+      uint64 m_materials; // CacheMaterial[m_numMaterials]
+      uint64 m_properties; // CacheProperty[m_numProperties] of all materials in material order
+      uint64 m_meshRemaps; // scene::MeshRemap[m_numMeshRemaps]
+   };
+
+   struct CacheString
+   {
+      uint64 m_offset;
+      uint64 m_length;
+   };
+
+   struct CacheDependency
+   {
+      CacheString m_path;
+      uint64 m_size; // MISSING_FILE if the file didn't exist
+      uint64 m_modifiedTime;
+      uint64 m_contentHash;
+   };
+
+   struct CacheMesh
+   {
+      CacheString m_name;
+      uint32 m_primitiveTypes;
+      uint32 m_numVertices;
+      uint32 m_numFaces;
+      uint32 m_numIndices;
+      uint32 m_materialIndex;
+      uint32 m_hasIndexBuffer; // the faces were stored in Mesh::m_pIndices
+      uint32 m_numUVComponents[MAX_NUMBER_OF_TEXTURECOORDS];
+      // the vertex streams, 0 if not present
+      uint64 m_vertices;
+      uint64 m_normals;
+      uint64 m_tangents;
+      uint64 m_bitangents;
+      uint64 m_smoothingGroups; // uint32[m_numVertices]
+      uint64 m_colors[MAX_NUMBER_OF_COLOR_SETS];
+      uint64 m_textureCoords[MAX_NUMBER_OF_TEXTURECOORDS];
+      uint64 m_faces; // Face[m_numFaces], m_pIndexArray holds the offset of the face's indices
+      uint64 m_indices; // uint32[m_numIndices], the indices of all faces in face order
+      uint64 m_lods; // CacheLod[m_numLods]
+      uint32 m_numLods;
+      uint32 m_numMeshlets;
+      uint64 m_meshlets; // Meshlet[m_numMeshlets]
+      uint64 m_meshletVertices; // uint32[m_numMeshletVertices]
+      uint64 m_meshletTriangles; // uint8[m_numMeshletTriangles * 3]
+      uint32 m_numMeshletVertices;
+      uint32 m_numMeshletTriangles;
+   };
+
+   struct CacheLod
+   {
+      uint64 m_indices; // uint32[m_numIndices]
+      uint32 m_numIndices;
+      float m_error;
+   };
+
+   struct CacheNode
+   {
+      float m_transformation[16];
+      CacheString m_name;
+      uint64 m_meshes; // uint32[m_numMeshes]
+      uint32 m_numMeshes;
+      uint32 m_numChildren; // the subtrees of the children follow the node
+   };
+
+   struct CacheMaterial
+   {
+      uint32 m_firstProperty;
+      uint32 m_numProperties;
+   };
+
+   struct CacheProperty
+   {
+      CacheString m_key;
+      uint64 m_data;
+      uint32 m_numBytes;
+      uint32 m_textureSemantic;
+      uint32 m_textureIndex;
+      uint32 m_propertyTypeInfo;
+   };
+
+   static uint64 Align(uint64 offset)
+   {
+      return (offset + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+   }
+
+   // Size, modification time and content hash of a file, size is MISSING_FILE if it
+   // doesn't exist. The file is only read if withHash is set.
+   static void GetFileInfo(const std::string &path, bool withHash, CacheDependency &info)
+   {
+      info.m_size = MISSING_FILE;
+      info.m_modifiedTime = 0;
+      info.m_contentHash = 0;
+      if (!core::filesys::GetFileStatus(path, info.m_size, info.m_modifiedTime))
+      {
+         info.m_size = MISSING_FILE;
+         return;
+      }
+
+      if (withHash)
+      {
+         MappedFile file;
+         if (file.Open(path))
+            info.m_contentHash = core::Fnv1a64(file.GetData(), file.GetSize());
+      }
+   }
+
+   // true if a dependency still looks like it did when the cache was written
+   static bool IsUpToDate(const std::string &path, const CacheDependency &recorded, uint64 creationTime)
+   {
+      CacheDependency current;
+      GetFileInfo(path, false, current);
+      if (current.m_size != recorded.m_size)
+         return false;
+
+      // the modification time has a resolution of a second, a file modified in the second
+      // the cache was written may have changed again without changing its time
+      if (current.m_size == MISSING_FILE ||
+         (current.m_modifiedTime == recorded.m_modifiedTime && recorded.m_modifiedTime < creationTime))
+         return true;
+
+      // touched, but maybe not changed (e.g. by a checkout)
+      GetFileInfo(path, true, current);
+      return current.m_contentHash == recorded.m_contentHash;
+   }
+
+   // Returns true if all faces of the mesh point into its index buffer.
+   static bool HasIndexBuffer(const Mesh *pMesh)
+   {
+      if (NULL == pMesh->m_pIndices)
+         return false;
+      for (uint32 i = 0; i < pMesh->m_numFaces; i++)
+      {
+         const Face &face = pMesh->m_pFaces[i];
+         if (face.m_pIndexArray < pMesh->m_pIndices ||
+            face.m_pIndexArray + face.m_numIndices > pMesh->m_pIndices + pMesh->m_numIndices)
+            return false;
+      }
+      return true;
+   }
+
+   static uint32 CountNodes(const Node *pNode)
+   {
+      uint32 n = 1;
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+         n += CountNodes(pNode->m_ppChildren[i]);
+      return n;
+   }
+
+   // Lays out and writes a cache file. The tables come first, then the bulk data like the
+   // vertex streams, then the small data like names. The bulk data isn't copied, the
+   // blocks refer to the scene until they are written.
+   class CacheWriter
+   {
+   private:
+      enum eBlockType
+      {
+         BLOCK_DATA,
+         BLOCK_FACES, // the faces of m_pMesh with offsets instead of pointers
+         BLOCK_GATHERED_INDICES // the index arrays of all faces of m_pMesh one after another
+      };
+
+      struct Block
+      {
+         eBlockType m_type;
+         const void *m_pData;
+         uint64 m_size;
+         uint64 m_offset;
+         const Mesh *m_pMesh;
+         uint64 m_indices; // offset of the mesh's indices for BLOCK_FACES
+      };
+
+      std::vector<Block> m_blocks;
+      uint64 m_bulkEnd;
+
+      std::vector<char> m_smallData;
+      uint64 m_smallDataOffset;
+
+      FILE *m_pFile;
+      uint64 m_position;
+
+      bool WriteAt(uint64 offset, const void *pData, uint64 size)
+      {
+         static const char zeros[CACHE_ALIGNMENT] = { 0 };
+         while (m_position < offset)
+         {
+            const size_t n = (size_t)std::min<uint64>(offset - m_position, CACHE_ALIGNMENT);
+            if (fwrite(zeros, 1, n, m_pFile) != n)
+               return false;
+            m_position += n;
+         }
+         if (size > 0 && fwrite(pData, 1, (size_t)size, m_pFile) != size)
+            return false;
+         m_position += size;
+         return true;
+      }
+
+      bool WriteBlock(const Block &block)
+      {
+         if (block.m_type == BLOCK_DATA)
+            return WriteAt(block.m_offset, block.m_pData, block.m_size);
+
+         if (!WriteAt(block.m_offset, NULL, 0))
+            return false;
+
+         const Mesh *pMesh = block.m_pMesh;
+         if (block.m_type == BLOCK_GATHERED_INDICES)
+         {
+            for (uint32 i = 0; i < pMesh->m_numFaces; i++)
+            {
+               const Face &face = pMesh->m_pFaces[i];
+               if (!WriteAt(m_position, face.m_pIndexArray, face.m_numIndices * sizeof(uint32)))
+                  return false;
+            }
+            return true;
+         }
+
+         // faces in batches, the index arrays are referred to by their offset in the file
+         const bool hasIndexBuffer = HasIndexBuffer(pMesh);
+         std::vector<char> buffer(sizeof(Face) * 1024);
+         uint64 indices = block.m_indices;
+         for (uint32 first = 0; first < pMesh->m_numFaces; first += 1024)
+         {
+            const uint32 count = std::min<uint32>(pMesh->m_numFaces - first, 1024);
+            std::fill(buffer.begin(), buffer.end(), 0);
+            Face *pOut = reinterpret_cast<Face*>(&buffer[0]);
+            for (uint32 i = 0; i < count; i++)
+            {
+               const Face &face = pMesh->m_pFaces[first + i];
+               const uint64 offset = hasIndexBuffer ?
+                  block.m_indices + (face.m_pIndexArray - pMesh->m_pIndices) * sizeof(uint32) : indices;
+               pOut[i].m_numIndices = face.m_numIndices;
+               pOut[i].m_pIndexArray = reinterpret_cast<uint32*>((size_t)offset);
+               pOut[i].m_ownsIndexArray = false;
+               indices += face.m_numIndices * sizeof(uint32);
+            }
+            if (!WriteAt(m_position, &buffer[0], count * sizeof(Face)))
+               return false;
+         }
+         return true;
+      }
+
+   public:
+      explicit CacheWriter(uint64 tablesEnd) :
+         m_bulkEnd(Align(tablesEnd)),
+         m_smallDataOffset(0),
+         m_pFile(NULL),
+         m_position(0)
+      {
+      }
+
+      // Reserves room for bulk data, returns its offset or 0 for pData NULL.
+      uint64 AddBlock(const void *pData, uint64 size)
+      {
+         if (NULL == pData)
+            return 0;
+         Block block = { BLOCK_DATA, pData, size, m_bulkEnd, NULL, 0 };
+         m_blocks.push_back(block);
+         m_bulkEnd = Align(m_bulkEnd + size);
+         return block.m_offset;
+      }
+
+      uint64 AddFaces(const Mesh *pMesh, uint64 indices)
+      {
+         Block block = { BLOCK_FACES, NULL, pMesh->m_numFaces * sizeof(Face), m_bulkEnd, pMesh, indices };
+         m_blocks.push_back(block);
+         m_bulkEnd = Align(m_bulkEnd + block.m_size);
+         return block.m_offset;
+      }
+
+      uint64 AddGatheredIndices(const Mesh *pMesh, uint32 numIndices)
+      {
+         Block block = { BLOCK_GATHERED_INDICES, NULL, numIndices * sizeof(uint32), m_bulkEnd, pMesh, 0 };
+         m_blocks.push_back(block);
+         m_bulkEnd = Align(m_bulkEnd + block.m_size);
+         return block.m_offset;
+      }
+
+      // Copies small data behind the bulk data, all bulk data must be added before.
+      uint64 AddSmallData(const void *pData, uint64 size)
+      {
+         if (m_smallDataOffset == 0)
+            m_smallDataOffset = m_bulkEnd;
+         const uint64 offset = m_smallDataOffset + m_smallData.size();
+         m_smallData.insert(m_smallData.end(), (const char*)pData, (const char*)pData + size);
+         m_smallData.resize((size_t)(Align(offset + size) - m_smallDataOffset), 0);
+         return offset;
+      }
+
+      CacheString AddString(const std::string &str)
+      {
+         CacheString result;
+         result.m_length = str.size();
+         result.m_offset = AddSmallData(str.c_str(), str.size() + 1);
+         return result;
+      }
+
+      uint64 GetFileSize() const
+      {
+         return (m_smallDataOffset == 0 ? m_bulkEnd : m_smallDataOffset) + m_smallData.size();
+      }
+
+      // Writes the tables, which must end before the offset passed to the constructor, and the blocks.
+      bool Write(const std::string &path, const std::vector<std::pair<uint64, std::vector<char> > > &tables)
+      {
+         m_pFile = fopen(path.c_str(), "wb");
+         if (NULL == m_pFile)
+            return false;
+
+         m_position = 0;
+         bool ok = true;
+         for (size_t i = 0; i < tables.size() && ok; i++)
+            ok = tables[i].second.empty() || WriteAt(tables[i].first, &tables[i].second[0], tables[i].second.size());
+         for (size_t i = 0; i < m_blocks.size() && ok; i++)
+            ok = WriteBlock(m_blocks[i]);
+         if (ok && !m_smallData.empty())
+            ok = WriteAt(m_smallDataOffset, &m_smallData[0], m_smallData.size());
+
+         ok = (fclose(m_pFile) == 0) && ok;
+         m_pFile = NULL;
+         return ok;
+      }
+   };
+
+   // Appends the nodes of a subtree in pre-order.
+   static void AddNodes(const Node *pNode, CacheWriter &writer, std::vector<CacheNode> &nodes)
+   {
+      CacheNode node;
+      memcpy(node.m_transformation, &pNode->m_transformation, sizeof(node.m_transformation));
+      node.m_name = writer.AddString(pNode->m_name);
+      node.m_numMeshes = pNode->m_numMeshes;
+      node.m_meshes = (pNode->m_numMeshes > 0) ? writer.AddSmallData(pNode->m_ppMeshes, pNode->m_numMeshes * sizeof(uint32)) : 0;
+      node.m_numChildren = pNode->m_numChildren;
+      nodes.push_back(node);
+
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+         AddNodes(pNode->m_ppChildren[i], writer, nodes);
+   }
+
+   // Copies a table of records into a byte array.
+   template <typename T>
+   static std::pair<uint64, std::vector<char> > MakeTable(uint64 offset, const std::vector<T> &records)
+   {
+      std::pair<uint64, std::vector<char> > table(offset, std::vector<char>(records.size() * sizeof(T)));
+      if (!records.empty())
+         memcpy(&table.second[0], &records[0], records.size() * sizeof(T));
+      return table;
+   }
+
+   std::string SceneCache::GetCachePath(const std::string &path, uint64 settingsHash) const
+   {
+      char name[32];
+      sprintf(name, "%016llx.scache", (unsigned long long)core::Fnv1a64(path.c_str(), path.size(), settingsHash));
+
+      std::string cachePath = m_directory;
+      if (!cachePath.empty() && cachePath[cachePath.size() - 1] != '/' && cachePath[cachePath.size() - 1] != '\\')
+         cachePath += '/';
+      return cachePath + name;
+   }
+
+   bool SceneCache::Save(const std::string &path, uint64 settingsHash, const std::vector<std::string> &dependencies,
+      const Scene *pScene) const
+   {
+      if (NULL == pScene || NULL == pScene->m_pRootNode)
+         return false;
+
+      // bones and vertex animations are not stored
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+      {
+         const Mesh *pMesh = pScene->m_ppMeshes[i];
+         if (pMesh->HasBones() || pMesh->m_numAnimMeshes > 0)
+            return false;
+      }
+
+      uint32 numProperties = 0;
+      for (uint32 i = 0; i < pScene->m_numMaterials; i++)
+         numProperties += pScene->m_ppMaterials[i]->GetNumProperties();
+
+      CacheHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.m_magic, CACHE_MAGIC, sizeof(header.m_magic));
+      header.m_version = CACHE_VERSION;
+      header.m_pointerSize = sizeof(void*);
+      header.m_faceSize = sizeof(Face);
+      header.m_settingsHash = settingsHash;
+      header.m_creationTime = (uint64)time(NULL);
+      header.m_sceneFlags = pScene->m_flags;
+      header.m_numDependencies = (uint32)dependencies.size() + 1;
+      header.m_numMeshes = pScene->m_numMeshes;
+      header.m_numNodes = CountNodes(pScene->m_pRootNode);
+      header.m_numMaterials = pScene->m_numMaterials;
+      header.m_numProperties = numProperties;
+      header.m_numMeshRemaps = pScene->m_pMeshRemaps ? pScene->m_numMeshRemaps : 0;
+      header.m_dependencies = Align(sizeof(CacheHeader));
+      header.m_meshes = Align(header.m_dependencies + header.m_numDependencies * sizeof(CacheDependency));
+      header.m_nodes = Align(header.m_meshes + header.m_numMeshes * sizeof(CacheMesh));
+      header.m_materials = Align(header.m_nodes + header.m_numNodes * sizeof(CacheNode));
+      header.m_properties = Align(header.m_materials + header.m_numMaterials * sizeof(CacheMaterial));
+      header.m_meshRemaps = Align(header.m_properties + header.m_numProperties * sizeof(CacheProperty));
+
+      CacheWriter writer(header.m_meshRemaps + header.m_numMeshRemaps * sizeof(scene::MeshRemap));
+
+      // the bulk data first
+      std::vector<CacheMesh> meshes(pScene->m_numMeshes);
+      std::vector<CacheLod> lods; // of all meshes in mesh order
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+      {
+         const Mesh *pMesh = pScene->m_ppMeshes[i];
+         CacheMesh &mesh = meshes[i];
+         memset(&mesh, 0, sizeof(mesh));
+         mesh.m_primitiveTypes = pMesh->m_primitiveTypes;
+         mesh.m_numVertices = pMesh->m_numVertices;
+         mesh.m_numFaces = pMesh->m_numFaces;
+         mesh.m_materialIndex = pMesh->m_materialIndex;
+
+         const uint64 streamSize = pMesh->m_numVertices * sizeof(Vector3f);
+         mesh.m_vertices = writer.AddBlock(pMesh->m_pVertices, streamSize);
+         mesh.m_normals = writer.AddBlock(pMesh->m_pNormals, streamSize);
+         mesh.m_tangents = writer.AddBlock(pMesh->m_pTangents, streamSize);
+         mesh.m_bitangents = writer.AddBlock(pMesh->m_pBiTangets, streamSize);
+         mesh.m_smoothingGroups = writer.AddBlock(pMesh->m_pSmoothingGroups, pMesh->m_numVertices * sizeof(uint32));
+         for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+            mesh.m_colors[a] = writer.AddBlock(pMesh->m_pColors[a], pMesh->m_numVertices * sizeof(Color4f));
+         for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+         {
+            mesh.m_textureCoords[a] = writer.AddBlock(pMesh->m_pTextureCoords[a], streamSize);
+            mesh.m_numUVComponents[a] = pMesh->m_numUVComponents[a];
+         }
+
+         if (pMesh->HasFaces())
+         {
+            mesh.m_hasIndexBuffer = HasIndexBuffer(pMesh) ? 1 : 0;
+            if (mesh.m_hasIndexBuffer)
+            {
+               mesh.m_numIndices = pMesh->m_numIndices;
+               mesh.m_indices = writer.AddBlock(pMesh->m_pIndices, pMesh->m_numIndices * sizeof(uint32));
+            }
+            else
+            {
+               for (uint32 f = 0; f < pMesh->m_numFaces; f++)
+                  mesh.m_numIndices += pMesh->m_pFaces[f].m_numIndices;
+               mesh.m_indices = writer.AddGatheredIndices(pMesh, mesh.m_numIndices);
+            }
+            mesh.m_faces = writer.AddFaces(pMesh, mesh.m_indices);
+         }
+
+         mesh.m_numLods = pMesh->HasLods() ? pMesh->m_numLods : 0;
+         for (uint32 l = 0; l < mesh.m_numLods; l++)
+         {
+            CacheLod lod;
+            lod.m_indices = writer.AddBlock(pMesh->m_pLods[l].m_pIndices, pMesh->m_pLods[l].m_numIndices * sizeof(uint32));
+            lod.m_numIndices = pMesh->m_pLods[l].m_numIndices;
+            lod.m_error = pMesh->m_pLods[l].m_error;
+            lods.push_back(lod);
+         }
+
+         if (pMesh->HasMeshlets())
+         {
+            mesh.m_numMeshlets = pMesh->m_numMeshlets;
+            mesh.m_meshlets = writer.AddBlock(pMesh->m_pMeshlets, pMesh->m_numMeshlets * sizeof(mesh2::Meshlet));
+            mesh.m_numMeshletVertices = pMesh->m_numMeshletVertices;
+            mesh.m_meshletVertices = writer.AddBlock(pMesh->m_pMeshletVertices, pMesh->m_numMeshletVertices * sizeof(uint32));
+            mesh.m_numMeshletTriangles = pMesh->m_numMeshletTriangles;
+            mesh.m_meshletTriangles = writer.AddBlock(pMesh->m_pMeshletTriangles, pMesh->m_numMeshletTriangles * 3);
+         }
+      }
+
+      // then names, node mesh lists, level of detail tables and material data
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+         meshes[i].m_name = writer.AddString(pScene->m_ppMeshes[i]->m_name);
+
+      uint32 firstLod = 0;
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+      {
+         if (meshes[i].m_numLods > 0)
+            meshes[i].m_lods = writer.AddSmallData(&lods[firstLod], meshes[i].m_numLods * sizeof(CacheLod));
+         firstLod += meshes[i].m_numLods;
+      }
+
+      std::vector<CacheNode> nodes;
+      nodes.reserve(header.m_numNodes);
+      AddNodes(pScene->m_pRootNode, writer, nodes);
+
+      std::vector<CacheMaterial> materials(pScene->m_numMaterials);
+      std::vector<CacheProperty> properties;
+      properties.reserve(numProperties);
+      for (uint32 i = 0; i < pScene->m_numMaterials; i++)
+      {
+         const Material *pMaterial = pScene->m_ppMaterials[i];
+         materials[i].m_firstProperty = (uint32)properties.size();
+         materials[i].m_numProperties = pMaterial->GetNumProperties();
+         for (uint32 p = 0; p < pMaterial->GetNumProperties(); p++)
+         {
+            const MaterialProperty *pProperty = pMaterial->GetProperty(p);
+            CacheProperty property;
+            property.m_key = writer.AddString(pProperty->m_key);
+            property.m_data = writer.AddSmallData(pProperty->m_data, pProperty->m_dataNumBytes);
+            property.m_numBytes = pProperty->m_dataNumBytes;
+            property.m_textureSemantic = pProperty->m_textureSemantic;
+            property.m_textureIndex = pProperty->m_textureIndex;
+            property.m_propertyTypeInfo = pProperty->m_propertyTypeInfo;
+            properties.push_back(property);
+         }
+      }
+
+      // the source file is the first dependency
+      std::vector<CacheDependency> files(header.m_numDependencies);
+      for (uint32 i = 0; i < header.m_numDependencies; i++)
+      {
+         const std::string &file = (i == 0) ? path : dependencies[i - 1];
+         GetFileInfo(file, true, files[i]);
+         files[i].m_path = writer.AddString(file);
+      }
+
+      header.m_fileSize = writer.GetFileSize();
+
+      std::vector<std::pair<uint64, std::vector<char> > > tables;
+      tables.push_back(std::make_pair(0, std::vector<char>((const char*)&header, (const char*)&header + sizeof(header))));
+      tables.push_back(MakeTable(header.m_dependencies, files));
+      tables.push_back(MakeTable(header.m_meshes, meshes));
+      tables.push_back(MakeTable(header.m_nodes, nodes));
+      tables.push_back(MakeTable(header.m_materials, materials));
+      tables.push_back(MakeTable(header.m_properties, properties));
+      tables.push_back(MakeTable(header.m_meshRemaps,
+         std::vector<scene::MeshRemap>(pScene->m_pMeshRemaps, pScene->m_pMeshRemaps + header.m_numMeshRemaps)));
+
+      // write to a temporary file first, so a reader never maps a partially written cache.
+      // The name is unique per thread, concurrent imports of a file may save it at once
+      const std::string cachePath = GetCachePath(path, settingsHash);
+      char threadSuffix[32];
+      sprintf(threadSuffix, ".%llx.tmp", (unsigned long long)std::hash<std::thread::id>()(std::this_thread::get_id()));
+      const std::string tempPath = cachePath + threadSuffix;
+      if (!writer.Write(tempPath, tables))
+      {
+         remove(tempPath.c_str());
+         return false;
+      }
+
+      remove(cachePath.c_str());
+      if (rename(tempPath.c_str(), cachePath.c_str()) != 0)
+      {
+         remove(tempPath.c_str());
+         return false;
+      }
+      return true;
+   }
+
+   // Keeps the mapped cache file alive as long as the scene points into it.
+   class MappedSceneStorage : public scene::SceneStorage
+   {
+   public:
+      MappedFile m_file;
+   };
+
+   // Reads a cache file, the records are only read through its member functions, which
+   // check that they lie inside the file.
+   class CacheReader
+   {
+   private:
+      char *m_pData;
+      uint64 m_size;
+
+   public:
+      CacheReader(char *pData, uint64 size) : m_pData(pData), m_size(size) { }
+
+      bool IsInside(uint64 offset, uint64 size) const
+      {
+         return offset <= m_size && size <= m_size - offset;
+      }
+
+      template <typename T>
+      T *Get(uint64 offset, uint64 count) const
+      {
+         if (count == 0 || !IsInside(offset, count * sizeof(T)))
+            return NULL;
+         return reinterpret_cast<T*>(m_pData + offset);
+      }
+
+      bool GetString(const CacheString &str, std::string &out) const
+      {
+         const char *pStr = Get<char>(str.m_offset, str.m_length + 1);
+         if (NULL == pStr)
+            return false;
+         out.assign(pStr, (size_t)str.m_length);
+         return true;
+      }
+   };
+
+   // Rebuilds the node at index and its subtree, index is moved behind the subtree.
+   static Node *ReadNodes(const CacheReader &reader, const CacheNode *pNodes, uint32 numNodes, uint32 &index)
+   {
+      if (index >= numNodes)
+         return NULL;
+
+      const CacheNode &cached = pNodes[index++];
+      Node *pNode = new Node;
+      memcpy(&pNode->m_transformation, cached.m_transformation, sizeof(cached.m_transformation));
+      bool ok = reader.GetString(cached.m_name, pNode->m_name);
+
+      if (ok && cached.m_numMeshes > 0)
+      {
+         const uint32 *pMeshes = reader.Get<uint32>(cached.m_meshes, cached.m_numMeshes);
+         ok = (NULL != pMeshes);
+         if (ok)
+         {
+            pNode->m_ppMeshes = new uint32[cached.m_numMeshes];
+            pNode->m_numMeshes = cached.m_numMeshes;
+            memcpy(pNode->m_ppMeshes, pMeshes, cached.m_numMeshes * sizeof(uint32));
+         }
+      }
+
+      if (ok && cached.m_numChildren > 0)
+      {
+         pNode->m_ppChildren = new Node*[cached.m_numChildren];
+         for (uint32 i = 0; i < cached.m_numChildren && ok; i++)
+         {
+            Node *pChild = ReadNodes(reader, pNodes, numNodes, index);
+            ok = (NULL != pChild);
+            if (ok)
+            {
+               pChild->m_pParentNode = pNode;
+               pNode->m_ppChildren[pNode->m_numChildren++] = pChild;
+            }
+         }
+      }
+
+      if (!ok)
+      {
+         delete pNode;
+         return NULL;
+      }
+      return pNode;
+   }
+
+   // Points a mesh into the cache file, returns false if the file is broken.
+   static bool ReadMesh(const CacheReader &reader, const CacheMesh &cached, Mesh *pMesh)
+   {
+      pMesh->m_ownsArrays = false;
+      pMesh->m_primitiveTypes = cached.m_primitiveTypes;
+      pMesh->m_numVertices = cached.m_numVertices;
+      pMesh->m_materialIndex = cached.m_materialIndex;
+      if (!reader.GetString(cached.m_name, pMesh->m_name))
+         return false;
+
+      const uint64 n = cached.m_numVertices;
+      bool ok = true;
+      if (cached.m_vertices)
+         ok = ok && NULL != (pMesh->m_pVertices = reader.Get<Vector3f>(cached.m_vertices, n));
+      if (cached.m_normals)
+         ok = ok && NULL != (pMesh->m_pNormals = reader.Get<Vector3f>(cached.m_normals, n));
+      if (cached.m_tangents)
+         ok = ok && NULL != (pMesh->m_pTangents = reader.Get<Vector3f>(cached.m_tangents, n));
+      if (cached.m_bitangents)
+         ok = ok && NULL != (pMesh->m_pBiTangets = reader.Get<Vector3f>(cached.m_bitangents, n));
+      if (cached.m_smoothingGroups)
+         ok = ok && NULL != (pMesh->m_pSmoothingGroups = reader.Get<uint32>(cached.m_smoothingGroups, n));
+      for (uint32 a = 0; a < MAX_NUMBER_OF_COLOR_SETS; a++)
+      {
+         if (cached.m_colors[a])
+            ok = ok && NULL != (pMesh->m_pColors[a] = reader.Get<Color4f>(cached.m_colors[a], n));
+      }
+      for (uint32 a = 0; a < MAX_NUMBER_OF_TEXTURECOORDS; a++)
+      {
+         pMesh->m_numUVComponents[a] = cached.m_numUVComponents[a];
+         if (cached.m_textureCoords[a])
+            ok = ok && NULL != (pMesh->m_pTextureCoords[a] = reader.Get<Vector3f>(cached.m_textureCoords[a], n));
+      }
+      if (ok && cached.m_numLods > 0)
+      {
+         const CacheLod *pLods = reader.Get<CacheLod>(cached.m_lods, cached.m_numLods);
+         ok = (NULL != pLods);
+         if (ok)
+         {
+            pMesh->m_pLods = new mesh2::MeshLod[cached.m_numLods];
+            pMesh->m_numLods = cached.m_numLods;
+         }
+         for (uint32 l = 0; l < pMesh->m_numLods && ok; l++)
+         {
+            pMesh->m_pLods[l].m_numIndices = pLods[l].m_numIndices;
+            pMesh->m_pLods[l].m_error = pLods[l].m_error;
+            if (pLods[l].m_numIndices > 0)
+               ok = NULL != (pMesh->m_pLods[l].m_pIndices = reader.Get<uint32>(pLods[l].m_indices, pLods[l].m_numIndices));
+         }
+      }
+      if (ok && cached.m_numMeshlets > 0)
+      {
+         pMesh->m_pMeshlets = reader.Get<mesh2::Meshlet>(cached.m_meshlets, cached.m_numMeshlets);
+         pMesh->m_pMeshletVertices = reader.Get<uint32>(cached.m_meshletVertices, cached.m_numMeshletVertices);
+         pMesh->m_pMeshletTriangles = reader.Get<uint8>(cached.m_meshletTriangles, cached.m_numMeshletTriangles * 3);
+         ok = NULL != pMesh->m_pMeshlets && NULL != pMesh->m_pMeshletVertices && NULL != pMesh->m_pMeshletTriangles;
+         if (ok)
+         {
+            pMesh->m_numMeshlets = cached.m_numMeshlets;
+            pMesh->m_numMeshletVertices = cached.m_numMeshletVertices;
+            pMesh->m_numMeshletTriangles = cached.m_numMeshletTriangles;
+         }
+      }
+      if (!ok || cached.m_numFaces == 0)
+         return ok;
+
+      uint32 *pIndices = reader.Get<uint32>(cached.m_indices, cached.m_numIndices);
+      Face *pFaces = reader.Get<Face>(cached.m_faces, cached.m_numFaces);
+      if (NULL == pIndices || NULL == pFaces)
+         return false;
+
+      // the faces hold the offsets of their indices, this touches (and copies) only their pages
+      const uint64 indicesEnd = cached.m_indices + cached.m_numIndices * sizeof(uint32);
+      for (uint32 i = 0; i < cached.m_numFaces; i++)
+      {
+         Face &face = pFaces[i];
+         const uint64 offset = (size_t)face.m_pIndexArray;
+         if (offset < cached.m_indices || offset + face.m_numIndices * sizeof(uint32) > indicesEnd)
+            return false;
+         face.m_pIndexArray = pIndices + (offset - cached.m_indices) / sizeof(uint32);
+      }
+
+      pMesh->m_pFaces = pFaces;
+      pMesh->m_numFaces = cached.m_numFaces;
+      if (cached.m_hasIndexBuffer)
+      {
+         pMesh->m_pIndices = pIndices;
+         pMesh->m_numIndices = cached.m_numIndices;
+      }
+      return true;
+   }
+
+   static Material *ReadMaterial(const CacheReader &reader, const CacheProperty *pProperties, uint32 numProperties)
+   {
+      Material *pMaterial = new Material;
+      std::string key;
+      for (uint32 i = 0; i < numProperties; i++)
+      {
+         const CacheProperty &property = pProperties[i];
+         const char *pData = reader.Get<char>(property.m_data, property.m_numBytes);
+         if (NULL == pData || !reader.GetString(property.m_key, key))
+         {
+            delete pMaterial;
+            return NULL;
+         }
+         pMaterial->AddBinaryProperty(pData, property.m_numBytes, key.c_str(), property.m_textureSemantic,
+            property.m_textureIndex, (material::ePropertyTypeInfo)property.m_propertyTypeInfo);
+      }
+      return pMaterial;
+   }
+
+   Scene *SceneCache::Load(const std::string &path, uint64 settingsHash) const
+   {
+      MappedSceneStorage *pStorage = new MappedSceneStorage;
+      if (!pStorage->m_file.Open(GetCachePath(path, settingsHash), true) || pStorage->m_file.GetSize() < sizeof(CacheHeader))
+      {
+         delete pStorage;
+         return NULL;
+      }
+
+      const CacheReader reader(pStorage->m_file.GetWritableData(), pStorage->m_file.GetSize());
+      const CacheHeader &header = *reader.Get<CacheHeader>(0, 1);
+      const CacheDependency *pFiles = reader.Get<CacheDependency>(header.m_dependencies, header.m_numDependencies);
+      bool ok = memcmp(header.m_magic, CACHE_MAGIC, sizeof(header.m_magic)) == 0 &&
+         header.m_version == CACHE_VERSION &&
+         header.m_pointerSize == sizeof(void*) &&
+         header.m_faceSize == sizeof(Face) &&
+         header.m_settingsHash == settingsHash &&
+         header.m_fileSize == pStorage->m_file.GetSize() &&
+         NULL != pFiles;
+
+      // the source file comes first, which also rules out a collision of the cache file names
+      std::string file;
+      for (uint32 i = 0; i < header.m_numDependencies && ok; i++)
+      {
+         ok = reader.GetString(pFiles[i].m_path, file) && (i > 0 || file == path);
+         ok = ok && IsUpToDate(file, pFiles[i], header.m_creationTime);
+      }
+
+      const CacheMesh *pMeshes = reader.Get<CacheMesh>(header.m_meshes, header.m_numMeshes);
+      const CacheNode *pNodes = reader.Get<CacheNode>(header.m_nodes, header.m_numNodes);
+      const CacheMaterial *pMaterials = reader.Get<CacheMaterial>(header.m_materials, header.m_numMaterials);
+      const CacheProperty *pProperties = reader.Get<CacheProperty>(header.m_properties, header.m_numProperties);
+      const scene::MeshRemap *pMeshRemaps = reader.Get<scene::MeshRemap>(header.m_meshRemaps, header.m_numMeshRemaps);
+      ok = ok && NULL != pNodes &&
+         (header.m_numMeshes == 0 || NULL != pMeshes) &&
+         (header.m_numMaterials == 0 || NULL != pMaterials) &&
+         (header.m_numProperties == 0 || NULL != pProperties) &&
+         (header.m_numMeshRemaps == 0 || NULL != pMeshRemaps);
+      if (!ok)
+      {
+         delete pStorage;
+         return NULL;
+      }
+
+      // from here on the scene owns the mapping
+      Scene *pScene = new Scene;
+      pScene->m_pStorage = pStorage;
+      pScene->m_flags = (scene::eSceneFlags)header.m_sceneFlags;
+
+      if (header.m_numMeshes > 0)
+      {
+         pScene->m_ppMeshes = new Mesh*[header.m_numMeshes];
+         for (uint32 i = 0; i < header.m_numMeshes && ok; i++)
+         {
+            pScene->m_ppMeshes[i] = new Mesh;
+            pScene->m_numMeshes++;
+            ok = ReadMesh(reader, pMeshes[i], pScene->m_ppMeshes[i]);
+         }
+      }
+
+      if (ok && header.m_numMaterials > 0)
+      {
+         pScene->m_ppMaterials = new Material*[header.m_numMaterials];
+         for (uint32 i = 0; i < header.m_numMaterials && ok; i++)
+         {
+            const CacheMaterial &material = pMaterials[i];
+            ok = material.m_firstProperty <= header.m_numProperties &&
+               material.m_numProperties <= header.m_numProperties - material.m_firstProperty;
+            Material *pMaterial = ok ? ReadMaterial(reader, pProperties + material.m_firstProperty, material.m_numProperties) : NULL;
+            ok = (NULL != pMaterial);
+            if (ok)
+               pScene->m_ppMaterials[pScene->m_numMaterials++] = pMaterial;
+         }
+      }
+
+      uint32 index = 0;
+      if (ok)
+      {
+         pScene->m_pRootNode = ReadNodes(reader, pNodes, header.m_numNodes, index);
+         ok = (NULL != pScene->m_pRootNode);
+      }
+
+      if (ok && header.m_numMeshRemaps > 0)
+      {
+         pScene->m_pMeshRemaps = new scene::MeshRemap[header.m_numMeshRemaps];
+         pScene->m_numMeshRemaps = header.m_numMeshRemaps;
+         memcpy(pScene->m_pMeshRemaps, pMeshRemaps, header.m_numMeshRemaps * sizeof(scene::MeshRemap));
+         // the node indices may tell a hierarchy flattened since, see scene::Scene::m_pMeshRemaps
+         for (uint32 i = 0; i < header.m_numMeshRemaps && ok; i++)
+            ok = pMeshRemaps[i].m_newMesh < header.m_numMeshes;
+      }
+
+      if (!ok)
+      {
+         delete pScene;
+         return NULL;
+      }
+      return pScene;
+   }
+
+} // namespace scenecache
@@ -0,0 +1,51 @@
+#ifndef _SCENECACHE_HPP_INCLUDED_
+#define _SCENECACHE_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include <string>
+#include <vector>
+
+namespace scene
+{
+   struct Scene;
+}
+
+namespace scenecache
+{
+
+   // On-disk cache of imported scenes, see CONFIG_IMPORT_CACHE_DIRECTORY.
+   //
+   // A cached scene is a single file holding the meshes, faces, node hierarchy and
+   // materials. Loading maps the file copy-on-write, the vertex streams and index
+   // buffers are used in place (mesh2::Mesh::m_ownsArrays is false), only the face
+   // pointers are fixed up. Each cache file records the size, modification time and
+   // content hash of the source file and the files it depends on (the material
+   // libraries of an OBJ file). It is used while all of them match, a changed
+   // modification time alone is accepted if the content hash still matches.
+   class SceneCache
+   {
+   private:
+      std::string m_directory;
+
+   public:
+      explicit SceneCache(const std::string &directory) : m_directory(directory) { }
+
+      // Path of the cache file of a source file, the settings hash identifies the
+      // post processing flags and importer properties the scene was created with.
+      std::string GetCachePath(const std::string &path, uint64 settingsHash) const;
+
+      // Returns the cached scene of a source file, NULL if there is none, it is out of
+      // date or it was written by a different build.
+      scene::Scene *Load(const std::string &path, uint64 settingsHash) const;
+
+      // Writes the scene to the cache, dependencies are the files besides path the
+      // scene was created from. Returns false if the scene can't be cached (e.g. it
+      // has bones) or the file couldn't be written.
+      bool Save(const std::string &path, uint64 settingsHash, const std::vector<std::string> &dependencies,
+         const scene::Scene *pScene) const;
+   };
+
+} // namespace scenecache
+
+#endif
@@ -0,0 +1,449 @@
+#include "tangentSpaceProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+
+#include "scene/scene.hpp"
+
+#include "importReport.hpp"
+
+#include "core/thread/threadpool.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+// The edges and corner angles are computed for four triangles at once with SSE, define
+// TANGENTSPACE_NO_SIMD to use the scalar code only.
+#if !defined(TANGENTSPACE_NO_SIMD)
+#  if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#     define TANGENTSPACE_SSE
+#     include <xmmintrin.h>
+#  endif
+#endif
+
+namespace postprocess
+{
+
+   // triangles or vertices per task when a large mesh is split up
+   static const uint32 CHUNK_SIZE = 16384;
+
+   static const uint32 NO_VERTEX = 0xffffffff;
+
+   // Calls func(first, last) for consecutive ranges covering [0, count), in parallel on the
+   // pool if there is more than one range.
+   static void ForEachChunk(core::thread::ThreadPool *pPool, uint32 count, const std::function<void(uint32, uint32)> &func)
+   {
+      const uint32 numChunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+      if (NULL == pPool || numChunks < 2)
+      {
+         if (count > 0)
+            func(0, count);
+         return;
+      }
+
+      core::thread::ParallelFor(*pPool, numChunks, [count, &func](uint32 chunk) {
+         func(chunk * CHUNK_SIZE, std::min<uint32>(count, (chunk + 1) * CHUNK_SIZE));
+      });
+   }
+
+   // the bits of a float as a hash key, -0 and 0 give the same key
+   static inline uint32 FloatKey(float value)
+   {
+      value += 0.0f;
+      uint32 bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return bits;
+   }
+
+   static inline float CornerAngle(float cosine)
+   {
+      return acosf(std::max<float>(-1.0f, std::min<float>(1.0f, cosine)));
+   }
+
+   // Computes the cross product of two edges of the triangles [first, last), which is the
+   // normal scaled by twice the area, and the angles at their corners. Corners next to an
+   // edge of length 0 get an angle of 0.
+   static void ComputeCorners(const Vector3f *pPositions, const uint32 *pIndices, uint32 first, uint32 last,
+      float *pCross, float *pAngles)
+   {
+      uint32 t = first;
+#ifdef TANGENTSPACE_SSE
+      for (; t + 4 <= last; t += 4)
+      {
+         // lane i holds triangle t + i
+         const uint32 *pTriangles = pIndices + t * 3;
+         const Vector3f &a0 = pPositions[pTriangles[0]], &b0 = pPositions[pTriangles[1]], &c0 = pPositions[pTriangles[2]];
+         const Vector3f &a1 = pPositions[pTriangles[3]], &b1 = pPositions[pTriangles[4]], &c1 = pPositions[pTriangles[5]];
+         const Vector3f &a2 = pPositions[pTriangles[6]], &b2 = pPositions[pTriangles[7]], &c2 = pPositions[pTriangles[8]];
+         const Vector3f &a3 = pPositions[pTriangles[9]], &b3 = pPositions[pTriangles[10]], &c3 = pPositions[pTriangles[11]];
+         const __m128 ax = _mm_setr_ps(a0.x, a1.x, a2.x, a3.x), ay = _mm_setr_ps(a0.y, a1.y, a2.y, a3.y), az = _mm_setr_ps(a0.z, a1.z, a2.z, a3.z);
+         const __m128 bx = _mm_setr_ps(b0.x, b1.x, b2.x, b3.x), by = _mm_setr_ps(b0.y, b1.y, b2.y, b3.y), bz = _mm_setr_ps(b0.z, b1.z, b2.z, b3.z);
+         const __m128 cx = _mm_setr_ps(c0.x, c1.x, c2.x, c3.x), cy = _mm_setr_ps(c0.y, c1.y, c2.y, c3.y), cz = _mm_setr_ps(c0.z, c1.z, c2.z, c3.z);
+
+         // ab, ac and bc
+         const __m128 e1x = _mm_sub_ps(bx, ax), e1y = _mm_sub_ps(by, ay), e1z = _mm_sub_ps(bz, az);
+         const __m128 e2x = _mm_sub_ps(cx, ax), e2y = _mm_sub_ps(cy, ay), e2z = _mm_sub_ps(cz, az);
+         const __m128 e3x = _mm_sub_ps(cx, bx), e3y = _mm_sub_ps(cy, by), e3z = _mm_sub_ps(cz, bz);
+
+         float crossX[4], crossY[4], crossZ[4];
+         _mm_storeu_ps(crossX, _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)));
+         _mm_storeu_ps(crossY, _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)));
+         _mm_storeu_ps(crossZ, _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+
+         const __m128 length1 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e1x), _mm_mul_ps(e1y, e1y)), _mm_mul_ps(e1z, e1z)));
+         const __m128 length2 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, e2x), _mm_mul_ps(e2y, e2y)), _mm_mul_ps(e2z, e2z)));
+         const __m128 length3 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e3x, e3x), _mm_mul_ps(e3y, e3y)), _mm_mul_ps(e3z, e3z)));
+         const __m128 dot12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e2x), _mm_mul_ps(e1y, e2y)), _mm_mul_ps(e1z, e2z));
+         const __m128 dot13 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e3x), _mm_mul_ps(e1y, e3y)), _mm_mul_ps(e1z, e3z));
+         const __m128 dot23 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, e3x), _mm_mul_ps(e2y, e3y)), _mm_mul_ps(e2z, e3z));
+
+         // the cosines at a (ab, ac), b (ba, bc) and c (ca, cb), degenerate corners are masked out
+         const __m128 zero = _mm_setzero_ps();
+         const __m128 product1 = _mm_mul_ps(length1, length2), product2 = _mm_mul_ps(length1, length3), product3 = _mm_mul_ps(length2, length3);
+         const __m128 valid1 = _mm_cmpgt_ps(product1, zero), valid2 = _mm_cmpgt_ps(product2, zero), valid3 = _mm_cmpgt_ps(product3, zero);
+         const __m128 one = _mm_set1_ps(1.0f);
+         float cosine1[4], cosine2[4], cosine3[4], mask1[4], mask2[4], mask3[4];
+         _mm_storeu_ps(cosine1, _mm_div_ps(dot12, _mm_or_ps(_mm_and_ps(valid1, product1), _mm_andnot_ps(valid1, one))));
+         _mm_storeu_ps(cosine2, _mm_div_ps(_mm_sub_ps(zero, dot13), _mm_or_ps(_mm_and_ps(valid2, product2), _mm_andnot_ps(valid2, one))));
+         _mm_storeu_ps(cosine3, _mm_div_ps(dot23, _mm_or_ps(_mm_and_ps(valid3, product3), _mm_andnot_ps(valid3, one))));
+         _mm_storeu_ps(mask1, _mm_and_ps(valid1, one));
+         _mm_storeu_ps(mask2, _mm_and_ps(valid2, one));
+         _mm_storeu_ps(mask3, _mm_and_ps(valid3, one));
+
+         for (uint32 i = 0; i < 4; i++)
+         {
+            float *pTriangleCross = pCross + (t + i) * 3;
+            pTriangleCross[0] = crossX[i];
+            pTriangleCross[1] = crossY[i];
+            pTriangleCross[2] = crossZ[i];
+
+            float *pTriangleAngles = pAngles + (t + i) * 3;
+            pTriangleAngles[0] = mask1[i] * CornerAngle(cosine1[i]);
+            pTriangleAngles[1] = mask2[i] * CornerAngle(cosine2[i]);
+            pTriangleAngles[2] = mask3[i] * CornerAngle(cosine3[i]);
+         }
+      }
+#endif
+
+      for (; t < last; t++)
+      {
+         const Vector3f &a = pPositions[pIndices[t * 3]], &b = pPositions[pIndices[t * 3 + 1]], &c = pPositions[pIndices[t * 3 + 2]];
+         const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+         const float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+         const float e3[3] = { c.x - b.x, c.y - b.y, c.z - b.z };
+
+         float *pTriangleCross = pCross + t * 3;
+         pTriangleCross[0] = e1[1] * e2[2] - e1[2] * e2[1];
+         pTriangleCross[1] = e1[2] * e2[0] - e1[0] * e2[2];
+         pTriangleCross[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+         const float length1 = sqrtf(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]);
+         const float length2 = sqrtf(e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+         const float length3 = sqrtf(e3[0] * e3[0] + e3[1] * e3[1] + e3[2] * e3[2]);
+         const float dot12 = e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2];
+         const float dot13 = e1[0] * e3[0] + e1[1] * e3[1] + e1[2] * e3[2];
+         const float dot23 = e2[0] * e3[0] + e2[1] * e3[1] + e2[2] * e3[2];
+
+         float *pTriangleAngles = pAngles + t * 3;
+         pTriangleAngles[0] = (length1 * length2 > 0.0f) ? CornerAngle(dot12 / (length1 * length2)) : 0.0f;
+         pTriangleAngles[1] = (length1 * length3 > 0.0f) ? CornerAngle(-dot13 / (length1 * length3)) : 0.0f;
+         pTriangleAngles[2] = (length2 * length3 > 0.0f) ? CornerAngle(dot23 / (length2 * length3)) : 0.0f;
+      }
+   }
+
+   static inline uint32 HashKey(const uint32 *pKey, uint32 stride)
+   {
+      uint32 hash = 0x811c9dc5u;
+      for (uint32 i = 0; i < stride; i++)
+         hash = (hash ^ pKey[i]) * 0x01000193u;
+      return hash ^ (hash >> 16);
+   }
+
+   // Sets the representative of every vertex marked with NO_VERTEX to the first such vertex
+   // with the same key, the keys are stride values per vertex. Other vertices keep theirs.
+   static void FindRepresentatives(const std::vector<uint32> &keys, uint32 stride, std::vector<uint32> &representatives)
+   {
+      const uint32 numVertices = (uint32)representatives.size();
+
+      // open addressing table with at least twice as many slots as vertices, a slot holds the
+      // vertex + 1, 0 marks a free one
+      uint32 tableSize = 16;
+      while (tableSize < numVertices * 2)
+         tableSize <<= 1;
+      std::vector<uint32> table(tableSize, 0);
+
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         if (representatives[v] != NO_VERTEX)
+            continue;
+
+         const uint32 *pKey = &keys[v * stride];
+         uint32 slot = HashKey(pKey, stride) & (tableSize - 1);
+         for (;;)
+         {
+            const uint32 entry = table[slot];
+            if (entry == 0)
+            {
+               table[slot] = v + 1;
+               representatives[v] = v;
+               break;
+            }
+            if (std::equal(pKey, pKey + stride, &keys[(entry - 1) * stride]))
+            {
+               representatives[v] = entry - 1;
+               break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+         }
+      }
+   }
+
+   // Lists the corners of all triangles by the representative of their vertex, the corners
+   // of representative r are corners[offsets[r]] to corners[offsets[r + 1] - 1].
+   static void ListCorners(const uint32 *pIndices, uint32 numIndices, const std::vector<uint32> &representatives,
+      std::vector<uint32> &offsets, std::vector<uint32> &corners)
+   {
+      offsets.assign(representatives.size() + 1, 0);
+      for (uint32 i = 0; i < numIndices; i++)
+         offsets[representatives[pIndices[i]] + 1]++;
+      for (size_t r = 1; r < offsets.size(); r++)
+         offsets[r] += offsets[r - 1];
+
+      std::vector<uint32> next(offsets.begin(), offsets.end() - 1);
+      corners.resize(numIndices);
+      for (uint32 i = 0; i < numIndices; i++)
+         corners[next[representatives[pIndices[i]]]++] = i;
+   }
+
+   static uint32 CountMeshes(const scene::Scene *pScene, bool (Mesh::*pHas)() const)
+   {
+      uint32 count = 0;
+      for (uint32 i = 0; i < pScene->m_numMeshes; i++)
+         count += (pScene->m_ppMeshes[i]->*pHas)() ? 1 : 0;
+      return count;
+   }
+
+   void GenSmoothNormalsProcess::GenerateNormals(Mesh *pMesh, core::thread::ThreadPool *pPool)
+   {
+      if (!pMesh->HasTriangleIndexBuffer() || !pMesh->HasPositions() || pMesh->HasNormals() || pMesh->m_numIndices == 0)
+         return;
+
+      pMesh->TakeOwnership();
+      const uint32 numVertices = pMesh->m_numVertices;
+      const uint32 numTriangles = pMesh->m_numIndices / 3;
+      const uint32 *pIndices = pMesh->m_pIndices;
+      const Vector3f *pPositions = pMesh->m_pVertices;
+
+      std::vector<float> cross(numTriangles * 3), angles(numTriangles * 3);
+      ForEachChunk(pPool, numTriangles, [&](uint32 first, uint32 last) {
+         ComputeCorners(pPositions, pIndices, first, last, &cross[0], &angles[0]);
+      });
+
+      // vertices with the same position and smoothing group share their normal, a vertex of
+      // a flat face keeps its own. Without smoothing groups all faces are smoothed.
+      std::vector<uint32> keys(numVertices * 4), representatives(numVertices, NO_VERTEX);
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         const uint32 group = pMesh->HasSmoothingGroups() ? pMesh->m_pSmoothingGroups[v] : 1;
+         keys[v * 4] = FloatKey(pPositions[v].x);
+         keys[v * 4 + 1] = FloatKey(pPositions[v].y);
+         keys[v * 4 + 2] = FloatKey(pPositions[v].z);
+         keys[v * 4 + 3] = group;
+         if (group == 0)
+            representatives[v] = v;
+      }
+      FindRepresentatives(keys, 4, representatives);
+
+      std::vector<uint32> offsets, corners;
+      ListCorners(pIndices, numTriangles * 3, representatives, offsets, corners);
+
+      // the face normals are weighted by the area and the angle at the corner
+      Vector3f *pNormals = new Vector3f[numVertices];
+      ForEachChunk(pPool, numVertices, [&](uint32 first, uint32 last) {
+         for (uint32 v = first; v < last; v++)
+         {
+            const uint32 r = representatives[v];
+            float normal[3] = { 0.0f, 0.0f, 0.0f };
+            for (uint32 i = offsets[r]; i < offsets[r + 1]; i++)
+            {
+               const uint32 corner = corners[i];
+               const float *pTriangleCross = &cross[corner / 3 * 3];
+               normal[0] += pTriangleCross[0] * angles[corner];
+               normal[1] += pTriangleCross[1] * angles[corner];
+               normal[2] += pTriangleCross[2] * angles[corner];
+            }
+
+            const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            const float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+            pNormals[v] = Vector3f(normal[0] * scale, normal[1] * scale, normal[2] * scale);
+         }
+      });
+      pMesh->m_pNormals = pNormals;
+   }
+
+   void GenSmoothNormalsProcess::ProcessMesh(Mesh *pMesh, const PostProcessContext &context) const
+   {
+      GenerateNormals(pMesh, context.m_pThreadPool);
+   }
+
+   void GenSmoothNormalsProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene)
+         return;
+
+      const uint32 numBefore = CountMeshes(pScene, &Mesh::HasNormals);
+      MeshProcess::Execute(pScene, context);
+      const uint32 numAfter = CountMeshes(pScene, &Mesh::HasNormals);
+
+      if (NULL != context.m_pReport && numAfter > numBefore)
+         context.m_pReport->AddPostProcessStat(GetName(), "meshes", numAfter - numBefore);
+   }
+
+   // Computes the direction of the U axis of the triangles [first, last) in object space
+   // like MikkTSpace does, normalized and flipped for mirrored mappings. A triangle whose
+   // mapping or area is degenerate gets a zero axis.
+   static void ComputeTextureAxes(const Vector3f *pPositions, const Vector3f *pTexCoords, const uint32 *pIndices,
+      uint32 first, uint32 last, float *pAxes, uint8 *pPreserving)
+   {
+      for (uint32 t = first; t < last; t++)
+      {
+         const uint32 *pTriangle = pIndices + t * 3;
+         const Vector3f &p0 = pPositions[pTriangle[0]], &p1 = pPositions[pTriangle[1]], &p2 = pPositions[pTriangle[2]];
+         const Vector3f &t0 = pTexCoords[pTriangle[0]], &t1 = pTexCoords[pTriangle[1]], &t2 = pTexCoords[pTriangle[2]];
+         const float d1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+         const float d2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+         const float s1 = t1.x - t0.x, s2 = t2.x - t0.x;
+         const float q1 = t1.y - t0.y, q2 = t2.y - t0.y;
+
+         const float signedArea = s1 * q2 - q1 * s2;
+         const float axis[3] = { q2 * d1[0] - q1 * d2[0], q2 * d1[1] - q1 * d2[1], q2 * d1[2] - q1 * d2[2] };
+         const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+         float *pAxis = pAxes + t * 3;
+         pPreserving[t] = signedArea > 0.0f ? 1 : 0;
+         const float scale = (signedArea != 0.0f && length > 0.0f) ? (signedArea > 0.0f ? 1.0f : -1.0f) / length : 0.0f;
+         pAxis[0] = axis[0] * scale;
+         pAxis[1] = axis[1] * scale;
+         pAxis[2] = axis[2] * scale;
+      }
+   }
+
+   void CalcTangentSpaceProcess::CalculateTangents(Mesh *pMesh, core::thread::ThreadPool *pPool)
+   {
+      if (!pMesh->HasTriangleIndexBuffer() || !pMesh->HasNormals() || !pMesh->HasTextureCoords(0) ||
+         pMesh->HasTangentsAndBitangents() || pMesh->m_numIndices == 0)
+         return;
+
+      pMesh->TakeOwnership();
+      const uint32 numVertices = pMesh->m_numVertices;
+      const uint32 numTriangles = pMesh->m_numIndices / 3;
+      const uint32 *pIndices = pMesh->m_pIndices;
+      const Vector3f *pPositions = pMesh->m_pVertices;
+      const Vector3f *pNormals = pMesh->m_pNormals;
+      const Vector3f *pTexCoords = pMesh->m_pTextureCoords[0];
+
+      std::vector<float> cross(numTriangles * 3), angles(numTriangles * 3), axes(numTriangles * 3);
+      std::vector<uint8> preserving(numTriangles);
+      ForEachChunk(pPool, numTriangles, [&](uint32 first, uint32 last) {
+         ComputeCorners(pPositions, pIndices, first, last, &cross[0], &angles[0]);
+         ComputeTextureAxes(pPositions, pTexCoords, pIndices, first, last, &axes[0], &preserving[0]);
+      });
+
+      // corners share their tangent if position, normal and texture coordinate are the same
+      std::vector<uint32> keys(numVertices * 8), representatives(numVertices, NO_VERTEX);
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         uint32 *pKey = &keys[v * 8];
+         pKey[0] = FloatKey(pPositions[v].x);
+         pKey[1] = FloatKey(pPositions[v].y);
+         pKey[2] = FloatKey(pPositions[v].z);
+         pKey[3] = FloatKey(pNormals[v].x);
+         pKey[4] = FloatKey(pNormals[v].y);
+         pKey[5] = FloatKey(pNormals[v].z);
+         pKey[6] = FloatKey(pTexCoords[v].x);
+         pKey[7] = FloatKey(pTexCoords[v].y);
+      }
+      FindRepresentatives(keys, 8, representatives);
+
+      std::vector<uint32> offsets, corners;
+      ListCorners(pIndices, numTriangles * 3, representatives, offsets, corners);
+
+      // the U axes are projected into the tangent plane and weighted by the corner angle,
+      // the bitangent follows from the normal and the orientation most of the corners have
+      Vector3f *pTangents = new Vector3f[numVertices];
+      Vector3f *pBitangents = new Vector3f[numVertices];
+      ForEachChunk(pPool, numVertices, [&](uint32 first, uint32 last) {
+         for (uint32 v = first; v < last; v++)
+         {
+            const float n[3] = { pNormals[v].x, pNormals[v].y, pNormals[v].z };
+            const uint32 r = representatives[v];
+            float tangent[3] = { 0.0f, 0.0f, 0.0f };
+            float orientation = 0.0f;
+            for (uint32 i = offsets[r]; i < offsets[r + 1]; i++)
+            {
+               const uint32 corner = corners[i];
+               const float *pAxis = &axes[corner / 3 * 3];
+               const float along = pAxis[0] * n[0] + pAxis[1] * n[1] + pAxis[2] * n[2];
+               float projected[3] = { pAxis[0] - n[0] * along, pAxis[1] - n[1] * along, pAxis[2] - n[2] * along };
+               const float length = sqrtf(projected[0] * projected[0] + projected[1] * projected[1] + projected[2] * projected[2]);
+               if (length <= 0.0f)
+                  continue;
+
+               const float weight = angles[corner] / length;
+               tangent[0] += projected[0] * weight;
+               tangent[1] += projected[1] * weight;
+               tangent[2] += projected[2] * weight;
+               orientation += preserving[corner / 3] ? angles[corner] : -angles[corner];
+            }
+
+            const float along = tangent[0] * n[0] + tangent[1] * n[1] + tangent[2] * n[2];
+            tangent[0] -= n[0] * along;
+            tangent[1] -= n[1] * along;
+            tangent[2] -= n[2] * along;
+            float length = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+            if (length <= 0.0f)
+            {
+               // no usable mapping, any direction in the tangent plane will do
+               const float axis[3] = { fabsf(n[0]) < 0.9f ? 1.0f : 0.0f, fabsf(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+               tangent[0] = n[1] * axis[2] - n[2] * axis[1];
+               tangent[1] = n[2] * axis[0] - n[0] * axis[2];
+               tangent[2] = n[0] * axis[1] - n[1] * axis[0];
+               length = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+            }
+            const float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+            tangent[0] *= scale;
+            tangent[1] *= scale;
+            tangent[2] *= scale;
+
+            const float sign = (orientation < 0.0f) ? -1.0f : 1.0f;
+            pTangents[v] = Vector3f(tangent[0], tangent[1], tangent[2]);
+            pBitangents[v] = Vector3f(sign * (n[1] * tangent[2] - n[2] * tangent[1]),
+               sign * (n[2] * tangent[0] - n[0] * tangent[2]), sign * (n[0] * tangent[1] - n[1] * tangent[0]));
+         }
+      });
+      pMesh->m_pTangents = pTangents;
+      pMesh->m_pBiTangets = pBitangents;
+   }
+
+   void CalcTangentSpaceProcess::ProcessMesh(Mesh *pMesh, const PostProcessContext &context) const
+   {
+      CalculateTangents(pMesh, context.m_pThreadPool);
+   }
+
+   void CalcTangentSpaceProcess::Execute(scene::Scene *pScene, PostProcessContext &context) const
+   {
+      if (NULL == pScene)
+         return;
+
+      const uint32 numBefore = CountMeshes(pScene, &Mesh::HasTangentsAndBitangents);
+      MeshProcess::Execute(pScene, context);
+      const uint32 numAfter = CountMeshes(pScene, &Mesh::HasTangentsAndBitangents);
+
+      if (NULL != context.m_pReport && numAfter > numBefore)
+         context.m_pReport->AddPostProcessStat(GetName(), "meshes", numAfter - numBefore);
+   }
+
+} // namespace postprocess
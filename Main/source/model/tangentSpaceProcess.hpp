@@ -0,0 +1,51 @@
+#ifndef _TANGENTSPACEPROCESS_HPP_INCLUDED_
+#define _TANGENTSPACEPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_GEN_SMOOTH_NORMALS, see postprocess.hpp.
+   class GenSmoothNormalsProcess : public MeshProcess
+   {
+   public:
+      const char *GetName() const { return "genSmoothNormals"; }
+      uint32 GetFlag() const { return PROCESS_GEN_SMOOTH_NORMALS; }
+      uint32 GetRequiredFlags() const { return PROCESS_TRIANGULATE; }
+
+      // generates the normals and adds the number of meshes which got some to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      void ProcessMesh(mesh2::Mesh *pMesh, const PostProcessContext &context) const;
+
+      // Generates the normals of one mesh if it has none, meshes with anything but triangles
+      // are left alone. Large meshes are split up into chunks on the pool, which may be NULL.
+      static void GenerateNormals(mesh2::Mesh *pMesh, core::thread::ThreadPool *pPool);
+   };
+
+   // Implements PROCESS_CALC_TANGENT_SPACE, see postprocess.hpp.
+   class CalcTangentSpaceProcess : public MeshProcess
+   {
+   public:
+      const char *GetName() const { return "calcTangentSpace"; }
+      uint32 GetFlag() const { return PROCESS_CALC_TANGENT_SPACE; }
+      uint32 GetRequiredFlags() const { return PROCESS_TRIANGULATE | PROCESS_GEN_SMOOTH_NORMALS; }
+
+      // calculates the tangents and adds the number of meshes which got some to the report
+      void Execute(scene::Scene *pScene, PostProcessContext &context) const;
+
+      void ProcessMesh(mesh2::Mesh *pMesh, const PostProcessContext &context) const;
+
+      // Calculates the tangents and bitangents of one mesh from its normals and first UV
+      // channel if it has none yet, meshes with anything but triangles are left alone.
+      // Large meshes are split up into chunks on the pool, which may be NULL.
+      static void CalculateTangents(mesh2::Mesh *pMesh, core::thread::ThreadPool *pPool);
+   };
+
+} // namespace postprocess
+
+#endif
@@ -0,0 +1,196 @@
+#include "triangulateProcess.hpp"
+
+#include "mesh2.hpp"
+using mesh2::Mesh;
+using mesh2::Face;
+
+#include "scene/scene.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace postprocess
+{
+
+   // Twice the signed area of the 2d triangle (a, b, c), positive if it turns counter-clockwise.
+   static float Cross2D(const float *a, const float *b, const float *c)
+   {
+      return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+   }
+
+   // true if p lies inside or on the border of the counter-clockwise triangle (a, b, c)
+   static bool IsInTriangle(const float *p, const float *a, const float *b, const float *c)
+   {
+      return Cross2D(a, b, p) >= 0.0f && Cross2D(b, c, p) >= 0.0f && Cross2D(c, a, p) >= 0.0f;
+   }
+
+   void TriangulateProcess::TriangulatePolygon(const Vector3f *pVertices, const uint32 *pPolygon, uint32 n,
+      uint32 *pOut, Scratch &scratch)
+   {
+      // the polygon normal (Newell's method) tells which plane to project the polygon to
+      float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+      for (uint32 i = 0; i < n && pVertices != NULL; i++)
+      {
+         const Vector3f &cur = pVertices[pPolygon[i]];
+         const Vector3f &next = pVertices[pPolygon[(i + 1) % n]];
+         nx += (cur.y - next.y) * (cur.z + next.z);
+         ny += (cur.z - next.z) * (cur.x + next.x);
+         nz += (cur.x - next.x) * (cur.y + next.y);
+      }
+
+      // drop the dominant axis of the normal, the sign keeps the polygon counter-clockwise in 2d
+      const float ax = fabsf(nx), ay = fabsf(ny), az = fabsf(nz);
+      uint32 u, v;
+      float sign;
+      if (az >= ax && az >= ay) {
+         u = 0; v = 1; sign = nz;
+      }
+      else if (ax >= ay) {
+         u = 1; v = 2; sign = nx;
+      }
+      else {
+         u = 2; v = 0; sign = ny;
+      }
+
+      bool isConvex = true;
+      if (sign != 0.0f)
+      {
+         scratch.m_points.resize(n * 2);
+         for (uint32 i = 0; i < n; i++)
+         {
+            const Vector3f &p = pVertices[pPolygon[i]];
+            const float c[3] = { p.x, p.y, p.z };
+            scratch.m_points[i * 2] = c[u];
+            scratch.m_points[i * 2 + 1] = (sign > 0.0f) ? c[v] : -c[v];
+         }
+
+         const float *pPoints = &scratch.m_points[0];
+         for (uint32 i = 0; i < n && isConvex; i++)
+            isConvex = Cross2D(&pPoints[((i + n - 1) % n) * 2], &pPoints[i * 2], &pPoints[((i + 1) % n) * 2]) >= 0.0f;
+      }
+
+      // a fan for convex and degenerated polygons
+      if (isConvex)
+      {
+         for (uint32 i = 1; i + 1 < n; i++)
+         {
+            *pOut++ = pPolygon[0];
+            *pOut++ = pPolygon[i];
+            *pOut++ = pPolygon[i + 1];
+         }
+         return;
+      }
+
+      // ear clipping, cut off a convex corner whose triangle holds no other corner until a triangle is left
+      const float *pPoints = &scratch.m_points[0];
+      std::vector<uint32> &remaining = scratch.m_remaining;
+      remaining.resize(n);
+      for (uint32 i = 0; i < n; i++)
+         remaining[i] = i;
+
+      uint32 cur = 0;
+      while (remaining.size() > 3)
+      {
+         const uint32 count = (uint32)remaining.size();
+         uint32 ear = count;
+         for (uint32 tries = 0; tries < count && ear == count; tries++, cur = (cur + 1) % count)
+         {
+            const uint32 a = remaining[(cur + count - 1) % count];
+            const uint32 b = remaining[cur];
+            const uint32 c = remaining[(cur + 1) % count];
+            const float *pa = &pPoints[a * 2], *pb = &pPoints[b * 2], *pc = &pPoints[c * 2];
+            if (Cross2D(pa, pb, pc) <= 0.0f)
+               continue;
+
+            bool isEar = true;
+            for (uint32 k = 0; k < count && isEar; k++)
+            {
+               const uint32 p = remaining[k];
+               if (p == a || p == b || p == c)
+                  continue;
+               isEar = !IsInTriangle(&pPoints[p * 2], pa, pb, pc);
+            }
+            if (isEar)
+               ear = cur;
+         }
+
+         // self-intersecting or otherwise broken polygon, clip the current corner anyway
+         if (ear == count)
+            ear = cur;
+
+         *pOut++ = pPolygon[remaining[(ear + count - 1) % count]];
+         *pOut++ = pPolygon[remaining[ear]];
+         *pOut++ = pPolygon[remaining[(ear + 1) % count]];
+         remaining.erase(remaining.begin() + ear);
+         cur = (ear < remaining.size()) ? ear : 0;
+      }
+
+      *pOut++ = pPolygon[remaining[0]];
+      *pOut++ = pPolygon[remaining[1]];
+      *pOut++ = pPolygon[remaining[2]];
+   }
+
+   void TriangulateProcess::TriangulateMesh(Mesh *pMesh)
+   {
+      if (!pMesh->HasFaces())
+         return;
+
+      // the faces are replaced below
+      pMesh->TakeOwnership();
+
+      uint32 numFaces = 0, numIndices = 0;
+      for (uint32 i = 0; i < pMesh->m_numFaces; i++)
+      {
+         const uint32 n = pMesh->m_pFaces[i].m_numIndices;
+         numFaces += (n > 3) ? n - 2 : 1;
+         numIndices += (n > 3) ? (n - 2) * 3 : n;
+      }
+
+      Face *pFaces = new Face[numFaces];
+      uint32 *pIndices = new uint32[numIndices];
+      uint32 *pOut = pIndices;
+      uint32 outFace = 0;
+      uint32 primitiveTypes = 0;
+      Scratch scratch;
+
+      for (uint32 i = 0; i < pMesh->m_numFaces; i++)
+      {
+         const Face &face = pMesh->m_pFaces[i];
+         const uint32 n = face.m_numIndices;
+         if (n <= 3)
+         {
+            // points, lines and triangles are copied as they are
+            std::copy(face.m_pIndexArray, face.m_pIndexArray + n, pOut);
+            pFaces[outFace].m_pIndexArray = pOut;
+            pFaces[outFace].m_numIndices = n;
+            pFaces[outFace].m_ownsIndexArray = false;
+            outFace++;
+            pOut += n;
+            if (n > 0)
+               primitiveTypes |= mesh2::GetPrimitiveTypeFlag(n);
+            continue;
+         }
+
+         TriangulatePolygon(pMesh->HasPositions() ? pMesh->m_pVertices : NULL, face.m_pIndexArray, n, pOut, scratch);
+         for (uint32 t = 0; t < n - 2; t++)
+         {
+            pFaces[outFace].m_pIndexArray = pOut;
+            pFaces[outFace].m_numIndices = 3;
+            pFaces[outFace].m_ownsIndexArray = false;
+            outFace++;
+            pOut += 3;
+         }
+         primitiveTypes |= mesh2::PRIMITIVE_TYPE_TRIANGLE;
+      }
+
+      // the old faces may point into the old index buffer, so it goes last
+      delete[] pMesh->m_pFaces;
+      delete[] pMesh->m_pIndices;
+      pMesh->m_pFaces = pFaces;
+      pMesh->m_numFaces = numFaces;
+      pMesh->m_pIndices = pIndices;
+      pMesh->m_numIndices = numIndices;
+      pMesh->m_primitiveTypes = primitiveTypes;
+   }
+
+} // namespace postprocess
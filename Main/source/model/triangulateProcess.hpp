@@ -0,0 +1,45 @@
+#ifndef _TRIANGULATEPROCESS_HPP_INCLUDED_
+#define _TRIANGULATEPROCESS_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include <vector>
+
+#include "baseProcess.hpp"
+#include "postprocess.hpp"
+
+namespace postprocess
+{
+
+   // Implements PROCESS_TRIANGULATE, see postprocess.hpp.
+   class TriangulateProcess : public MeshProcess
+   {
+   private:
+      // scratch memory of the ear clipping, one set per mesh
+      struct Scratch
+      {
+         std::vector<float> m_points; // projected 2d positions
+         std::vector<uint32> m_remaining; // corners not clipped yet
+      };
+
+      // Writes the n - 2 triangles of a polygon with n > 3 corners to pOut, without
+      // positions (pVertices is NULL) the polygon is split as a fan.
+      static void TriangulatePolygon(const Vector3f *pVertices, const uint32 *pPolygon, uint32 n,
+         uint32 *pOut, Scratch &scratch);
+   public:
+      const char *GetName() const { return "triangulate"; }
+      uint32 GetFlag() const { return PROCESS_TRIANGULATE; }
+
+      void ProcessMesh(mesh2::Mesh *pMesh, const PostProcessContext &context) const { TriangulateMesh(pMesh); }
+
+      // Triangulates the polygons of one mesh and moves all its faces into the
+      // index buffer of the mesh.
+      static void TriangulateMesh(mesh2::Mesh *pMesh);
+   };
+
+} // namespace postprocess
+
+#endif
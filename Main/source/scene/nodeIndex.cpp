@@ -0,0 +1,126 @@
+#include "nodeIndex.hpp"
+
+#include "scene.hpp"
+
+#include "core/hash/hash.hpp"
+
+#include <cstring>
+
+// The slots of a batch are prefetched with SSE, define NODEINDEX_NO_SIMD to look them up
+// one after the other.
+#if !defined(NODEINDEX_NO_SIMD)
+#  if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#     define NODEINDEX_SSE
+#     include <xmmintrin.h>
+#  endif
+#endif
+
+namespace scene
+{
+
+   // names looked up together by the batched Find()
+   static const uint32 BATCH_SIZE = 32;
+
+   static uint32 CountNodes(const Node *pNode)
+   {
+      uint32 count = 1;
+      for (uint32 i = 0; i < pNode->m_numChildren; i++)
+         count += CountNodes(pNode->m_ppChildren[i]);
+      return count;
+   }
+
+   NodeIndex::NodeIndex(Node *pRoot)
+      : m_mask(0)
+      , m_numNodes(0)
+   {
+      // at most half of the slots are used
+      const uint32 numNodes = (NULL != pRoot) ? CountNodes(pRoot) : 0;
+      uint32 size = 16;
+      while (size < numNodes * 2)
+         size *= 2;
+      Entry empty;
+      empty.m_hash = 0;
+      empty.m_length = 0;
+      empty.m_pNode = NULL;
+      m_entries.assign(size, empty);
+      m_mask = size - 1;
+
+      // pre-order with an explicit stack, deep hierarchies don't recurse
+      std::vector<Node*> stack;
+      if (NULL != pRoot)
+         stack.push_back(pRoot);
+      while (!stack.empty())
+      {
+         Node *pNode = stack.back();
+         stack.pop_back();
+         Insert(pNode);
+         for (uint32 i = pNode->m_numChildren; i > 0; i--)
+            stack.push_back(pNode->m_ppChildren[i - 1]);
+      }
+   }
+
+   void NodeIndex::Insert(Node *pNode)
+   {
+      const uint32 length = (uint32)pNode->m_name.size();
+      const uint32 hash = core::SuperFastHash(pNode->m_name.c_str(), length);
+      for (uint32 slot = hash & m_mask;; slot = (slot + 1) & m_mask)
+      {
+         Entry &entry = m_entries[slot];
+         if (NULL == entry.m_pNode)
+         {
+            entry.m_hash = hash;
+            entry.m_length = length;
+            entry.m_pNode = pNode;
+            m_numNodes++;
+            return;
+         }
+         // a node with the same name came first in pre-order
+         if (entry.m_hash == hash && entry.m_length == length && entry.m_pNode->m_name == pNode->m_name)
+            return;
+      }
+   }
+
+   Node *NodeIndex::Find(const char *name, uint32 length, uint32 hash) const
+   {
+      for (uint32 slot = hash & m_mask;; slot = (slot + 1) & m_mask)
+      {
+         const Entry &entry = m_entries[slot];
+         if (NULL == entry.m_pNode)
+            return NULL;
+         if (entry.m_hash == hash && entry.m_length == length && 0 == memcmp(entry.m_pNode->m_name.c_str(), name, length))
+            return entry.m_pNode;
+      }
+   }
+
+   Node *NodeIndex::Find(const char *name) const
+   {
+      if (NULL == name)
+         return NULL;
+      const uint32 length = (uint32)strlen(name);
+      return Find(name, length, core::SuperFastHash(name, length));
+   }
+
+   void NodeIndex::Find(const char *const *ppNames, uint32 count, Node **ppNodes) const
+   {
+      uint32 lengths[BATCH_SIZE], hashes[BATCH_SIZE];
+      for (uint32 first = 0; first < count; first += BATCH_SIZE)
+      {
+         const uint32 n = (count - first < BATCH_SIZE) ? count - first : BATCH_SIZE;
+         for (uint32 i = 0; i < n; i++)
+         {
+            const char *name = ppNames[first + i];
+            lengths[i] = (NULL != name) ? (uint32)strlen(name) : 0;
+            hashes[i] = (NULL != name) ? core::SuperFastHash(name, lengths[i]) : 0;
+#ifdef NODEINDEX_SSE
+            _mm_prefetch((const char*)&m_entries[hashes[i] & m_mask], _MM_HINT_T0);
+#endif
+         }
+         for (uint32 i = 0; i < n; i++)
+         {
+            const char *name = ppNames[first + i];
+            ppNodes[first + i] = (NULL != name) ? Find(name, lengths[i], hashes[i]) : NULL;
+         }
+      }
+   }
+
+} // namespace scene
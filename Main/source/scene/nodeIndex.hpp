@@ -0,0 +1,47 @@
+#ifndef _NODEINDEX_HPP_INCLUDED_
+#define _NODEINDEX_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include <vector>
+
+namespace scene
+{
+
+   struct Node;
+
+   // Hash table from names to the nodes of a hierarchy, see Scene::BuildNodeIndex(). Where
+   // names repeat the first node in pre-order wins, like Node::FindNode() finds it.
+   class NodeIndex
+   {
+   public:
+      explicit NodeIndex(Node *pRoot);
+
+      // NULL if no node has the name
+      Node *Find(const char *name) const;
+
+      // Looks up count names at once, ppNodes[i] is NULL if no node has ppNames[i]. The
+      // table slots of a batch are fetched before the names are compared.
+      void Find(const char *const *ppNames, uint32 count, Node **ppNodes) const;
+
+      uint32 GetNumNodes() const { return m_numNodes; }
+
+   private:
+      struct Entry
+      {
+         uint32 m_hash;
+         uint32 m_length;
+         Node *m_pNode; // NULL for an empty slot
+      };
+
+      void Insert(Node *pNode);
+      Node *Find(const char *name, uint32 length, uint32 hash) const;
+
+      std::vector<Entry> m_entries; // a power of two in size, open addressing
+      uint32 m_mask;
+      uint32 m_numNodes;
+   };
+
+} // namespace scene
+
+#endif
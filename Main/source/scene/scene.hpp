@@ -57,6 +57,7 @@ using mesh2::Face;
 //#include "anim.h"
 //#include "metadata.h"
 #include "model/material.hpp"
+#include "nodeIndex.hpp"
 
 namespace scene
 {
@@ -106,6 +107,12 @@ namespace scene
 
       uint32* m_ppMeshes; // Each entry is an index into the mesh
 
+      /** False if m_ppChildren and m_ppMeshes belong to the scene's storage (see
+      *  SceneArena), the node doesn't delete them then. Call TakeOwnership()
+      *  before replacing one of them. The child nodes are always owned.
+      */
+      bool m_ownsArrays;
+
       /** Metadata associated with this node or NULL if there is no metadata.
       *  Whether any metadata is generated depends on the source file format. See the
       * @link importer_notes @endlink page for more information on every source file
@@ -120,8 +127,10 @@ namespace scene
          , m_ppChildren(NULL)
          , m_numMeshes(0)
          , m_ppMeshes(NULL)
+         , m_ownsArrays(true)
          //, mMetaData(NULL)
       {
+         m_transformation.SetIdentity();
       }
 
       Node(const std::string &name)
@@ -131,8 +140,10 @@ namespace scene
          , m_ppChildren(NULL)
          , m_numMeshes(0)
          , m_ppMeshes(NULL)
+         , m_ownsArrays(true)
          //, mMetaData(NULL)
       {
+         m_transformation.SetIdentity();
       }
 
       ~Node()
@@ -143,11 +154,32 @@ namespace scene
             for (uint32 a = 0; a < m_numChildren; a++)
                delete m_ppChildren[a];
          }
-         delete[] m_ppChildren;
-         delete[] m_ppMeshes;
+         if (m_ownsArrays)
+         {
+            delete[] m_ppChildren;
+            delete[] m_ppMeshes;
+         }
          //delete mMetaData;
       }
 
+      //! Copies the arrays which belong to the scene's storage, afterwards the
+      //! node may replace and delete them like the arrays it allocated itself
+      void TakeOwnership()
+      {
+         if (m_ownsArrays)
+            return;
+
+         Node **ppChildren = m_ppChildren ? new Node*[m_numChildren] : NULL;
+         if (ppChildren)
+            std::copy(m_ppChildren, m_ppChildren + m_numChildren, ppChildren);
+         uint32 *pMeshes = m_ppMeshes ? new uint32[m_numMeshes] : NULL;
+         if (pMeshes)
+            std::copy(m_ppMeshes, m_ppMeshes + m_numMeshes, pMeshes);
+         m_ppChildren = ppChildren;
+         m_ppMeshes = pMeshes;
+         m_ownsArrays = true;
+      }
+
 
       /** Searches for a node with a specific name, beginning at this
       *  nodes. Normally you will call this method on the root node
@@ -262,6 +294,34 @@ namespace scene
    *  delete a given scene on your own.
    */
 
+   /** Memory the arrays of a scene's meshes and nodes live in instead of being allocated
+   *  one by one, e.g. a mapped scene cache or a SceneArena. The scene deletes it after its
+   *  meshes and nodes, which don't free arrays they don't own (see mesh2::Mesh::m_ownsArrays
+   *  and Node::m_ownsArrays).
+   */
+   class SceneStorage
+   {
+   public:
+      virtual ~SceneStorage() { }
+
+      // the heap blocks the storage holds, for the import report
+      virtual uint32 GetNumAllocations() const { return 1; }
+   };
+
+   /** Where postprocess::PROCESS_MERGE_MESHES or PROCESS_PRE_TRANSFORM_VERTICES
+   *  put a mesh referenced by a node, see Scene::m_pMeshRemaps.
+   */
+   struct MeshRemap
+   {
+      uint32 m_node; // the referencing node in a pre-order walk of the hierarchy, the root is 0
+      uint32 m_oldMesh; // index of the mesh before the step
+      uint32 m_newMesh; // index into Scene::m_ppMeshes
+      uint32 m_firstVertex; // the vertices and faces of the mesh in the new mesh
+      uint32 m_numVertices;
+      uint32 m_firstFace;
+      uint32 m_numFaces;
+   };
+
    struct Scene
    {
       eSceneFlags m_flags; // Most applications will want to reject all scenes with the AI_SCENE_FLAGS_INCOMPLETE
@@ -338,7 +398,59 @@ namespace scene
       */
        //Camera** m_ppCameras;
 
-      Scene() : m_numMeshes(0) {}
+      /** The number of entries in m_pMeshRemaps. */
+      uint32 m_numMeshRemaps;
+
+      /** One entry per mesh reference of a node before the last run of
+      * PROCESS_MERGE_MESHES, in node order. PROCESS_PRE_TRANSFORM_VERTICES
+      * updates the entries or adds them if there are none, the node indices
+      * keep telling the hierarchy before it was flattened. NULL if neither
+      * step ran.
+      */
+      MeshRemap* m_pMeshRemaps;
+
+      Scene()
+         : m_flags((eSceneFlags)0)
+         , m_pRootNode(NULL)
+         , m_numMeshes(0)
+         , m_ppMeshes(NULL)
+         , m_numMaterials(0)
+         , m_ppMaterials(NULL)
+         , m_numAnimations(0)
+         , m_numTextures(0)
+         , m_numLights(0)
+         , m_numCameras(0)
+         , m_numMeshRemaps(0)
+         , m_pMeshRemaps(NULL)
+         , m_pStorage(NULL)
+         , m_pPrivate(NULL)
+         , m_pNodeIndex(NULL)
+      {
+      }
+
+      ~Scene()
+      {
+         delete m_pRootNode;
+
+         if (m_numMeshes && m_ppMeshes)
+         {
+            for (uint32 a = 0; a < m_numMeshes; a++)
+               delete m_ppMeshes[a];
+         }
+         delete[] m_ppMeshes;
+
+         if (m_numMaterials && m_ppMaterials)
+         {
+            for (uint32 a = 0; a < m_numMaterials; a++)
+               delete m_ppMaterials[a];
+         }
+         delete[] m_ppMaterials;
+         delete[] m_pMeshRemaps;
+         delete m_pNodeIndex;
+
+         // the meshes and nodes may point into the storage, so it goes last
+         delete m_pStorage;
+      }
 
       //scene size in bytes ...
       inline void GetSceneByteSize(uint32 &verticesSize, uint32 &indicesSize ) const
@@ -355,8 +467,14 @@ namespace scene
             if (m_ppMeshes[i]->HasVertexColors(0))
                verticesSize += m_ppMeshes[i]->m_numVertices * sizeof(Color4f);
             
+            // only triangles go to the index buffer, every mesh in its own index size and
+            // aligned to it, see oglbuffer::generateBufferFromScene()
             if (m_ppMeshes[i]->HasFaces())
-               indicesSize += m_ppMeshes[i]->m_numFaces * sizeof(Face);
+            {
+               const uint32 indexSize = m_ppMeshes[i]->GetIndexSize();
+               indicesSize = (indicesSize + indexSize - 1) / indexSize * indexSize;
+               indicesSize += m_ppMeshes[i]->GetNumTriangles() * 3 * indexSize;
+            }
 
             if (m_ppMeshes[i]->HasTextureCoords(0))
                verticesSize += m_ppMeshes[i]->m_numVertices * sizeof(Vector3f);
@@ -398,8 +516,72 @@ namespace scene
          //return m_ppAnimations != NULL && m_numAnimations > 0;
       }
 
+      /** Memory owned by the scene which the meshes and nodes may point into,
+      *  NULL if all of them own their arrays. */
+      SceneStorage* m_pStorage;
+
       /**  Internal data, do not touch */
       void* m_pPrivate;
+
+      /** Builds the name index FindNode() and FindNodes() use instead of
+      *  searching the hierarchy. Call InvalidateNodeIndex() after adding,
+      *  removing or renaming nodes, the importer rebuilds it after post
+      *  processing. See CONFIG_IMPORT_BUILD_NODE_INDEX.
+      */
+      void BuildNodeIndex()
+      {
+         delete m_pNodeIndex;
+         m_pNodeIndex = NULL;
+         if (NULL != m_pRootNode)
+            m_pNodeIndex = new NodeIndex(m_pRootNode);
+      }
+
+      void InvalidateNodeIndex()
+      {
+         delete m_pNodeIndex;
+         m_pNodeIndex = NULL;
+      }
+
+      bool HasNodeIndex() const
+      {
+         return NULL != m_pNodeIndex;
+      }
+
+      /** The first node in pre-order with the name, NULL if there is none.
+      *  Searches the hierarchy unless the index is built.
+      */
+      Node* FindNode(const char *name) const
+      {
+         if (NULL != m_pNodeIndex)
+            return m_pNodeIndex->Find(name);
+         return (NULL != m_pRootNode && NULL != name) ? m_pRootNode->FindNode(name) : NULL;
+      }
+
+      Node* FindNode(const std::string &name) const
+      {
+         return FindNode(name.c_str());
+      }
+
+      /** Looks up count names at once, ppNodes[i] is the node FindNode()
+      *  returns for ppNames[i].
+      */
+      void FindNodes(const char *const *ppNames, uint32 count, Node **ppNodes) const
+      {
+         if (NULL != m_pNodeIndex)
+         {
+            m_pNodeIndex->Find(ppNames, count, ppNodes);
+            return;
+         }
+         for (uint32 i = 0; i < count; i++)
+            ppNodes[i] = FindNode(ppNames[i]);
+      }
+
+   private:
+      NodeIndex* m_pNodeIndex; // NULL unless BuildNodeIndex() was called
+
+      // the scene owns its meshes, nodes and materials
+      Scene(const Scene &other);
+      Scene &operator=(const Scene &other);
    };
 
 } // namespace scene
@@ -0,0 +1,57 @@
+#include "sceneArena.hpp"
+
+#include <algorithm>
+
+namespace scene
+{
+
+   static const size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+   // blocks double in size up to this
+   static const size_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+   SceneArena::SceneArena(size_t initialSize)
+      : m_pCurrent(NULL)
+      , m_pEnd(NULL)
+      , m_nextBlockSize(MIN_BLOCK_SIZE)
+      , m_numBytes(0)
+      , m_capacity(0)
+   {
+      if (initialSize > 0)
+         AddBlock(initialSize);
+   }
+
+   SceneArena::~SceneArena()
+   {
+      for (size_t i = 0; i < m_blocks.size(); i++)
+         delete[] m_blocks[i];
+   }
+
+   void SceneArena::AddBlock(size_t minSize)
+   {
+      const size_t size = std::max<size_t>(m_nextBlockSize, minSize);
+      char *pBlock = new char[size];
+      m_blocks.push_back(pBlock);
+      m_pCurrent = pBlock;
+      m_pEnd = pBlock + size;
+      m_capacity += size;
+      m_nextBlockSize = std::min<size_t>(std::max<size_t>(m_nextBlockSize, size) * 2, MAX_BLOCK_SIZE);
+   }
+
+   void *SceneArena::AllocateBytes(size_t size, size_t alignment)
+   {
+      // new[] aligns a block for every type, so only the offset into it matters
+      size_t padding = (alignment - (size_t)m_pCurrent % alignment) % alignment;
+      if (NULL == m_pCurrent || size + padding > (size_t)(m_pEnd - m_pCurrent))
+      {
+         AddBlock(size);
+         padding = 0;
+      }
+
+      void *p = m_pCurrent + padding;
+      m_pCurrent += padding + size;
+      m_numBytes += size;
+      return p;
+   }
+
+} // namespace scene
@@ -0,0 +1,62 @@
+#ifndef _SCENEARENA_HPP_INCLUDED_
+#define _SCENEARENA_HPP_INCLUDED_
+
+#include "scene.hpp"
+
+#include <new>
+#include <vector>
+
+namespace scene
+{
+
+   /** Scene storage the arrays of an import are carved out of one after the other, see
+   *  CONFIG_IMPORT_SCENE_ARENA. The arena grows by adding blocks, nothing is freed before
+   *  the scene deletes it, which releases all arrays with a few block frees. Arrays which
+   *  post processing replaces are copied out first (see mesh2::Mesh::TakeOwnership()) and
+   *  stay behind unused. Not thread safe.
+   */
+   class SceneArena : public SceneStorage
+   {
+   public:
+      // the first block holds at least initialSize bytes
+      explicit SceneArena(size_t initialSize = 0);
+      virtual ~SceneArena();
+
+      // Like new T[count], NULL for 0. The destructors are never called.
+      template <typename T>
+      T *Allocate(size_t count)
+      {
+         if (0 == count)
+            return NULL;
+         T *p = static_cast<T*>(AllocateBytes(count * sizeof(T), __alignof(T)));
+         for (size_t i = 0; i < count; i++)
+            new (p + i) T;
+         return p;
+      }
+
+      void *AllocateBytes(size_t size, size_t alignment);
+
+      // bytes handed out, without the alignment padding
+      uint64 GetNumBytes() const { return m_numBytes; }
+      uint64 GetCapacity() const { return m_capacity; }
+      uint32 GetNumBlocks() const { return (uint32)m_blocks.size(); }
+
+      virtual uint32 GetNumAllocations() const { return 1 + GetNumBlocks(); }
+
+   private:
+      void AddBlock(size_t minSize);
+
+      std::vector<char*> m_blocks;
+      char *m_pCurrent; // free space of the last block
+      char *m_pEnd;
+      size_t m_nextBlockSize;
+      uint64 m_numBytes;
+      uint64 m_capacity;
+
+      SceneArena(const SceneArena &other);
+      SceneArena &operator=(const SceneArena &other);
+   };
+
+} // namespace scene
+
+#endif
@@ -0,0 +1,156 @@
+#include "transformHierarchy.hpp"
+
+#include "scene.hpp"
+
+#include "core/thread/threadpool.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace scene
+{
+
+   // nodes of a level per task
+   static const uint32 CHUNK_SIZE = 1024;
+
+   static const uint32 NO_LEVEL = 0xffffffff;
+
+   const uint32 TransformHierarchy::NO_NODE;
+
+   TransformHierarchy::TransformHierarchy(Node *pRoot)
+      : m_firstDirtyLevel(NO_LEVEL)
+      , m_lastDirtyLevel(0)
+   {
+      m_levelStarts.push_back(0);
+      if (NULL == pRoot)
+         return;
+
+      // breadth first, the children of the nodes of one level form the next level
+      m_nodes.push_back(pRoot);
+      m_parents.push_back(NO_NODE);
+      for (uint32 first = 0; first < (uint32)m_nodes.size();)
+      {
+         const uint32 last = (uint32)m_nodes.size();
+         for (uint32 i = first; i < last; i++)
+         {
+            const Node *pNode = m_nodes[i];
+            for (uint32 c = 0; c < pNode->m_numChildren; c++)
+            {
+               m_nodes.push_back(pNode->m_ppChildren[c]);
+               m_parents.push_back(i);
+            }
+         }
+         m_levelStarts.push_back(last);
+         first = last;
+      }
+
+      const uint32 numNodes = (uint32)m_nodes.size();
+      m_locals.resize(numNodes);
+      m_worlds.resize(numNodes);
+      for (uint32 i = 0; i < numNodes; i++)
+      {
+         m_locals[i] = m_nodes[i]->m_transformation;
+         m_indices[m_nodes[i]] = i;
+      }
+
+      // everything is computed once
+      m_dirty.assign(numNodes, 1);
+      m_firstDirtyLevel = 0;
+      m_lastDirtyLevel = GetNumLevels() - 1;
+      Update();
+   }
+
+   uint32 TransformHierarchy::GetIndex(const Node *pNode) const
+   {
+      std::map<const Node*, uint32>::const_iterator it = m_indices.find(pNode);
+      return (it != m_indices.end()) ? it->second : NO_NODE;
+   }
+
+   uint32 TransformHierarchy::GetLevel(uint32 index) const
+   {
+      return (uint32)(std::upper_bound(m_levelStarts.begin(), m_levelStarts.end(), index) - m_levelStarts.begin()) - 1;
+   }
+
+   void TransformHierarchy::SetLocal(uint32 index, const Matrix4f &local)
+   {
+      m_locals[index] = local;
+      m_dirty[index] = 1;
+      const uint32 level = GetLevel(index);
+      m_firstDirtyLevel = (m_firstDirtyLevel == NO_LEVEL) ? level : std::min<uint32>(m_firstDirtyLevel, level);
+      m_lastDirtyLevel = std::max<uint32>(m_lastDirtyLevel, level);
+   }
+
+   bool TransformHierarchy::IsDirty(uint32 index) const
+   {
+      for (; index != NO_NODE; index = m_parents[index])
+      {
+         if (m_dirty[index])
+            return true;
+      }
+      return false;
+   }
+
+   bool TransformHierarchy::UpdateRange(uint32 first, uint32 last)
+   {
+      bool any = false;
+      for (uint32 i = first; i < last; i++)
+      {
+         const uint32 parent = m_parents[i];
+         if (NO_NODE == parent)
+         {
+            if (m_dirty[i])
+               m_worlds[i] = m_locals[i];
+         }
+         else if (m_dirty[i] || m_dirty[parent])
+         {
+            // the flag tells the children of the next level
+            m_dirty[i] = 1;
+            m_worlds[i] = m_worlds[parent] * m_locals[i];
+         }
+         any = any || m_dirty[i];
+      }
+      return any;
+   }
+
+   void TransformHierarchy::Update(core::thread::ThreadPool *pPool)
+   {
+      if (NO_LEVEL == m_firstDirtyLevel)
+         return;
+
+      // Levels above the first marked one are up to date. Below the last marked level the
+      // walk ends with the first level without a dirty node.
+      uint32 level = m_firstDirtyLevel;
+      for (; level < GetNumLevels(); level++)
+      {
+         const uint32 first = m_levelStarts[level], last = m_levelStarts[level + 1];
+         const uint32 numChunks = (last - first + CHUNK_SIZE - 1) / CHUNK_SIZE;
+         bool any = false;
+         if (NULL != pPool && numChunks > 1)
+         {
+            std::vector<uint8> chunkDirty(numChunks, 0);
+            core::thread::ParallelFor(*pPool, numChunks, [this, first, last, &chunkDirty](uint32 c) {
+               const uint32 begin = first + c * CHUNK_SIZE;
+               chunkDirty[c] = UpdateRange(begin, std::min<uint32>(begin + CHUNK_SIZE, last)) ? 1 : 0;
+            });
+            any = std::find(chunkDirty.begin(), chunkDirty.end(), 1) != chunkDirty.end();
+         }
+         else
+            any = UpdateRange(first, last);
+
+         if (!any && level >= m_lastDirtyLevel)
+            break;
+      }
+
+      const uint32 end = (level < GetNumLevels()) ? m_levelStarts[level] : GetNumNodes();
+      std::fill(m_dirty.begin() + m_levelStarts[m_firstDirtyLevel], m_dirty.begin() + end, 0);
+      m_firstDirtyLevel = NO_LEVEL;
+      m_lastDirtyLevel = 0;
+   }
+
+   void TransformHierarchy::StoreLocals() const
+   {
+      for (uint32 i = 0; i < GetNumNodes(); i++)
+         m_nodes[i]->m_transformation = m_locals[i];
+   }
+
+} // namespace scene
@@ -0,0 +1,94 @@
+#ifndef _TRANSFORMHIERARCHY_HPP_INCLUDED_
+#define _TRANSFORMHIERARCHY_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+#include "core/math/matrix4.hpp"
+using core::math::Matrix4f;
+
+#include <vector>
+#include <map>
+
+namespace core
+{
+   namespace thread
+   {
+      class ThreadPool;
+   }
+}
+
+namespace scene
+{
+
+   struct Node;
+
+   // The transformations of a node hierarchy in flat arrays for updating them at runtime.
+   // The nodes are stored level by level, so every parent comes before its children and
+   // the nodes of one level lie next to each other, children of the same parent in a row.
+   // Update() recomputes the world matrices below the nodes whose local matrix changed, one
+   // level after the other and the nodes of large levels in parallel. The arrays are a
+   // snapshot of the hierarchy, build a new one after adding or removing nodes.
+   class TransformHierarchy
+   {
+   public:
+      static const uint32 NO_NODE = 0xffffffff;
+
+      // Takes the nodes below and including pRoot and their Node::m_transformation, the
+      // world matrices are computed right away.
+      explicit TransformHierarchy(Node *pRoot);
+
+      uint32 GetNumNodes() const { return (uint32)m_parents.size(); }
+      uint32 GetNumLevels() const { return (uint32)m_levelStarts.size() - 1; }
+
+      // the nodes of a level are [GetLevelStart(level), GetLevelStart(level + 1))
+      uint32 GetLevelStart(uint32 level) const { return m_levelStarts[level]; }
+
+      // NO_NODE for the root
+      uint32 GetParent(uint32 index) const { return m_parents[index]; }
+      Node *GetNode(uint32 index) const { return m_nodes[index]; }
+
+      // the index of a node in the arrays, NO_NODE if it isn't part of the hierarchy
+      uint32 GetIndex(const Node *pNode) const;
+
+      const Matrix4f &GetLocal(uint32 index) const { return m_locals[index]; }
+
+      // replaces the transformation relative to the parent, the node and its subtree are
+      // updated by the next Update()
+      void SetLocal(uint32 index, const Matrix4f &local);
+
+      // the transformation into the space of the root's parent, as of the last Update()
+      const Matrix4f &GetWorld(uint32 index) const { return m_worlds[index]; }
+
+      // GetNumNodes() world matrices in the order of the indices, e.g. for uploading
+      const Matrix4f *GetWorldMatrices() const { return m_worlds.empty() ? NULL : &m_worlds[0]; }
+
+      // true if the node or one of its ancestors changed since the last Update()
+      bool IsDirty(uint32 index) const;
+
+      // Recomputes the world matrices of the changed nodes and their descendants, levels
+      // with more than one chunk of nodes are split up on the pool if there is one.
+      void Update(core::thread::ThreadPool *pPool = NULL);
+
+      // copies the local matrices back into Node::m_transformation
+      void StoreLocals() const;
+
+   private:
+      // updates [first, last) of one level, returns true if one of them was dirty
+      bool UpdateRange(uint32 first, uint32 last);
+
+      uint32 GetLevel(uint32 index) const;
+
+      std::vector<Node*> m_nodes;
+      std::vector<uint32> m_parents;
+      std::vector<Matrix4f> m_locals;
+      std::vector<Matrix4f> m_worlds;
+      std::vector<uint8> m_dirty; // set by SetLocal(), spreads to the children in Update()
+      std::vector<uint32> m_levelStarts; // one more than there are levels
+      std::map<const Node*, uint32> m_indices;
+      uint32 m_firstDirtyLevel; // the range of levels SetLocal() marked nodes in
+      uint32 m_lastDirtyLevel;
+   };
+
+} // namespace scene
+
+#endif
@@ -103,6 +103,13 @@ namespace oglshader
 
    }
 
+   // true if the attribute was added and is active in the program
+   bool GLSLShader::HasAttribute(const std::string &attribute) const
+   {
+      map<std::string, GLuint>::const_iterator it = m_attributeMap.find(attribute);
+      return it != m_attributeMap.end() && it->second != (GLuint)-1;
+   }
+
    void GLSLShader::CreateAndLink(std::ostream &stream)
    {
       m_program = glCreateProgram();
@@ -51,6 +51,7 @@ namespace oglshader
       void Use();
       void Unuse();
       void AddAttribute(const std::string &);
+      bool HasAttribute(const std::string &attribute) const;
       void DeleteProgram();
       void CreateAndLink(std::ostream &stream);
       //void GetCompilationStatus(string &outStatus) const;
@@ -0,0 +1,96 @@
+#include "tests.hpp"
+
+#include "model/asyncImporter.hpp"
+#include "model/config.hpp"
+#include "model/postprocess.hpp"
+#include "scene/scene.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace tests
+{
+
+   static const char *FILE_NAME = "selftest_async.obj";
+
+   // imports queued at once, several times the number of threads
+   static const uint32 NUM_IMPORTS = 8;
+
+   // A grid of quads, large enough for the chunked parse (ObjParser::PARALLEL_MIN_CHUNK_SIZE)
+   // so every import calls ParallelFor() on the pool of the AsyncImporter.
+   static bool WriteGrid(const char *pFileName, uint32 size)
+   {
+      FILE *pFile = fopen(pFileName, "wb");
+      if (NULL == pFile)
+         return false;
+
+      for (uint32 y = 0; y <= size; y++)
+      {
+         for (uint32 x = 0; x <= size; x++)
+            fprintf(pFile, "v %f %f %f\n", x * 0.125f, y * 0.125f, (x ^ y) * 0.001f);
+      }
+      for (uint32 y = 0; y < size; y++)
+      {
+         for (uint32 x = 0; x < size; x++)
+         {
+            const uint32 v = y * (size + 1) + x + 1;
+            fprintf(pFile, "f %u %u %u %u\n", v, v + 1, v + size + 2, v + size + 1);
+         }
+      }
+      return 0 == fclose(pFile);
+   }
+
+   // Destroys an AsyncImporter while most of its imports are still queued. The destructor
+   // has to wait for them, the last queued imports still need the pool for their parse.
+   static uint32 TestDestroyWhileQueued(bool cancelSome)
+   {
+      importer::Importer settings;
+      std::vector<importer::ImportTaskPtr> tasks;
+      {
+         importer::AsyncImporter async(settings, 2);
+         for (uint32 i = 0; i < NUM_IMPORTS; i++)
+            tasks.push_back(async.ReadFileAsync(FILE_NAME, postprocess::PROCESS_TRIANGULATE));
+         if (cancelSome)
+         {
+            for (uint32 i = 1; i < NUM_IMPORTS; i += 2)
+               tasks[i]->Cancel();
+         }
+      }
+
+      uint32 numFailures = 0;
+      for (uint32 i = 0; i < NUM_IMPORTS; i++)
+      {
+         if (!tasks[i]->IsDone())
+         {
+            printf("asyncimporter: import %u is still running after the importer was destroyed\n", i);
+            numFailures++;
+            continue;
+         }
+
+         Scene *pScene = tasks[i]->GetScene();
+         const bool canceled = cancelSome && (i & 1);
+         if (canceled ? NULL != pScene : (NULL == pScene || 0 == pScene->m_numMeshes))
+         {
+            printf("asyncimporter: import %u %s\n", i, canceled ? "returned a scene after Cancel()" : "has no scene");
+            numFailures++;
+         }
+         delete pScene;
+      }
+      return numFailures;
+   }
+
+   uint32 TestAsyncImporter()
+   {
+      if (!WriteGrid(FILE_NAME, 200))
+      {
+         printf("asyncimporter: can't write %s\n", FILE_NAME);
+         return 1;
+      }
+
+      const uint32 numFailures = TestDestroyWhileQueued(false) + TestDestroyWhileQueued(true);
+      remove(FILE_NAME);
+      printf("asyncimporter: %u failures\n", numFailures);
+      return numFailures;
+   }
+
+} // namespace tests
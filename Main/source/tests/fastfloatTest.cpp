@@ -0,0 +1,316 @@
+#include "tests.hpp"
+
+#include "core/fastfloat.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tests
+{
+
+   // random inputs per generator
+   static const uint32 NUM_RANDOM = 100000;
+
+   // mismatches printed per test, the others are only counted
+   static const uint32 MAX_REPORTS = 20;
+
+   static bool SameFloat(float a, float b)
+   {
+      if (std::isnan(a) || std::isnan(b))
+         return std::isnan(a) && std::isnan(b);
+      return 0 == memcmp(&a, &b, sizeof(float));
+   }
+
+   // The floats a decimal number rounds to if strtod() read it as d. Both are the same
+   // unless d lies exactly between two floats, the decimal number may lie on either side
+   // of the double then.
+   static void RoundToFloat(double d, float &nearest, float &other)
+   {
+      const float inf = std::numeric_limits<float>::infinity();
+      const double absD = fabs(d);
+      // FLT_MAX plus half an ulp, from there on everything rounds to infinity
+      const double overflow = (double)FLT_MAX + ldexp(1.0, 103);
+      if (absD >= overflow)
+      {
+         nearest = (d < 0.0) ? -inf : inf;
+         other = (absD == overflow) ? ((d < 0.0) ? -FLT_MAX : FLT_MAX) : nearest;
+         return;
+      }
+      if (absD > FLT_MAX)
+      {
+         nearest = other = (d < 0.0) ? -FLT_MAX : FLT_MAX;
+         return;
+      }
+
+      nearest = other = (float)d;
+      if ((double)nearest == d)
+         return;
+      // the sum of two neighbouring floats and its half are exact in double
+      const float next = std::nextafter(nearest, (d > (double)nearest) ? inf : -inf);
+      if (((double)nearest + (double)next) * 0.5 == d)
+         other = next;
+   }
+
+   // Parses text with ParseFloat() and strtod(), they must agree on the value and the
+   // number of characters read. Returns the number of failures.
+   static uint32 CheckNumber(const std::string &text, uint32 &numReports)
+   {
+      // an exactly sized copy, the parser must not read behind end
+      const std::vector<char> buffer(text.begin(), text.end());
+      const char *pBegin = &buffer[0];
+      float value = 0.0f;
+      const char *pEnd = core::fastfloat::ParseFloat(pBegin, pBegin + buffer.size(), value);
+
+      char *pStrtodEnd = NULL;
+      const double d = strtod(text.c_str(), &pStrtodEnd);
+      const size_t length = pEnd - pBegin, expectedLength = pStrtodEnd - text.c_str();
+
+      float nearest, other;
+      RoundToFloat(d, nearest, other);
+      if (length == expectedLength && (0 == length || SameFloat(value, nearest) || SameFloat(value, other)))
+         return 0;
+
+      if (numReports++ < MAX_REPORTS)
+      {
+         printf("fastfloat: \"%s\" gives %.9g (%u chars), strtod %.9g (%u chars)\n", text.c_str(),
+            value, (uint32)length, nearest, (uint32)expectedLength);
+      }
+      return 1;
+   }
+
+   // cases strtod() can't decide: exact ties, which round to even, and the special values
+   struct ExactCase
+   {
+      const char *m_pText;
+      float m_value;
+      uint32 m_length; // 0 if there is no number
+   };
+
+   static uint32 CheckExact(const ExactCase &test, uint32 &numReports)
+   {
+      const std::string text(test.m_pText);
+      const std::vector<char> buffer(text.begin(), text.end());
+      const char *pBegin = &buffer[0];
+      float value = 0.0f;
+      const uint32 length = (uint32)(core::fastfloat::ParseFloat(pBegin, pBegin + buffer.size(), value) - pBegin);
+      if (length == test.m_length && (0 == length || SameFloat(value, test.m_value)))
+         return 0;
+
+      if (numReports++ < MAX_REPORTS)
+      {
+         printf("fastfloat: \"%s\" gives %.9g (%u chars), expected %.9g (%u chars)\n", test.m_pText,
+            value, length, test.m_value, test.m_length);
+      }
+      return 1;
+   }
+
+   static float RandomFloat(std::mt19937 &random)
+   {
+      for (;;)
+      {
+         const uint32 bits = random();
+         float value;
+         memcpy(&value, &bits, sizeof(value));
+         if (!std::isnan(value) && !std::isinf(value))
+            return value;
+      }
+   }
+
+   // [+-]digits[.digits][(e|E)[+-]digits] with up to 30 digits before and after the point
+   static std::string RandomDecimal(std::mt19937 &random)
+   {
+      std::string text;
+      const uint32 sign = random() % 3;
+      if (sign > 0)
+         text += (1 == sign) ? '-' : '+';
+
+      uint32 numInteger = random() % 31, numFraction = random() % 31;
+      if (0 == numInteger + numFraction)
+         numInteger = 1;
+      for (uint32 i = 0; i < numInteger; i++)
+         text += (char)('0' + random() % 10);
+      if (numFraction > 0 || 0 == random() % 4)
+         text += '.';
+      for (uint32 i = 0; i < numFraction; i++)
+         text += (char)('0' + random() % 10);
+
+      if (random() % 4 != 0)
+      {
+         char exponent[16];
+         // mostly around the float range, sometimes far outside
+         const int32 value = (random() % 8 != 0) ? (int32)(random() % 100) - 60 : (int32)(random() % 800) - 400;
+         const char *pSign = (value < 0) ? "-" : ((random() % 2) ? "+" : "");
+         sprintf(exponent, "%c%s%d", (random() % 2) ? 'e' : 'E', pSign, abs(value));
+         text += exponent;
+      }
+      return text;
+   }
+
+   static uint32 TestParseFloat(uint32 &numReports)
+   {
+      static const char *EDGE_CASES[] = {
+         "0", "-0", "+0", "0.0", "000", ".0", "0.", "1", "+1", "-1", ".5", "+.5", "-.5", "5.", "+5.",
+         "1e10", "1E-10", "1e+10", "1.5e", "2e+", "3e-", "1ex", "-e5", ".", "+", "-", "+.", "e5", "x",
+         "0.1", "0.2", "0.3", "3.14159265", "2.718281828459045", "1e-7", "123456789", "4294967296",
+         // around the largest float
+         "3.4028234e38", "3.4028235e38", "3.40282357e38", "3.4028236e38", "-3.4028236e+38", "1e38",
+         "1e39", "1e400", "-1e400", "340282356779733661637539395458142568448",
+         "340282366920938463463374607431768211455",
+         // normal limit and denormals
+         "1.17549435e-38", "1.1754942e-38", "1.17549421e-38", "1e-38", "1e-40", "1e-44", "1.4e-45",
+         "1.401298464e-45", "2.8e-45", "7.1e-46", "7e-46", "1e-46", "1e-50", "1e-400", "-1e-45",
+         // long mantissas, past the 19 digits a 64 bit integer holds
+         "0.1000000000000000000000000001", "123456789012345678901234567890",
+         "3.141592653589793238462643383279502884197", "0.000000000000000000000000000000000000000000001",
+         "99999999999999999999999999999999999999", "00000000000000000000000000000000000000001.5",
+         "1.00000005960464477539062499999", "16777216.9999999999999999999999", "1e0000000000000000000000001",
+         "0e99999999", "1e-99999999", "12345678901234567890e-30",
+         // trailing characters
+         "1.5f", "2.0,3.0", "1e5.5", "1..2", "1.2.3"
+      };
+
+      uint32 numFailures = 0;
+      for (uint32 i = 0; i < sizeof(EDGE_CASES) / sizeof(EDGE_CASES[0]); i++)
+         numFailures += CheckNumber(EDGE_CASES[i], numReports);
+
+      const float inf = std::numeric_limits<float>::infinity();
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      const ExactCase EXACT_CASES[] = {
+         { "16777217", 16777216.0f, 8 },
+         { "16777219", 16777220.0f, 8 },
+         { "16777217.00000000000000000001", 16777218.0f, 29 },
+         { "1.000000059604644775390625", 1.0f, 26 },
+         { "1.0000000596046447753906250000001", 1.00000011920928955078125f, 33 },
+         { "1.000000178813934326171875", 1.0000002384185791015625f, 26 },
+         // half the smallest denormal
+         { "7.00649232162408535461864791644958065640130970938257885878534141944895541342930300743319094181060791015625e-46", 0.0f, 110 },
+         { "7.00649232162408535461864791644958065640130970938257885878534141944895541342930300743319094181060791015626e-46", 1.4e-45f, 110 },
+         { "inf", inf, 3 },
+         { "-inf", -inf, 4 },
+         { "+INF", inf, 4 },
+         { "Infinity", inf, 8 },
+         { "-infinity", -inf, 9 },
+         { "infinit", inf, 3 },
+         { "nan", nan, 3 },
+         { "NaN", nan, 3 },
+         { "-nan", nan, 4 },
+         { "in", 0.0f, 0 },
+         { "na", 0.0f, 0 }
+      };
+      for (uint32 i = 0; i < sizeof(EXACT_CASES) / sizeof(EXACT_CASES[0]); i++)
+         numFailures += CheckExact(EXACT_CASES[i], numReports);
+
+      std::mt19937 random(20261018);
+      static const char *FORMATS[] = { "%.9g", "%.8e", "%.17g", "%.3g", "%.12f", "%.25e" };
+      char text[512];
+      for (uint32 i = 0; i < NUM_RANDOM; i++)
+      {
+         // the shortest round trip text of a float and some longer and shorter ones
+         sprintf(text, FORMATS[i % (sizeof(FORMATS) / sizeof(FORMATS[0]))], RandomFloat(random));
+         numFailures += CheckNumber(text, numReports);
+
+         numFailures += CheckNumber(RandomDecimal(random), numReports);
+
+         // close to the halfway point between two floats
+         const float value = RandomFloat(random);
+         const float next = std::nextafter(value, (value < 0.0f) ? -FLT_MAX : FLT_MAX);
+         sprintf(text, "%.*e", 9 + random() % 20, ((double)value + (double)next) * 0.5);
+         numFailures += CheckNumber(text, numReports);
+      }
+      return numFailures;
+   }
+
+   // Numbers of one line as the vertex statements have them, ParseFloats() must read the
+   // same values as ParseFloat() on each token.
+   static uint32 TestParseFloats(uint32 &numReports)
+   {
+      struct LineCase
+      {
+         const char *m_pText;
+         uint32 m_numMax;
+         uint32 m_numValues;
+         float m_values[4];
+         uint32 m_rest; // offset of the returned iterator
+      };
+      const float inf = std::numeric_limits<float>::infinity();
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      const LineCase LINE_CASES[] = {
+         { "1.5 -2e3\t.25 +7", 4, 4, { 1.5f, -2000.0f, 0.25f, 7.0f }, 15 },
+         { "  1 2 3 4", 3, 3, { 1.0f, 2.0f, 3.0f }, 7 },
+         { "1 2x 3", 4, 3, { 1.0f, 2.0f, 3.0f }, 6 },
+         { "1 abc 3", 4, 1, { 1.0f }, 2 },
+         { "1 2\r\n3", 4, 2, { 1.0f, 2.0f }, 3 },
+         { "4 5\n6", 4, 2, { 4.0f, 5.0f }, 3 },
+         { " \t ", 4, 0, { 0.0f }, 3 },
+         { "-inf nan 1e-45", 4, 3, { -inf, nan, 1.4e-45f }, 14 }
+      };
+
+      uint32 numFailures = 0;
+      for (uint32 i = 0; i < sizeof(LINE_CASES) / sizeof(LINE_CASES[0]); i++)
+      {
+         const LineCase &test = LINE_CASES[i];
+         const std::vector<char> buffer(test.m_pText, test.m_pText + strlen(test.m_pText));
+         float values[4];
+         uint32 numValues = 0;
+         const char *pRest = core::fastfloat::ParseFloats(&buffer[0], &buffer[0] + buffer.size(), values, test.m_numMax, numValues);
+         bool same = numValues == test.m_numValues && pRest - &buffer[0] == test.m_rest;
+         for (uint32 v = 0; same && v < numValues; v++)
+            same = SameFloat(values[v], test.m_values[v]);
+         if (!same)
+         {
+            numFailures++;
+            if (numReports++ < MAX_REPORTS)
+               printf("fastfloat: line \"%s\" gives %u values, rest at %u\n", test.m_pText, numValues, (uint32)(pRest - &buffer[0]));
+         }
+      }
+
+      std::mt19937 random(4711);
+      static const char *BLANKS[] = { " ", "\t", "  ", " \t " };
+      for (uint32 i = 0; i < NUM_RANDOM / 10; i++)
+      {
+         std::vector<std::string> tokens(1 + random() % 4);
+         std::string line;
+         for (size_t t = 0; t < tokens.size(); t++)
+         {
+            tokens[t] = RandomDecimal(random);
+            line += BLANKS[random() % 4] + tokens[t];
+         }
+         line += (random() % 2) ? "\n1 2" : "";
+
+         const std::vector<char> buffer(line.begin(), line.end());
+         float values[4];
+         uint32 numValues = 0;
+         core::fastfloat::ParseFloats(&buffer[0], &buffer[0] + buffer.size(), values, 4, numValues);
+         bool same = numValues == tokens.size();
+         for (uint32 v = 0; same && v < numValues; v++)
+         {
+            float value;
+            core::fastfloat::ParseFloat(tokens[v].c_str(), tokens[v].c_str() + tokens[v].size(), value);
+            same = SameFloat(values[v], value);
+         }
+         if (!same)
+         {
+            numFailures++;
+            if (numReports++ < MAX_REPORTS)
+               printf("fastfloat: line \"%s\" gives %u values\n", line.c_str(), numValues);
+         }
+      }
+      return numFailures;
+   }
+
+   uint32 TestFastFloat()
+   {
+      uint32 numReports = 0;
+      const uint32 numFailures = TestParseFloat(numReports) + TestParseFloats(numReports);
+      printf("fastfloat: %u failures\n", numFailures);
+      return numFailures;
+   }
+
+} // namespace tests
@@ -0,0 +1,19 @@
+#include "tests.hpp"
+
+#include <cstdio>
+
+namespace tests
+{
+
+   uint32 RunAll()
+   {
+      uint32 numFailures = 0;
+      numFailures += TestFastFloat();
+      numFailures += TestVertexPacking();
+      numFailures += TestAsyncImporter();
+      numFailures += TestTransformHierarchy();
+      printf("self test: %u failures\n", numFailures);
+      return numFailures;
+   }
+
+} // namespace tests
@@ -0,0 +1,30 @@
+#ifndef _TESTS_HPP_INCLUDED_
+#define _TESTS_HPP_INCLUDED_
+
+// Self tests of the modules which can be checked without a window or GL context. Each
+// test prints its mismatches to stdout and returns their number, the application runs
+// them instead of the demo if it is started with -selftest.
+
+#include "core/BasicTypes.hpp"
+
+namespace tests
+{
+
+   // core::fastfloat against strtod()
+   uint32 TestFastFloat();
+
+   // gfx::vertexpacking, packs random meshes in every format and decodes them again
+   uint32 TestVertexPacking();
+
+   // importer::AsyncImporter destroyed with imports still queued
+   uint32 TestAsyncImporter();
+
+   // scene::TransformHierarchy updates against a full recompute of the world matrices
+   uint32 TestTransformHierarchy();
+
+   // runs all tests, returns the number of failures
+   uint32 RunAll();
+
+} // namespace tests
+
+#endif
@@ -0,0 +1,163 @@
+#include "tests.hpp"
+
+#include "scene/scene.hpp"
+#include "scene/transformHierarchy.hpp"
+using scene::Node;
+using scene::TransformHierarchy;
+
+#include "core/math/vector3.hpp"
+using core::math::Vector3f;
+
+#include "core/thread/threadpool.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace tests
+{
+
+   // children per node of every level, the leaves form a level of more than one chunk of
+   // TransformHierarchy so the pool splits it up
+   static const uint32 BRANCHING[] = { 3, 4, 100 };
+   static const uint32 NUM_LEVELS = sizeof(BRANCHING) / sizeof(BRANCHING[0]) + 1;
+
+   // mismatches printed, the others are only counted
+   static const uint32 MAX_REPORTS = 20;
+
+   static Matrix4f RandomTransformation(std::mt19937 &random)
+   {
+      std::uniform_real_distribution<float> angle(-180.0f, 180.0f), offset(-5.0f, 5.0f);
+      Matrix4f local;
+      local.SetIdentity();
+      local.SetRotationDegrees(Vector3f(angle(random), angle(random), angle(random)));
+      local.SetTranslation(offset(random), offset(random), offset(random));
+      return local;
+   }
+
+   static Node *BuildTree(uint32 level, std::mt19937 &random)
+   {
+      Node *pNode = new Node;
+      pNode->m_transformation = RandomTransformation(random);
+      if (level + 1 < NUM_LEVELS)
+      {
+         pNode->m_numChildren = BRANCHING[level];
+         pNode->m_ppChildren = new Node*[pNode->m_numChildren];
+         for (uint32 c = 0; c < pNode->m_numChildren; c++)
+         {
+            pNode->m_ppChildren[c] = BuildTree(level + 1, random);
+            pNode->m_ppChildren[c]->m_pParentNode = pNode;
+         }
+      }
+      return pNode;
+   }
+
+   // the world matrices of the subtree from Node::m_transformation, without the hierarchy
+   static void ComputeWorlds(const TransformHierarchy &hierarchy, const Node *pNode, const Matrix4f &parent,
+      std::vector<Matrix4f> &worlds)
+   {
+      const Matrix4f world = parent * pNode->m_transformation;
+      worlds[hierarchy.GetIndex(pNode)] = world;
+      for (uint32 c = 0; c < pNode->m_numChildren; c++)
+         ComputeWorlds(hierarchy, pNode->m_ppChildren[c], world, worlds);
+   }
+
+   static bool Near(const Matrix4f &a, const Matrix4f &b)
+   {
+      for (uint8 r = 0; r < 4; r++)
+      {
+         for (uint8 c = 0; c < 4; c++)
+         {
+            if (fabsf(a(r, c) - b(r, c)) > 1e-4f * (1.0f + fabsf(b(r, c))))
+               return false;
+         }
+      }
+      return true;
+   }
+
+   // true if pAncestor is pNode or one of its parents
+   static bool IsInSubtree(const Node *pNode, const Node *pAncestor)
+   {
+      for (; NULL != pNode; pNode = pNode->m_pParentNode)
+      {
+         if (pNode == pAncestor)
+            return true;
+      }
+      return false;
+   }
+
+   // Compares every world matrix of the hierarchy with a full recompute from the nodes,
+   // the changed subtrees as well as their untouched siblings.
+   static uint32 CompareWorlds(const TransformHierarchy &hierarchy, Node *pRoot, const char *pStep, uint32 &numReports)
+   {
+      hierarchy.StoreLocals();
+      std::vector<Matrix4f> worlds(hierarchy.GetNumNodes());
+      Matrix4f identity;
+      identity.SetIdentity();
+      ComputeWorlds(hierarchy, pRoot, identity, worlds);
+
+      uint32 numFailures = 0;
+      for (uint32 i = 0; i < hierarchy.GetNumNodes(); i++)
+      {
+         if (!Near(hierarchy.GetWorld(i), worlds[i]))
+         {
+            numFailures++;
+            if (numReports++ < MAX_REPORTS)
+               printf("transformhierarchy: %s: world matrix of node %u differs from the full recompute\n", pStep, i);
+         }
+      }
+      return numFailures;
+   }
+
+   // the nodes below pChanged have to be dirty until the next Update(), all others not
+   static uint32 CheckDirty(const TransformHierarchy &hierarchy, const Node *pChanged, uint32 &numReports)
+   {
+      uint32 numFailures = 0;
+      for (uint32 i = 0; i < hierarchy.GetNumNodes(); i++)
+      {
+         if (hierarchy.IsDirty(i) != IsInSubtree(hierarchy.GetNode(i), pChanged))
+         {
+            numFailures++;
+            if (numReports++ < MAX_REPORTS)
+               printf("transformhierarchy: node %u is %s after SetLocal()\n", i, hierarchy.IsDirty(i) ? "dirty" : "not dirty");
+         }
+      }
+      return numFailures;
+   }
+
+   uint32 TestTransformHierarchy()
+   {
+      std::mt19937 random(4711);
+      Node *pRoot = BuildTree(0, random);
+      TransformHierarchy hierarchy(pRoot);
+      uint32 numReports = 0;
+      uint32 numFailures = CompareWorlds(hierarchy, pRoot, "construction", numReports);
+
+      // a node in the middle of the hierarchy, its siblings keep their matrices
+      Node *pMiddle = pRoot->m_ppChildren[1]->m_ppChildren[2];
+      hierarchy.SetLocal(hierarchy.GetIndex(pMiddle), RandomTransformation(random));
+      numFailures += CheckDirty(hierarchy, pMiddle, numReports);
+      hierarchy.Update();
+      numFailures += CompareWorlds(hierarchy, pRoot, "mid level node", numReports);
+
+      // nodes on several levels at once, the leaf level is updated in parallel
+      {
+         core::thread::ThreadPool pool(2);
+         hierarchy.SetLocal(hierarchy.GetIndex(pRoot->m_ppChildren[2]->m_ppChildren[0]->m_ppChildren[7]),
+            RandomTransformation(random));
+         hierarchy.SetLocal(hierarchy.GetIndex(pRoot->m_ppChildren[0]), RandomTransformation(random));
+         hierarchy.Update(&pool);
+         numFailures += CompareWorlds(hierarchy, pRoot, "several levels", numReports);
+
+         // nothing changed, nothing moves
+         hierarchy.Update(&pool);
+         numFailures += CompareWorlds(hierarchy, pRoot, "unchanged", numReports);
+      }
+
+      delete pRoot;
+      printf("transformhierarchy: %u failures\n", numFailures);
+      return numFailures;
+   }
+
+} // namespace tests
@@ -0,0 +1,308 @@
+#include "tests.hpp"
+
+#include "gfx/vertexpacking.hpp"
+using namespace gfx::vertexpacking;
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace tests
+{
+
+   // meshes per format
+   static const uint32 NUM_MESHES = 40;
+
+   // mismatches printed, the others are only counted
+   static const uint32 MAX_REPORTS = 20;
+
+   // octahedral directions decode within this angle
+   static const double MAX_OCT_DEGREES = 0.01;
+
+   static const char *POSITION_NAMES[] = { "POSITION_FLOAT", "POSITION_HALF", "POSITION_UNORM16" };
+   static const char *DIRECTION_NAMES[] = { "DIRECTION_FLOAT", "DIRECTION_OCT16" };
+   static const char *TEXCOORD_NAMES[] = { "TEXCOORD_FLOAT", "TEXCOORD_HALF" };
+
+   // largest difference of a value and its half float, the rounding to nearest gives half an ulp
+   static float HalfError(float value)
+   {
+      // 10 mantissa bits, below 2^-14 the denormal spacing of 2^-24 applies
+      return std::max<float>(fabsf(value) * (1.0f / 2048.0f), 1.0f / 33554432.0f);
+   }
+
+   // in degrees
+   static double Angle(const Vector3f &a, const Vector3f &b)
+   {
+      const double cx = (double)a.y * b.z - (double)a.z * b.y;
+      const double cy = (double)a.z * b.x - (double)a.x * b.z;
+      const double cz = (double)a.x * b.y - (double)a.y * b.x;
+      const double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+      return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979323846;
+   }
+
+   static Vector3f Cross(const Vector3f &a, const Vector3f &b)
+   {
+      return Vector3f(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+   }
+
+   static Vector3f Normalized(const Vector3f &v)
+   {
+      const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+      return Vector3f(v.x / length, v.y / length, v.z / length);
+   }
+
+   // mostly uniform on the sphere, sometimes one of the directions on the octahedron's seams
+   static Vector3f RandomDirection(std::mt19937 &random)
+   {
+      static const float SEAMS[][3] = {
+         { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+         { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f },
+         { 1.0f, -1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f }, { 0.0f, 1.0f, -1.0f }, { 1e-4f, -1e-4f, -1.0f }
+      };
+      if (0 == random() % 16)
+      {
+         const float *pSeam = SEAMS[random() % (sizeof(SEAMS) / sizeof(SEAMS[0]))];
+         return Normalized(Vector3f(pSeam[0], pSeam[1], pSeam[2]));
+      }
+
+      std::normal_distribution<float> normal;
+      Vector3f v;
+      do
+      {
+         v = Vector3f(normal(random), normal(random), normal(random));
+      } while (v.x * v.x + v.y * v.y + v.z * v.z < 1e-6f);
+      return Normalized(v);
+   }
+
+   // A mesh with random vertices in a box of random size and position. Normals, tangents and
+   // texture coordinates are left out of some meshes, tangent frames are orthonormal with a
+   // random handedness.
+   static mesh2::Mesh *RandomMesh(std::mt19937 &random)
+   {
+      std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+      mesh2::Mesh *pMesh = new mesh2::Mesh;
+      const uint32 numVertices = 1 + random() % 500;
+      pMesh->m_numVertices = numVertices;
+
+      // sizes from 1/100 to 1000, some boxes are flat
+      float extent[3], offset[3];
+      for (uint32 c = 0; c < 3; c++)
+      {
+         extent[c] = (0 == random() % 10) ? 0.0f : powf(10.0f, unit(random) * 5.0f - 2.0f);
+         offset[c] = (unit(random) - 0.5f) * 2000.0f;
+      }
+      pMesh->m_pVertices = new Vector3f[numVertices];
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         pMesh->m_pVertices[v] = Vector3f(offset[0] + unit(random) * extent[0], offset[1] + unit(random) * extent[1],
+            offset[2] + unit(random) * extent[2]);
+      }
+
+      if (random() % 4 != 0)
+      {
+         pMesh->m_pNormals = new Vector3f[numVertices];
+         for (uint32 v = 0; v < numVertices; v++)
+            pMesh->m_pNormals[v] = RandomDirection(random);
+
+         if (random() % 2)
+         {
+            pMesh->m_pTangents = new Vector3f[numVertices];
+            pMesh->m_pBiTangets = new Vector3f[numVertices];
+            for (uint32 v = 0; v < numVertices; v++)
+            {
+               const Vector3f &n = pMesh->m_pNormals[v];
+               Vector3f side;
+               do
+               {
+                  side = Cross(n, RandomDirection(random));
+               } while (side.x * side.x + side.y * side.y + side.z * side.z < 1e-4f);
+               const Vector3f t = Normalized(side);
+               const Vector3f b = Cross(n, t);
+               pMesh->m_pTangents[v] = t;
+               pMesh->m_pBiTangets[v] = (random() % 2) ? b : Vector3f(-b.x, -b.y, -b.z);
+            }
+         }
+      }
+
+      if (random() % 4 != 0)
+      {
+         pMesh->m_numUVComponents[0] = 2;
+         pMesh->m_pTextureCoords[0] = new Vector3f[numVertices];
+         for (uint32 v = 0; v < numVertices; v++)
+            pMesh->m_pTextureCoords[0][v] = Vector3f(unit(random) * 5.0f - 2.0f, unit(random) * 5.0f - 2.0f, 0.0f);
+      }
+      return pMesh;
+   }
+
+   // largest errors of one format, positions and texture coordinates relative to their bound
+   struct FormatErrors
+   {
+      double m_position;
+      double m_direction; // degrees
+      double m_texCoord;
+
+      FormatErrors() : m_position(0.0), m_direction(0.0), m_texCoord(0.0) { }
+   };
+
+   static uint32 Report(uint32 &numReports, const VertexFormat &format, uint32 vertex, const char *pWhat)
+   {
+      if (numReports++ < MAX_REPORTS)
+      {
+         printf("vertexpacking: %s/%s/%s vertex %u: %s out of bounds\n", POSITION_NAMES[format.m_position],
+            DIRECTION_NAMES[format.m_direction], TEXCOORD_NAMES[format.m_texCoord], vertex, pWhat);
+      }
+      return 1;
+   }
+
+   // what UnpackVertex() returns for a direction the mesh doesn't have, see PackVertices()
+   static Vector3f MissingDirection(const VertexLayout &layout, eAttribute attribute)
+   {
+      if (layout.HasAttribute(attribute) && layout.m_format.m_direction == DIRECTION_OCT16)
+         return Vector3f(0.0f, 0.0f, 1.0f);
+      return Vector3f(0.0f, 0.0f, 0.0f);
+   }
+
+   static bool Equal(const Vector3f &a, const Vector3f &b)
+   {
+      return a.x == b.x && a.y == b.y && a.z == b.z;
+   }
+
+   // Packs the mesh, decodes every vertex and compares it with the mesh. Floats must come back
+   // exactly, half floats within half an ulp, 16 bit unorm positions within half a step of
+   // 1/65535 of the mesh bounds and octahedral directions within MAX_OCT_DEGREES. The layout
+   // has the attributes of the mesh, or all of them like the one layout of a scene in
+   // oglbuffer::generateBufferFromScene().
+   static uint32 CheckMesh(const mesh2::Mesh *pMesh, const VertexFormat &format, bool allAttributes, FormatErrors &errors,
+      uint32 &numReports)
+   {
+      const VertexLayout layout = allAttributes ? VertexLayout(format, true, true, true) :
+         VertexLayout(format, pMesh->HasNormals(), pMesh->HasTangentsAndBitangents(), pMesh->HasTextureCoords(0));
+      std::vector<uint8> packed((size_t)pMesh->m_numVertices * layout.m_stride);
+      const PackedBounds bounds = PackVertices(pMesh, layout, &packed[0]);
+
+      const double maxDirection = (format.m_direction == DIRECTION_OCT16) ? MAX_OCT_DEGREES : 0.0;
+      uint32 numFailures = 0;
+      for (uint32 v = 0; v < pMesh->m_numVertices; v++)
+      {
+         UnpackedVertex vertex;
+         UnpackVertex(layout, bounds, &packed[(size_t)v * layout.m_stride], vertex);
+
+         const float *pPosition = &pMesh->m_pVertices[v].x;
+         const float *pDecoded = &vertex.m_position.x;
+         const float *pOffset = &bounds.m_offset.x;
+         const float *pScale = &bounds.m_scale.x;
+         bool positionOk = true;
+         for (uint32 c = 0; c < 3; c++)
+         {
+            const float error = fabsf(pDecoded[c] - pPosition[c]);
+            float maxError = 0.0f;
+            if (format.m_position == POSITION_HALF)
+               maxError = HalfError(pPosition[c]);
+            else if (format.m_position == POSITION_UNORM16)
+            {
+               // plus the float rounding of the scaling on both sides
+               maxError = pScale[c] * (0.5f / 65535.0f) + 4.0f * FLT_EPSILON * (fabsf(pOffset[c]) + pScale[c]);
+            }
+            if (maxError > 0.0f)
+               errors.m_position = std::max<double>(errors.m_position, error / maxError);
+            positionOk = positionOk && error <= maxError;
+         }
+         if (!positionOk)
+            numFailures += Report(numReports, format, v, "position");
+
+         if (pMesh->HasNormals())
+         {
+            const double angle = Angle(vertex.m_normal, pMesh->m_pNormals[v]);
+            errors.m_direction = std::max<double>(errors.m_direction, angle);
+            if (angle > maxDirection)
+               numFailures += Report(numReports, format, v, "normal");
+         }
+         else if (!Equal(vertex.m_normal, MissingDirection(layout, ATTRIBUTE_NORMAL)))
+            numFailures += Report(numReports, format, v, "missing normal");
+
+         if (pMesh->HasTangentsAndBitangents())
+         {
+            const double angle = Angle(vertex.m_tangent, pMesh->m_pTangents[v]);
+            errors.m_direction = std::max<double>(errors.m_direction, angle);
+            if (angle > maxDirection)
+               numFailures += Report(numReports, format, v, "tangent");
+
+            // the bitangent is rebuilt from the normal and tangent, it sums both their errors
+            if (Angle(vertex.m_bitangent, pMesh->m_pBiTangets[v]) > 2.0 * maxDirection + 1e-4)
+               numFailures += Report(numReports, format, v, "bitangent");
+         }
+         else if (!Equal(vertex.m_tangent, MissingDirection(layout, ATTRIBUTE_TANGENT)))
+            numFailures += Report(numReports, format, v, "missing tangent");
+
+         if (pMesh->HasTextureCoords(0))
+         {
+            const Vector3f &uv = pMesh->m_pTextureCoords[0][v];
+            const float errorU = fabsf(vertex.m_texCoord.x - uv.x), errorV = fabsf(vertex.m_texCoord.y - uv.y);
+            const bool half = format.m_texCoord == TEXCOORD_HALF;
+            if (half)
+               errors.m_texCoord = std::max<double>(errors.m_texCoord, std::max<float>(errorU / HalfError(uv.x), errorV / HalfError(uv.y)));
+            if (errorU > (half ? HalfError(uv.x) : 0.0f) || errorV > (half ? HalfError(uv.y) : 0.0f))
+               numFailures += Report(numReports, format, v, "texture coordinate");
+         }
+         else if (vertex.m_texCoord.x != 0.0f || vertex.m_texCoord.y != 0.0f)
+            numFailures += Report(numReports, format, v, "missing texture coordinate");
+      }
+      return numFailures;
+   }
+
+   // every half float except NaN converts to float and back to itself
+   static uint32 TestHalfRoundTrip(uint32 &numReports)
+   {
+      uint32 numFailures = 0;
+      for (uint32 h = 0; h <= 0xffff; h++)
+      {
+         const bool isNaN = (h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0;
+         if (!isNaN && FloatToHalf(HalfToFloat((uint16)h)) != h)
+         {
+            numFailures++;
+            if (numReports++ < MAX_REPORTS)
+               printf("vertexpacking: half 0x%04x doesn't survive the float round trip\n", h);
+         }
+      }
+      return numFailures;
+   }
+
+   uint32 TestVertexPacking()
+   {
+      uint32 numReports = 0;
+      uint32 numFailures = TestHalfRoundTrip(numReports);
+
+      std::mt19937 random(1337);
+      const ePositionFormat POSITIONS[] = { POSITION_FLOAT, POSITION_HALF, POSITION_UNORM16 };
+      const eDirectionFormat DIRECTIONS[] = { DIRECTION_FLOAT, DIRECTION_OCT16 };
+      const eTexCoordFormat TEXCOORDS[] = { TEXCOORD_FLOAT, TEXCOORD_HALF };
+      for (uint32 p = 0; p < 3; p++)
+      {
+         for (uint32 d = 0; d < 2; d++)
+         {
+            for (uint32 t = 0; t < 2; t++)
+            {
+               const VertexFormat format(POSITIONS[p], DIRECTIONS[d], TEXCOORDS[t]);
+               FormatErrors errors;
+               for (uint32 m = 0; m < NUM_MESHES; m++)
+               {
+                  mesh2::Mesh *pMesh = RandomMesh(random);
+                  numFailures += CheckMesh(pMesh, format, false, errors, numReports);
+                  numFailures += CheckMesh(pMesh, format, true, errors, numReports);
+                  delete pMesh;
+               }
+               printf("vertexpacking: %s/%s/%s largest errors: position %.3f and texture coordinate %.3f "
+                  "of the bound, direction %.4f degrees\n", POSITION_NAMES[p], DIRECTION_NAMES[d], TEXCOORD_NAMES[t],
+                  errors.m_position, errors.m_texCoord, errors.m_direction);
+            }
+         }
+      }
+
+      printf("vertexpacking: %u failures\n", numFailures);
+      return numFailures;
+   }
+
+} // namespace tests
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 
 //#include "bmp.hpp"
@@ -12,6 +13,8 @@
 #include "openal/oaldriver.hpp"
 #include "gfx/oglbuffer.hpp"
 
+#include "tests/tests.hpp"
+
 #include "win32/win32console.hpp"
 using win32console::Win32Console;
 
@@ -56,6 +59,10 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
    t = debugConsole.SetRedirection(win32console::REDIR_STDOUT);
 
+   // -selftest runs the module tests instead of the demo
+   if (NULL != strstr(lpCmdLine, "-selftest"))
+      return (INT)tests::RunAll();
+
    Matrix4f mat = Matrix4f::IDENTITY * 3;
    Vector4f v(4, 5, 6, 7);
    printf("hello\n");
@@ -133,12 +140,9 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
    shader.AddUniformData("light.color", color.Ptr(), oglshader::TYPE_FVEC3, 1);
    shader.Unuse();
 
-   oglbuffer::generateBufferFromScene(sc, shader, vaoID, vboIndicesID);
+   std::vector<oglbuffer::MeshDrawInfo> drawInfos;
+   oglbuffer::generateBufferFromScene(sc, shader, vaoID, vboIndicesID, drawInfos);
    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
- 
-   int32 numIndicesInScene = 0;
-   for (uint32 i = 0; i < sc->m_numMeshes; i++)
-      numIndicesInScene +=( sc->m_ppMeshes[i]->m_numFaces * 3);
 
    win.mouse.SetVisible(true);
    win.mouse.SetPosition(winWidth/2, winHeight/2);
@@ -176,7 +180,8 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
       pipeline.SetCamera(camera.GetPosition(), camera.GetTarget(), camera.GetUp());
       shader.AddUniformData("MVP", &pipeline.GetWVPTrans(), oglshader::TYPE_FMAT4, 1, true);
   
-      glDrawArrays(GL_TRIANGLES, 0, numIndicesInScene);
+      for (size_t i = 0; i < drawInfos.size(); i++)
+         oglbuffer::drawMesh(drawInfos[i]);
       shader.Unuse();   
       glBindVertexArray(0);  
       oglContext.SwapFrontAndBackBuffer();